@@ -34,4 +34,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <sfeTk/sfeToolkit.h>
 #include "sfeTkArdI2C.h"
-#include "sfeTkArdSPI.h"
\ No newline at end of file
+#include "sfeTkArdSPI.h"
+#include "sfeTkArdI2CPort.h"
+#include "sfeTkArdSPIPort.h"
+#include "sfeTkArdCriticalSection.h"
+#include "sfeTkArdBusHooks.h"
+#include "sfeTkArdLog.h"
@@ -0,0 +1,145 @@
+// sfeTkArena.h
+//
+// Defines a static memory bump (arena) allocator for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkPool.h"
+
+/**
+ * @brief A bump allocator over a static buffer - for scratch memory that lives for one acquisition cycle.
+ *
+ * alloc() moves a pointer forward, so it is O(1) and never fragments. Nothing is freed on its own - call reset()
+ * once per cycle, when all of the cycle's allocations are done with.
+ *
+ * @tparam kSize The size of the arena in bytes
+ * @tparam Guard The guard policy - sfeTkNoGuard, or a critical section to use the arena from an interrupt
+ */
+template <size_t kSize, typename Guard = sfeTkNoGuard> class sfeTkArena
+{
+    static_assert(kSize > 0, "sfeTkArena size must be > 0");
+
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - an empty arena
+    */
+    sfeTkArena() : _used{0}, _highWater{0}, _nFailed{0}
+    {
+    }
+
+    sfeTkArena(const sfeTkArena &) = delete;
+    sfeTkArena &operator=(const sfeTkArena &) = delete;
+
+    /**--------------------------------------------------------------------------
+        @brief Allocate memory from the arena
+
+        @param size The number of bytes
+        @param align The alignment - a power of two
+
+        @retval void* The memory, nullptr if the arena does not have room
+    */
+    void *alloc(size_t size, size_t align = __BIGGEST_ALIGNMENT__)
+    {
+        Guard guard;
+        (void)guard;
+
+        uintptr_t base = (uintptr_t)_buffer;
+        uintptr_t start = (base + _used + align - 1) & ~(uintptr_t)(align - 1);
+        size_t end = (size_t)(start - base) + size;
+
+        if (end > kSize)
+        {
+            _nFailed++;
+            return nullptr;
+        }
+
+        _used = end;
+        if (_used > _highWater)
+            _highWater = _used;
+
+        return (void *)start;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Allocate an array from the arena - for scratch buffers of plain types
+
+        @param count The number of elements
+
+        @retval T* The array - not initialized. nullptr if the arena does not have room
+    */
+    template <typename T> T *allocArray(size_t count)
+    {
+        return static_cast<T *>(alloc(count * sizeof(T), alignof(T)));
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Release everything allocated from the arena - once per cycle
+    */
+    void reset(void)
+    {
+        Guard guard;
+        (void)guard;
+
+        _used = 0;
+    }
+
+    /** The number of bytes in use - including alignment padding */
+    size_t used(void) const
+    {
+        return _used;
+    }
+
+    /** The most bytes used in a cycle - use to size the arena */
+    size_t highWater(void) const
+    {
+        return _highWater;
+    }
+
+    /** The number of alloc() calls that failed because the arena was full */
+    uint32_t nFailed(void) const
+    {
+        return _nFailed;
+    }
+
+    /** Reset the high water mark and failure count */
+    void resetStats(void)
+    {
+        _highWater = _used;
+        _nFailed = 0;
+    }
+
+    /** The size of the arena */
+    static constexpr size_t capacity(void)
+    {
+        return kSize;
+    }
+
+  private:
+    alignas(__BIGGEST_ALIGNMENT__) uint8_t _buffer[kSize];
+
+    size_t _used;
+    size_t _highWater;
+    uint32_t _nFailed;
+};
@@ -0,0 +1,166 @@
+// sfeTkBitset.h
+//
+// Defines a fixed size bit set for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A fixed size set of bits - for flags keyed by a small index, such as a register address or device id.
+ *
+ * Bit indexes are not checked - an index >= kBits is undefined.
+ *
+ * @tparam kBits The number of bits
+ */
+template <size_t kBits> class sfeTkBitset
+{
+    static_assert(kBits > 0, "sfeTkBitset size must be > 0");
+
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - all bits clear
+    */
+    sfeTkBitset()
+    {
+        reset();
+    }
+
+    /** Set a bit */
+    void set(size_t bit)
+    {
+        _words[bit / kWordBits] |= (Word)1 << (bit % kWordBits);
+    }
+
+    /** Set a bit to a value */
+    void set(size_t bit, bool value)
+    {
+        if (value)
+            set(bit);
+        else
+            reset(bit);
+    }
+
+    /** Clear a bit */
+    void reset(size_t bit)
+    {
+        _words[bit / kWordBits] &= ~((Word)1 << (bit % kWordBits));
+    }
+
+    /** Clear all bits */
+    void reset(void)
+    {
+        for (size_t i = 0; i < kWords; i++)
+            _words[i] = 0;
+    }
+
+    /** Toggle a bit */
+    void flip(size_t bit)
+    {
+        _words[bit / kWordBits] ^= (Word)1 << (bit % kWordBits);
+    }
+
+    /** Is a bit set? */
+    bool test(size_t bit) const
+    {
+        return (_words[bit / kWordBits] >> (bit % kWordBits)) & 1;
+    }
+
+    /** Is a bit set? */
+    bool operator[](size_t bit) const
+    {
+        return test(bit);
+    }
+
+    /** Is any bit set? */
+    bool any(void) const
+    {
+        for (size_t i = 0; i < kWords; i++)
+        {
+            if (_words[i])
+                return true;
+        }
+        return false;
+    }
+
+    /** Is no bit set? */
+    bool none(void) const
+    {
+        return !any();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The number of bits set
+
+        @retval size_t The count
+    */
+    size_t count(void) const
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < kWords; i++)
+            n += (size_t)__builtin_popcountl((unsigned long)_words[i]);
+        return n;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Find the next set bit
+
+        @param from The first bit to check
+
+        @retval size_t The index of the first set bit at or after from, size() if none
+    */
+    size_t findNext(size_t from = 0) const
+    {
+        for (size_t i = from / kWordBits; i < kWords; i++)
+        {
+            Word word = _words[i];
+            if (i == from / kWordBits)
+                word &= (Word)(~(Word)0 << (from % kWordBits));
+
+            if (word)
+                return i * kWordBits + (size_t)__builtin_ctzl((unsigned long)word);
+        }
+        return kBits;
+    }
+
+    /** The number of bits */
+    static constexpr size_t size(void)
+    {
+        return kBits;
+    }
+
+  private:
+    // a byte on 8-bit parts, the native word elsewhere
+#if defined(__AVR__)
+    typedef uint8_t Word;
+#else
+    typedef unsigned long Word;
+#endif
+    static constexpr size_t kWordBits = sizeof(Word) * 8;
+    static constexpr size_t kWords = (kBits + kWordBits - 1) / kWordBits;
+
+    Word _words[kWords];
+};
@@ -0,0 +1,386 @@
+// sfeTkBusBudget.h
+//
+// Defines a bandwidth budget for a bus - the wire time the devices on the bus need each second, from the
+// operations of a sample and the sample rate of each, against a utilization limit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sfeTkBusMonitor.h"
+#include "sfeTkBusWire.h"
+#include "sfeTkIBus.h"
+#include "sfeTkTransaction.h"
+
+// Each device on the bus declares what it does for a sample - the steps of a transaction (one frame), the same
+// steps run as separate operations, or a number of bus clocks - and its sample rate. The clocks of a sample come
+// from the wire model of the bus (sfeTkBusWire.h) - address bytes, starts, restarts, stops and the chunks of long
+// reads - so changing the clock or the chunk size with setWire() changes the budget. Call check() at startup, or
+// let the budget refuse a device that would take the bus over the limit.
+//
+// The budget is the minimum wire time; a core's gaps between bytes and clock stretching are extra. Compare with
+// the bus utilization monitor (sfeTkBusMonitor.h) on the running system, and leave headroom in the limit.
+
+/**
+ * @brief The bus budget of a set of devices
+ *
+ * @code
+ *     static constexpr auto kReadImu = sfeTkTxn() << sfeTkWrite(kRegFifo, 0x01) >> sfeTkRead(kRegData, 12);
+ *
+ *     sfeTkBusBudget<> budget(sfeTkBusWire::i2c(400000), 7000, 5000);   // limit 70%, warn at 50%
+ *     budget.add("imu", kReadImu, 1000);                                 // 1 kHz
+ *     budget.addOperations("baro", kBaroSteps, 2, 50);
+ *     if (budget.check() != kSTkErrOk)
+ *         budget.report(Serial);
+ * @endcode
+ *
+ * @tparam kDevices The most devices in the budget
+ */
+template <size_t kDevices = 8> class sfeTkBusBudget
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor
+
+        @param wire The wire model of the bus
+        @param limit The utilization limit, in hundredths of a percent
+        @param warning The utilization to warn at, in hundredths of a percent
+    */
+    sfeTkBusBudget(const sfeTkBusWire &wire, uint16_t limit = 7000, uint16_t warning = 5000)
+        : _wire(wire), _nDevices{0}, _bReject{true}
+    {
+        setLimits(limit, warning);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the wire model - the clock and settings of the bus. The budget is recomputed.
+
+        @param wire The wire model of the bus
+    */
+    void setWire(const sfeTkBusWire &wire)
+    {
+        _wire = wire;
+    }
+
+    /** The wire model of the bus */
+    const sfeTkBusWire &wire(void) const
+    {
+        return _wire;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the limits
+
+        @param limit The utilization limit, in hundredths of a percent
+        @param warning The utilization to warn at, in hundredths of a percent
+        @param bReject Refuse a device that would take the bus over the limit - else it is added, and the add
+        returns kSTkErrBusOverBudget
+    */
+    void setLimits(uint16_t limit, uint16_t warning, bool bReject = true)
+    {
+        _limit = limit < kSTkBusMonitorFull ? limit : kSTkBusMonitorFull;
+        _warning = warning < _limit ? warning : _limit;
+        _bReject = bReject;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add a device whose sample is a transaction - one frame on the bus
+
+        @param name The name of the device in the report
+        @param txn The transaction of a sample - kept by reference, so make it static
+        @param rate The samples a second
+
+        @retval sfeTkError_t kSTkErrOk, kSTkErrBusBudgetWarning, kSTkErrBusOverBudget, or kSTkErrFail if the
+        budget has no room for another device
+    */
+    template <size_t N> sfeTkError_t add(const char *name, const sfeTkTransaction<N> &txn, uint32_t rate)
+    {
+        return add(name, txn.steps(), N, true, 0, rate);
+    }
+
+    // a temporary transaction would be gone before the budget is checked
+    template <size_t N> sfeTkError_t add(const char *name, const sfeTkTransaction<N> &&txn, uint32_t rate) = delete;
+
+    /**--------------------------------------------------------------------------
+        @brief Add a device whose sample is a number of operations, each with its own start and stop
+
+        @param name The name of the device in the report
+        @param steps The operations of a sample - kept by reference, so make them static
+        @param nSteps The number of operations
+        @param rate The samples a second
+
+        @retval sfeTkError_t kSTkErrOk, kSTkErrBusBudgetWarning, kSTkErrBusOverBudget, or kSTkErrFail if the
+        budget has no room for another device
+    */
+    sfeTkError_t addOperations(const char *name, const sfeTkTxnStep *steps, size_t nSteps, uint32_t rate)
+    {
+        return add(name, steps, nSteps, false, 0, rate);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add a device by the bus clocks of a sample - for traffic the steps do not describe
+
+        @param name The name of the device in the report
+        @param clocks The bus clocks of a sample
+        @param rate The samples a second
+
+        @retval sfeTkError_t kSTkErrOk, kSTkErrBusBudgetWarning, kSTkErrBusOverBudget, or kSTkErrFail if the
+        budget has no room for another device
+    */
+    sfeTkError_t addClocks(const char *name, uint32_t clocks, uint32_t rate)
+    {
+        return add(name, nullptr, 0, false, clocks, rate);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Change the sample rate of a device - not refused, check() the budget after
+
+        @param device The device - the order it was added in, from 0
+        @param rate The samples a second
+    */
+    void setRate(size_t device, uint32_t rate)
+    {
+        if (device < _nDevices)
+            _devices[device].rate = rate;
+    }
+
+    /** The number of devices */
+    size_t size(void) const
+    {
+        return _nDevices;
+    }
+
+    /** The name of a device */
+    const char *name(size_t device) const
+    {
+        return device < _nDevices ? _devices[device].name : "";
+    }
+
+    /** The sample rate of a device */
+    uint32_t rate(size_t device) const
+    {
+        return device < _nDevices ? _devices[device].rate : 0;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The bus clocks of a sample of a device
+
+        @param device The device
+        @retval uint32_t The clocks
+    */
+    uint32_t clocks(size_t device) const
+    {
+        if (device >= _nDevices)
+            return 0;
+
+        const Device &entry = _devices[device];
+        uint32_t clocks = entry.clocks;
+        for (size_t i = 0; entry.steps && i < entry.nSteps; i++)
+            clocks += _wire.stepBits(entry.steps[i], i + 1 == entry.nSteps, entry.bJoined);
+        return clocks;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The bus clocks each second of all devices
+
+        @retval uint64_t The clocks
+    */
+    uint64_t clocksPerSecond(void) const
+    {
+        uint64_t total = 0;
+        for (size_t i = 0; i < _nDevices; i++)
+            total += (uint64_t)clocks(i) * _devices[i].rate;
+        return total;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The wire time each second of all devices
+
+        @retval uint32_t The time in microseconds - more than 1000000 if the bus is too slow
+    */
+    uint32_t busyMicros(void) const
+    {
+        return busyMicros(clocksPerSecond());
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The utilization of the bus
+
+        @retval uint16_t The utilization in hundredths of a percent, rounded up - at most kSTkBusMonitorFull
+    */
+    uint16_t utilization(void) const
+    {
+        return utilization(clocksPerSecond());
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Check the budget against the limits
+
+        @retval sfeTkError_t kSTkErrOk, kSTkErrBusBudgetWarning over the warning level, kSTkErrBusOverBudget
+        over the limit
+    */
+    sfeTkError_t check(void) const
+    {
+        return verdict(clocksPerSecond());
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The slowest bus clock the devices fit in at the limit
+
+        @retval uint32_t The clock in Hz
+    */
+    uint32_t requiredClock(void) const
+    {
+        if (_limit == 0)
+            return 0xFFFFFFFFUL;
+        uint64_t clock = (clocksPerSecond() * kSTkBusMonitorFull + _limit - 1) / _limit;
+        return clock > 0xFFFFFFFFUL ? 0xFFFFFFFFUL : (uint32_t)clock;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The fastest sample rate of a device that keeps the bus within the limit, with the other devices
+        at their rates
+
+        @param device The device
+        @retval uint32_t The samples a second - 0 if the others are over the limit already
+    */
+    uint32_t maxRate(size_t device) const
+    {
+        uint32_t perSample = clocks(device);
+        if (perSample == 0)
+            return 0;
+
+        uint64_t others = clocksPerSecond() - (uint64_t)perSample * _devices[device].rate;
+        uint64_t allowed = (uint64_t)_wire.clock * _limit / kSTkBusMonitorFull;
+        return allowed > others ? (uint32_t)((allowed - others) / perSample) : 0;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Print the budget - each device, the total against the limits, and the clock the devices need
+
+        @param out Where to print - a class with println(const char *), such as Serial
+    */
+    template <typename Out> void report(Out &out) const
+    {
+        char line[112];
+        uint64_t total = clocksPerSecond();
+        uint16_t used = utilization(total);
+        sfeTkError_t result = verdict(total);
+
+        snprintf(line, sizeof(line),
+                 "Bus budget: %s at %lu kHz - %u.%02u%% used, limit %u.%02u%%, warning %u.%02u%%: %s",
+                 _wire.type == kSTkBusWireI2C ? "I2C" : "SPI", (unsigned long)(_wire.clock / 1000), used / 100,
+                 used % 100, _limit / 100, _limit % 100, _warning / 100, _warning % 100,
+                 result == kSTkErrOk ? "ok" : (result == kSTkErrBusBudgetWarning ? "WARNING" : "OVER"));
+        out.println(line);
+        snprintf(line, sizeof(line), "  %-12s %8s %8s %10s %10s %7s %8s", "device", "clocks", "rate Hz", "us/sample",
+                 "us/s", "share", "max Hz");
+        out.println(line);
+        for (size_t i = 0; i < _nDevices; i++)
+        {
+            uint32_t perSample = clocks(i);
+            uint64_t perSecond = (uint64_t)perSample * _devices[i].rate;
+            uint16_t share = utilization(perSecond);
+            snprintf(line, sizeof(line), "  %-12s %8lu %8lu %10lu %10lu %3u.%02u%% %8lu", _devices[i].name,
+                     (unsigned long)perSample, (unsigned long)_devices[i].rate,
+                     (unsigned long)_wire.time(perSample), (unsigned long)busyMicros(perSecond), share / 100,
+                     share % 100, (unsigned long)maxRate(i));
+            out.println(line);
+        }
+        snprintf(line, sizeof(line), "  %-12s %8s %8s %10s %10lu %3u.%02u%%", "total", "", "", "",
+                 (unsigned long)busyMicros(total), used / 100, used % 100);
+        out.println(line);
+        snprintf(line, sizeof(line), "  the devices need a %lu kHz clock for the limit",
+                 (unsigned long)((requiredClock() + 999) / 1000));
+        out.println(line);
+    }
+
+  private:
+    struct Device
+    {
+        const char *name;
+        const sfeTkTxnStep *steps;
+        size_t nSteps;
+        bool bJoined;
+        uint32_t clocks; // clocks not described by steps
+        uint32_t rate;
+    };
+
+    sfeTkError_t add(const char *name, const sfeTkTxnStep *steps, size_t nSteps, bool bJoined, uint32_t clocks,
+                     uint32_t rate)
+    {
+        if (_nDevices >= kDevices)
+            return kSTkErrFail;
+
+        Device &entry = _devices[_nDevices++];
+        entry.name = name ? name : "";
+        entry.steps = steps;
+        entry.nSteps = nSteps;
+        entry.bJoined = bJoined;
+        entry.clocks = clocks;
+        entry.rate = rate;
+
+        sfeTkError_t result = check();
+        if (result == kSTkErrBusOverBudget && _bReject)
+            _nDevices--; // admission control - the device does not fit
+        return result;
+    }
+
+    uint32_t busyMicros(uint64_t clocks) const
+    {
+        if (_wire.clock == 0)
+            return 0;
+        uint64_t micros = (clocks * 1000000 + _wire.clock - 1) / _wire.clock;
+        return micros > 0xFFFFFFFFUL ? 0xFFFFFFFFUL : (uint32_t)micros;
+    }
+
+    uint16_t utilization(uint64_t clocks) const
+    {
+        if (_wire.clock == 0)
+            return clocks > 0 ? kSTkBusMonitorFull : 0;
+        uint64_t value = (clocks * kSTkBusMonitorFull + _wire.clock - 1) / _wire.clock;
+        return value > kSTkBusMonitorFull ? kSTkBusMonitorFull : (uint16_t)value;
+    }
+
+    sfeTkError_t verdict(uint64_t clocks) const
+    {
+        // compared in clocks, so a bus over 100% is over any limit
+        uint64_t scaled = clocks * kSTkBusMonitorFull;
+        if (scaled > (uint64_t)_wire.clock * _limit)
+            return kSTkErrBusOverBudget;
+        if (scaled > (uint64_t)_wire.clock * _warning)
+            return kSTkErrBusBudgetWarning;
+        return kSTkErrOk;
+    }
+
+    sfeTkBusWire _wire;
+    Device _devices[kDevices];
+    size_t _nDevices;
+    uint16_t _limit;
+    uint16_t _warning;
+    bool _bReject;
+};
@@ -0,0 +1,346 @@
+// sfeTkBusHooks.h
+//
+// Defines hooks run before and after each bus operation - for profiling, tracing and watchdogs - selected at
+// compile time by a policy type
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkIBus.h"
+
+/**
+ * @brief The bus operation a hook is called for - one for each sfeTkIBus operation
+ */
+enum sfeTkBusHookOp_t : uint8_t
+{
+    kSTkBusHookWriteByte = 0,
+    kSTkBusHookWriteWord,
+    kSTkBusHookWriteRegion,
+    kSTkBusHookWriteRegisterByte,
+    kSTkBusHookWriteRegisterWord,
+    kSTkBusHookWriteRegisterRegion,
+    kSTkBusHookWriteRegister16Region,
+    kSTkBusHookReadRegisterByte,
+    kSTkBusHookReadRegisterWord,
+    kSTkBusHookReadRegisterRegion,
+    kSTkBusHookReadRegister16Region,
+    kSTkBusHookTransaction
+};
+
+/**
+ * @brief What a hook is told about a bus operation
+ */
+struct sfeTkBusHookInfo
+{
+    /** The bus - so the device - the operation is on */
+    sfeTkIBus *bus;
+
+    /** The operation */
+    sfeTkBusHookOp_t op;
+
+    /** The register - 0 for operations without one, and for transactions */
+    uint16_t reg;
+
+    /** The number of bytes written or requested - the number of steps for a transaction */
+    size_t length;
+
+    /** The data written, or the buffer read into (filled for the after hook) - nullptr for a transaction */
+    const uint8_t *data;
+
+    /** The steps of a transaction - nullptr for other operations */
+    const sfeTkTxnStep *steps;
+
+    /** The result - set for the after hook */
+    sfeTkError_t result;
+
+    /** The time the operation took, in the units of the policy's clock - set for the after hook */
+    uint32_t duration;
+};
+
+/**
+ * @brief The hook policy for no hooks. sfeTkHookedBus<Bus, sfeTkNoBusHooks>::type is Bus - the bus class itself -
+ * so no hooks cost nothing at all.
+ *
+ * A hook policy is a class with:
+ *   - static const bool kEnabled - true
+ *   - uint32_t now(void) - the clock used for the duration
+ *   - void before(const sfeTkBusHookInfo &info) - called before each operation
+ *   - void after(const sfeTkBusHookInfo &info) - called after each operation, with the result and duration
+ *
+ * The methods of the policy are called directly, not through a pointer, so they are inlined - a policy with
+ * empty methods and a constant clock adds nothing to an operation but the call through the vtable.
+ */
+struct sfeTkNoBusHooks
+{
+    static const bool kEnabled = false;
+};
+
+/**
+ * @brief A hook policy that calls a function - set at run time - before and after each operation. With a function
+ * set, each hook point costs one indirect call; with none, a test of the pointer.
+ *
+ * @tparam Clock A class with a static uint32_t now(void) method, used for the duration - for example
+ *               sfeTkArdMicros (sfeTkArdBusHooks.h) on Arduino
+ */
+template <typename Clock> class sfeTkBusHookCallback
+{
+  public:
+    static const bool kEnabled = true;
+
+    /**
+     * @brief The hook function. bAfter is false before the operation, true after it
+     */
+    typedef void (*Hook)(const sfeTkBusHookInfo &info, bool bAfter, void *context);
+
+    sfeTkBusHookCallback(void) : _hook{nullptr}, _context{nullptr}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the hook function - nullptr for none
+
+        @param hook The function
+        @param context Passed to the function
+    */
+    void setHook(Hook hook, void *context = nullptr)
+    {
+        _hook = hook;
+        _context = context;
+    }
+
+    uint32_t now(void)
+    {
+        return _hook ? Clock::now() : 0;
+    }
+
+    void before(const sfeTkBusHookInfo &info)
+    {
+        if (_hook)
+            _hook(info, false, _context);
+    }
+
+    void after(const sfeTkBusHookInfo &info)
+    {
+        if (_hook)
+            _hook(info, true, _context);
+    }
+
+  private:
+    Hook _hook;
+    void *_context;
+};
+
+/**
+ * @brief A bus class with hooks - Bus, with each sfeTkIBus operation wrapped in the before and after hooks of the
+ * policy. Use sfeTkHookedBus<Bus, Hooks>::type, which is Bus itself when the policy is not enabled.
+ *
+ * The hooks are outside the bus operation, so the duration includes all of it - and an operation is hooked once,
+ * however it is called: through sfeTkIBus, on the class, or with the value returning overloads. A transaction is
+ * one operation. Operations that do not go through the bus methods are not hooked - the checked handles
+ * (checked()) and the asynchronous reads. Operations that a bus implements with other operations - transactions
+ * with the default sfeTkIBus::executeSteps() - call the hooks for each of those too.
+ *
+ * @tparam Bus The bus class - sfeTkArdI2C, sfeTkArdSPI, a device handle, or any sfeTkIBus implementation
+ * @tparam Hooks The hook policy
+ */
+// The policy is a private base, not a member, so a policy with no state takes no space in the bus object
+template <typename Bus, typename Hooks> class sfeTkHookedBusImpl : public Bus, private Hooks
+{
+  public:
+    using Bus::Bus;
+
+    sfeTkHookedBusImpl(void) : Bus()
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The hook policy object - to set a hook, or read what a policy collected
+    */
+    Hooks &hooks(void)
+    {
+        return *this;
+    }
+
+    sfeTkError_t writeByte(uint8_t data)
+    {
+        Scope scope(*this, kSTkBusHookWriteByte, 0, 1, &data);
+        return scope.done(Bus::writeByte(data));
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    sfeTkError_t writeWord(uint16_t data)
+    {
+        Scope scope(*this, kSTkBusHookWriteWord, 0, 2, (const uint8_t *)&data);
+        return scope.done(Bus::writeWord(data));
+    }
+#endif
+
+    sfeTkError_t writeRegion(const uint8_t *data, size_t length)
+    {
+        Scope scope(*this, kSTkBusHookWriteRegion, 0, length, data);
+        return scope.done(Bus::writeRegion(data, length));
+    }
+
+    sfeTkError_t writeRegisterByte(uint8_t devReg, uint8_t data)
+    {
+        Scope scope(*this, kSTkBusHookWriteRegisterByte, devReg, 1, &data);
+        return scope.done(Bus::writeRegisterByte(devReg, data));
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    sfeTkError_t writeRegisterWord(uint8_t devReg, uint16_t data)
+    {
+        Scope scope(*this, kSTkBusHookWriteRegisterWord, devReg, 2, (const uint8_t *)&data);
+        return scope.done(Bus::writeRegisterWord(devReg, data));
+    }
+#endif
+
+    sfeTkError_t writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
+    {
+        Scope scope(*this, kSTkBusHookWriteRegisterRegion, devReg, length, data);
+        return scope.done(Bus::writeRegisterRegion(devReg, data, length));
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    sfeTkError_t writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
+    {
+        Scope scope(*this, kSTkBusHookWriteRegister16Region, devReg, length, data);
+        return scope.done(Bus::writeRegister16Region(devReg, data, length));
+    }
+#endif
+
+    sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data)
+    {
+        Scope scope(*this, kSTkBusHookReadRegisterByte, devReg, 1, &data);
+        return scope.done(Bus::readRegisterByte(devReg, data));
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    sfeTkError_t readRegisterWord(uint8_t devReg, uint16_t &data)
+    {
+        Scope scope(*this, kSTkBusHookReadRegisterWord, devReg, 2, (const uint8_t *)&data);
+        return scope.done(Bus::readRegisterWord(devReg, data));
+    }
+#endif
+
+    sfeTkError_t readRegisterRegion(uint8_t reg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        Scope scope(*this, kSTkBusHookReadRegisterRegion, reg, numBytes, data);
+        return scope.done(Bus::readRegisterRegion(reg, data, numBytes, readBytes));
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    sfeTkError_t readRegister16Region(uint16_t reg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        Scope scope(*this, kSTkBusHookReadRegister16Region, reg, numBytes, data);
+        return scope.done(Bus::readRegister16Region(reg, data, numBytes, readBytes));
+    }
+#endif
+
+    // the value returning reads of sfeTkIBus - they call the hooked read methods above
+    using sfeTkIBus::readRegisterByte;
+#if SFE_TK_ENABLE_WORD_OPS
+    using sfeTkIBus::readRegisterWord;
+#endif
+    using sfeTkIBus::readRegisterRegion;
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    using sfeTkIBus::readRegister16Region;
+#endif
+
+#if SFE_TK_ENABLE_TRANSACTIONS
+    sfeTkError_t executeSteps(const sfeTkTxnStep *steps, size_t nSteps)
+    {
+        Scope scope(*this, kSTkBusHookTransaction, 0, nSteps, nullptr, steps);
+        return scope.done(Bus::executeSteps(steps, nSteps));
+    }
+#endif
+
+  private:
+    // Calls the before hook when made, and the after hook from done() with the result
+    class Scope
+    {
+      public:
+        Scope(sfeTkHookedBusImpl &theBus, sfeTkBusHookOp_t op, uint16_t reg, size_t length, const uint8_t *data,
+              const sfeTkTxnStep *steps = nullptr)
+            : _hooks{theBus.hooks()}
+        {
+            _info.bus = &theBus;
+            _info.op = op;
+            _info.reg = reg;
+            _info.length = length;
+            _info.data = data;
+            _info.steps = steps;
+            _info.result = kSTkErrOk;
+            _info.duration = 0;
+            _hooks.before(_info);
+            _start = _hooks.now();
+        }
+
+        sfeTkError_t done(sfeTkError_t result)
+        {
+            _info.duration = _hooks.now() - _start;
+            _info.result = result;
+            _hooks.after(_info);
+            return result;
+        }
+
+      private:
+        Hooks &_hooks;
+        sfeTkBusHookInfo _info;
+        uint32_t _start;
+    };
+};
+
+/**
+ * @brief Selects the bus class for a hook policy - see sfeTkHookedBus
+ */
+template <bool bEnabled, typename Bus, typename Hooks> struct sfeTkHookedBusSelect
+{
+    typedef sfeTkHookedBusImpl<Bus, Hooks> type;
+};
+
+template <typename Bus, typename Hooks> struct sfeTkHookedBusSelect<false, Bus, Hooks>
+{
+    typedef Bus type;
+};
+
+/**
+ * @brief The bus class with the hooks of a policy - sfeTkHookedBusImpl<Bus, Hooks>, or Bus when the policy is not
+ * enabled (sfeTkNoBusHooks). A driver that takes its hook policy as a template parameter builds to exactly the
+ * code of the plain bus class when hooks are off.
+ *
+ * @code
+ *     #ifdef MY_PROFILE
+ *     typedef sfeTkArdBusHookCallback BusHooks;
+ *     #else
+ *     typedef sfeTkNoBusHooks BusHooks;
+ *     #endif
+ *
+ *     sfeTkHookedBus<sfeTkArdI2C, BusHooks>::type theBus;
+ * @endcode
+ */
+template <typename Bus, typename Hooks> struct sfeTkHookedBus
+{
+    typedef typename sfeTkHookedBusSelect<Hooks::kEnabled, Bus, Hooks>::type type;
+};
@@ -0,0 +1,375 @@
+// sfeTkBusMonitor.h
+//
+// Defines a utilization monitor for a bus - the share of time the bus is busy, over a sliding window
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sfeTkBusHooks.h"
+#include "sfeTkBusWire.h"
+
+// A monitor is for one physical bus - the devices on the bus feed it through the sfeTkBusMonitorHooks policy of
+// their bus objects. The busy time of each operation is measured (the duration of the operation, which includes
+// the CPU time of the bus code) or estimated from the bytes and the clock rate with the wire model
+// (sfeTkBusWire.h).
+//
+// The window is split in kSlots slots. Busy time is added to the current slot, and when a slot ends the oldest
+// is dropped - so the window slides by a slot at a time, and the cost of an operation is an add and a compare.
+// When a slot ends, the utilization of the full window just completed is checked against the peak and the
+// threshold. The slots only move when there is an operation, or update() is called - call it from the main loop
+// to see the bus go idle.
+
+/**
+ * @brief The utilization of a full bus - utilization values are in hundredths of a percent
+ */
+const uint16_t kSTkBusMonitorFull = 10000;
+
+/**
+ * @brief Accumulates the busy time of a bus over a sliding window
+ *
+ * @tparam Clock A class with a static uint32_t now(void) method - the time base of the window
+ * @tparam kSlots The number of slots the window is split in
+ */
+template <typename Clock, size_t kSlots = 8> class sfeTkBusMonitor
+{
+    static_assert(kSlots >= 2, "sfeTkBusMonitor needs two or more slots");
+
+  public:
+    /** The clock of the monitor - used by the hook policy */
+    typedef Clock ClockType;
+
+    /**
+     * @brief The threshold callback - bAbove is true when the utilization went over the threshold, false when
+     * it went back under it, less the hysteresis
+     */
+    typedef void (*Callback)(bool bAbove, uint16_t utilization, void *context);
+
+    /**--------------------------------------------------------------------------
+        @brief Constructor
+
+        @param window The length of the window, in ticks of the clock
+        @param rate The ticks a second of the clock - used to convert estimated wire time
+    */
+    sfeTkBusMonitor(uint32_t window = 1000000, uint32_t rate = 1000000)
+        : _rate{rate}, _threshold{kSTkBusMonitorFull + 1}, _hysteresis{0}, _callback{nullptr}, _context{nullptr}
+    {
+        setWindow(window);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the length of the window - the statistics are reset
+
+        @param window The length of the window, in ticks of the clock
+    */
+    void setWindow(uint32_t window)
+    {
+        _slotLength = window >= kSlots ? window / kSlots : 1;
+        reset();
+    }
+
+    /** The length of the window in ticks of the clock - a whole number of slots */
+    uint32_t window(void) const
+    {
+        return _slotLength * kSlots;
+    }
+
+    /** The ticks a second of the clock */
+    uint32_t rate(void) const
+    {
+        return _rate;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the threshold, and the function called when the utilization of a window crosses it
+
+        @param threshold The threshold, in hundredths of a percent
+        @param callback The function - nullptr for none
+        @param context Passed to the function
+        @param hysteresis How far under the threshold the utilization must go to be under it again
+    */
+    void setThreshold(uint16_t threshold, Callback callback, void *context = nullptr, uint16_t hysteresis = 500)
+    {
+        _threshold = threshold;
+        _callback = callback;
+        _context = context;
+        _hysteresis = hysteresis < threshold ? hysteresis : threshold;
+        _bAbove = false;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add the busy time of an operation - called by the hook policy
+
+        @param busy The busy time, in ticks of the clock
+        @param now The time the operation ended
+    */
+    void addBusy(uint32_t busy, uint32_t now)
+    {
+        if (now - _slotStart >= _slotLength)
+            advance(now);
+
+        _slots[_current] += busy;
+        _windowBusy += busy;
+        _total += busy;
+        _operations++;
+    }
+
+    void addBusy(uint32_t busy)
+    {
+        addBusy(busy, Clock::now());
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Move the window to the current time - checks the peak and the threshold for the slots that ended
+    */
+    void update(void)
+    {
+        uint32_t now = Clock::now();
+        if (now - _slotStart >= _slotLength)
+            advance(now);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The utilization of the window that ends now
+
+        @retval uint16_t The utilization in hundredths of a percent
+    */
+    uint16_t utilization(void)
+    {
+        uint32_t now = Clock::now();
+        if (now - _slotStart >= _slotLength)
+            advance(now);
+
+        // the full slots before this one, and the part of this one so far
+        uint32_t span = (uint32_t)_nFull * _slotLength + (now - _slotStart);
+        return percent(_windowBusy, span);
+    }
+
+    /** The highest utilization of a full window, in hundredths of a percent */
+    uint16_t peak(void) const
+    {
+        return _peak;
+    }
+
+    /** Clear the peak */
+    void resetPeak(void)
+    {
+        _peak = 0;
+    }
+
+    /** The total busy time since the last reset, in ticks of the clock */
+    uint32_t busy(void) const
+    {
+        return _total;
+    }
+
+    /** The number of operations since the last reset */
+    uint32_t operations(void) const
+    {
+        return _operations;
+    }
+
+    /** Is the utilization over the threshold? */
+    bool above(void) const
+    {
+        return _bAbove;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Clear the window, the peak and the totals - the window starts now
+    */
+    void reset(void)
+    {
+        for (size_t i = 0; i < kSlots; i++)
+            _slots[i] = 0;
+        _current = 0;
+        _nFull = 0;
+        _slotStart = Clock::now();
+        _windowBusy = 0;
+        _peak = 0;
+        _total = 0;
+        _operations = 0;
+        _bAbove = false;
+    }
+
+  private:
+    static uint16_t percent(uint32_t busy, uint32_t span)
+    {
+        if (span == 0)
+            return 0;
+        uint64_t value = (uint64_t)busy * kSTkBusMonitorFull / span;
+        return value > kSTkBusMonitorFull ? kSTkBusMonitorFull : (uint16_t)value;
+    }
+
+    // end the slots up to the time - each that ends completes a window
+    void advance(uint32_t now)
+    {
+        uint32_t nEnded = (now - _slotStart) / _slotLength;
+        for (uint32_t i = 0; i < nEnded; i++)
+        {
+            if (_nFull < kSlots - 1)
+                _nFull++;
+            else
+                check(percent(_windowBusy, kSlots * _slotLength));
+
+            _current = (_current + 1) % kSlots;
+            _windowBusy -= _slots[_current];
+            _slots[_current] = 0;
+
+            // after a window of idle slots, the rest are idle too
+            if (i >= kSlots && _windowBusy == 0)
+                break;
+        }
+        _slotStart += nEnded * _slotLength;
+    }
+
+    // a full window ended
+    void check(uint16_t value)
+    {
+        if (value > _peak)
+            _peak = value;
+
+        if (!_bAbove && value >= _threshold)
+        {
+            _bAbove = true;
+            if (_callback)
+                _callback(true, value, _context);
+        }
+        else if (_bAbove && value + _hysteresis < _threshold)
+        {
+            _bAbove = false;
+            if (_callback)
+                _callback(false, value, _context);
+        }
+    }
+
+    uint32_t _slots[kSlots];
+    size_t _current;
+    size_t _nFull; // the full slots before the current one - up to kSlots - 1
+    uint32_t _slotStart;
+    uint32_t _slotLength;
+    uint32_t _windowBusy;
+
+    uint32_t _rate;
+    uint16_t _peak;
+    uint32_t _total;
+    uint32_t _operations;
+
+    uint16_t _threshold;
+    uint16_t _hysteresis;
+    bool _bAbove;
+    Callback _callback;
+    void *_context;
+};
+
+/**
+ * @brief The hook policy that adds a bus's operations to a monitor. Attach the bus object of each device on a
+ * physical bus to the monitor of that bus.
+ *
+ * @code
+ *     sfeTkArdBusMonitor wireMonitor(1000000);    // a one second window
+ *     sfeTkArdI2CHooked<sfeTkArdBusMonitorHooks> imu, baro;
+ *
+ *     imu.hooks().attach(wireMonitor, sfeTkBusWire::i2c(400000));   // estimated from the bytes
+ *     baro.hooks().attach(wireMonitor);                              // measured
+ *     wireMonitor.setThreshold(7000, onBusy);                         // 70%
+ * @endcode
+ *
+ * @tparam Monitor The monitor class - an sfeTkBusMonitor
+ */
+template <typename Monitor> class sfeTkBusMonitorHooks
+{
+  public:
+    static const bool kEnabled = true;
+
+    sfeTkBusMonitorHooks(void) : _monitor{nullptr}, _scale{0}, _bEstimate{false}, _depth{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Attach to a monitor - the busy time of an operation is its measured duration
+
+        @param monitor The monitor of the bus
+    */
+    void attach(Monitor &monitor)
+    {
+        _monitor = &monitor;
+        _bEstimate = false;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Attach to a monitor - the busy time of an operation is estimated from its bytes with a wire model.
+        The clock is not read for the duration of each operation.
+
+        @param monitor The monitor of the bus
+        @param wire The wire model of the bus
+    */
+    void attach(Monitor &monitor, const sfeTkBusWire &wire)
+    {
+        _monitor = &monitor;
+        _wire = wire;
+        _bEstimate = true;
+
+        // the monitor ticks of a bus clock, 16.16 fixed point - so an operation costs a multiply, not a divide
+        uint64_t scale = wire.clock > 0 ? ((uint64_t)monitor.rate() << 16) / wire.clock : 0;
+        _scale = scale > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)scale;
+    }
+
+    /** Stop adding operations to the monitor */
+    void detach(void)
+    {
+        _monitor = nullptr;
+    }
+
+    uint32_t now(void)
+    {
+        return _monitor && !_bEstimate ? Monitor::ClockType::now() : 0;
+    }
+
+    void before(const sfeTkBusHookInfo &)
+    {
+        _depth++;
+    }
+
+    void after(const sfeTkBusHookInfo &info)
+    {
+        // only the outer operation - a bus that runs a transaction as separate operations hooks those too
+        if (--_depth != 0 || !_monitor)
+            return;
+
+        if (_bEstimate)
+            _monitor->addBusy((uint32_t)(((uint64_t)_wire.hookBits(info) * _scale + 0x8000) >> 16));
+        else
+            _monitor->addBusy(info.duration);
+    }
+
+  private:
+    Monitor *_monitor;
+    sfeTkBusWire _wire;
+    uint32_t _scale;
+    bool _bEstimate;
+    uint8_t _depth;
+};
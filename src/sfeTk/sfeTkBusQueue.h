@@ -0,0 +1,177 @@
+// sfeTkBusQueue.h
+//
+// Defines a bounded, lock-free queue used to pass work between tasks for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A bounded, lock-free, multi-producer/multi-consumer queue.
+ *
+ * Each slot carries a sequence number that tells producers and consumers whether the slot is free
+ * or holds data for the current lap of the ring. Producers and consumers claim positions with a
+ * compare-and-swap, so no task ever blocks another one and push/pop are safe to call from any task.
+ *
+ * The queue uses the GCC/Clang __atomic builtins, so it is usable on every toolchain the toolkit
+ * supports that provides native atomics for size_t (all 32-bit Arduino cores and the host).
+ *
+ * @tparam T The type of the stored items - should be small and trivially copyable (a pointer is typical)
+ * @tparam kCapacity The number of slots in the queue - must be a power of two
+ */
+template <typename T, size_t kCapacity> class sfeTkBusQueue
+{
+    static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0, "sfeTkBusQueue capacity must be a power of 2");
+
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - sets up the slot sequence numbers
+
+    */
+    sfeTkBusQueue() : _head{0}, _tail{0}
+    {
+        for (size_t i = 0; i < kCapacity; i++)
+            _slots[i].sequence = i;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add an item to the end of the queue
+
+        @param item The item to add
+
+        @retval bool - true on success, false if the queue is full
+    */
+    bool push(const T &item)
+    {
+        size_t pos = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        for (;;)
+        {
+            Slot &slot = _slots[pos & kMask];
+            size_t seq = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+            if (diff == 0)
+            {
+                // slot is free for this lap - try to claim it
+                if (__atomic_compare_exchange_n(&_tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                {
+                    slot.item = item;
+                    __atomic_store_n(&slot.sequence, pos + 1, __ATOMIC_RELEASE);
+                    return true;
+                }
+                // on failure, pos was reloaded by the CAS - go around again
+            }
+            else if (diff < 0)
+                return false; // full
+            else
+                pos = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Remove the item at the front of the queue
+
+        @param[out] item The removed item
+
+        @retval bool - true on success, false if the queue is empty
+    */
+    bool pop(T &item)
+    {
+        size_t pos = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+        for (;;)
+        {
+            Slot &slot = _slots[pos & kMask];
+            size_t seq = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+            if (diff == 0)
+            {
+                if (__atomic_compare_exchange_n(&_head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                {
+                    item = slot.item;
+                    __atomic_store_n(&slot.sequence, pos + kCapacity, __ATOMIC_RELEASE);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false; // empty
+            else
+                pos = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief An approximate count of the items in the queue - exact when no other task is using the queue
+
+        @retval size_t The number of queued items
+    */
+    size_t size(void) const
+    {
+        // the head first - it never passes the tail, so a tail loaded after it is not behind it. The indices move
+        // between the loads, so keep the count in 0..kCapacity
+        size_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+        size_t tail = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+        intptr_t count = (intptr_t)(tail - head);
+        if (count < 0)
+            return 0;
+        return (size_t)count > kCapacity ? kCapacity : (size_t)count;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Is the queue empty (approximate when other tasks are using the queue)
+
+        @retval bool true if empty
+    */
+    bool empty(void) const
+    {
+        return size() == 0;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The capacity of the queue
+
+        @retval size_t The number of slots
+    */
+    static constexpr size_t capacity(void)
+    {
+        return kCapacity;
+    }
+
+  private:
+    static constexpr size_t kMask = kCapacity - 1;
+
+    struct Slot
+    {
+        size_t sequence;
+        T item;
+    };
+
+    Slot _slots[kCapacity];
+
+    // consumers move the head, producers move the tail
+    size_t _head;
+    size_t _tail;
+};
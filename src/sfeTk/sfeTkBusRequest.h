@@ -0,0 +1,163 @@
+// sfeTkBusRequest.h
+//
+// Defines a bus request descriptor - a bus operation that is executed later, or by another task - for the SparkFun
+// Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkIBus.h"
+
+/**
+ * @brief A request descriptor for the bus service.
+ *
+ * The request, and the buffer it points to, are owned by the submitter and must stay valid until the
+ * request is done. The service sets the status to kSTkErrBusPending on submit, and to the result of the
+ * bus operation once it is executed.
+ */
+struct sfeTkBusRequest
+{
+    /** The operation to perform */
+    sfeTkBusOp_t op;
+
+    /** The priority of the request - 0 is the highest */
+    uint8_t priority;
+
+    /** The register to read/write - 8 or 16 bit depending on the operation */
+    uint16_t reg;
+
+    /** The data buffer for the operation */
+    uint8_t *data;
+
+    /** The length of the data buffer */
+    size_t length;
+
+    /** The number of bytes transferred - set on completion of a read */
+    size_t transferred;
+
+    /** The status of the request - kSTkErrBusPending until complete */
+    sfeTkError_t status;
+
+    /** Optional completion callback - called from the task (or interrupt) that completes the request */
+    void (*onComplete)(sfeTkBusRequest &request, void *context);
+
+    /** The context passed to the completion callback */
+    void *context;
+
+    /**--------------------------------------------------------------------------
+        @brief Setup the request for an operation
+
+        @param theOp The operation to perform
+        @param theReg The register for the operation
+        @param theData The data buffer for the operation
+        @param theLength The length of the data buffer
+        @param thePriority The priority of the request - 0 is the highest
+    */
+    void set(sfeTkBusOp_t theOp, uint16_t theReg, uint8_t *theData, size_t theLength, uint8_t thePriority = 0)
+    {
+        op = theOp;
+        reg = theReg;
+        data = theData;
+        length = theLength;
+        priority = thePriority;
+        transferred = 0;
+        status = kSTkErrOk;
+        onComplete = nullptr;
+        context = nullptr;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Complete the request - call the completion callback, then publish the status.
+
+        The callback runs before the status is published, so the request is still owned by the
+        completing task while the callback runs.
+
+        @param result The result of the operation
+    */
+    void complete(sfeTkError_t result)
+    {
+        if (onComplete)
+            onComplete(*this, context);
+
+        __atomic_store_n(&status, result, __ATOMIC_RELEASE);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Has the request completed? Safe to call from any task.
+
+        @retval bool true if the request is done and status() holds the result
+    */
+    bool done(void) const
+    {
+        return __atomic_load_n(&status, __ATOMIC_ACQUIRE) != kSTkErrBusPending;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The current status of the request
+
+        @retval sfeTkError_t kSTkErrBusPending while queued, otherwise the result of the operation
+    */
+    sfeTkError_t result(void) const
+    {
+        return __atomic_load_n(&status, __ATOMIC_ACQUIRE);
+    }
+};
+
+/**
+ * @brief Execute a request on the given bus - synchronously, in the calling task. The request is not completed,
+ *        the caller completes it with the returned result.
+ *
+ * @param bus The bus to use
+ * @param request The request to execute
+ *
+ * @retval sfeTkError_t The result of the bus operation
+ */
+inline sfeTkError_t sfeTkBusExecute(sfeTkIBus &bus, sfeTkBusRequest &request)
+{
+    switch (request.op)
+    {
+    case kSTkBusOpWriteRegion:
+        return bus.writeRegion(request.data, request.length);
+
+    case kSTkBusOpWriteRegisterRegion:
+        return bus.writeRegisterRegion((uint8_t)request.reg, request.data, request.length);
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    case kSTkBusOpWriteRegister16Region:
+        return bus.writeRegister16Region(request.reg, request.data, request.length);
+#endif
+
+    case kSTkBusOpReadRegisterRegion:
+        return bus.readRegisterRegion((uint8_t)request.reg, request.data, request.length, request.transferred);
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    case kSTkBusOpReadRegister16Region:
+        return bus.readRegister16Region(request.reg, request.data, request.length, request.transferred);
+#endif
+
+    default: // a compiled out operation
+        break;
+    }
+    return kSTkErrFail;
+}
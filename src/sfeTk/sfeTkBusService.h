@@ -0,0 +1,196 @@
+// sfeTkBusService.h
+//
+// Defines a bus service - a single owner of a bus that executes queued requests - for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkBusQueue.h"
+#include "sfeTkBusRequest.h"
+
+/**
+ * @brief A bus service owns one bus, and executes the requests submitted to it, in order.
+ *
+ * Application tasks submit requests from any task (the request queues are lock-free), and the bus is only ever
+ * touched by the task that calls serviceOne()/serviceAll() - so application tasks never block on bus I/O.
+ *
+ * Requests are executed in priority order (0 is highest), and in submit order within a priority.
+ *
+ * Completion is signaled through the request status (see sfeTkBusRequest::done()) and the optional request callback.
+ * A notify function can be set, which is called on every submit, allowing a service task to sleep until work arrives.
+ *
+ * @tparam kDepth The depth of each priority queue - must be a power of two
+ * @tparam kPriorities The number of priority levels
+ */
+template <size_t kDepth = 8, uint8_t kPriorities = 2> class sfeTkBusService
+{
+    static_assert(kPriorities > 0, "sfeTkBusService requires at least one priority level");
+
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor
+
+        @param theBus The bus this service owns
+    */
+    sfeTkBusService(sfeTkIBus &theBus)
+        : _bus{theBus}, _notify{nullptr}, _notifyContext{nullptr}, _nSubmitted{0}, _nCompleted{0}, _nRejected{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Submit a request to the service. Safe to call from any task.
+
+        @param request The request to queue. Must remain valid until done.
+
+        @retval sfeTkError_t kSTkErrOk if queued, kSTkErrBusQueueFull if the queue for the priority is full
+    */
+    sfeTkError_t submit(sfeTkBusRequest &request)
+    {
+        if (request.priority >= kPriorities)
+            request.priority = kPriorities - 1;
+
+        request.transferred = 0;
+        __atomic_store_n(&request.status, kSTkErrBusPending, __ATOMIC_RELEASE);
+
+        if (!_queues[request.priority].push(&request))
+        {
+            __atomic_store_n(&request.status, kSTkErrBusQueueFull, __ATOMIC_RELEASE);
+            __atomic_fetch_add(&_nRejected, 1, __ATOMIC_RELAXED);
+            return kSTkErrBusQueueFull;
+        }
+        __atomic_fetch_add(&_nSubmitted, 1, __ATOMIC_RELAXED);
+
+        if (_notify)
+            _notify(_notifyContext);
+
+        return kSTkErrOk;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Execute the next request - highest priority first. Only call from the service task.
+
+        @retval bool true if a request was executed, false if there was no work
+    */
+    bool serviceOne(void)
+    {
+        sfeTkBusRequest *request;
+
+        for (uint8_t i = 0; i < kPriorities; i++)
+        {
+            if (!_queues[i].pop(request))
+                continue;
+
+            request->complete(sfeTkBusExecute(_bus, *request));
+            __atomic_fetch_add(&_nCompleted, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+        return false;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Execute all queued requests. Only call from the service task.
+
+        @retval size_t The number of requests executed
+    */
+    size_t serviceAll(void)
+    {
+        size_t n = 0;
+        while (serviceOne())
+            n++;
+        return n;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Is there queued work?
+
+        @retval bool true if any request is queued
+    */
+    bool pending(void) const
+    {
+        for (uint8_t i = 0; i < kPriorities; i++)
+        {
+            if (!_queues[i].empty())
+                return true;
+        }
+        return false;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the function called when a request is submitted - used to wake up a service task
+
+        @param notify The notify function - called from the submitting task
+        @param context Context passed to the notify function
+    */
+    void setNotify(void (*notify)(void *), void *context)
+    {
+        _notifyContext = context;
+        _notify = notify;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The bus this service owns
+
+        @retval sfeTkIBus& The bus
+    */
+    sfeTkIBus &bus(void)
+    {
+        return _bus;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The number of requests accepted by submit()
+    */
+    uint32_t nSubmitted(void) const
+    {
+        return __atomic_load_n(&_nSubmitted, __ATOMIC_RELAXED);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The number of requests completed - counted once the completion has run
+    */
+    uint32_t nCompleted(void) const
+    {
+        return __atomic_load_n(&_nCompleted, __ATOMIC_RELAXED);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The number of requests rejected because a queue was full
+    */
+    uint32_t nRejected(void) const
+    {
+        return __atomic_load_n(&_nRejected, __ATOMIC_RELAXED);
+    }
+
+  private:
+    sfeTkIBus &_bus;
+
+    sfeTkBusQueue<sfeTkBusRequest *, kDepth> _queues[kPriorities];
+
+    void (*_notify)(void *);
+    void *_notifyContext;
+
+    uint32_t _nSubmitted;
+    uint32_t _nCompleted;
+    uint32_t _nRejected;
+};
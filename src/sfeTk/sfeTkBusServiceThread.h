@@ -0,0 +1,181 @@
+// sfeTkBusServiceThread.h
+//
+// Defines a std::thread based bus service task for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+// Note: This file requires std::thread - available on the host and on RTOS based cores (ESP32). It is not
+//       included by SparkFun_Toolkit.h, include it directly when needed.
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "sfeTkBusService.h"
+
+/**
+ * @brief A bus service that runs in its own std::thread.
+ *
+ * The thread sleeps until a request is submitted, then drains the request queues. Tasks that need to block
+ * on a result can use wait(), tasks that must not block poll sfeTkBusRequest::done() or use a callback.
+ *
+ * @tparam kDepth The depth of each priority queue - must be a power of two
+ * @tparam kPriorities The number of priority levels
+ */
+template <size_t kDepth = 8, uint8_t kPriorities = 2>
+class sfeTkBusServiceThread : public sfeTkBusService<kDepth, kPriorities>
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor
+
+        @param theBus The bus this service owns
+    */
+    sfeTkBusServiceThread(sfeTkIBus &theBus)
+        : sfeTkBusService<kDepth, kPriorities>(theBus), _running{false}, _signaled{false}
+    {
+        this->setNotify(wakeup, this);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Destructor - stops the service thread
+    */
+    ~sfeTkBusServiceThread()
+    {
+        stop();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Start the service thread
+
+        @retval sfeTkError_t kSTkErrOk on success, kSTkErrFail if already running
+    */
+    sfeTkError_t start(void)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_running)
+            return kSTkErrFail;
+
+        _running = true;
+        _thread = std::thread(&sfeTkBusServiceThread::run, this);
+        return kSTkErrOk;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Stop the service thread. Queued requests that were not executed remain pending.
+    */
+    void stop(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_running)
+                return;
+            _running = false;
+        }
+        _wakeup.notify_one();
+
+        if (_thread.joinable())
+            _thread.join();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Block the calling task until a request is done
+
+        @param request The request to wait on
+        @param timeoutMS The maximum time to wait in milliseconds
+
+        @retval sfeTkError_t The result of the request, or kSTkErrBusTimeout
+    */
+    sfeTkError_t wait(sfeTkBusRequest &request, uint32_t timeoutMS)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        if (!_completed.wait_for(lock, std::chrono::milliseconds(timeoutMS), [&request] { return request.done(); }))
+            return kSTkErrBusTimeout;
+
+        return request.result();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Submit a request and wait for it to complete
+
+        @param request The request to execute
+        @param timeoutMS The maximum time to wait in milliseconds
+
+        @retval sfeTkError_t The result of the request, kSTkErrBusQueueFull or kSTkErrBusTimeout
+    */
+    sfeTkError_t transact(sfeTkBusRequest &request, uint32_t timeoutMS)
+    {
+        sfeTkError_t retval = this->submit(request);
+        if (retval != kSTkErrOk)
+            return retval;
+
+        return wait(request, timeoutMS);
+    }
+
+  private:
+    static void wakeup(void *context)
+    {
+        sfeTkBusServiceThread *self = static_cast<sfeTkBusServiceThread *>(context);
+        {
+            // set under the lock, so a wakeup between the thread's check and its sleep is never lost
+            std::lock_guard<std::mutex> lock(self->_mutex);
+            self->_signaled = true;
+        }
+        self->_wakeup.notify_one();
+    }
+
+    void run(void)
+    {
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wakeup.wait(lock, [this] { return _signaled || !_running; });
+                if (!_running)
+                    return;
+                _signaled = false;
+            }
+
+            while (this->serviceOne())
+            {
+                // take the lock so a waiter can't miss the notify between its check and its sleep
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                }
+                _completed.notify_all();
+            }
+        }
+    }
+
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _wakeup;
+    std::condition_variable _completed;
+
+    bool _running;
+    bool _signaled;
+};
@@ -0,0 +1,228 @@
+// sfeTkBusWire.h
+//
+// Defines a model of the wire time of bus operations - the bits an operation puts on an I2C or SPI bus, with the
+// protocol overheads, and the time they take at a clock rate
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sfeTkBusHooks.h"
+#include "sfeTkTransaction.h"
+
+// The model follows the Arduino bus classes. On I2C, each byte is 9 clocks (8 bits and the acknowledge), and each
+// segment of a frame - the address byte and what follows it - starts with about one clock of start or repeated
+// start, with about one clock for the stop at the end of the frame:
+//
+//   register write    start, address, register, data, stop
+//   register read     start, address, register, stop, start, address, data, stop
+//
+// A read longer than the chunk size of the bus (sfeTkArdI2C::setBufferChunkSize(), 32 by default) is requested in
+// chunks, each a start and the address again. With stops off (sfeTkII2C::setStop(false)) the phases of a read are
+// joined by repeated starts, and the steps of a transaction always are - a transaction is one frame. On SPI, each
+// byte is 8 clocks - the register, then the data - with a configurable number of clocks for the chip select.
+//
+// The time of the bits is the minimum - the gaps a core leaves between bytes, and clock stretching, are not in the
+// model. Compare with a measurement of the bus to see how far a platform is from it.
+
+/**
+ * @brief The bus types of the wire model
+ */
+enum sfeTkBusWireType_t : uint8_t
+{
+    kSTkBusWireI2C = 0,
+    kSTkBusWireSPI
+};
+
+/**
+ * @brief The wire model of a bus - its type, clock rate and the settings that change the protocol overhead
+ */
+struct sfeTkBusWire
+{
+    /** The bus type */
+    sfeTkBusWireType_t type;
+
+    /** The bus clock in Hz */
+    uint32_t clock;
+
+    /** I2C - the most bytes read in one request; longer reads are split */
+    uint16_t chunk;
+
+    /** I2C - a stop ends each phase of a read, as with sfeTkII2C::stop() set (the default) */
+    bool stops;
+
+    /** SPI - the clocks of chip select setup and hold, for each operation */
+    uint16_t selectBits;
+
+    /**--------------------------------------------------------------------------
+        @brief The model of an I2C bus
+
+        @param clock The bus clock in Hz
+        @param chunk The chunk size of reads - see sfeTkArdI2C::setBufferChunkSize()
+        @param stops A stop ends each phase of a read - see sfeTkII2C::setStop()
+
+        @retval sfeTkBusWire The model
+    */
+    static sfeTkBusWire i2c(uint32_t clock, uint16_t chunk = 32, bool stops = true)
+    {
+        sfeTkBusWire wire = {kSTkBusWireI2C, clock, chunk, stops, 0};
+        return wire;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The model of an SPI bus
+
+        @param clock The bus clock in Hz
+        @param selectBits The clocks to add for the chip select of each operation
+
+        @retval sfeTkBusWire The model
+    */
+    static sfeTkBusWire spi(uint32_t clock, uint16_t selectBits = 0)
+    {
+        sfeTkBusWire wire = {kSTkBusWireSPI, clock, 0, false, selectBits};
+        return wire;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The bus clocks of a register operation, on its own or as part of a frame
+
+        @param bRead true for a read
+        @param regBytes The bytes of the register address - 0 for a write without a register
+        @param length The bytes of data
+        @param bStop Add the stop - false for a transaction step that is not the last
+        @param bJoined The phases of a read are joined by repeated starts - true for a transaction step
+
+        @retval uint32_t The clocks
+    */
+    uint32_t bits(bool bRead, uint8_t regBytes, size_t length, bool bStop = true, bool bJoined = false) const
+    {
+        if (type == kSTkBusWireSPI)
+            return selectBits + 8 * (uint32_t)(regBytes + length);
+
+        uint32_t clocks = bStop ? 1 : 0;
+        if (!bRead)
+            return clocks + 1 + 9 * (uint32_t)(1 + regBytes + length);
+
+        // the register write, then a request - the address again - for each chunk, with a stop between them
+        uint32_t phaseStop = stops && !bJoined ? 1 : 0;
+        clocks += 1 + 9 * (uint32_t)(1 + regBytes) + phaseStop;
+        size_t theChunk = chunk > 0 ? chunk : length;
+        while (true)
+        {
+            size_t nChunk = length > theChunk ? theChunk : length;
+            clocks += 1 + 9 * (uint32_t)(1 + nChunk);
+            length -= nChunk;
+            if (length == 0)
+                return clocks;
+            clocks += phaseStop;
+        }
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The bus clocks of a transaction step
+
+        @param step The step
+        @param bLast Is this the last step - the stop is sent after it
+        @param bJoined The step is part of a transaction frame - false for a step run as an operation of its own,
+        with its own start and stop
+
+        @retval uint32_t The clocks
+    */
+    uint32_t stepBits(const sfeTkTxnStep &step, bool bLast, bool bJoined = true) const
+    {
+        size_t length = step.nValue > 0 ? step.nValue : step.length;
+        bool bStop = bLast || !bJoined;
+        switch (step.op)
+        {
+        case kSTkBusOpWriteRegion:
+            return bits(false, 0, length, bStop, bJoined);
+        case kSTkBusOpWriteRegisterRegion:
+            return bits(false, 1, length, bStop, bJoined);
+        case kSTkBusOpWriteRegister16Region:
+            return bits(false, 2, length, bStop, bJoined);
+        case kSTkBusOpReadRegisterRegion:
+            return bits(true, 1, length, bStop, bJoined);
+        case kSTkBusOpReadRegister16Region:
+            return bits(true, 2, length, bStop, bJoined);
+        }
+        return 0;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The bus clocks of a bus operation, as a hook sees it
+
+        @param info The operation
+
+        @retval uint32_t The clocks
+    */
+    uint32_t hookBits(const sfeTkBusHookInfo &info) const
+    {
+        switch (info.op)
+        {
+        case kSTkBusHookWriteByte:
+        case kSTkBusHookWriteWord:
+        case kSTkBusHookWriteRegion:
+            return bits(false, 0, info.length);
+
+        case kSTkBusHookWriteRegisterByte:
+        case kSTkBusHookWriteRegisterWord:
+        case kSTkBusHookWriteRegisterRegion:
+            return bits(false, 1, info.length);
+
+        case kSTkBusHookWriteRegister16Region:
+            return bits(false, 2, info.length);
+
+        case kSTkBusHookReadRegisterByte:
+        case kSTkBusHookReadRegisterWord:
+        case kSTkBusHookReadRegisterRegion:
+            return bits(true, 1, info.length);
+
+        case kSTkBusHookReadRegister16Region:
+            return bits(true, 2, info.length);
+
+        case kSTkBusHookTransaction: {
+            uint32_t clocks = 0;
+            for (size_t i = 0; info.steps && i < info.length; i++)
+                clocks += stepBits(info.steps[i], i + 1 == info.length);
+            return clocks;
+        }
+        }
+        return 0;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The time of a number of bus clocks
+
+        @param clocks The bus clocks
+        @param rate The ticks a second of the time returned - 1000000 for microseconds
+
+        @retval uint32_t The time, in ticks of the rate
+    */
+    uint32_t time(uint32_t clocks, uint32_t rate = 1000000) const
+    {
+        return clock > 0 ? (uint32_t)(((uint64_t)clocks * rate + clock / 2) / clock) : 0;
+    }
+};
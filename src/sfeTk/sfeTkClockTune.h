@@ -0,0 +1,354 @@
+// sfeTkClockTune.h
+//
+// Defines the I2C clock tuner - finds the fastest clock a device reads reliably at, on the board it is wired to
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sfeTkIBus.h"
+
+// The tuner steps the clock up through a list of clocks, reading a register of known value (a WHO_AM_I or chip id)
+// many times at each. A read that fails, or returns another value, is an error. The first clock with more errors
+// than allowed ends the steps - faster clocks are not tried. The clock selected is the fastest step at or below
+// the fastest reliable clock less the safety margin, and it is read at again before it is returned.
+//
+// No errors in n reads says the error rate is under about 3 / n (95% confidence) - 1000 reads, under 0.3%. A
+// marginal clock fails a byte now and then, so use more reads for a device that is read often.
+//
+// The clock is a setting of the port, so devices that share a bus run at the slowest clock tuned for them - see
+// sfeTkClockTuneSlowest(). Tune each device with the others idle. Keep the record (sfeTkClockTuneRecord) in
+// EEPROM or flash, and tune again when it is not valid for the device.
+//
+// The tuner is not part of SparkFun_Toolkit.h - a sketch that tunes includes <sfeTk/sfeTkClockTune.h>.
+
+/**
+ * @brief The clocks the tuner steps through by default, in Hz - standard mode to fast mode plus
+ */
+const uint32_t kSTkClockTuneSteps[] = {100000, 200000, 400000, 600000, 800000, 1000000};
+
+/**
+ * @brief The number of default clocks
+ */
+const size_t kSTkClockTuneNSteps = sizeof(kSTkClockTuneSteps) / sizeof(kSTkClockTuneSteps[0]);
+
+/**
+ * @brief The record of a tuning - the clock for a device, kept in EEPROM or flash
+ *
+ * @code
+ *     sfeTkClockTuneRecord record;
+ *     EEPROM.get(kTuneAddress, record);
+ *     if (!record.valid(myBus.address(), kRegWhoAmI, kWhoAmI))
+ *     {
+ *         sfeTkClockTuner<> tuner;
+ *         if (tuner.tune(myBus, kRegWhoAmI, kWhoAmI, record) == kSTkErrOk)
+ *             EEPROM.put(kTuneAddress, record);
+ *     }
+ *     myBus.setClock(record.clock);
+ * @endcode
+ */
+struct sfeTkClockTuneRecord
+{
+    /** Marks a record - and its layout */
+    static const uint16_t kMagic = 0x5443;
+
+    uint16_t magic;
+
+    /** The device - the I2C address, and the register and value read */
+    uint8_t address;
+    uint8_t idReg;
+    uint8_t idValue;
+
+    /** The safety margin used, in percent */
+    uint8_t margin;
+
+    /** The clock selected, in Hz */
+    uint32_t clock;
+
+    /** The fastest clock with no more errors than allowed, in Hz */
+    uint32_t fastest;
+
+    /** The checksum of the fields above */
+    uint16_t check;
+
+    /**--------------------------------------------------------------------------
+        @brief Set the magic and the checksum - after the fields are set
+    */
+    void seal(void)
+    {
+        magic = kMagic;
+        check = checksum();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Is the record a tuning of the device?
+
+        @param theAddress The I2C address of the device
+        @param theReg The register read
+        @param theValue The value of the register
+
+        @retval bool true if the record is sealed, unchanged, and for the device
+    */
+    bool valid(uint8_t theAddress, uint8_t theReg, uint8_t theValue) const
+    {
+        return magic == kMagic && check == checksum() && address == theAddress && idReg == theReg &&
+               idValue == theValue && clock > 0;
+    }
+
+    // Fletcher-16 of the fields before the checksum - erased flash (all 0xFF) or zeroed EEPROM is not valid
+    uint16_t checksum(void) const
+    {
+        uint8_t bytes[] = {(uint8_t)magic,         (uint8_t)(magic >> 8),    address,
+                           idReg,                  idValue,                  margin,
+                           (uint8_t)clock,         (uint8_t)(clock >> 8),    (uint8_t)(clock >> 16),
+                           (uint8_t)(clock >> 24), (uint8_t)fastest,         (uint8_t)(fastest >> 8),
+                           (uint8_t)(fastest >> 16), (uint8_t)(fastest >> 24)};
+        uint16_t sum1 = 0, sum2 = 0;
+        for (size_t i = 0; i < sizeof(bytes); i++)
+        {
+            sum1 = (uint16_t)((sum1 + bytes[i]) % 255);
+            sum2 = (uint16_t)((sum2 + sum1) % 255);
+        }
+        return (uint16_t)((sum2 << 8) | sum1);
+    }
+};
+
+/**
+ * @brief The clock for devices that share a bus - the slowest of their records
+ *
+ * @param records The records of the devices on the bus
+ * @param nRecords The number of records
+ *
+ * @retval uint32_t The clock in Hz - 0 if there are no records
+ */
+inline uint32_t sfeTkClockTuneSlowest(const sfeTkClockTuneRecord *records, size_t nRecords)
+{
+    uint32_t clock = 0;
+    for (size_t i = 0; i < nRecords; i++)
+    {
+        if (clock == 0 || records[i].clock < clock)
+            clock = records[i].clock;
+    }
+    return clock;
+}
+
+/**
+ * @brief Steps the I2C clock up to find the fastest a device reads reliably at
+ *
+ * The bus class is a sfeTkArdI2C, or any class with sfeTkError_t setClock(uint32_t), uint8_t address() and
+ * sfeTkError_t readRegisterByte(uint8_t, uint8_t &).
+ *
+ * @tparam kMaxSteps The most clocks in the list of the tuner
+ */
+template <size_t kMaxSteps = 8> class sfeTkClockTuner
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor
+
+        @param clocks The clocks to step through, slowest first - the list is kept, so make it static
+        @param nClocks The number of clocks - at most kMaxSteps are used
+    */
+    sfeTkClockTuner(const uint32_t *clocks = kSTkClockTuneSteps, size_t nClocks = kSTkClockTuneNSteps)
+        : _clocks{clocks}, _nClocks{nClocks < kMaxSteps ? nClocks : kMaxSteps}, _nReads{1000}, _maxErrors{0},
+          _margin{20}, _nTried{0}, _confirmErrors{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the reads at each clock
+
+        @param nReads The reads of the known register at each clock
+        @param maxErrors The most errors allowed in the reads for the clock to be reliable
+    */
+    void setReads(uint32_t nReads, uint32_t maxErrors = 0)
+    {
+        _nReads = nReads > 0 ? nReads : 1;
+        _maxErrors = maxErrors;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the safety margin
+
+        @param percent How far under the fastest reliable clock the clock selected is
+    */
+    void setMargin(uint8_t percent)
+    {
+        _margin = percent < 100 ? percent : 99;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Tune the clock of a device. The clock is left at the clock selected, or the slowest clock if the
+        device is not reliable at it.
+
+        @param bus The bus of the device
+        @param idReg A register of known value
+        @param idValue The value of the register
+        @param[out] record The tuning, sealed - the clock selected and the fastest reliable clock
+
+        @retval sfeTkError_t kSTkErrOk, kSTkErrBusUnreliable if the device is not reliable at the slowest clock,
+        or the error of setting the clock
+    */
+    template <typename Bus> sfeTkError_t tune(Bus &bus, uint8_t idReg, uint8_t idValue, sfeTkClockTuneRecord &record)
+    {
+        record.address = bus.address();
+        record.idReg = idReg;
+        record.idValue = idValue;
+        record.margin = _margin;
+        record.clock = 0;
+        record.fastest = 0;
+        record.magic = 0;
+        record.check = 0;
+        _nTried = 0;
+        _confirmErrors = 0;
+
+        // step up until a clock fails
+        size_t nReliable = 0;
+        for (size_t i = 0; i < _nClocks; i++)
+        {
+            sfeTkError_t retval = bus.setClock(_clocks[i]);
+            if (retval != kSTkErrOk)
+                return retval;
+
+            _errors[i] = run(bus, idReg, idValue, _reads[i]);
+            _nTried = i + 1;
+            if (_errors[i] > _maxErrors)
+                break;
+            nReliable = i + 1;
+        }
+
+        if (nReliable == 0)
+        {
+            bus.setClock(_clocks[0]);
+            return kSTkErrBusUnreliable;
+        }
+        record.fastest = _clocks[nReliable - 1];
+
+        // the fastest step within the margin, then read at it again - down a step at a time if it fails
+        uint32_t limit = (uint32_t)((uint64_t)record.fastest * (100 - _margin) / 100);
+        size_t selected = 0;
+        for (size_t i = 0; i < nReliable; i++)
+        {
+            if (_clocks[i] <= limit)
+                selected = i;
+        }
+        for (size_t i = selected + 1; i-- > 0;)
+        {
+            bus.setClock(_clocks[i]);
+            uint32_t nReads;
+            _confirmErrors = run(bus, idReg, idValue, nReads);
+            if (_confirmErrors <= _maxErrors)
+            {
+                record.clock = _clocks[i];
+                record.seal();
+                return kSTkErrOk;
+            }
+        }
+        return kSTkErrBusUnreliable;
+    }
+
+    /** The number of clocks of the last tuning that were read at */
+    size_t tried(void) const
+    {
+        return _nTried;
+    }
+
+    /** A clock of the list */
+    uint32_t clock(size_t step) const
+    {
+        return step < _nClocks ? _clocks[step] : 0;
+    }
+
+    /** The errors at a clock in the last tuning - valid for steps up to tried() */
+    uint32_t errors(size_t step) const
+    {
+        return step < _nTried ? _errors[step] : 0;
+    }
+
+    /** The reads at a clock in the last tuning - fewer than set when the clock failed */
+    uint32_t reads(size_t step) const
+    {
+        return step < _nTried ? _reads[step] : 0;
+    }
+
+    /** The errors when the clock selected was read at again */
+    uint32_t confirmErrors(void) const
+    {
+        return _confirmErrors;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Print the last tuning - the errors at each clock, and the clock selected
+
+        @param out Where to print - a class with println(const char *), such as Serial
+        @param record The record of the tuning
+    */
+    template <typename Out> void report(Out &out, const sfeTkClockTuneRecord &record) const
+    {
+        char line[96];
+        snprintf(line, sizeof(line), "Clock tuning: device 0x%02X, register 0x%02X = 0x%02X, %lu reads a clock",
+                 record.address, record.idReg, record.idValue, (unsigned long)_nReads);
+        out.println(line);
+        for (size_t i = 0; i < _nTried; i++)
+        {
+            snprintf(line, sizeof(line), "  %7lu kHz %5lu errors in %7lu reads  %s", (unsigned long)(_clocks[i] / 1000),
+                     (unsigned long)_errors[i], (unsigned long)_reads[i], _errors[i] > _maxErrors ? "FAIL" : "ok");
+            out.println(line);
+        }
+        if (record.clock == 0)
+            snprintf(line, sizeof(line), "  not reliable at %lu kHz", (unsigned long)(_clocks[0] / 1000));
+        else
+            snprintf(line, sizeof(line), "  fastest reliable %lu kHz, selected %lu kHz with a %u%% margin",
+                     (unsigned long)(record.fastest / 1000), (unsigned long)(record.clock / 1000), record.margin);
+        out.println(line);
+    }
+
+  private:
+    // the errors in the reads at the current clock - stops when over the limit
+    template <typename Bus> uint32_t run(Bus &bus, uint8_t idReg, uint8_t idValue, uint32_t &nReads)
+    {
+        uint32_t nErrors = 0;
+        for (nReads = 0; nReads < _nReads && nErrors <= _maxErrors; nReads++)
+        {
+            uint8_t value = 0;
+            if (bus.readRegisterByte(idReg, value) != kSTkErrOk || value != idValue)
+                nErrors++;
+        }
+        return nErrors;
+    }
+
+    const uint32_t *_clocks;
+    size_t _nClocks;
+    uint32_t _nReads;
+    uint32_t _maxErrors;
+    uint8_t _margin;
+
+    uint32_t _errors[kMaxSteps];
+    uint32_t _reads[kMaxSteps];
+    size_t _nTried;
+    uint32_t _confirmErrors;
+};
@@ -0,0 +1,69 @@
+// sfeTkConfig.h
+//
+// Compile time configuration - the operation families built into the bus classes - for the SparkFun Electronics
+// Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+// The bus interface is virtual, so every method of an implementation is referenced by its vtable and linked in,
+// even if no driver calls it. The operation families below can be compiled out of sfeTkIBus and all of its
+// implementations to save flash (and, for async, RAM in each bus object).
+//
+// Set these for the whole build - the library sources must see the same values as the sketch. For example:
+//    arduino-cli: --build-property "compiler.cpp.extra_flags=-DSFE_TK_ENABLE_WORD_OPS=0"
+//    PlatformIO:  build_flags = -DSFE_TK_ENABLE_WORD_OPS=0
+//
+// A driver that uses a disabled operation fails to compile, rather than failing at run time.
+
+/**
+ * @brief 16 bit register addresses - writeRegister16Region(), readRegister16Region() and the 16 bit async read
+ */
+#ifndef SFE_TK_ENABLE_16BIT_REGISTERS
+#define SFE_TK_ENABLE_16BIT_REGISTERS 1
+#endif
+
+/**
+ * @brief Word operations - writeWord(), writeRegisterWord() and readRegisterWord()
+ */
+#ifndef SFE_TK_ENABLE_WORD_OPS
+#define SFE_TK_ENABLE_WORD_OPS 1
+#endif
+
+/**
+ * @brief Asynchronous transfers on the Arduino bus classes - the backend pointer and the Async read methods
+ */
+#ifndef SFE_TK_ENABLE_ASYNC
+#define SFE_TK_ENABLE_ASYNC 1
+#endif
+
+/**
+ * @brief Transactions - sfeTkIBus::transaction() and the fused transaction of the Arduino bus classes.
+ *
+ * Off by default - the virtual executeSteps() is linked into every bus, so only a build that uses transactions
+ * pays for it. Set to 1 to enable.
+ */
+#ifndef SFE_TK_ENABLE_TRANSACTIONS
+#define SFE_TK_ENABLE_TRANSACTIONS 0
+#endif
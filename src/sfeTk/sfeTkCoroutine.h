@@ -0,0 +1,625 @@
+// sfeTkCoroutine.h
+//
+// Defines C++20 coroutine support - tasks, an executor and awaitable bus operations - for the SparkFun
+// Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+// Note: This file requires a C++20 compiler with coroutine support. It is not included by SparkFun_Toolkit.h,
+//       include it directly when needed.
+
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <new>
+#include <string.h>
+
+#include "sfeTkBusService.h"
+
+// The coroutine frame pool - frames up to this size come from static memory. Frames hold pointers, so the
+// default scales with the pointer size (512 bytes on 32 bit targets).
+#ifndef SFE_TK_CO_FRAME_SIZE
+#define SFE_TK_CO_FRAME_SIZE (128 * sizeof(void *))
+#endif
+
+// The number of frames in the pool
+#ifndef SFE_TK_CO_FRAME_COUNT
+#define SFE_TK_CO_FRAME_COUNT 8
+#endif
+
+/**
+ * @brief A static pool for coroutine frames.
+ *
+ * Frames that fit in a pool block are allocated from static memory with O(1) alloc and free. Larger frames, or
+ * frames allocated when the pool is empty, fall back to the heap and are counted, so an application can size the
+ * pool until nHeapFrames() stays zero.
+ *
+ * @note The pool is not thread safe - coroutines are created and destroyed by the executor's task.
+ */
+class sfeTkCoFramePool
+{
+  public:
+    static constexpr size_t kBlockSize = SFE_TK_CO_FRAME_SIZE;
+    static constexpr size_t kBlockCount = SFE_TK_CO_FRAME_COUNT;
+
+    static void *allocate(size_t size)
+    {
+        if (size <= kBlockSize && _free)
+        {
+            Block *block = _free;
+            _free = block->next;
+            if (++_nInUse > _highWater)
+                _highWater = _nInUse;
+            return block;
+        }
+        _nHeapFrames++;
+        return ::operator new(size);
+    }
+
+    static void release(void *ptr)
+    {
+        Block *block = static_cast<Block *>(ptr);
+        if (block >= _blocks && block < _blocks + kBlockCount)
+        {
+            block->next = _free;
+            _free = block;
+            _nInUse--;
+            return;
+        }
+        ::operator delete(ptr);
+    }
+
+    /** The number of pool blocks in use */
+    static size_t nInUse(void)
+    {
+        return _nInUse;
+    }
+
+    /** The maximum number of pool blocks in use at once */
+    static size_t highWater(void)
+    {
+        return _highWater;
+    }
+
+    /** The number of frames that were allocated from the heap */
+    static size_t nHeapFrames(void)
+    {
+        return _nHeapFrames;
+    }
+
+  private:
+    union Block {
+        Block *next;
+        alignas(max_align_t) unsigned char storage[kBlockSize];
+    };
+
+    static Block *initFreeList(void)
+    {
+        for (size_t i = 0; i < kBlockCount - 1; i++)
+            _blocks[i].next = &_blocks[i + 1];
+        _blocks[kBlockCount - 1].next = nullptr;
+        return _blocks;
+    }
+
+    static inline Block _blocks[kBlockCount];
+    static inline Block *_free = initFreeList();
+    static inline size_t _nInUse = 0;
+    static inline size_t _highWater = 0;
+    static inline size_t _nHeapFrames = 0;
+};
+
+class sfeTkCoExecutor;
+
+/**
+ * @brief A wait record - links a suspended coroutine into one of the executor lists.
+ *
+ * Wait records live in the awaiter, which lives in the suspended coroutine's frame, so the executor never allocates.
+ */
+struct sfeTkCoWait
+{
+    sfeTkCoWait *next = nullptr;
+    std::coroutine_handle<> handle;
+    uint32_t deadline = 0;
+    const sfeTkBusRequest *request = nullptr;
+};
+
+/**
+ * @brief The return type of a toolkit coroutine. The coroutine result is an sfeTkError_t.
+ *
+ * A task starts suspended. Pass it to sfeTkCoExecutor::spawn() to run it as a top level task, or co_await it from
+ * another task to run it as a sub-operation.
+ */
+class sfeTkCoTask
+{
+  public:
+    struct promise_type
+    {
+        sfeTkError_t result = kSTkErrOk;
+        std::coroutine_handle<> continuation;
+        sfeTkError_t *resultOut = nullptr;
+        sfeTkCoExecutor *executor = nullptr;
+
+        // used to queue the task when it is started by the executor
+        sfeTkCoWait startWait;
+
+        static void *operator new(size_t size)
+        {
+            return sfeTkCoFramePool::allocate(size);
+        }
+
+        static void operator delete(void *ptr)
+        {
+            sfeTkCoFramePool::release(ptr);
+        }
+
+        sfeTkCoTask get_return_object()
+        {
+            return sfeTkCoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept;
+            void await_resume() noexcept
+            {
+            }
+        };
+
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_value(sfeTkError_t value)
+        {
+            result = value;
+        }
+
+        void unhandled_exception()
+        {
+            result = kSTkErrFail;
+        }
+    };
+
+    sfeTkCoTask(sfeTkCoTask &&rhs) : _handle{rhs._handle}
+    {
+        rhs._handle = nullptr;
+    }
+
+    sfeTkCoTask(const sfeTkCoTask &) = delete;
+    sfeTkCoTask &operator=(const sfeTkCoTask &) = delete;
+
+    ~sfeTkCoTask()
+    {
+        if (_handle)
+            _handle.destroy();
+    }
+
+    // Awaiting a task runs it as a sub-operation, the awaiting coroutine resumes when it completes.
+    bool await_ready() noexcept
+    {
+        return !_handle || _handle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        _handle.promise().continuation = awaiting;
+        return _handle;
+    }
+
+    sfeTkError_t await_resume() noexcept
+    {
+        return _handle ? _handle.promise().result : kSTkErrFail;
+    }
+
+  private:
+    friend class sfeTkCoExecutor;
+
+    explicit sfeTkCoTask(std::coroutine_handle<promise_type> handle) : _handle{handle}
+    {
+    }
+
+    std::coroutine_handle<promise_type> _handle;
+};
+
+/**
+ * @brief A small, single threaded coroutine executor.
+ *
+ * The executor resumes coroutines when their timed waits expire or their bus requests complete. Call runOnce()
+ * from the application loop (or a task). Ready coroutines are resumed in FIFO order, timers in deadline order
+ * (ties in the order the waits started), so the resume order is deterministic.
+ *
+ * The executor uses a caller supplied time source, typically millis() or micros(). Delays are in its units.
+ */
+class sfeTkCoExecutor
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor
+
+        @param now The time source for timed waits
+    */
+    sfeTkCoExecutor(uint32_t (*now)(void)) : _now{now}, _nActive{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Start a task. The executor owns the task from here, the frame is released when it completes.
+
+        @param task The task to run
+        @param result Optional - set to the task result when it completes
+
+        @retval sfeTkError_t kSTkErrOk on success
+    */
+    sfeTkError_t spawn(sfeTkCoTask &&task, sfeTkError_t *result = nullptr)
+    {
+        if (!task._handle)
+            return kSTkErrFail;
+
+        std::coroutine_handle<sfeTkCoTask::promise_type> handle = task._handle;
+        task._handle = nullptr;
+
+        handle.promise().executor = this;
+        handle.promise().resultOut = result;
+        if (result)
+            *result = kSTkErrBusPending;
+
+        _nActive++;
+        handle.promise().startWait.handle = handle;
+        ready(handle.promise().startWait);
+        return kSTkErrOk;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Run all coroutines that are ready - expired timers, completed bus requests and started tasks
+
+        @retval size_t The number of coroutines resumed
+    */
+    size_t runOnce(void)
+    {
+        size_t nResumed = 0;
+        uint32_t now = _now();
+
+        while (_timers && (int32_t)(now - _timers->deadline) >= 0)
+        {
+            sfeTkCoWait *wait = _timers;
+            _timers = wait->next;
+            ready(*wait);
+        }
+
+        sfeTkCoWait **link = &_busWaits;
+        while (*link)
+        {
+            sfeTkCoWait *wait = *link;
+            if (wait->request->done())
+            {
+                *link = wait->next;
+                ready(*wait);
+            }
+            else
+                link = &wait->next;
+        }
+
+        // only run what is ready now - coroutines made ready while running wait for the next pass
+        sfeTkCoWait *tail = _readyTail;
+        while (_ready)
+        {
+            sfeTkCoWait *wait = _ready;
+            _ready = wait->next;
+            if (!_ready)
+                _readyTail = nullptr;
+
+            wait->handle.resume();
+            nResumed++;
+
+            if (wait == tail)
+                break;
+        }
+        return nResumed;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The number of top level tasks that have not completed
+
+        @retval size_t Active task count
+    */
+    size_t nActive(void) const
+    {
+        return _nActive;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The current time from the executor time source
+    */
+    uint32_t now(void) const
+    {
+        return _now();
+    }
+
+    /**
+     * @brief Awaiter for a timed wait. Returned by delay().
+     */
+    struct DelayAwaiter
+    {
+        sfeTkCoExecutor &executor;
+        uint32_t duration;
+        sfeTkCoWait wait;
+
+        bool await_ready() noexcept
+        {
+            return duration == 0;
+        }
+        void await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            wait.handle = handle;
+            wait.deadline = executor.now() + duration;
+            executor.addTimer(wait);
+        }
+        void await_resume() noexcept
+        {
+        }
+    };
+
+    /**--------------------------------------------------------------------------
+        @brief A timed wait - co_await executor.delay(10) suspends the coroutine for 10 time units
+
+        @param duration The time to wait, in units of the executor time source
+    */
+    DelayAwaiter delay(uint32_t duration)
+    {
+        return DelayAwaiter{*this, duration, {}};
+    }
+
+    // Used by the awaiters
+    void addTimer(sfeTkCoWait &wait)
+    {
+        sfeTkCoWait **link = &_timers;
+        while (*link && (int32_t)(wait.deadline - (*link)->deadline) >= 0)
+            link = &(*link)->next;
+        wait.next = *link;
+        *link = &wait;
+    }
+
+    void addBusWait(sfeTkCoWait &wait)
+    {
+        wait.next = _busWaits;
+        _busWaits = &wait;
+    }
+
+  private:
+    friend struct sfeTkCoTask::promise_type::FinalAwaiter;
+
+    void ready(sfeTkCoWait &wait)
+    {
+        wait.next = nullptr;
+        if (_readyTail)
+            _readyTail->next = &wait;
+        else
+            _ready = &wait;
+        _readyTail = &wait;
+    }
+
+    void completed(void)
+    {
+        _nActive--;
+    }
+
+    uint32_t (*_now)(void);
+    size_t _nActive;
+
+    sfeTkCoWait *_ready = nullptr;
+    sfeTkCoWait *_readyTail = nullptr;
+    sfeTkCoWait *_timers = nullptr;
+    sfeTkCoWait *_busWaits = nullptr;
+};
+
+inline std::coroutine_handle<> sfeTkCoTask::promise_type::FinalAwaiter::await_suspend(
+    std::coroutine_handle<promise_type> handle) noexcept
+{
+    promise_type &promise = handle.promise();
+
+    // a sub-operation - continue the awaiting coroutine, which owns (and destroys) this frame
+    if (promise.continuation)
+        return promise.continuation;
+
+    // a top level task - report the result and release the frame
+    if (promise.resultOut)
+        *promise.resultOut = promise.result;
+    if (promise.executor)
+        promise.executor->completed();
+
+    handle.destroy();
+    return std::noop_coroutine();
+}
+
+/**
+ * @brief Awaitable bus operations. The operations are submitted to a bus service, and the coroutine is
+ *        resumed by the executor when the request is done.
+ *
+ * The service is run by its own task (sfeTkBusServiceThread, an RTOS task), or inline - by calling the
+ * service's serviceAll() in the same loop as the executor's runOnce().
+ *
+ * @tparam Service The bus service type - sfeTkBusService or a derived class
+ */
+template <typename Service> class sfeTkCoBus
+{
+  public:
+    sfeTkCoBus(Service &service, sfeTkCoExecutor &executor, uint8_t priority = 0)
+        : _service{service}, _executor{executor}, _priority{priority}
+    {
+    }
+
+    /**
+     * @brief Awaiter for a bus request. The request lives in the awaiter - in the coroutine frame.
+     */
+    struct RequestAwaiter
+    {
+        sfeTkCoBus &bus;
+        sfeTkBusRequest request;
+        sfeTkCoWait wait;
+        uint8_t scratch[2];
+        void *out;
+        size_t *readBytes;
+
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            // byte and word operations use the scratch buffer - set here, once the awaiter is in its final place
+            if (!request.data)
+                request.data = scratch;
+
+            // a full queue completes the request right away with the error
+            if (bus._service.submit(request) != kSTkErrOk)
+                return false;
+
+            wait.handle = handle;
+            wait.request = &request;
+            bus._executor.addBusWait(wait);
+            return true;
+        }
+
+        sfeTkError_t await_resume() noexcept
+        {
+            sfeTkError_t status = request.result();
+            if (readBytes)
+                *readBytes = request.transferred;
+
+            if (status != kSTkErrOk || !out)
+                return status;
+
+            if (request.transferred != request.length)
+                return kSTkErrBusUnderRead;
+
+            if (request.length == sizeof(uint8_t))
+                *static_cast<uint8_t *>(out) = scratch[0];
+            else
+                memcpy(out, scratch, sizeof(uint16_t));
+
+            return kSTkErrOk;
+        }
+    };
+
+    RequestAwaiter writeByte(uint8_t data)
+    {
+        RequestAwaiter awaiter = make(kSTkBusOpWriteRegion, 0, nullptr, sizeof(uint8_t));
+        awaiter.scratch[0] = data;
+        return awaiter;
+    }
+
+    RequestAwaiter writeWord(uint16_t data)
+    {
+        RequestAwaiter awaiter = make(kSTkBusOpWriteRegion, 0, nullptr, sizeof(uint16_t));
+        memcpy(awaiter.scratch, &data, sizeof(uint16_t));
+        return awaiter;
+    }
+
+    RequestAwaiter writeRegion(const uint8_t *data, size_t length)
+    {
+        return make(kSTkBusOpWriteRegion, 0, const_cast<uint8_t *>(data), length);
+    }
+
+    RequestAwaiter writeRegisterByte(uint8_t devReg, uint8_t data)
+    {
+        RequestAwaiter awaiter = make(kSTkBusOpWriteRegisterRegion, devReg, nullptr, sizeof(uint8_t));
+        awaiter.scratch[0] = data;
+        return awaiter;
+    }
+
+    RequestAwaiter writeRegisterWord(uint8_t devReg, uint16_t data)
+    {
+        RequestAwaiter awaiter = make(kSTkBusOpWriteRegisterRegion, devReg, nullptr, sizeof(uint16_t));
+        memcpy(awaiter.scratch, &data, sizeof(uint16_t));
+        return awaiter;
+    }
+
+    RequestAwaiter writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
+    {
+        return make(kSTkBusOpWriteRegisterRegion, devReg, const_cast<uint8_t *>(data), length);
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    RequestAwaiter writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
+    {
+        return make(kSTkBusOpWriteRegister16Region, devReg, const_cast<uint8_t *>(data), length);
+    }
+#endif
+
+    RequestAwaiter readRegisterByte(uint8_t devReg, uint8_t &data)
+    {
+        RequestAwaiter awaiter = make(kSTkBusOpReadRegisterRegion, devReg, nullptr, sizeof(uint8_t));
+        awaiter.out = &data;
+        return awaiter;
+    }
+
+    RequestAwaiter readRegisterWord(uint8_t devReg, uint16_t &data)
+    {
+        RequestAwaiter awaiter = make(kSTkBusOpReadRegisterRegion, devReg, nullptr, sizeof(uint16_t));
+        awaiter.out = &data;
+        return awaiter;
+    }
+
+    RequestAwaiter readRegisterRegion(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        RequestAwaiter awaiter = make(kSTkBusOpReadRegisterRegion, devReg, data, numBytes);
+        awaiter.readBytes = &readBytes;
+        return awaiter;
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    RequestAwaiter readRegister16Region(uint16_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        RequestAwaiter awaiter = make(kSTkBusOpReadRegister16Region, devReg, data, numBytes);
+        awaiter.readBytes = &readBytes;
+        return awaiter;
+    }
+#endif
+
+  private:
+    RequestAwaiter make(sfeTkBusOp_t op, uint16_t devReg, uint8_t *data, size_t length)
+    {
+        RequestAwaiter awaiter{*this, {}, {}, {0, 0}, nullptr, nullptr};
+        awaiter.request.set(op, devReg, data, length, _priority);
+        return awaiter;
+    }
+
+    Service &_service;
+    sfeTkCoExecutor &_executor;
+    uint8_t _priority;
+};
+
+#endif
@@ -62,3 +62,8 @@ const sfeTkError_t kSTkErrOk = 0; // success
  * @brief A base value for bus errors. All bus errors are greater than this value, in the 1000 range
  */
 const sfeTkError_t kSTkErrBaseBus = 0x1000;
+
+/**
+ * @brief A base value for register map errors, in the 2000 range. See sfeTkRegister.h
+ */
+const sfeTkError_t kSTkErrBaseRegister = 0x2000;
@@ -0,0 +1,216 @@
+// sfeTkFlatMap.h
+//
+// Defines a small, fixed capacity sorted map - no heap - for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A small map with a fixed capacity, stored in the object - no heap, no exceptions.
+ *
+ * Keys are kept sorted in their own array, so a lookup is a binary search over contiguous keys (typically
+ * register addresses), and values are only touched on a hit. Insert and erase move the following entries, which
+ * is cheap at the sizes this is meant for (tens of entries).
+ *
+ * @tparam K The key type - must support < and ==
+ * @tparam V The value type - default constructible and copyable
+ * @tparam kCapacity The maximum number of entries
+ */
+template <typename K, typename V, size_t kCapacity> class sfeTkFlatMap
+{
+    static_assert(kCapacity > 0, "sfeTkFlatMap capacity must be > 0");
+
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - an empty map
+    */
+    sfeTkFlatMap() : _size{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the value for a key - adds the key if not present
+
+        @param key The key
+        @param value The value
+
+        @retval bool true on success, false if the key is new and the map is full
+    */
+    bool set(const K &key, const V &value)
+    {
+        size_t index = lowerBound(key);
+        if (index < _size && _keys[index] == key)
+        {
+            _values[index] = value;
+            return true;
+        }
+
+        if (_size >= kCapacity)
+            return false;
+
+        for (size_t i = _size; i > index; i--)
+        {
+            _keys[i] = _keys[i - 1];
+            _values[i] = _values[i - 1];
+        }
+        _keys[index] = key;
+        _values[index] = value;
+        _size++;
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Find the value for a key
+
+        @param key The key
+
+        @retval V* The value, nullptr if the key is not in the map
+    */
+    V *find(const K &key)
+    {
+        size_t index = lowerBound(key);
+        return index < _size && _keys[index] == key ? &_values[index] : nullptr;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Find the value for a key
+
+        @param key The key
+
+        @retval const V* The value, nullptr if the key is not in the map
+    */
+    const V *find(const K &key) const
+    {
+        size_t index = lowerBound(key);
+        return index < _size && _keys[index] == key ? &_values[index] : nullptr;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Is the key in the map?
+
+        @param key The key
+
+        @retval bool true if present
+    */
+    bool contains(const K &key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Remove a key
+
+        @param key The key
+
+        @retval bool true if the key was removed, false if not present
+    */
+    bool erase(const K &key)
+    {
+        size_t index = lowerBound(key);
+        if (index >= _size || !(_keys[index] == key))
+            return false;
+
+        for (size_t i = index + 1; i < _size; i++)
+        {
+            _keys[i - 1] = _keys[i];
+            _values[i - 1] = _values[i];
+        }
+        _size--;
+        return true;
+    }
+
+    /** The key of an entry, in key order - the index is not checked */
+    const K &keyAt(size_t index) const
+    {
+        return _keys[index];
+    }
+
+    /** The value of an entry, in key order - the index is not checked */
+    V &valueAt(size_t index)
+    {
+        return _values[index];
+    }
+
+    /** The value of an entry, in key order - the index is not checked */
+    const V &valueAt(size_t index) const
+    {
+        return _values[index];
+    }
+
+    /** Remove all entries */
+    void clear(void)
+    {
+        _size = 0;
+    }
+
+    /** The number of entries */
+    size_t size(void) const
+    {
+        return _size;
+    }
+
+    /** Is the map empty? */
+    bool empty(void) const
+    {
+        return _size == 0;
+    }
+
+    /** Is the map full? */
+    bool full(void) const
+    {
+        return _size == kCapacity;
+    }
+
+    /** The maximum number of entries */
+    static constexpr size_t capacity(void)
+    {
+        return kCapacity;
+    }
+
+  private:
+    // the index of the first key not less than key. The loop has no data dependent branch - the compare
+    // becomes a conditional move, which keeps lookups of random keys fast.
+    size_t lowerBound(const K &key) const
+    {
+        if (_size == 0)
+            return 0;
+
+        const K *base = _keys;
+        size_t n = _size;
+        while (n > 1)
+        {
+            size_t half = n / 2;
+            base = base[half] < key ? base + half : base;
+            n -= half;
+        }
+        return (size_t)(base - _keys) + (*base < key ? 1 : 0);
+    }
+
+    K _keys[kCapacity];
+    V _values[kCapacity];
+    size_t _size;
+};
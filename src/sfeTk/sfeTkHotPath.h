@@ -0,0 +1,72 @@
+// sfeTkHotPath.h
+//
+// Defines the hot path scope marker used to verify bus operations don't allocate, for the SparkFun Electronics
+// Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+/**
+ * @brief Marks a function as a hot path - a bus operation that must not allocate memory.
+ *
+ * Place SFE_TK_HOT_PATH(); at the top of the function. In normal builds it expands to nothing. When
+ * SFE_TK_HOT_PATH_CHECK is defined (the host test harness), it declares a scope object that calls
+ * sfeTkHotPathEnter()/sfeTkHotPathLeave(), which the harness implements to flag any allocation made while a
+ * hot path is running.
+ */
+#if defined(SFE_TK_HOT_PATH_CHECK)
+
+/** Called on entry to a hot path scope - implemented by the test harness */
+void sfeTkHotPathEnter(const char *name);
+
+/** Called on exit from a hot path scope - implemented by the test harness */
+void sfeTkHotPathLeave(void);
+
+/**
+ * @brief The scope object declared by SFE_TK_HOT_PATH() in check builds
+ */
+class sfeTkHotPathScope
+{
+  public:
+    sfeTkHotPathScope(const char *name)
+    {
+        sfeTkHotPathEnter(name);
+    }
+
+    ~sfeTkHotPathScope()
+    {
+        sfeTkHotPathLeave();
+    }
+
+    sfeTkHotPathScope(const sfeTkHotPathScope &) = delete;
+    sfeTkHotPathScope &operator=(const sfeTkHotPathScope &) = delete;
+};
+
+#define SFE_TK_HOT_PATH() sfeTkHotPathScope sfeTkHotPathScope_(__func__)
+
+#else
+
+#define SFE_TK_HOT_PATH()
+
+#endif
@@ -0,0 +1,91 @@
+// sfeTkIAsyncTransfer.h
+//
+// Defines the asynchronous transfer interface - used to hand bus transfers to DMA - for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkBusRequest.h"
+
+/**
+ * @brief Interface for an asynchronous transfer backend.
+ *
+ * A backend takes a whole bus request (typically a long readRegisterRegion) and runs it without the CPU
+ * - with DMA on platforms that support it - completing the request when the transfer is done. Completion
+ * is signaled through the request (sfeTkBusRequest::done() and the optional callback), possibly from an
+ * interrupt or another task.
+ *
+ * A backend runs one transfer at a time. While a transfer is in flight, the bus must not be used for other
+ * operations.
+ */
+class sfeTkIAsyncTransfer
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Start a transfer
+
+        @param bus The bus (device) the transfer is for
+        @param request The transfer to run. Must remain valid until done.
+
+        @retval sfeTkError_t kSTkErrOk if the transfer was started, kSTkErrBusQueueFull if a transfer is in flight
+    */
+    virtual sfeTkError_t start(sfeTkIBus &bus, sfeTkBusRequest &request) = 0;
+
+    /**--------------------------------------------------------------------------
+        @brief Is a transfer in flight?
+
+        @retval bool true if busy
+    */
+    virtual bool busy(void) = 0;
+
+    /**--------------------------------------------------------------------------
+        @brief Give a polled backend a chance to complete a transfer. Backends that complete from an
+               interrupt or another task do nothing.
+    */
+    virtual void poll(void)
+    {
+    }
+};
+
+/**
+ * @brief The CPU fallback backend - runs the transfer with the bus's own (CPU driven) methods, in the calling task.
+ *
+ * The transfer is complete when start() returns. Used by the bus implementations when no backend is set.
+ */
+class sfeTkCpuTransfer : public sfeTkIAsyncTransfer
+{
+  public:
+    sfeTkError_t start(sfeTkIBus &bus, sfeTkBusRequest &request)
+    {
+        request.transferred = 0;
+        request.status = kSTkErrBusPending;
+        request.complete(sfeTkBusExecute(bus, request));
+        return kSTkErrOk;
+    }
+
+    bool busy(void)
+    {
+        return false;
+    }
+};
@@ -27,7 +27,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
+#include "sfeTkConfig.h"
 #include "sfeTkError.h"
+#include "sfeTkResult.h"
+#include "sfeTkTransaction.h"
 #include <stddef.h>
 
 /**
@@ -76,6 +79,109 @@ const sfeTkError_t kSTkErrBusUnderRead = kSTkErrBaseBus + 7;
  */
 const sfeTkError_t kSTkErrBusNotEnabled = kSTkErrBaseBus + 8;
 
+/**
+ * @brief Returned when a bus request queue is full and the request was not accepted.
+ */
+const sfeTkError_t kSTkErrBusQueueFull = kSTkErrFail * (kSTkErrBaseBus + 9);
+
+/**
+ * @brief Returned when a bus request was submitted but has not completed yet. Info
+ */
+const sfeTkError_t kSTkErrBusPending = kSTkErrBaseBus + 10;
+
+/**
+ * @brief Returned when the devices of a budget need more of the bus than the limit
+ */
+const sfeTkError_t kSTkErrBusOverBudget = kSTkErrFail * (kSTkErrBaseBus + 11);
+
+/**
+ * @brief Returned when the devices of a budget need more of the bus than the warning level. Info
+ */
+const sfeTkError_t kSTkErrBusBudgetWarning = kSTkErrBaseBus + 12;
+
+/**
+ * @brief Returned when a device does not read reliably at the slowest clock of the tuner
+ */
+const sfeTkError_t kSTkErrBusUnreliable = kSTkErrFail * (kSTkErrBaseBus + 13);
+
+/**
+ * @brief The value returning reads of sfeTkIBus, for a class with the same read methods that is not a bus - the
+ *        device handles. They return the value with the error code, and call the read methods of Derived.
+ *
+ * sfeTkIBus has its own copy - as a base class of every bus, this class would add type information to each.
+ * Derived declares its read methods, which hide these - it re-exposes them with using declarations, e.g.
+ * "using sfeTkBusValueReads<Derived>::readRegisterByte;".
+ *
+ * @tparam Derived The class with the out parameter reads
+ */
+template <typename Derived> class sfeTkBusValueReads
+{
+  public:
+    /**--------------------------------------------------------------------------
+     *  @brief Read a single byte from the given register
+     *
+     *  @param devReg The device's register's address.
+     *
+     *  @retval sfeTkResult<uint8_t> The byte read, and kSTkErrOk on success
+     */
+    sfeTkResult<uint8_t> readRegisterByte(uint8_t devReg)
+    {
+        uint8_t data;
+        sfeTkError_t retval = static_cast<Derived *>(this)->readRegisterByte(devReg, data);
+        return sfeTkResult<uint8_t>(retval, retval == kSTkErrOk ? data : 0);
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**--------------------------------------------------------------------------
+     *  @brief Read a single word (16 bit) from the given register
+     *
+     *  @param devReg The device's register's address.
+     *
+     *  @retval sfeTkResult<uint16_t> The word read, and kSTkErrOk on success
+     */
+    sfeTkResult<uint16_t> readRegisterWord(uint8_t devReg)
+    {
+        uint16_t data;
+        sfeTkError_t retval = static_cast<Derived *>(this)->readRegisterWord(devReg, data);
+        return sfeTkResult<uint16_t>(retval, retval == kSTkErrOk ? data : 0);
+    }
+#endif
+
+    /**--------------------------------------------------------------------------
+     *  @brief Reads a block of data from the given register.
+     *
+     *  @param reg The device's register's address.
+     *  @param data Data buffer to read into
+     *  @param numBytes - length of the data buffer
+     *
+     *  @retval sfeTkResult<size_t> The number of bytes read, and kSTkErrOk on success
+     */
+    sfeTkResult<size_t> readRegisterRegion(uint8_t reg, uint8_t *data, size_t numBytes)
+    {
+        size_t readBytes = 0;
+        sfeTkError_t retval = static_cast<Derived *>(this)->readRegisterRegion(reg, data, numBytes, readBytes);
+        return sfeTkResult<size_t>(retval, readBytes);
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**--------------------------------------------------------------------------
+     *  @brief Reads a block of data from the given 16-bit register address.
+     *
+     *  @param reg The device's 16 bit register's address.
+     *  @param data Data buffer to read into
+     *  @param numBytes - length of the data buffer
+     *
+     *  @retval sfeTkResult<size_t> The number of bytes read, and kSTkErrOk on success
+     */
+    sfeTkResult<size_t> readRegister16Region(uint16_t reg, uint8_t *data, size_t numBytes)
+    {
+        size_t readBytes = 0;
+        sfeTkError_t retval = static_cast<Derived *>(this)->readRegister16Region(reg, data, numBytes, readBytes);
+        return sfeTkResult<size_t>(retval, readBytes);
+    }
+#endif
+};
+
 /**
  * @brief Interface that defines the communication bus for the SparkFun Electronics Toolkit.
  *
@@ -95,6 +201,7 @@ class sfeTkIBus
      */
     virtual sfeTkError_t writeByte(uint8_t data) = 0;
 
+#if SFE_TK_ENABLE_WORD_OPS
     /**--------------------------------------------------------------------------
      *  @brief Send a word to the device. 
      *  @param data Data to write.
@@ -103,6 +210,7 @@ class sfeTkIBus
      *
      */
     virtual sfeTkError_t writeWord(uint16_t data) = 0;
+#endif
 
     /**--------------------------------------------------------------------------
      *  @brief Send an array of data to the device.
@@ -125,6 +233,7 @@ class sfeTkIBus
      */
     virtual sfeTkError_t writeRegisterByte(uint8_t devReg, uint8_t data) = 0;
 
+#if SFE_TK_ENABLE_WORD_OPS
     /**--------------------------------------------------------------------------
      * @brief Write a single word (16 bit) to the given register
      *
@@ -135,6 +244,7 @@ class sfeTkIBus
      *
      */
     virtual sfeTkError_t writeRegisterWord(uint8_t devReg, uint16_t data) = 0;
+#endif
 
     /**--------------------------------------------------------------------------
      *  @brief Writes a number of bytes starting at the given register's address.
@@ -148,6 +258,7 @@ class sfeTkIBus
      */
     virtual sfeTkError_t writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length) = 0;
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
     /**--------------------------------------------------------------------------
      *  @brief Writes a number of bytes starting at the given register's 16-bit address.
      *
@@ -159,6 +270,7 @@ class sfeTkIBus
      *
      */
     virtual sfeTkError_t writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length) = 0;
+#endif
 
     /**--------------------------------------------------------------------------
      *  @brief Read a single byte from the given register
@@ -171,6 +283,7 @@ class sfeTkIBus
      */
     virtual sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data) = 0;
 
+#if SFE_TK_ENABLE_WORD_OPS
     /**--------------------------------------------------------------------------
      *  @brief Read a single word (16 bit) from the given register
      *
@@ -180,6 +293,7 @@ class sfeTkIBus
      *   @retval sfeTkError_t -  kSTkErrOk on successful execution.
      */
     virtual sfeTkError_t readRegisterWord(uint8_t devReg, uint16_t &data) = 0;
+#endif
 
     /**--------------------------------------------------------------------------
      *  @brief Reads a block of data from the given register.
@@ -194,6 +308,7 @@ class sfeTkIBus
      */
     virtual sfeTkError_t readRegisterRegion(uint8_t reg, uint8_t *data, size_t numBytes, size_t &readBytes) = 0;
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
     /**--------------------------------------------------------------------------
      *  @brief Reads a block of data from the given 16-bit register address.
      *
@@ -206,6 +321,142 @@ class sfeTkIBus
      *
      */
     virtual sfeTkError_t readRegister16Region(uint16_t reg, uint8_t *data, size_t numBytes, size_t &readBytes) = 0;
+#endif
+
+#if SFE_TK_ENABLE_TRANSACTIONS
+    /**--------------------------------------------------------------------------
+     *  @brief Runs a transaction - see sfeTk/sfeTkTransaction.h
+     *
+     *  @param txn The transaction
+     *
+     *  @retval sfeTkError_t kSTkErrOk if every step succeeded, else the result of the step that failed
+     */
+    template <size_t N> sfeTkError_t transaction(const sfeTkTransaction<N> &txn)
+    {
+        return executeSteps(txn.steps(), N);
+    }
+
+    /**--------------------------------------------------------------------------
+     *  @brief Runs the steps of a transaction in order, stopping at the first step that fails.
+     *
+     *  This version runs one bus operation a step. An implementation overrides it to run the steps as one
+     *  operation on the bus.
+     *
+     *  @param steps The steps
+     *  @param nSteps The number of steps
+     *
+     *  @retval sfeTkError_t kSTkErrOk if every step succeeded, else the result of the step that failed
+     */
+    virtual sfeTkError_t executeSteps(const sfeTkTxnStep *steps, size_t nSteps)
+    {
+        for (size_t i = 0; i < nSteps; i++)
+        {
+            uint8_t value[2];
+            size_t length, readBytes;
+            const uint8_t *data = sfeTkTxnStepData(steps[i], value, length);
+            sfeTkError_t retval = kSTkErrFail;
+
+            switch (steps[i].op)
+            {
+            case kSTkBusOpWriteRegion:
+                retval = writeRegion(data, length);
+                break;
+
+            case kSTkBusOpWriteRegisterRegion:
+                retval = writeRegisterRegion((uint8_t)steps[i].reg, data, length);
+                break;
+
+            case kSTkBusOpReadRegisterRegion:
+                retval = readRegisterRegion((uint8_t)steps[i].reg, steps[i].data, length, readBytes);
+                break;
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+            case kSTkBusOpWriteRegister16Region:
+                retval = writeRegister16Region(steps[i].reg, data, length);
+                break;
+
+            case kSTkBusOpReadRegister16Region:
+                retval = readRegister16Region(steps[i].reg, steps[i].data, length, readBytes);
+                break;
+#endif
+            default: // a compiled out operation
+                break;
+            }
+            if (retval != kSTkErrOk)
+                return retval;
+        }
+        return kSTkErrOk;
+    }
+#endif
+
+    // Value returning reads. These overloads return the value with the error code, rather than through an
+    // out parameter. An implementation that declares the read methods hides these - it re-exposes them with
+    // using declarations (e.g. "using sfeTkIBus::readRegisterByte;"), so they call its read methods through the
+    // vtable, and a subclass that overrides a read method is used by the value form too.
+
+    /**--------------------------------------------------------------------------
+     *  @brief Read a single byte from the given register
+     *
+     *  @param devReg The device's register's address.
+     *
+     *  @retval sfeTkResult<uint8_t> The byte read, and kSTkErrOk on success
+     */
+    sfeTkResult<uint8_t> readRegisterByte(uint8_t devReg)
+    {
+        uint8_t data;
+        sfeTkError_t retval = readRegisterByte(devReg, data);
+        return sfeTkResult<uint8_t>(retval, retval == kSTkErrOk ? data : 0);
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**--------------------------------------------------------------------------
+     *  @brief Read a single word (16 bit) from the given register
+     *
+     *  @param devReg The device's register's address.
+     *
+     *  @retval sfeTkResult<uint16_t> The word read, and kSTkErrOk on success
+     */
+    sfeTkResult<uint16_t> readRegisterWord(uint8_t devReg)
+    {
+        uint16_t data;
+        sfeTkError_t retval = readRegisterWord(devReg, data);
+        return sfeTkResult<uint16_t>(retval, retval == kSTkErrOk ? data : 0);
+    }
+#endif
+
+    /**--------------------------------------------------------------------------
+     *  @brief Reads a block of data from the given register.
+     *
+     *  @param reg The device's register's address.
+     *  @param data Data buffer to read into
+     *  @param numBytes - length of the data buffer
+     *
+     *  @retval sfeTkResult<size_t> The number of bytes read, and kSTkErrOk on success
+     */
+    sfeTkResult<size_t> readRegisterRegion(uint8_t reg, uint8_t *data, size_t numBytes)
+    {
+        size_t readBytes = 0;
+        sfeTkError_t retval = readRegisterRegion(reg, data, numBytes, readBytes);
+        return sfeTkResult<size_t>(retval, readBytes);
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**--------------------------------------------------------------------------
+     *  @brief Reads a block of data from the given 16-bit register address.
+     *
+     *  @param reg The device's 16 bit register's address.
+     *  @param data Data buffer to read into
+     *  @param numBytes - length of the data buffer
+     *
+     *  @retval sfeTkResult<size_t> The number of bytes read, and kSTkErrOk on success
+     */
+    sfeTkResult<size_t> readRegister16Region(uint16_t reg, uint8_t *data, size_t numBytes)
+    {
+        size_t readBytes = 0;
+        sfeTkError_t retval = readRegister16Region(reg, data, numBytes, readBytes);
+        return sfeTkResult<size_t>(retval, readBytes);
+    }
+#endif
 };
 
 //};
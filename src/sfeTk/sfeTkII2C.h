@@ -49,7 +49,7 @@ class sfeTkII2C : public sfeTkIBus
      *
      * @param addr
      */
-    sfeTkII2C(uint8_t addr) : _address{addr}
+    sfeTkII2C(uint8_t addr) : _address{addr}, _stop{true}
     {
     }
 
@@ -0,0 +1,78 @@
+// sfeTkILock.h
+//
+// Defines the lock interface used to share a bus between tasks for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+/**
+ * @brief Interface for a lock - implemented with the mutex of the platform (FreeRTOS, std::mutex), or an
+ *        interrupt guard on a single threaded board.
+ */
+class sfeTkILock
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Take the lock - blocks until available
+    */
+    virtual void lock(void) = 0;
+
+    /**--------------------------------------------------------------------------
+        @brief Release the lock
+    */
+    virtual void unlock(void) = 0;
+};
+
+/**
+ * @brief Holds a lock for the life of the guard. A null lock is allowed, and does nothing.
+ */
+class sfeTkLockGuard
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - takes the lock
+
+        @param theLock The lock to hold, can be nullptr
+    */
+    sfeTkLockGuard(sfeTkILock *theLock) : _lock{theLock}
+    {
+        if (_lock)
+            _lock->lock();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Destructor - releases the lock
+    */
+    ~sfeTkLockGuard()
+    {
+        if (_lock)
+            _lock->unlock();
+    }
+
+    sfeTkLockGuard(const sfeTkLockGuard &) = delete;
+    sfeTkLockGuard &operator=(const sfeTkLockGuard &) = delete;
+
+  private:
+    sfeTkILock *_lock;
+};
@@ -0,0 +1,592 @@
+// sfeTkLatency.h
+//
+// Defines a latency probe - the time from an interrupt to the bus read it starts, and to the end of that read,
+// as histograms with percentiles and the worst cases
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sfeTkBusHooks.h"
+#include "sfeTkPool.h"
+
+// A sensor raises an interrupt when it has data, and the program reads the data over the bus. The probe stamps
+// three times for each event:
+//
+//   interrupt    interrupt() - called first thing in the interrupt handler
+//   bus start    the first bus operation after the interrupt (sfeTkLatencyHooks, or busStart())
+//   bus done     the end of the read that collects the data (sfeTkLatencyHooks, or busDone())
+//
+// and adds the interrupt to start, the bus time and the interrupt to done to a histogram each. The probe takes
+// one event at a time - an interrupt while one is in flight is counted as an overrun, and the earlier stamp is
+// kept, since that is the event the program is still serving.
+//
+// The histograms are log-linear: values under 16 have a bin each, and each power of two above that is split in 8
+// bins, so a percentile is within 12.5% of the true value however wide the spread, in a fixed number of bins.
+// Use the cycle counter for the clock where there is one (sfeTkArdCycleClock) - at micros() resolution the short
+// stages are only a few ticks.
+
+/**
+ * @brief A log-linear histogram of latencies, with the minimum, maximum and mean
+ *
+ * @tparam kBins The number of bins - values past the last bin are counted in it. 176 bins span 2^24 ticks; each
+ * bin is 4 bytes of RAM.
+ */
+template <size_t kBins = 176> class sfeTkLatencyHistogram
+{
+    static_assert(kBins > 16, "sfeTkLatencyHistogram needs more than 16 bins");
+
+  public:
+    sfeTkLatencyHistogram(void)
+    {
+        reset();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add a value
+
+        @param value The value, in ticks
+    */
+    void add(uint32_t value)
+    {
+        size_t bin = binOf(value);
+        _counts[bin < kBins ? bin : kBins - 1]++;
+
+        if (_count == 0 || value < _min)
+            _min = value;
+        if (value > _max)
+            _max = value;
+        _sum += value;
+        _count++;
+    }
+
+    /** The number of values */
+    uint32_t count(void) const
+    {
+        return _count;
+    }
+
+    /** The smallest value - 0 if there are none */
+    uint32_t min(void) const
+    {
+        return _min;
+    }
+
+    /** The largest value */
+    uint32_t max(void) const
+    {
+        return _max;
+    }
+
+    /** The mean value */
+    uint32_t mean(void) const
+    {
+        return _count > 0 ? (uint32_t)(_sum / _count) : 0;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief A percentile - the top of the bin it falls in, so never under the true value
+
+        @param perMille The percentile in tenths of a percent - 500 for the median, 999 for p99.9
+
+        @retval uint32_t The value, at most the largest value
+    */
+    uint32_t percentile(uint16_t perMille) const
+    {
+        if (_count == 0)
+            return 0;
+
+        // the rank of the value, rounded up
+        uint64_t rank = ((uint64_t)_count * perMille + 999) / 1000;
+        if (rank == 0)
+            rank = 1;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBins; i++)
+        {
+            seen += _counts[i];
+            if (seen >= rank)
+            {
+                uint32_t high = binHigh(i);
+                return high < _max && i < kBins - 1 ? high : _max;
+            }
+        }
+        return _max;
+    }
+
+    /** The number of bins */
+    size_t bins(void) const
+    {
+        return kBins;
+    }
+
+    /** The number of values in a bin */
+    uint32_t binCount(size_t bin) const
+    {
+        return bin < kBins ? _counts[bin] : 0;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The bin of a value
+
+        @param value The value
+        @retval size_t The bin - kBins or more if the value is past the last bin
+    */
+    static size_t binOf(uint32_t value)
+    {
+        if (value < 16)
+            return value;
+
+        uint8_t msb = 31;
+        while (!(value & (1UL << msb)))
+            msb--;
+        uint8_t shift = msb - 3;
+        return 16 + (size_t)(shift - 1) * 8 + ((value >> shift) - 8);
+    }
+
+    /** The smallest value in a bin */
+    static uint32_t binLow(size_t bin)
+    {
+        if (bin < 16)
+            return (uint32_t)bin;
+        uint8_t shift = (uint8_t)((bin - 16) / 8 + 1);
+        return (uint32_t)(8 + (bin - 16) % 8) << shift;
+    }
+
+    /** The largest value in a bin */
+    static uint32_t binHigh(size_t bin)
+    {
+        if (bin < 16)
+            return (uint32_t)bin;
+        if (bin >= 16 + 28 * 8 - 1)
+            return 0xFFFFFFFFUL;
+        return binLow(bin + 1) - 1;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Clear the histogram
+    */
+    void reset(void)
+    {
+        for (size_t i = 0; i < kBins; i++)
+            _counts[i] = 0;
+        _count = 0;
+        _min = 0;
+        _max = 0;
+        _sum = 0;
+    }
+
+  private:
+    uint32_t _counts[kBins];
+    uint32_t _count;
+    uint32_t _min;
+    uint32_t _max;
+    uint64_t _sum;
+};
+
+/**
+ * @brief Stamps interrupts, and the bus reads that serve them, into latency histograms
+ *
+ * @code
+ *     sfeTkArdLatencyProbe probe;
+ *     sfeTkArdI2CHooked<sfeTkArdLatencyHooks> imu;
+ *
+ *     void onDataReady(void) { probe.interrupt(); bDataReady = true; }
+ *
+ *     imu.hooks().attach(probe);                  // stamps the next read of a register region
+ *     ...
+ *     if (bDataReady) { bDataReady = false; imu.readRegisterRegion(kRegData, data, sizeof(data), n); }
+ *     ...
+ *     probe.report(Serial, sfeTkArdCyclesHz());
+ * @endcode
+ *
+ * @tparam Clock A class with a static uint32_t now(void) method
+ * @tparam kBins The bins of each of the three histograms
+ * @tparam kWorst The number of worst cases kept
+ * @tparam Guard The guard policy - a critical section where a 32 bit read is not atomic (AVR)
+ */
+template <typename Clock, size_t kBins = 176, size_t kWorst = 4, typename Guard = sfeTkNoGuard>
+class sfeTkLatencyProbe
+{
+  public:
+    /** The clock of the probe */
+    typedef Clock ClockType;
+
+    /** The histogram type of the probe */
+    typedef sfeTkLatencyHistogram<kBins> Histogram;
+
+    /**
+     * @brief The stages of one event, in ticks
+     */
+    struct Sample
+    {
+        uint32_t toStart;  // interrupt to the start of the bus read
+        uint32_t bus;      // the bus read
+        uint32_t total;    // interrupt to the end of the bus read
+        uint32_t sequence; // the number of the interrupt
+    };
+
+    sfeTkLatencyProbe(void)
+    {
+        reset();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Stamp an interrupt - call first thing in the interrupt handler
+    */
+    void interrupt(void)
+    {
+        uint32_t now = Clock::now();
+        _interrupts = _interrupts + 1;
+        if (_bPending)
+        {
+            _overruns = _overruns + 1;
+            return;
+        }
+        _irqTime = now;
+        _bPending = true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Stamp the start of the bus read for the interrupt in flight - nothing if there is none, or the read
+        has started
+    */
+    void busStart(void)
+    {
+        if (!_bPending || _bStarted)
+            return;
+        _startTime = Clock::now();
+        _bStarted = true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Stamp the end of the bus read for the interrupt in flight, and add the event to the histograms. A
+        read that failed is counted, not added. Then the probe takes the next interrupt.
+
+        @param result The result of the read
+    */
+    void busDone(sfeTkError_t result = kSTkErrOk)
+    {
+        if (!_bStarted)
+            return;
+        uint32_t now = Clock::now();
+
+        uint32_t irqTime;
+        uint32_t sequence;
+        {
+            Guard guard;
+            (void)guard;
+            irqTime = _irqTime;
+            sequence = _interrupts - _overruns;
+            _bPending = false;
+        }
+        _bStarted = false;
+
+        if (result != kSTkErrOk)
+        {
+            _failures++;
+            return;
+        }
+
+        Sample sample = {_startTime - irqTime, now - _startTime, now - irqTime, sequence};
+        _toStart.add(sample.toStart);
+        _bus.add(sample.bus);
+        _total.add(sample.total);
+        addWorst(sample);
+    }
+
+    /** Interrupt to the start of the bus read */
+    const Histogram &toStart(void) const
+    {
+        return _toStart;
+    }
+
+    /** The bus read */
+    const Histogram &bus(void) const
+    {
+        return _bus;
+    }
+
+    /** Interrupt to the end of the bus read */
+    const Histogram &total(void) const
+    {
+        return _total;
+    }
+
+    /** The number of worst cases kept */
+    size_t worstCount(void) const
+    {
+        return _nWorst;
+    }
+
+    /** A worst case - 0 is the longest interrupt to the end of the bus read */
+    const Sample &worst(size_t i) const
+    {
+        return _worst[i < _nWorst ? i : 0];
+    }
+
+    /** The interrupts stamped */
+    uint32_t interrupts(void) const
+    {
+        return _interrupts;
+    }
+
+    /** The interrupts that came while an earlier one was still in flight */
+    uint32_t overruns(void) const
+    {
+        return _overruns;
+    }
+
+    /** The reads that failed */
+    uint32_t failures(void) const
+    {
+        return _failures;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Clear the histograms and counts - an interrupt in flight is dropped
+    */
+    void reset(void)
+    {
+        Guard guard;
+        (void)guard;
+        _bPending = false;
+        _bStarted = false;
+        _irqTime = 0;
+        _startTime = 0;
+        _interrupts = 0;
+        _overruns = 0;
+        _failures = 0;
+        _nWorst = 0;
+        _toStart.reset();
+        _bus.reset();
+        _total.reset();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Print the percentiles of each stage, the worst cases and the histogram of interrupt to done
+
+        @param out Where to print - a class with println(const char *), such as Serial
+        @param rate The ticks a second of the clock - times are in microseconds, or in ticks if 0
+    */
+    template <typename Out> void report(Out &out, uint32_t rate = 0) const
+    {
+        char line[112];
+        const char *units = rate > 0 ? "us" : "ticks";
+
+        snprintf(line, sizeof(line), "Latency: %lu events, %lu overruns, %lu failures (%s)",
+                 (unsigned long)_total.count(), (unsigned long)_overruns, (unsigned long)_failures, units);
+        out.println(line);
+        snprintf(line, sizeof(line), "  %-11s %9s %9s %9s %9s %9s %9s %9s %9s", "stage", "min", "p50", "p90", "p99",
+                 "p99.9", "max", "mean", "jitter");
+        out.println(line);
+        reportStage(out, "irq->start", _toStart, rate);
+        reportStage(out, "bus", _bus, rate);
+        reportStage(out, "irq->done", _total, rate);
+
+        out.println("");
+        out.println("Worst cases:");
+        snprintf(line, sizeof(line), "  %-8s %11s %9s %9s", "event", "irq->start", "bus", "irq->done");
+        out.println(line);
+        for (size_t i = 0; i < _nWorst; i++)
+        {
+            char toStart[24], bus[24], total[24];
+            snprintf(line, sizeof(line), "  %-8lu %11s %9s %9s", (unsigned long)_worst[i].sequence,
+                     format(toStart, sizeof(toStart), _worst[i].toStart, rate),
+                     format(bus, sizeof(bus), _worst[i].bus, rate),
+                     format(total, sizeof(total), _worst[i].total, rate));
+            out.println(line);
+        }
+        if (_nWorst == 0)
+            out.println("  none");
+
+        // the histogram of interrupt to done, a row for each power of two
+        uint32_t counts[34];
+        size_t nRows = 0;
+        uint32_t most = 1;
+        for (size_t i = 0; i < kBins; i++)
+        {
+            size_t row = octave(i);
+            while (nRows <= row)
+                counts[nRows++] = 0;
+            counts[row] += _total.binCount(i);
+            if (counts[row] > most)
+                most = counts[row];
+        }
+
+        out.println("");
+        out.println("irq->done:");
+        for (size_t row = 0; row < nRows; row++)
+        {
+            if (counts[row] == 0)
+                continue;
+
+            char low[24], high[24], bar[41];
+            size_t nBar = (size_t)(((uint64_t)counts[row] * 40 + most - 1) / most);
+            for (size_t i = 0; i < nBar; i++)
+                bar[i] = '#';
+            bar[nBar] = 0;
+
+            uint32_t lowValue = row == 0 ? 0 : 1UL << (row + 2);
+            uint32_t highValue = row == 0 ? 7 : (row + 3 < 32 ? (1UL << (row + 3)) - 1 : 0xFFFFFFFFUL);
+            if (row + 1 == nRows)
+                highValue = 0xFFFFFFFFUL; // the last bin counts everything past it
+
+            snprintf(line, sizeof(line), "  %9s - %9s %8lu %s", format(low, sizeof(low), lowValue, rate),
+                     highValue == 0xFFFFFFFFUL ? "" : format(high, sizeof(high), highValue, rate),
+                     (unsigned long)counts[row], bar);
+            out.println(line);
+        }
+    }
+
+  private:
+    // a value in microseconds with a decimal, or in ticks
+    static const char *format(char *buffer, size_t size, uint32_t value, uint32_t rate)
+    {
+        if (rate == 0)
+            snprintf(buffer, size, "%lu", (unsigned long)value);
+        else
+        {
+            uint64_t tenths = ((uint64_t)value * 10000000 + rate / 2) / rate;
+            snprintf(buffer, size, "%lu.%lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+        }
+        return buffer;
+    }
+
+    template <typename Out>
+    static void reportStage(Out &out, const char *name, const Histogram &histogram, uint32_t rate)
+    {
+        char line[112];
+        char values[8][24];
+        uint32_t p50 = histogram.percentile(500);
+        uint32_t p99 = histogram.percentile(990);
+        snprintf(line, sizeof(line), "  %-11s %9s %9s %9s %9s %9s %9s %9s %9s", name,
+                 format(values[0], 24, histogram.min(), rate), format(values[1], 24, p50, rate),
+                 format(values[2], 24, histogram.percentile(900), rate), format(values[3], 24, p99, rate),
+                 format(values[4], 24, histogram.percentile(999), rate), format(values[5], 24, histogram.max(), rate),
+                 format(values[6], 24, histogram.mean(), rate), format(values[7], 24, p99 - p50, rate));
+        out.println(line);
+    }
+
+    // the power of two row of a bin - values 0 to 7, then one row for each power of two
+    static size_t octave(size_t bin)
+    {
+        if (bin < 8)
+            return 0;
+        if (bin < 16)
+            return 1;
+        return (bin - 16) / 8 + 2;
+    }
+
+    // keep the longest events, longest first
+    void addWorst(const Sample &sample)
+    {
+        if (kWorst == 0 || (_nWorst == kWorst && sample.total <= _worst[kWorst - 1].total))
+            return;
+
+        size_t i = _nWorst < kWorst ? _nWorst++ : kWorst - 1;
+        for (; i > 0 && _worst[i - 1].total < sample.total; i--)
+            _worst[i] = _worst[i - 1];
+        _worst[i] = sample;
+    }
+
+    // set by the interrupt
+    volatile bool _bPending;
+    volatile uint32_t _irqTime;
+    volatile uint32_t _interrupts;
+    volatile uint32_t _overruns;
+
+    bool _bStarted;
+    uint32_t _startTime;
+    uint32_t _failures;
+
+    Histogram _toStart;
+    Histogram _bus;
+    Histogram _total;
+
+    Sample _worst[kWorst > 0 ? kWorst : 1];
+    size_t _nWorst;
+};
+
+/**
+ * @brief The hook policy that stamps the bus start and bus done of a probe. The first operation on the bus after
+ * an interrupt is the bus start - a status read before the data counts as bus time - and the end of the first
+ * operation of the given type is the bus done.
+ *
+ * @tparam Probe The probe class - an sfeTkLatencyProbe
+ */
+template <typename Probe> class sfeTkLatencyHooks
+{
+  public:
+    static const bool kEnabled = true;
+
+    sfeTkLatencyHooks(void) : _probe{nullptr}, _op{kSTkBusHookReadRegisterRegion}, _depth{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Attach to a probe
+
+        @param probe The probe
+        @param op The operation that ends the bus read - a register region read by default
+    */
+    void attach(Probe &probe, sfeTkBusHookOp_t op = kSTkBusHookReadRegisterRegion)
+    {
+        _probe = &probe;
+        _op = op;
+    }
+
+    /** Stop stamping the probe */
+    void detach(void)
+    {
+        _probe = nullptr;
+    }
+
+    // the probe reads its own clock
+    uint32_t now(void)
+    {
+        return 0;
+    }
+
+    void before(const sfeTkBusHookInfo &)
+    {
+        if (_depth++ == 0 && _probe)
+            _probe->busStart();
+    }
+
+    void after(const sfeTkBusHookInfo &info)
+    {
+        // only the outer operation - a bus that runs a transaction as separate operations hooks those too
+        if (--_depth == 0 && _probe && info.op == _op)
+            _probe->busDone(info.result);
+    }
+
+  private:
+    Probe *_probe;
+    sfeTkBusHookOp_t _op;
+    uint8_t _depth;
+};
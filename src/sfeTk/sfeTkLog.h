@@ -0,0 +1,345 @@
+// sfeTkLog.h
+//
+// Defines the toolkit's binary log - log sites record an ID and their raw arguments, formatted on the host
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sfeTkPool.h"
+#include "sfeTkRing.h"
+
+// A log site is a printf style message, for example:
+//
+//    SFE_TK_LOG_WARN("I2C 0x%02x: read %u of %u bytes", address(), nRead, nWanted);
+//
+// Nothing is formatted on the device. The site records the 32 bit FNV-1a hash of its format string - computed
+// at compile time, so the string is not in the image - a time stamp and its arguments, each as 32 raw bits, in a
+// ring buffer. The host tool (tools/sfeTkLog.py) builds a table of the formats from the sources, and turns the
+// records back into messages. Sites with the same format share an ID.
+//
+// Sites at or below SFE_TK_LOG_LEVEL are compiled in - the default, 0, compiles all logging out, and the
+// arguments are not evaluated. Set it for the whole build, as for the sfeTkConfig.h options.
+
+#ifndef SFE_TK_LOG_LEVEL
+#define SFE_TK_LOG_LEVEL 0
+#endif
+
+/**
+ * @brief The log levels - a site is compiled in when its level is <= SFE_TK_LOG_LEVEL
+ */
+enum sfeTkLogLevel_t : uint8_t
+{
+    kSTkLogError = 1,
+    kSTkLogWarn = 2,
+    kSTkLogInfo = 3,
+    kSTkLogDebug = 4
+};
+
+/**
+ * @brief The most arguments a log site can have
+ */
+const uint8_t kSTkLogMaxArgs = 8;
+
+/**
+ * @brief The size of a record without its arguments - the ID, the time stamp, and the level and argument count
+ *
+ * A record is little endian: ID (4 bytes), time (4), level << 4 | number of arguments (1), then the arguments
+ * (4 bytes each).
+ */
+const size_t kSTkLogHeaderSize = 9;
+
+/**
+ * @brief The FNV-1a hash of a string - the ID of a log site's format. Computed at compile time for a literal.
+ *
+ * @param str The string
+ * @param hash The hash so far
+ *
+ * @retval uint32_t The hash
+ */
+constexpr uint32_t sfeTkLogHash(const char *str, uint32_t hash = 2166136261UL)
+{
+    return *str ? sfeTkLogHash(str + 1, (hash ^ (uint8_t)*str) * 16777619UL) : hash;
+}
+
+// Arguments are recorded as 32 raw bits. Signed values are sign extended, so %d shows them on the host whatever
+// the size of int on the target. 64 bit values are truncated. Floating point values are recorded as float -
+// show them with %f, %e or %g. A string is recorded as its address, not its text.
+
+inline uint32_t sfeTkLogArg(bool value)
+{
+    return value ? 1 : 0;
+}
+inline uint32_t sfeTkLogArg(char value)
+{
+    return (uint32_t)(int32_t)value;
+}
+inline uint32_t sfeTkLogArg(signed char value)
+{
+    return (uint32_t)(int32_t)value;
+}
+inline uint32_t sfeTkLogArg(unsigned char value)
+{
+    return value;
+}
+inline uint32_t sfeTkLogArg(short value)
+{
+    return (uint32_t)(int32_t)value;
+}
+inline uint32_t sfeTkLogArg(unsigned short value)
+{
+    return value;
+}
+inline uint32_t sfeTkLogArg(int value)
+{
+    return (uint32_t)(int32_t)value;
+}
+inline uint32_t sfeTkLogArg(unsigned int value)
+{
+    return (uint32_t)value;
+}
+inline uint32_t sfeTkLogArg(long value)
+{
+    return (uint32_t)(int32_t)value;
+}
+inline uint32_t sfeTkLogArg(unsigned long value)
+{
+    return (uint32_t)value;
+}
+inline uint32_t sfeTkLogArg(long long value)
+{
+    return (uint32_t)value;
+}
+inline uint32_t sfeTkLogArg(unsigned long long value)
+{
+    return (uint32_t)value;
+}
+inline uint32_t sfeTkLogArg(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+inline uint32_t sfeTkLogArg(double value)
+{
+    return sfeTkLogArg((float)value);
+}
+template <typename T> inline uint32_t sfeTkLogArg(const T *value)
+{
+    return (uint32_t)(uintptr_t)value;
+}
+
+/**
+ * @brief A ring buffer of log records. When full, the oldest records are dropped to make room.
+ *
+ * @tparam kBytes The size of the buffer in bytes - a record is 9 bytes plus 4 for each argument
+ * @tparam Guard The guard policy - sfeTkNoGuard, or a critical section to log from an interrupt
+ */
+template <size_t kBytes, typename Guard = sfeTkNoGuard> class sfeTkLog
+{
+    static_assert(kBytes >= kSTkLogHeaderSize + 4 * kSTkLogMaxArgs, "sfeTkLog buffer must hold the largest record");
+
+  public:
+    sfeTkLog() : _dropped{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add a record, dropping the oldest records if there isn't room
+
+        @param id The ID of the log site - sfeTkLogHash() of its format
+        @param level The level of the site
+        @param time The time stamp
+        @param args The arguments - see sfeTkLogArg()
+        @param nArgs The number of arguments, up to kSTkLogMaxArgs
+
+        @retval bool true if older records were dropped
+    */
+    bool write(uint32_t id, uint8_t level, uint32_t time, const uint32_t *args, uint8_t nArgs)
+    {
+        if (nArgs > kSTkLogMaxArgs)
+            nArgs = kSTkLogMaxArgs;
+        size_t length = kSTkLogHeaderSize + 4 * nArgs;
+
+        Guard guard;
+        (void)guard;
+
+        bool bDropped = false;
+        while (_ring.capacity() - _ring.size() < length)
+        {
+            dropOldest();
+            bDropped = true;
+        }
+
+        put(id);
+        put(time);
+        _ring.push((uint8_t)(level << 4 | nArgs));
+        for (uint8_t i = 0; i < nArgs; i++)
+            put(args[i]);
+
+        return bDropped;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Remove whole records from the front of the log
+
+        @param data The buffer to copy the records to
+        @param length The size of the buffer
+
+        @retval size_t The number of bytes copied
+    */
+    size_t read(uint8_t *data, size_t length)
+    {
+        Guard guard;
+        (void)guard;
+
+        size_t nRead = 0;
+        while (!_ring.empty())
+        {
+            size_t record = recordLength();
+            if (record > length - nRead)
+                break;
+
+            for (size_t i = 0; i < record; i++)
+                _ring.pop(data[nRead++]);
+        }
+        return nRead;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The number of records dropped to make room, since the last call - and resets the count
+    */
+    uint32_t takeDropped(void)
+    {
+        Guard guard;
+        (void)guard;
+
+        uint32_t dropped = _dropped;
+        _dropped = 0;
+        return dropped;
+    }
+
+    /** The number of bytes of records in the log */
+    size_t size(void) const
+    {
+        return _ring.size();
+    }
+
+    /** Is the log empty? */
+    bool empty(void) const
+    {
+        return _ring.empty();
+    }
+
+    /** Remove all records */
+    void clear(void)
+    {
+        Guard guard;
+        (void)guard;
+
+        _ring.clear();
+        _dropped = 0;
+    }
+
+  private:
+    void put(uint32_t value)
+    {
+        _ring.push((uint8_t)value);
+        _ring.push((uint8_t)(value >> 8));
+        _ring.push((uint8_t)(value >> 16));
+        _ring.push((uint8_t)(value >> 24));
+    }
+
+    // the length of the record at the front
+    size_t recordLength(void) const
+    {
+        return kSTkLogHeaderSize + 4 * (_ring[kSTkLogHeaderSize - 1] & 0x0F);
+    }
+
+    void dropOldest(void)
+    {
+        size_t record = recordLength();
+        for (size_t i = 0; i < record; i++)
+            _ring.pop();
+        _dropped++;
+    }
+
+    sfeTkRing<uint8_t, kBytes> _ring;
+    uint32_t _dropped;
+};
+
+/**
+ * @brief Records a log site - implemented by the platform layer, which adds the time stamp
+ *
+ * @param id The ID of the site
+ * @param level The level of the site
+ * @param args The arguments
+ * @param nArgs The number of arguments
+ */
+void sfeTkLogWrite(uint32_t id, uint8_t level, const uint32_t *args, uint8_t nArgs);
+
+/**
+ * @brief Records a log site with its arguments - called by the SFE_TK_LOG_* macros
+ */
+template <typename... Args> inline void sfeTkLogSite(uint32_t id, uint8_t level, Args... args)
+{
+    static_assert(sizeof...(Args) <= kSTkLogMaxArgs, "too many arguments to a log site");
+
+    const uint32_t values[sizeof...(Args) + 1] = {sfeTkLogArg(args)..., 0};
+    sfeTkLogWrite(id, level, values, (uint8_t)sizeof...(Args));
+}
+
+#define SFE_TK_LOG_SITE(level, format, ...)                                                                      \
+    do                                                                                                             \
+    {                                                                                                              \
+        constexpr uint32_t sfeTkLogId_ = sfeTkLogHash(format);                                                     \
+        sfeTkLogSite(sfeTkLogId_, level, ##__VA_ARGS__);                                                           \
+    } while (0)
+
+#if SFE_TK_LOG_LEVEL >= 1
+#define SFE_TK_LOG_ERROR(format, ...) SFE_TK_LOG_SITE(kSTkLogError, format, ##__VA_ARGS__)
+#else
+#define SFE_TK_LOG_ERROR(format, ...) do {} while (0)
+#endif
+
+#if SFE_TK_LOG_LEVEL >= 2
+#define SFE_TK_LOG_WARN(format, ...) SFE_TK_LOG_SITE(kSTkLogWarn, format, ##__VA_ARGS__)
+#else
+#define SFE_TK_LOG_WARN(format, ...) do {} while (0)
+#endif
+
+#if SFE_TK_LOG_LEVEL >= 3
+#define SFE_TK_LOG_INFO(format, ...) SFE_TK_LOG_SITE(kSTkLogInfo, format, ##__VA_ARGS__)
+#else
+#define SFE_TK_LOG_INFO(format, ...) do {} while (0)
+#endif
+
+#if SFE_TK_LOG_LEVEL >= 4
+#define SFE_TK_LOG_DEBUG(format, ...) SFE_TK_LOG_SITE(kSTkLogDebug, format, ##__VA_ARGS__)
+#else
+#define SFE_TK_LOG_DEBUG(format, ...) do {} while (0)
+#endif
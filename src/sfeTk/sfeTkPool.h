@@ -0,0 +1,194 @@
+// sfeTkPool.h
+//
+// Defines a static memory, fixed block size pool allocator for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The default guard policy of the toolkit allocators - no locking, for use from a single task.
+ *
+ * A guard policy is a class whose constructor enters a critical section and whose destructor leaves it. For a
+ * pool shared with an interrupt handler, use sfeTkArdCriticalSection (sfeTkArdCriticalSection.h).
+ */
+class sfeTkNoGuard
+{
+};
+
+/**
+ * @brief A pool of fixed size blocks in static memory - O(1) alloc and free, no heap, no fragmentation.
+ *
+ * Free blocks are kept on an intrusive list, so a block costs no memory beyond its size (rounded up to hold a
+ * pointer and to the largest alignment of the target). Use for short lived request descriptors and buffers of
+ * a known size.
+ *
+ * @tparam kBlockSize The size of a block in bytes
+ * @tparam kBlocks The number of blocks
+ * @tparam Guard The guard policy - sfeTkNoGuard, or a critical section to use the pool from an interrupt
+ */
+template <size_t kBlockSize, size_t kBlocks, typename Guard = sfeTkNoGuard> class sfeTkPool
+{
+    static_assert(kBlockSize > 0 && kBlocks > 0, "sfeTkPool block size and count must be > 0");
+
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - all blocks free
+    */
+    sfeTkPool() : _nInUse{0}, _highWater{0}, _nFailed{0}
+    {
+        for (size_t i = 0; i < kBlocks; i++)
+            _blocks[i].next = i + 1 < kBlocks ? &_blocks[i + 1] : nullptr;
+        _free = &_blocks[0];
+    }
+
+    // blocks hold pointers into the pool - it can't be copied
+    sfeTkPool(const sfeTkPool &) = delete;
+    sfeTkPool &operator=(const sfeTkPool &) = delete;
+
+    /**--------------------------------------------------------------------------
+        @brief Allocate a block
+
+        @retval void* The block - kBlockSize bytes, aligned for any type. nullptr if the pool is empty.
+    */
+    void *alloc(void)
+    {
+        Guard guard;
+        (void)guard;
+
+        Block *block = _free;
+        if (!block)
+        {
+            _nFailed++;
+            return nullptr;
+        }
+
+        _free = block->next;
+        if (++_nInUse > _highWater)
+            _highWater = _nInUse;
+
+        return block->data;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Return a block to the pool
+
+        @param ptr The block, from alloc(). nullptr is ignored.
+
+        @retval bool true on success, false if ptr is not a block of this pool
+    */
+    bool free(void *ptr)
+    {
+        if (!ptr)
+            return true;
+        if (!owns(ptr))
+            return false;
+
+        Block *block = reinterpret_cast<Block *>(ptr);
+
+        Guard guard;
+        (void)guard;
+
+        block->next = _free;
+        _free = block;
+        _nInUse--;
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Is the pointer a block of this pool?
+
+        @param ptr The pointer to check
+
+        @retval bool true if ptr is the start of a block in this pool
+    */
+    bool owns(const void *ptr) const
+    {
+        uintptr_t address = (uintptr_t)ptr;
+        uintptr_t first = (uintptr_t)&_blocks[0];
+
+        return address >= first && address < first + sizeof(_blocks) && (address - first) % sizeof(Block) == 0;
+    }
+
+    /** The number of blocks allocated */
+    size_t nInUse(void) const
+    {
+        return _nInUse;
+    }
+
+    /** The number of free blocks */
+    size_t nFree(void) const
+    {
+        return kBlocks - _nInUse;
+    }
+
+    /** The most blocks allocated at once - use to size the pool */
+    size_t highWater(void) const
+    {
+        return _highWater;
+    }
+
+    /** The number of alloc() calls that failed because the pool was empty */
+    uint32_t nFailed(void) const
+    {
+        return _nFailed;
+    }
+
+    /** Reset the high water mark and failure count */
+    void resetStats(void)
+    {
+        Guard guard;
+        (void)guard;
+
+        _highWater = _nInUse;
+        _nFailed = 0;
+    }
+
+    /** The usable size of a block */
+    static constexpr size_t blockSize(void)
+    {
+        return kBlockSize;
+    }
+
+    /** The number of blocks */
+    static constexpr size_t capacity(void)
+    {
+        return kBlocks;
+    }
+
+  private:
+    union alignas(__BIGGEST_ALIGNMENT__) Block {
+        Block *next;
+        uint8_t data[kBlockSize];
+    };
+
+    Block _blocks[kBlocks];
+    Block *_free;
+
+    size_t _nInUse;
+    size_t _highWater;
+    uint32_t _nFailed;
+};
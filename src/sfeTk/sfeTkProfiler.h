@@ -0,0 +1,273 @@
+// sfeTkProfiler.h
+//
+// Defines an opt-in profiler of the phases of bus operations - setup, address, transfer, copy and teardown
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkBusHooks.h"
+
+/**
+ * @brief The phases of a bus operation.
+ *
+ * Time is given to a phase when the phase ends, so each phase is the time since the end of the one before:
+ *  - setup: the checks, and the bus settings (SPI beginTransaction() and chip select)
+ *  - address: sending the register address (an I2C read's write phase, the SPI register byte)
+ *  - transfer: moving the data - each I2C requestFrom() or write transmission, and the SPI data transfer. Each is
+ *    counted as a chunk
+ *  - copy: moving data between the bus library's buffer and the caller's (for SPI, clearing the read buffer)
+ *  - teardown: the rest - ending the transaction, the result
+ * An I2C write sends the register and the data in one transmission, so it is all transfer.
+ */
+enum sfeTkProfilePhase_t : uint8_t
+{
+    kSTkProfileSetup = 0,
+    kSTkProfileAddress,
+    kSTkProfileTransfer,
+    kSTkProfileCopy,
+    kSTkProfileTeardown,
+    kSTkProfilePhases
+};
+
+/**
+ * @brief The number of operations profiled - each sfeTkBusHookOp_t
+ */
+const uint8_t kSTkProfileOps = kSTkBusHookTransaction + 1;
+
+/**
+ * @brief The phase times of one operation, or the sum over a number of operations
+ */
+struct sfeTkProfileRecord
+{
+    /** The time in each phase, in clock ticks - see sfeTkProfileClockHz() */
+    uint32_t phase[kSTkProfilePhases];
+
+    /** The number of transfer chunks */
+    uint32_t chunks;
+
+    /** The number of operations */
+    uint32_t count;
+
+    /** The longest operation, in clock ticks */
+    uint32_t maxTotal;
+
+    /** The time in all phases */
+    uint32_t total(void) const
+    {
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < kSTkProfilePhases; i++)
+            sum += phase[i];
+        return sum;
+    }
+};
+
+/**
+ * @brief Collects the phase times of the bus operations of the Arduino bus classes, for each operation type.
+ *
+ * Profiling is compiled in when SFE_TK_PROFILE_PHASES is defined for the whole build - else the profile points
+ * in the bus code expand to nothing. The profiler is one object for the program, sfeTkProfilerInstance(), and is
+ * not thread safe - profile one thread's bus use at a time. An operation called from another (a transaction's
+ * steps) is part of the outer operation. The checked handles and asynchronous reads are not profiled.
+ *
+ * The clock (sfeTkProfileClock()) is a cycle counter where there is one - Cortex-M3 and later, ESP32, x86 hosts -
+ * else micros().
+ */
+class sfeTkProfiler
+{
+  public:
+    sfeTkProfiler(void) : _depth{0}, _op{kSTkBusHookWriteByte}, _mark{0}, _bEnabled{true}
+    {
+        reset();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Start or stop collecting - collecting by default
+    */
+    void setEnabled(bool bEnabled)
+    {
+        _bEnabled = bEnabled;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Clear the collected times
+    */
+    void reset(void)
+    {
+        for (uint8_t i = 0; i < kSTkProfileOps; i++)
+            clear(_stats[i]);
+        clear(_last);
+        _lastOp = kSTkBusHookWriteByte;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The sum of the phase times of all operations of a type
+
+        @param op The operation
+
+        @retval sfeTkProfileRecord The times - count is the number of operations
+    */
+    const sfeTkProfileRecord &stats(sfeTkBusHookOp_t op) const
+    {
+        return _stats[op];
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The phase times of the last operation - see lastOp()
+    */
+    const sfeTkProfileRecord &last(void) const
+    {
+        return _last;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The type of the last operation
+    */
+    sfeTkBusHookOp_t lastOp(void) const
+    {
+        return _lastOp;
+    }
+
+    // The profile points - called by the bus code through the SFE_TK_PROFILE_* macros
+
+    /** An operation starts - an operation inside another is part of the outer one */
+    void begin(sfeTkBusHookOp_t op);
+
+    /** A phase of the current operation ends */
+    void phase(sfeTkProfilePhase_t thePhase);
+
+    /** A transfer chunk of the current operation ends */
+    void chunk(void)
+    {
+        if (_depth == 0 || !_bEnabled)
+            return;
+        phase(kSTkProfileTransfer);
+        _current.chunks++;
+    }
+
+    /** An operation ends */
+    void end(void);
+
+  private:
+    static void clear(sfeTkProfileRecord &record)
+    {
+        for (uint8_t i = 0; i < kSTkProfilePhases; i++)
+            record.phase[i] = 0;
+        record.chunks = 0;
+        record.count = 0;
+        record.maxTotal = 0;
+    }
+
+    sfeTkProfileRecord _stats[kSTkProfileOps];
+    sfeTkProfileRecord _current;
+    sfeTkProfileRecord _last;
+    sfeTkBusHookOp_t _lastOp;
+
+    uint8_t _depth;
+    sfeTkBusHookOp_t _op;
+    uint32_t _mark;
+    bool _bEnabled;
+};
+
+/** The profiler clock, in ticks - implemented by the platform layer */
+uint32_t sfeTkProfileClock(void);
+
+/** The rate of the profiler clock in ticks a second - 0 if it is not known */
+uint32_t sfeTkProfileClockHz(void);
+
+/** The profiler of the program - implemented by the platform layer */
+sfeTkProfiler &sfeTkProfilerInstance(void);
+
+inline void sfeTkProfiler::begin(sfeTkBusHookOp_t op)
+{
+    if (_depth++ > 0 || !_bEnabled)
+        return;
+
+    clear(_current);
+    _op = op;
+    _mark = sfeTkProfileClock();
+}
+
+inline void sfeTkProfiler::phase(sfeTkProfilePhase_t thePhase)
+{
+    if (_depth == 0 || !_bEnabled)
+        return;
+
+    uint32_t now = sfeTkProfileClock();
+    _current.phase[thePhase] += now - _mark;
+    _mark = now;
+}
+
+inline void sfeTkProfiler::end(void)
+{
+    if (_depth == 0 || --_depth > 0 || !_bEnabled)
+        return;
+
+    _current.phase[kSTkProfileTeardown] += sfeTkProfileClock() - _mark;
+    _current.count = 1;
+    _current.maxTotal = _current.total();
+    _last = _current;
+    _lastOp = _op;
+
+    sfeTkProfileRecord &stats = _stats[_op];
+    for (uint8_t i = 0; i < kSTkProfilePhases; i++)
+        stats.phase[i] += _current.phase[i];
+    stats.chunks += _current.chunks;
+    stats.count++;
+    if (_current.maxTotal > stats.maxTotal)
+        stats.maxTotal = _current.maxTotal;
+}
+
+/**
+ * @brief The scope of a profiled operation - declared by SFE_TK_PROFILE_OP()
+ */
+class sfeTkProfileScope
+{
+  public:
+    sfeTkProfileScope(sfeTkBusHookOp_t op)
+    {
+        sfeTkProfilerInstance().begin(op);
+    }
+
+    ~sfeTkProfileScope()
+    {
+        sfeTkProfilerInstance().end();
+    }
+
+    sfeTkProfileScope(const sfeTkProfileScope &) = delete;
+    sfeTkProfileScope &operator=(const sfeTkProfileScope &) = delete;
+};
+
+#if defined(SFE_TK_PROFILE_PHASES)
+
+#define SFE_TK_PROFILE_OP(op) sfeTkProfileScope sfeTkProfileScope_(op)
+#define SFE_TK_PROFILE_PHASE(thePhase) sfeTkProfilerInstance().phase(thePhase)
+#define SFE_TK_PROFILE_CHUNK() sfeTkProfilerInstance().chunk()
+
+#else
+
+#define SFE_TK_PROFILE_OP(op)
+#define SFE_TK_PROFILE_PHASE(thePhase)
+#define SFE_TK_PROFILE_CHUNK()
+
+#endif
@@ -0,0 +1,415 @@
+// sfeTkReactor.h
+//
+// Defines a single threaded event reactor - timers, interrupt (GPIO) events and bus completions - for the SparkFun
+// Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkBusRequest.h"
+
+/**
+ * @brief Reactor handler function. Called with the context passed when the handler was added.
+ */
+typedef void (*sfeTkReactorHandler_t)(void *context);
+
+/**
+ * @brief Run time statistics for a reactor handler - in time source units
+ */
+struct sfeTkReactorStats
+{
+    /** The number of times the handler ran */
+    uint32_t count;
+
+    /** The total run time of the handler */
+    uint32_t totalTime;
+
+    /** The longest run time of the handler */
+    uint32_t maxTime;
+
+    /** Timers only - the longest delay from the timer deadline to the handler running */
+    uint32_t maxLatency;
+};
+
+/**
+ * @brief A small, single threaded reactor that dispatches timer expirations, interrupt events (GPIO data ready)
+ *        and bus request completions to handlers.
+ *
+ * Ordering is deterministic: on each pass, ready handlers are dispatched in the order they were added - so
+ * add handlers in priority order. To bound the dispatch latency of a pass, the number of handlers run per pass
+ * can be limited (setMaxDispatch()); handlers not run are dispatched first on the next pass.
+ *
+ * signal() is safe to call from an interrupt: each event has a raised count written only by signal() and a
+ * handled count written only by the reactor, so no read-modify-write is shared between the two.
+ *
+ * Bus completions are polled on each pass (sfeTkBusRequest::done()). A completion callback can instead signal()
+ * an event handler, which avoids the polling.
+ *
+ * @tparam kMaxHandlers The maximum number of handlers
+ */
+template <uint16_t kMaxHandlers = 8> class sfeTkReactor
+{
+    static_assert(kMaxHandlers <= INT16_MAX, "sfeTkReactor handler ids are int16_t");
+
+  public:
+    /** Returned by the add methods when no handler slot is available */
+    static constexpr int16_t kNoHandler = -1;
+
+    /**--------------------------------------------------------------------------
+        @brief Constructor
+
+        @param now The time source for timers and run time statistics - typically micros()
+    */
+    sfeTkReactor(uint32_t (*now)(void))
+        : _now{now}, _nHandlers{0}, _maxDispatch{kMaxHandlers}, _next{0}, _lastDispatched{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add a timer handler
+
+        @param period The timer period, in time source units
+        @param handler The handler to call when the timer expires
+        @param context Passed to the handler
+        @param bPeriodic true to rearm the timer after it expires
+
+        @retval int16_t The handler id, or kNoHandler
+    */
+    int16_t addTimer(uint32_t period, sfeTkReactorHandler_t handler, void *context, bool bPeriodic = true)
+    {
+        int16_t id = add(kTimer, handler, context);
+        if (id == kNoHandler)
+            return id;
+
+        _handlers[id].period = period;
+        _handlers[id].bPeriodic = bPeriodic;
+        _handlers[id].deadline = _now() + period;
+        _handlers[id].bArmed = true;
+        return id;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add an event handler - run when the event is signaled (from a GPIO interrupt, a completion callback)
+
+        @param handler The handler to call when the event is signaled
+        @param context Passed to the handler
+
+        @retval int16_t The handler id - pass to signal(), or kNoHandler
+    */
+    int16_t addEvent(sfeTkReactorHandler_t handler, void *context)
+    {
+        int16_t id = add(kEvent, handler, context);
+        if (id != kNoHandler)
+            _handlers[id].bArmed = true;
+        return id;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add a bus completion handler - run once when the request is done. Rearm with watch().
+
+        @param request The request to watch
+        @param handler The handler to call when the request is done
+        @param context Passed to the handler
+
+        @retval int16_t The handler id, or kNoHandler
+    */
+    int16_t addCompletion(const sfeTkBusRequest &request, sfeTkReactorHandler_t handler, void *context)
+    {
+        int16_t id = add(kCompletion, handler, context);
+        if (id != kNoHandler)
+            watch(id, request);
+        return id;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Watch a (new) request with a completion handler
+
+        @param id The completion handler id
+        @param request The request to watch
+    */
+    void watch(int16_t id, const sfeTkBusRequest &request)
+    {
+        if (valid(id) && _handlers[id].kind == kCompletion)
+        {
+            _handlers[id].request = &request;
+            _handlers[id].bArmed = true;
+        }
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Signal an event. Safe to call from an interrupt or another task - but each event should have a
+               single signaling source.
+
+        @param id The event handler id
+    */
+    void signal(int16_t id)
+    {
+        if (!valid(id))
+            return;
+
+        // single byte load/store - atomic on every target, no read-modify-write shared with the reactor
+        uint8_t raised = __atomic_load_n(&_handlers[id].raised, __ATOMIC_RELAXED);
+        __atomic_store_n(&_handlers[id].raised, (uint8_t)(raised + 1), __ATOMIC_RELEASE);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Restart a timer - from now, with a new period
+
+        @param id The timer handler id
+        @param period The new timer period
+    */
+    void restartTimer(int16_t id, uint32_t period)
+    {
+        if (valid(id) && _handlers[id].kind == kTimer)
+        {
+            _handlers[id].period = period;
+            _handlers[id].deadline = _now() + period;
+            _handlers[id].bArmed = true;
+        }
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Stop a timer, or stop watching a request
+
+        @param id The handler id
+    */
+    void disarm(int16_t id)
+    {
+        if (valid(id))
+            _handlers[id].bArmed = false;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Limit the number of handlers run per pass - bounds the time a pass takes
+
+        @param maxDispatch The maximum number of handlers per pass (> 0)
+    */
+    void setMaxDispatch(uint16_t maxDispatch)
+    {
+        if (maxDispatch > 0)
+            _maxDispatch = maxDispatch;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Run one dispatch pass - call from loop()
+
+        @retval uint16_t The number of handlers run
+    */
+    uint16_t runOnce(void)
+    {
+        uint16_t nRun = 0;
+
+        // start where the last (limited) pass stopped, so every ready handler gets its turn
+        for (uint16_t n = 0; n < _nHandlers && nRun < _maxDispatch; n++)
+        {
+            uint16_t id = (uint16_t)((_next + n) % _nHandlers);
+            uint32_t now = _now();
+            uint32_t latency;
+
+            if (!ready(_handlers[id], now, latency))
+                continue;
+
+            dispatch(_handlers[id], now, latency);
+            nRun++;
+        }
+
+        // if the pass was cut short, continue with the next handler on the next pass. Otherwise, restart
+        // with the first handler, which keeps the order deterministic.
+        _next = nRun < _maxDispatch ? 0 : (uint16_t)((_lastDispatched + 1) % _nHandlers);
+        return nRun;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The time until the next timer expires - how long an idle loop can sleep
+
+        @param maxWait The value returned if no timer is armed
+
+        @retval uint32_t Time to the next deadline, 0 if a timer has expired
+    */
+    uint32_t timeToNextTimer(uint32_t maxWait) const
+    {
+        uint32_t now = _now();
+        uint32_t wait = maxWait;
+
+        for (uint16_t id = 0; id < _nHandlers; id++)
+        {
+            const Handler &handler = _handlers[id];
+            if (handler.kind != kTimer || !handler.bArmed)
+                continue;
+
+            int32_t left = (int32_t)(handler.deadline - now);
+            if (left <= 0)
+                return 0;
+            if ((uint32_t)left < wait)
+                wait = (uint32_t)left;
+        }
+        return wait;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The run time statistics of a handler
+
+        @param id The handler id
+
+        @retval const sfeTkReactorStats& The statistics
+    */
+    const sfeTkReactorStats &stats(int16_t id) const
+    {
+        return _handlers[valid(id) ? id : 0].stats;
+    }
+
+    /** Reset the run time statistics of all handlers */
+    void resetStats(void)
+    {
+        for (uint16_t id = 0; id < _nHandlers; id++)
+            _handlers[id].stats = sfeTkReactorStats{0, 0, 0, 0};
+    }
+
+    /** The number of handlers */
+    uint16_t nHandlers(void) const
+    {
+        return _nHandlers;
+    }
+
+  private:
+    enum Kind : uint8_t
+    {
+        kTimer,
+        kEvent,
+        kCompletion
+    };
+
+    struct Handler
+    {
+        Kind kind;
+        bool bArmed;
+        bool bPeriodic;
+
+        // events - raised is only written by signal(), handled only by the reactor
+        uint8_t raised;
+        uint8_t handled;
+
+        sfeTkReactorHandler_t handler;
+        void *context;
+
+        uint32_t period;
+        uint32_t deadline;
+        const sfeTkBusRequest *request;
+
+        sfeTkReactorStats stats;
+    };
+
+    bool valid(int16_t id) const
+    {
+        return id >= 0 && id < (int16_t)_nHandlers;
+    }
+
+    int16_t add(Kind kind, sfeTkReactorHandler_t handler, void *context)
+    {
+        if (_nHandlers >= kMaxHandlers || !handler)
+            return kNoHandler;
+
+        Handler &entry = _handlers[_nHandlers];
+        entry.kind = kind;
+        entry.bArmed = false;
+        entry.bPeriodic = false;
+        entry.raised = 0;
+        entry.handled = 0;
+        entry.handler = handler;
+        entry.context = context;
+        entry.period = 0;
+        entry.deadline = 0;
+        entry.request = nullptr;
+        entry.stats = sfeTkReactorStats{0, 0, 0, 0};
+
+        return (int16_t)_nHandlers++;
+    }
+
+    // Is the handler ready to run? Consumes the event/timer/completion if so.
+    bool ready(Handler &handler, uint32_t now, uint32_t &latency)
+    {
+        latency = 0;
+        if (!handler.bArmed)
+            return false;
+
+        switch (handler.kind)
+        {
+        case kTimer:
+            if ((int32_t)(now - handler.deadline) < 0)
+                return false;
+
+            latency = now - handler.deadline;
+            if (handler.bPeriodic)
+            {
+                // stay on the period grid - unless we've fallen more than a period behind
+                handler.deadline += handler.period;
+                if ((int32_t)(now - handler.deadline) >= 0)
+                    handler.deadline = now + handler.period;
+            }
+            else
+                handler.bArmed = false;
+            return true;
+
+        case kEvent: {
+            uint8_t raised = __atomic_load_n(&handler.raised, __ATOMIC_ACQUIRE);
+            if (raised == handler.handled)
+                return false;
+            // multiple signals since the last pass collapse into one dispatch
+            handler.handled = raised;
+            return true;
+        }
+
+        case kCompletion:
+            if (!handler.request || !handler.request->done())
+                return false;
+            handler.bArmed = false;
+            return true;
+        }
+        return false;
+    }
+
+    void dispatch(Handler &handler, uint32_t start, uint32_t latency)
+    {
+        handler.handler(handler.context);
+
+        uint32_t runTime = _now() - start;
+        sfeTkReactorStats &stats = handler.stats;
+        stats.count++;
+        stats.totalTime += runTime;
+        if (runTime > stats.maxTime)
+            stats.maxTime = runTime;
+        if (latency > stats.maxLatency)
+            stats.maxLatency = latency;
+
+        _lastDispatched = (uint16_t)(&handler - _handlers);
+    }
+
+    uint32_t (*_now)(void);
+
+    Handler _handlers[kMaxHandlers];
+    uint16_t _nHandlers;
+    uint16_t _maxDispatch;
+    uint16_t _next;
+    uint16_t _lastDispatched;
+};
@@ -0,0 +1,224 @@
+// sfeTkReactorEpoll.h
+//
+// Defines an epoll/timerfd backed wait for the sfeTkReactor - Linux host builds - for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+// Note: This file is Linux only (epoll, timerfd, eventfd). It is not included by SparkFun_Toolkit.h, include it
+//       directly in host builds.
+
+#if defined(__linux__)
+
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "sfeTkReactor.h"
+
+/**
+ * @brief Runs a sfeTkReactor on Linux, sleeping in epoll_wait() until a timer expires, a watched file descriptor
+ *        (a GPIO line event fd, a UART) is ready, or another thread wakes the loop.
+ *
+ * The reactor time source must count microseconds - it is used to arm the timerfd.
+ *
+ * Other threads that signal() an event, or complete a watched bus request, call wake() so the loop runs.
+ *
+ * @tparam kMaxHandlers The handler count of the reactor
+ * @tparam kMaxFds The maximum number of watched file descriptors
+ */
+template <uint16_t kMaxHandlers = 8, uint8_t kMaxFds = 4> class sfeTkReactorEpoll
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor
+
+        @param reactor The reactor to run
+    */
+    sfeTkReactorEpoll(sfeTkReactor<kMaxHandlers> &reactor)
+        : _reactor{reactor}, _epollFd{-1}, _timerFd{-1}, _wakeFd{-1}, _nFds{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Destructor - closes the epoll, timer and wake descriptors
+    */
+    ~sfeTkReactorEpoll()
+    {
+        end();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Create the epoll instance, the timer and the wakeup descriptors
+
+        @retval sfeTkError_t kSTkErrOk on success, kSTkErrFail on failure
+    */
+    sfeTkError_t begin(void)
+    {
+        if (_epollFd >= 0)
+            return kSTkErrOk;
+
+        _epollFd = epoll_create1(EPOLL_CLOEXEC);
+        _timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        _wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (_epollFd < 0 || _timerFd < 0 || _wakeFd < 0 || watch(_timerFd, EPOLLIN) != kSTkErrOk ||
+            watch(_wakeFd, EPOLLIN) != kSTkErrOk)
+        {
+            end();
+            return kSTkErrFail;
+        }
+        return kSTkErrOk;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Close the descriptors created by begin(). Watched descriptors are not closed.
+    */
+    void end(void)
+    {
+        int *fds[] = {&_wakeFd, &_timerFd, &_epollFd};
+        for (int *fd : fds)
+        {
+            if (*fd >= 0)
+                close(*fd);
+            *fd = -1;
+        }
+        _nFds = 0;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Signal a reactor event when a file descriptor is ready
+
+        @param fd The descriptor to watch - for a GPIO, a line event descriptor from the gpio character device
+        @param eventId The reactor event handler to signal
+        @param events The epoll events to watch for
+
+        @retval sfeTkError_t kSTkErrOk on success, kSTkErrFail on failure or if no slot is available
+    */
+    sfeTkError_t addFd(int fd, int16_t eventId, uint32_t events = EPOLLIN | EPOLLPRI)
+    {
+        if (_epollFd < 0 || _nFds >= kMaxFds)
+            return kSTkErrFail;
+
+        if (watch(fd, events) != kSTkErrOk)
+            return kSTkErrFail;
+
+        _fds[_nFds].fd = fd;
+        _fds[_nFds].eventId = eventId;
+        _nFds++;
+        return kSTkErrOk;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Wake the loop - safe to call from any thread
+    */
+    void wake(void)
+    {
+        uint64_t one = 1;
+        if (_wakeFd >= 0 && write(_wakeFd, &one, sizeof(one)) < 0)
+        {
+            // the counter is saturated - the loop is already awake
+        }
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Sleep until there is work (or maxWaitMS passes), then run one reactor pass
+
+        @param maxWaitMS The longest time to sleep, in milliseconds. -1 to sleep until there is work.
+
+        @retval uint16_t The number of handlers run
+    */
+    uint16_t runOnce(int maxWaitMS)
+    {
+        if (_epollFd < 0)
+            return 0;
+
+        // arm the timer for the next reactor deadline - an expired timer fires immediately
+        uint32_t wait = _reactor.timeToNextTimer(UINT32_MAX);
+        struct itimerspec spec = {};
+        if (wait != UINT32_MAX)
+        {
+            if (wait == 0)
+                wait = 1;
+            spec.it_value.tv_sec = wait / 1000000;
+            spec.it_value.tv_nsec = (long)(wait % 1000000) * 1000;
+        }
+        timerfd_settime(_timerFd, 0, &spec, nullptr);
+
+        struct epoll_event ready[kMaxFds + 2];
+        int nReady = epoll_wait(_epollFd, ready, kMaxFds + 2, maxWaitMS);
+
+        for (int i = 0; i < nReady; i++)
+            drain(ready[i].data.fd);
+
+        return _reactor.runOnce();
+    }
+
+  private:
+    sfeTkError_t watch(int fd, uint32_t events)
+    {
+        struct epoll_event event = {};
+        event.events = events;
+        event.data.fd = fd;
+        return epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) == 0 ? kSTkErrOk : kSTkErrFail;
+    }
+
+    void drain(int fd)
+    {
+        uint64_t count;
+        if (fd == _timerFd || fd == _wakeFd)
+        {
+            // reset the counter - the reactor pass does the work
+            ssize_t n = read(fd, &count, sizeof(count));
+            (void)n;
+            return;
+        }
+
+        // watched descriptors are level triggered - the handler must consume the data (read the line event)
+        for (uint8_t i = 0; i < _nFds; i++)
+        {
+            if (_fds[i].fd == fd)
+                _reactor.signal(_fds[i].eventId);
+        }
+    }
+
+    struct Watch
+    {
+        int fd;
+        int16_t eventId;
+    };
+
+    sfeTkReactor<kMaxHandlers> &_reactor;
+
+    int _epollFd;
+    int _timerFd;
+    int _wakeFd;
+
+    Watch _fds[kMaxFds];
+    uint8_t _nFds;
+};
+
+#endif
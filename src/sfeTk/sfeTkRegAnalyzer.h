@@ -0,0 +1,575 @@
+// sfeTkRegAnalyzer.h
+//
+// Defines an analysis mode for the register traffic of drivers - access counts for each register, and the reads
+// and writes a driver could avoid
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sfeTkBusHooks.h"
+#include "sfeTkFlatMap.h"
+#include "sfeTkRegister.h"
+
+// The analyzer sees each register operation of the devices attached to it - through the sfeTkRegAnalyzerHooks
+// hook policy - and keeps, for each (device, register):
+//
+//   - the reads and writes, the bytes moved and the time they took
+//   - redundant reads - a read that returned the value the register already had, when the register is not
+//     volatile. A driver that cached the value would not have read it.
+//   - read-modify-write reads - a read followed by a write of the same register, with nothing else on the device
+//     in between. A shadow copy of the register (sfeTkRegShadow) makes the read unnecessary.
+//   - redundant writes - a write of the value the register already has
+//
+// The value of a register is kept as a hash, so the analyzer's RAM does not depend on the register widths. The
+// register descriptors of a device (sfeTkRegister), when given, say which registers are volatile - the device
+// changes them, so reading the same value again is not avoidable. Without descriptors, a register is judged by its
+// values alone, and marked as undescribed in the report.
+//
+// This is a development tool - it costs a flat map lookup and a hash of the data for each operation.
+
+/**
+ * @brief Collects the register access statistics of devices, and reports the avoidable operations
+ *
+ * @tparam Clock A class with a static uint32_t now(void) method - the time of the operations
+ * @tparam kRegisters The most (device, register) pairs kept - operations on others are counted as untracked
+ * @tparam kDevices The most devices
+ */
+template <typename Clock, size_t kRegisters = 64, size_t kDevices = 8> class sfeTkRegAnalyzer
+{
+  public:
+    /** The clock of the analyzer - used by the hook policy */
+    typedef Clock ClockType;
+
+    /**
+     * @brief The statistics of a register, or the totals of all registers
+     */
+    struct Stats
+    {
+        /** The number of reads and writes */
+        uint32_t reads;
+        uint32_t writes;
+
+        /** The bytes read and written */
+        uint32_t bytesRead;
+        uint32_t bytesWritten;
+
+        /** Reads that returned the value the register already had */
+        uint32_t redundantReads;
+
+        /** Reads followed by a write of the register - avoidable with a shadow copy */
+        uint32_t rmwReads;
+
+        /** Writes of the value the register already had */
+        uint32_t redundantWrites;
+
+        /** The time of the reads and writes, in the units of the clock */
+        uint32_t readTime;
+        uint32_t writeTime;
+
+        /** The number of operations that could be avoided */
+        uint32_t avoidable(void) const
+        {
+            return redundantReads + rmwReads + redundantWrites;
+        }
+
+        /** The estimated time saved without the avoidable operations - their count times the average time */
+        uint32_t saved(void) const
+        {
+            uint32_t time = 0;
+            if (reads > 0)
+                time += (uint32_t)((uint64_t)readTime * (redundantReads + rmwReads) / reads);
+            if (writes > 0)
+                time += (uint32_t)((uint64_t)writeTime * redundantWrites / writes);
+            return time;
+        }
+    };
+
+    sfeTkRegAnalyzer(void) : _nDevices{0}, _untracked{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add a device to analyze - normally called by sfeTkRegAnalyzerHooks::attach()
+
+        @param name The name of the device in the report
+        @param regs The register descriptors of the device, or nullptr
+        @param nRegs The number of descriptors
+
+        @retval int The device number, or -1 if there are already kDevices devices
+    */
+    int addDevice(const char *name, const sfeTkRegister *regs = nullptr, size_t nRegs = 0)
+    {
+        if (_nDevices >= kDevices)
+            return -1;
+
+        Device &device = _devices[_nDevices];
+        device.name = name;
+        device.regs = regs;
+        device.nRegs = regs ? nRegs : 0;
+        device.lastRead = kNoRegister;
+        device.bLastReadCounted = false;
+        return (int)_nDevices++;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Record a bus operation of a device - called from the after hook
+
+        Failed operations, and operations without a register (writeByte(), writeRegion()) are not counted. The
+        steps of a transaction are counted as separate operations, each taking an equal share of its time.
+
+        @param device The device number from addDevice()
+        @param info The operation
+    */
+    void record(int device, const sfeTkBusHookInfo &info)
+    {
+        if (device < 0 || (size_t)device >= _nDevices || info.result != kSTkErrOk)
+            return;
+
+        Device &theDevice = _devices[device];
+        switch (info.op)
+        {
+        case kSTkBusHookWriteRegisterByte:
+        case kSTkBusHookWriteRegisterWord:
+        case kSTkBusHookWriteRegisterRegion:
+        case kSTkBusHookWriteRegister16Region:
+            recordAccess(device, theDevice, false, info.reg, info.data, info.length, info.duration);
+            break;
+
+        case kSTkBusHookReadRegisterByte:
+        case kSTkBusHookReadRegisterWord:
+        case kSTkBusHookReadRegisterRegion:
+        case kSTkBusHookReadRegister16Region:
+            recordAccess(device, theDevice, true, info.reg, info.data, info.length, info.duration);
+            break;
+
+        case kSTkBusHookTransaction:
+            for (size_t i = 0; info.steps && i < info.length; i++)
+            {
+                const sfeTkTxnStep &step = info.steps[i];
+                uint8_t value[2];
+                size_t length = 0;
+                const uint8_t *data = sfeTkTxnStepData(step, value, length);
+                uint32_t duration = info.duration / (uint32_t)info.length;
+
+                if (step.op == kSTkBusOpWriteRegisterRegion || step.op == kSTkBusOpWriteRegister16Region)
+                    recordAccess(device, theDevice, false, step.reg, data, length, duration);
+                else if (step.op == kSTkBusOpReadRegisterRegion || step.op == kSTkBusOpReadRegister16Region)
+                    recordAccess(device, theDevice, true, step.reg, step.data, length, duration);
+                else
+                    theDevice.lastRead = kNoRegister;
+            }
+            break;
+
+        default:
+            // an operation without a register - the device did something between a read and a write
+            theDevice.lastRead = kNoRegister;
+            break;
+        }
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The statistics of a register
+
+        @param device The device number
+        @param reg The register
+
+        @retval Stats* The statistics, or nullptr if the register was not accessed
+    */
+    const Stats *stats(int device, uint16_t reg) const
+    {
+        const Entry *entry = _entries.find(key(device, reg));
+        return entry ? &entry->stats : nullptr;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The totals of all registers - use saved() for the time saved, not the saved() of the totals
+    */
+    Stats totals(void) const
+    {
+        Stats total = {};
+        for (size_t i = 0; i < _entries.size(); i++)
+        {
+            const Stats &stats = _entries.valueAt(i).stats;
+            total.reads += stats.reads;
+            total.writes += stats.writes;
+            total.bytesRead += stats.bytesRead;
+            total.bytesWritten += stats.bytesWritten;
+            total.redundantReads += stats.redundantReads;
+            total.rmwReads += stats.rmwReads;
+            total.redundantWrites += stats.redundantWrites;
+            total.readTime += stats.readTime;
+            total.writeTime += stats.writeTime;
+        }
+        return total;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The estimated time saved without the avoidable operations of all registers - the sum for each
+        register, as each has its own average time
+    */
+    uint32_t saved(void) const
+    {
+        uint32_t time = 0;
+        for (size_t i = 0; i < _entries.size(); i++)
+            time += _entries.valueAt(i).stats.saved();
+        return time;
+    }
+
+    /** The number of operations on registers that did not fit in the analyzer */
+    uint32_t untracked(void) const
+    {
+        return _untracked;
+    }
+
+    /** The number of (device, register) pairs accessed */
+    size_t size(void) const
+    {
+        return _entries.size();
+    }
+
+    /** The number of devices */
+    size_t devices(void) const
+    {
+        return _nDevices;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Clear the statistics and known register values - the devices are kept
+    */
+    void reset(void)
+    {
+        _entries.clear();
+        _untracked = 0;
+        for (size_t i = 0; i < _nDevices; i++)
+            _devices[i].lastRead = kNoRegister;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Print the report - the avoidable operations, ranked by the time they cost, then the most accessed
+        registers
+
+        A register that is volatile is marked "v", one without a descriptor "?" - its redundant reads may be the
+        device returning the same value by chance.
+
+        @param out Where to print - Serial, or any class with println(const char *)
+        @param maxRows The most registers in each table
+        @param units The units of the clock, for the headings
+    */
+    template <typename Out> void report(Out &out, size_t maxRows = 10, const char *units = "us") const
+    {
+        char line[112];
+        uint16_t order[kRegisters];
+        size_t nOrder = 0;
+
+        Stats total = totals();
+        snprintf(line, sizeof(line), "Register analysis: %lu reads, %lu writes, %lu avoidable, ~%lu %s to save",
+                 (unsigned long)total.reads, (unsigned long)total.writes, (unsigned long)total.avoidable(),
+                 (unsigned long)saved(), units);
+        out.println(line);
+        if (_untracked > 0)
+        {
+            snprintf(line, sizeof(line), "  %lu operations on registers not tracked - the analyzer is full",
+                     (unsigned long)_untracked);
+            out.println(line);
+        }
+
+        // avoidable operations, most time saved first
+        for (size_t i = 0; i < _entries.size(); i++)
+            if (_entries.valueAt(i).stats.avoidable() > 0)
+                insert(order, nOrder, (uint16_t)i, true);
+
+        out.println("");
+        out.println("Avoidable operations:");
+        snprintf(line, sizeof(line), "  %-12s %6s %7s %7s %9s %9s %9s %10s", "device", "reg", "reads", "writes",
+                 "redundant", "rmw reads", "rewrites", units);
+        out.println(line);
+        for (size_t i = 0; i < nOrder && i < maxRows; i++)
+        {
+            const Entry &entry = _entries.valueAt(order[i]);
+            const Stats &stats = entry.stats;
+            snprintf(line, sizeof(line), "  %-12s 0x%04x%c %7lu %7lu %9lu %9lu %9lu %10lu", deviceName(order[i]),
+                     (unsigned)(_entries.keyAt(order[i]) & 0xFFFF), mark(entry), (unsigned long)stats.reads,
+                     (unsigned long)stats.writes, (unsigned long)stats.redundantReads, (unsigned long)stats.rmwReads,
+                     (unsigned long)stats.redundantWrites, (unsigned long)stats.saved());
+            out.println(line);
+        }
+        if (nOrder == 0)
+            out.println("  none");
+
+        // the heat map - the most accessed registers
+        nOrder = 0;
+        uint32_t most = 1;
+        for (size_t i = 0; i < _entries.size(); i++)
+        {
+            insert(order, nOrder, (uint16_t)i, false);
+            const Stats &stats = _entries.valueAt(i).stats;
+            if (stats.reads + stats.writes > most)
+                most = stats.reads + stats.writes;
+        }
+
+        out.println("");
+        out.println("Most accessed registers:");
+        snprintf(line, sizeof(line), "  %-12s %6s %7s %7s %9s %9s", "device", "reg", "reads", "writes", "bytes",
+                 units);
+        out.println(line);
+        for (size_t i = 0; i < nOrder && i < maxRows; i++)
+        {
+            const Entry &entry = _entries.valueAt(order[i]);
+            const Stats &stats = entry.stats;
+            int n = snprintf(line, sizeof(line), "  %-12s 0x%04x%c %7lu %7lu %9lu %9lu ", deviceName(order[i]),
+                             (unsigned)(_entries.keyAt(order[i]) & 0xFFFF), mark(entry),
+                             (unsigned long)stats.reads, (unsigned long)stats.writes,
+                             (unsigned long)(stats.bytesRead + stats.bytesWritten),
+                             (unsigned long)(stats.readTime + stats.writeTime));
+
+            // a bar of up to 20 characters, scaled to the most accessed register
+            size_t bar = (size_t)(((uint64_t)(stats.reads + stats.writes) * 20 + most - 1) / most);
+            for (size_t j = 0; j < bar && n >= 0 && (size_t)n < sizeof(line) - 1; j++)
+                line[n++] = '#';
+            if (n >= 0 && (size_t)n < sizeof(line))
+                line[n] = '\0';
+            out.println(line);
+        }
+    }
+
+  private:
+    static const uint16_t kNoRegister = 0xFFFF;
+
+    // entry flags
+    static const uint8_t kKnown = 0x01;     // the value hash is the register's value
+    static const uint8_t kVolatile = 0x02;  // the descriptor says the device changes the register
+    static const uint8_t kDescribed = 0x04; // the register has a descriptor
+    static const uint8_t kChecked = 0x08;   // the descriptors were searched
+
+    struct Entry
+    {
+        Stats stats;
+        uint32_t hash;
+        uint16_t length;
+        uint8_t flags;
+    };
+
+    struct Device
+    {
+        const char *name;
+        const sfeTkRegister *regs;
+        size_t nRegs;
+
+        // the register of the last operation, if it was a read - for read-modify-write
+        uint16_t lastRead;
+        bool bLastReadCounted;
+    };
+
+    static uint32_t key(int device, uint16_t reg)
+    {
+        return (uint32_t)device << 16 | reg;
+    }
+
+    static uint32_t hash(const uint8_t *data, size_t length)
+    {
+        uint32_t value = 2166136261UL;
+        for (size_t i = 0; data && i < length; i++)
+            value = (value ^ data[i]) * 16777619UL;
+        return value;
+    }
+
+    // the entry of a register, added if new - nullptr if the analyzer is full
+    Entry *entry(int device, uint16_t reg, size_t length)
+    {
+        uint32_t theKey = key(device, reg);
+        Entry *found = _entries.find(theKey);
+        if (found)
+            return found;
+
+        Entry newEntry = {};
+        const Device &theDevice = _devices[device];
+        newEntry.flags = kChecked;
+        for (size_t i = 0; i < theDevice.nRegs; i++)
+        {
+            // a register the access starts at, or one it covers
+            const sfeTkRegister &desc = theDevice.regs[i];
+            if (desc.address < reg + (length > 0 ? length : 1) && reg < desc.address + desc.width)
+            {
+                newEntry.flags |= kDescribed;
+                if (desc.isVolatile())
+                    newEntry.flags |= kVolatile;
+            }
+        }
+        if (!_entries.set(theKey, newEntry))
+            return nullptr;
+        return _entries.find(theKey);
+    }
+
+    void recordAccess(int device, Device &theDevice, bool bRead, uint16_t reg, const uint8_t *data, size_t length,
+                      uint32_t duration)
+    {
+        Entry *theEntry = entry(device, reg, length);
+        if (!theEntry)
+        {
+            _untracked++;
+            theDevice.lastRead = kNoRegister;
+            return;
+        }
+
+        Stats &stats = theEntry->stats;
+        uint32_t value = hash(data, length);
+        bool bSame = (theEntry->flags & kKnown) && theEntry->length == length && theEntry->hash == value &&
+                     !(theEntry->flags & kVolatile);
+
+        if (bRead)
+        {
+            stats.reads++;
+            stats.bytesRead += (uint32_t)length;
+            stats.readTime += duration;
+            if (bSame)
+                stats.redundantReads++;
+
+            theDevice.lastRead = reg;
+            theDevice.bLastReadCounted = bSame;
+        }
+        else
+        {
+            stats.writes++;
+            stats.bytesWritten += (uint32_t)length;
+            stats.writeTime += duration;
+            if (bSame)
+                stats.redundantWrites++;
+
+            // the read before this write was only to modify the value - unless it was already redundant
+            if (theDevice.lastRead == reg && !theDevice.bLastReadCounted && !(theEntry->flags & kVolatile))
+                stats.rmwReads++;
+            theDevice.lastRead = kNoRegister;
+        }
+
+        theEntry->hash = value;
+        theEntry->length = (uint16_t)length;
+        theEntry->flags |= kKnown;
+    }
+
+    const char *deviceName(size_t index) const
+    {
+        const char *name = _devices[_entries.keyAt(index) >> 16].name;
+        return name ? name : "?";
+    }
+
+    static char mark(const Entry &entry)
+    {
+        if (entry.flags & kVolatile)
+            return 'v';
+        return (entry.flags & kDescribed) ? ' ' : '?';
+    }
+
+    // insert an entry index in order - by time saved, or by the number of accesses
+    void insert(uint16_t *order, size_t &nOrder, uint16_t index, bool bBySaved) const
+    {
+        size_t i = nOrder++;
+        for (; i > 0 && ranksAbove(index, order[i - 1], bBySaved); i--)
+            order[i] = order[i - 1];
+        order[i] = index;
+    }
+
+    // does one entry rank above another - time saved then the number avoidable, or the number of accesses
+    bool ranksAbove(uint16_t index, uint16_t other, bool bBySaved) const
+    {
+        const Stats &a = _entries.valueAt(index).stats;
+        const Stats &b = _entries.valueAt(other).stats;
+        if (!bBySaved)
+            return a.reads + a.writes > b.reads + b.writes;
+        return a.saved() != b.saved() ? a.saved() > b.saved() : a.avoidable() > b.avoidable();
+    }
+
+    sfeTkFlatMap<uint32_t, Entry, kRegisters> _entries;
+    Device _devices[kDevices];
+    size_t _nDevices;
+    uint32_t _untracked;
+};
+
+/**
+ * @brief The hook policy that feeds a bus's operations to an analyzer. The bus is one device - attach it to the
+ * analyzer with its name and register descriptors.
+ *
+ * @code
+ *     sfeTkArdRegAnalyzer analyzer;
+ *     sfeTkArdI2CHooked<sfeTkArdRegAnalyzerHooks> imu;
+ *
+ *     imu.init(Wire, kExampleImuAddress);
+ *     imu.hooks().attach(analyzer, "imu", kExampleImuRegisters, kExampleImuRegisterCount);
+ *     ... run the driver ...
+ *     analyzer.report(Serial);
+ * @endcode
+ *
+ * @tparam Analyzer The analyzer class - an sfeTkRegAnalyzer
+ */
+template <typename Analyzer> class sfeTkRegAnalyzerHooks
+{
+  public:
+    static const bool kEnabled = true;
+
+    sfeTkRegAnalyzerHooks(void) : _analyzer{nullptr}, _device{-1}, _depth{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Attach the bus to an analyzer
+
+        @param analyzer The analyzer
+        @param name The name of the device in the report
+        @param regs The register descriptors of the device, or nullptr
+        @param nRegs The number of descriptors
+
+        @retval bool false if the analyzer has no room for another device
+    */
+    bool attach(Analyzer &analyzer, const char *name, const sfeTkRegister *regs = nullptr, size_t nRegs = 0)
+    {
+        _device = analyzer.addDevice(name, regs, nRegs);
+        _analyzer = _device >= 0 ? &analyzer : nullptr;
+        return _analyzer != nullptr;
+    }
+
+    uint32_t now(void)
+    {
+        return _analyzer ? Analyzer::ClockType::now() : 0;
+    }
+
+    void before(const sfeTkBusHookInfo &)
+    {
+        _depth++;
+    }
+
+    void after(const sfeTkBusHookInfo &info)
+    {
+        // only the outer operation - a bus that runs a transaction as separate operations hooks those too
+        if (--_depth == 0 && _analyzer)
+            _analyzer->record(_device, info);
+    }
+
+  private:
+    Analyzer *_analyzer;
+    int _device;
+    uint8_t _depth;
+};
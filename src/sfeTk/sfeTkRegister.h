@@ -0,0 +1,525 @@
+// sfeTkRegister.h
+//
+// Defines register map descriptors - registers, fields, burst groups and a shadow cache - for the SparkFun
+// Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkBitset.h"
+#include "sfeTkIBus.h"
+
+// The descriptors in this file are literal types, so a device's register map is a set of constexpr constants -
+// in flash, or folded into the code that uses them. They are normally generated from a register description by
+// tools/sfeTkRegGen.py, rather than written by hand.
+
+/**
+ * @brief Returned when a register is read that is write only, or written that is read only
+ */
+const sfeTkError_t kSTkErrRegNoAccess = kSTkErrFail * (kSTkErrBaseRegister + 1);
+
+/**
+ * @brief Returned when a field of a write only register is written, and the shadow cache has no value for the
+ * register to merge the field into
+ */
+const sfeTkError_t kSTkErrRegNotCached = kSTkErrFail * (kSTkErrBaseRegister + 2);
+
+/**
+ * @brief The access a register allows
+ */
+enum sfeTkRegAccess_t : uint8_t
+{
+    kSTkRegReadOnly = 0x01,
+    kSTkRegWriteOnly = 0x02,
+    kSTkRegReadWrite = 0x03
+};
+
+/**
+ * @brief Register flags
+ */
+const uint8_t kSTkRegVolatile = 0x01;  // the device changes the value - never cached
+const uint8_t kSTkRegBigEndian = 0x02; // a multi-byte value is sent high byte first
+const uint8_t kSTkRegAddress16 = 0x04; // the register address is 16 bits
+
+/**
+ * @brief The shadow slot of a register that is not cached
+ */
+const uint16_t kSTkRegNoShadow = 0xFFFF;
+
+/**
+ * @brief A device register - address, width, access, flags, reset value and its place in the shadow cache
+ */
+struct sfeTkRegister
+{
+    /** The register address */
+    uint16_t address;
+
+    /** The width of the register in bytes, 1 to 4 */
+    uint8_t width;
+
+    /** The access allowed - an sfeTkRegAccess_t value */
+    uint8_t access;
+
+    /** The kSTkReg* flags */
+    uint8_t flags;
+
+    /** The offset of the register in the shadow cache, or kSTkRegNoShadow */
+    uint16_t shadow;
+
+    /** The value of the register after a device reset */
+    uint32_t reset;
+
+    /** Can the register be read? */
+    constexpr bool readable(void) const
+    {
+        return (access & kSTkRegReadOnly) != 0;
+    }
+
+    /** Can the register be written? */
+    constexpr bool writable(void) const
+    {
+        return (access & kSTkRegWriteOnly) != 0;
+    }
+
+    /** Does the device change the value? */
+    constexpr bool isVolatile(void) const
+    {
+        return (flags & kSTkRegVolatile) != 0;
+    }
+
+    /** Does the register have a slot in the shadow cache? */
+    constexpr bool cacheable(void) const
+    {
+        return shadow != kSTkRegNoShadow;
+    }
+};
+
+/**
+ * @brief A field of a register - a run of bits
+ */
+struct sfeTkRegField
+{
+    /** The register that holds the field */
+    sfeTkRegister reg;
+
+    /** The bit position of the lowest bit of the field */
+    uint8_t shift;
+
+    /** The number of bits in the field, 1 to 32 */
+    uint8_t width;
+
+    /** The mask of the field, in register position */
+    constexpr uint32_t mask(void) const
+    {
+        return (width >= 32 ? 0xFFFFFFFFu : (((uint32_t)1 << width) - 1)) << shift;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The value of the field in a register value
+
+        @param regValue The register value
+
+        @retval uint32_t The field value
+    */
+    constexpr uint32_t get(uint32_t regValue) const
+    {
+        return (regValue & mask()) >> shift;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief A register value with the field set - the other bits are unchanged
+
+        @param regValue The register value
+        @param value The field value - bits outside the field are dropped
+
+        @retval uint32_t The new register value
+    */
+    constexpr uint32_t set(uint32_t regValue, uint32_t value) const
+    {
+        return (regValue & ~mask()) | ((value << shift) & mask());
+    }
+};
+
+/**
+ * @brief A burst group - a contiguous run of registers read with one bus operation
+ */
+struct sfeTkRegBurst
+{
+    /** The address of the first register */
+    uint16_t address;
+
+    /** The number of bytes read */
+    uint16_t length;
+
+    /** kSTkRegAddress16 if the register addresses are 16 bits */
+    uint8_t flags;
+
+    /** Is a register in the group? */
+    constexpr bool contains(const sfeTkRegister &reg) const
+    {
+        return reg.address >= address && reg.address + reg.width <= address + length;
+    }
+
+    /** The offset of a register in the group's buffer */
+    constexpr size_t offset(const sfeTkRegister &reg) const
+    {
+        return reg.address - address;
+    }
+};
+
+/**
+ * @brief The value of a register, from its bytes as sent on the bus
+ *
+ * @param reg The register
+ * @param bytes The bytes - reg.width of them
+ *
+ * @retval uint32_t The value
+ */
+inline uint32_t sfeTkRegDecode(const sfeTkRegister &reg, const uint8_t *bytes)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < reg.width; i++)
+    {
+        uint8_t byte = (reg.flags & kSTkRegBigEndian) ? bytes[i] : bytes[reg.width - 1 - i];
+        value = (value << 8) | byte;
+    }
+    return value;
+}
+
+/**
+ * @brief The bytes of a register value, as sent on the bus
+ *
+ * @param reg The register
+ * @param value The value
+ * @param[out] bytes The bytes - reg.width of them
+ */
+inline void sfeTkRegEncode(const sfeTkRegister &reg, uint32_t value, uint8_t *bytes)
+{
+    for (uint8_t i = 0; i < reg.width; i++)
+    {
+        uint8_t byte = (uint8_t)(value >> (8 * i));
+        bytes[(reg.flags & kSTkRegBigEndian) ? reg.width - 1 - i : i] = byte;
+    }
+}
+
+/**
+ * @brief The value of a register in a burst group buffer
+ *
+ * @param burst The burst group
+ * @param reg The register - in the group
+ * @param buffer The buffer read by sfeTkRegReadBurst()
+ *
+ * @retval uint32_t The value
+ */
+inline uint32_t sfeTkRegBurstValue(const sfeTkRegBurst &burst, const sfeTkRegister &reg, const uint8_t *buffer)
+{
+    return sfeTkRegDecode(reg, buffer + burst.offset(reg));
+}
+
+/**
+ * @brief Read bytes from an 8 or 16 bit register address - see kSTkRegAddress16
+ */
+inline sfeTkError_t sfeTkRegReadBytes(sfeTkIBus &theBus, uint8_t flags, uint16_t address, uint8_t *data,
+                                      size_t length)
+{
+    size_t readBytes = 0;
+    sfeTkError_t retval;
+    if (flags & kSTkRegAddress16)
+    {
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+        retval = theBus.readRegister16Region(address, data, length, readBytes);
+#else
+        return kSTkErrFail;
+#endif
+    }
+    else
+        retval = theBus.readRegisterRegion((uint8_t)address, data, length, readBytes);
+
+    if (retval != kSTkErrOk)
+        return retval;
+    return readBytes == length ? kSTkErrOk : kSTkErrBusUnderRead;
+}
+
+/**
+ * @brief Write bytes to an 8 or 16 bit register address - see kSTkRegAddress16
+ */
+inline sfeTkError_t sfeTkRegWriteBytes(sfeTkIBus &theBus, uint8_t flags, uint16_t address, const uint8_t *data,
+                                       size_t length)
+{
+    if (flags & kSTkRegAddress16)
+    {
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+        return theBus.writeRegister16Region(address, data, length);
+#else
+        return kSTkErrFail;
+#endif
+    }
+    return theBus.writeRegisterRegion((uint8_t)address, data, length);
+}
+
+/**
+ * @brief Read a register from the device
+ *
+ * @param theBus The bus
+ * @param reg The register
+ * @param[out] value The value read
+ *
+ * @retval kSTkErrOk on success, kSTkErrRegNoAccess if the register is write only, else the bus error
+ */
+inline sfeTkError_t sfeTkRegRead(sfeTkIBus &theBus, const sfeTkRegister &reg, uint32_t &value)
+{
+    if (!reg.readable())
+        return kSTkErrRegNoAccess;
+
+    uint8_t bytes[4];
+    sfeTkError_t retval = sfeTkRegReadBytes(theBus, reg.flags, reg.address, bytes, reg.width);
+    if (retval == kSTkErrOk)
+        value = sfeTkRegDecode(reg, bytes);
+    return retval;
+}
+
+/**
+ * @brief Write a register on the device
+ *
+ * @param theBus The bus
+ * @param reg The register
+ * @param value The value to write
+ *
+ * @retval kSTkErrOk on success, kSTkErrRegNoAccess if the register is read only, else the bus error
+ */
+inline sfeTkError_t sfeTkRegWrite(sfeTkIBus &theBus, const sfeTkRegister &reg, uint32_t value)
+{
+    if (!reg.writable())
+        return kSTkErrRegNoAccess;
+
+    uint8_t bytes[4];
+    sfeTkRegEncode(reg, value, bytes);
+    return sfeTkRegWriteBytes(theBus, reg.flags, reg.address, bytes, reg.width);
+}
+
+/**
+ * @brief Read a burst group with one bus operation. Use sfeTkRegBurstValue() to get each register's value.
+ *
+ * @param theBus The bus
+ * @param burst The burst group
+ * @param[out] buffer The buffer - at least burst.length bytes
+ *
+ * @retval kSTkErrOk on success, else the bus error
+ */
+inline sfeTkError_t sfeTkRegReadBurst(sfeTkIBus &theBus, const sfeTkRegBurst &burst, uint8_t *buffer)
+{
+    return sfeTkRegReadBytes(theBus, burst.flags, burst.address, buffer, burst.length);
+}
+
+/**
+ * @brief A transaction step that reads a burst group - so a group can be part of an sfeTkTransaction
+ *
+ * @param burst The burst group
+ * @param buffer The buffer - at least burst.length bytes
+ *
+ * @retval sfeTkTxnStep The step
+ */
+constexpr sfeTkTxnStep sfeTkRegBurstStep(const sfeTkRegBurst &burst, uint8_t *buffer)
+{
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    return (burst.flags & kSTkRegAddress16) ? sfeTkRead16(burst.address, buffer, burst.length)
+                                            : sfeTkRead((uint8_t)burst.address, buffer, burst.length);
+#else
+    return sfeTkRead((uint8_t)burst.address, buffer, burst.length);
+#endif
+}
+
+/**
+ * @brief A shadow cache of a device's registers - the last value read or written of each register that has a
+ * shadow slot (sfeTkRegister::shadow).
+ *
+ * Registers the device does not change are read from the cache rather than the bus, and a field write of such a
+ * register is one bus write rather than a read and a write. Write only registers can have fields written once
+ * the cache has a value - from a write, or from loadReset() after the device is reset. Volatile registers have
+ * no slot, and always go to the bus.
+ *
+ * The cache holds the register bytes as sent on the bus, so it is the size of the cached registers - the
+ * generator emits the size for each device.
+ *
+ * @tparam kBytes The size of the cache in bytes
+ */
+template <size_t kBytes> class sfeTkRegShadow
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Does the cache hold a value for the register?
+    */
+    bool cached(const sfeTkRegister &reg) const
+    {
+        return reg.cacheable() && _valid.test(reg.shadow);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Read a register - from the cache if it holds a value, else from the device
+
+        @param theBus The bus
+        @param reg The register
+        @param[out] value The value
+
+        @retval kSTkErrOk on success, else the error of sfeTkRegRead()
+    */
+    sfeTkError_t read(sfeTkIBus &theBus, const sfeTkRegister &reg, uint32_t &value)
+    {
+        if (cached(reg))
+        {
+            value = sfeTkRegDecode(reg, _bytes + reg.shadow);
+            return kSTkErrOk;
+        }
+        sfeTkError_t retval = sfeTkRegRead(theBus, reg, value);
+        if (retval == kSTkErrOk)
+            store(reg, value);
+        return retval;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Write a register, and keep the value in the cache
+
+        @param theBus The bus
+        @param reg The register
+        @param value The value
+
+        @retval kSTkErrOk on success, else the error of sfeTkRegWrite()
+    */
+    sfeTkError_t write(sfeTkIBus &theBus, const sfeTkRegister &reg, uint32_t value)
+    {
+        sfeTkError_t retval = sfeTkRegWrite(theBus, reg, value);
+        if (retval == kSTkErrOk)
+            store(reg, value);
+        else if (reg.cacheable())
+            _valid.reset(reg.shadow); // the device value is unknown
+        return retval;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Write a register only if the cache does not already hold the value
+
+        @param theBus The bus
+        @param reg The register
+        @param value The value
+
+        @retval kSTkErrOk on success, else the error of sfeTkRegWrite()
+    */
+    sfeTkError_t update(sfeTkIBus &theBus, const sfeTkRegister &reg, uint32_t value)
+    {
+        if (cached(reg) && sfeTkRegDecode(reg, _bytes + reg.shadow) == value)
+            return kSTkErrOk;
+        return write(theBus, reg, value);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Read a field
+
+        @param theBus The bus
+        @param field The field
+        @param[out] value The field value
+
+        @retval kSTkErrOk on success, else the error of read()
+    */
+    sfeTkError_t readField(sfeTkIBus &theBus, const sfeTkRegField &field, uint32_t &value)
+    {
+        uint32_t regValue = 0;
+        sfeTkError_t retval = read(theBus, field.reg, regValue);
+        if (retval == kSTkErrOk)
+            value = field.get(regValue);
+        return retval;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Write a field - the other bits of the register keep their value. The register is only written if
+        the value changes.
+
+        @param theBus The bus
+        @param field The field
+        @param value The field value
+
+        @retval kSTkErrOk on success, kSTkErrRegNotCached for a write only register the cache has no value for,
+        else the bus error
+    */
+    sfeTkError_t writeField(sfeTkIBus &theBus, const sfeTkRegField &field, uint32_t value)
+    {
+        uint32_t regValue = 0;
+        if (!field.reg.readable() && !cached(field.reg))
+            return kSTkErrRegNotCached;
+
+        sfeTkError_t retval = read(theBus, field.reg, regValue);
+        if (retval != kSTkErrOk)
+            return retval;
+        return update(theBus, field.reg, field.set(regValue, value));
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Keep a register value in the cache, without a bus operation - for a value read some other way,
+        such as in a burst group. Does nothing if the register has no slot.
+
+        @param reg The register
+        @param value The value
+    */
+    void store(const sfeTkRegister &reg, uint32_t value)
+    {
+        if (!reg.cacheable())
+            return;
+        sfeTkRegEncode(reg, value, _bytes + reg.shadow);
+        _valid.set(reg.shadow);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Load the reset value of each cached register - after the device is reset
+
+        @param regs The registers of the device
+        @param count The number of registers
+    */
+    void loadReset(const sfeTkRegister *regs, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            store(regs[i], regs[i].reset);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Forget a register's value - the next read goes to the device
+    */
+    void invalidate(const sfeTkRegister &reg)
+    {
+        if (reg.cacheable())
+            _valid.reset(reg.shadow);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Forget all values
+    */
+    void invalidate(void)
+    {
+        _valid.reset();
+    }
+
+  private:
+    uint8_t _bytes[kBytes];
+
+    // one bit per byte of the cache - set at the first byte of each register with a value
+    sfeTkBitset<kBytes> _valid;
+};
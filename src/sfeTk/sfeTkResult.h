@@ -0,0 +1,138 @@
+// sfeTkResult.h
+//
+// Defines a result type - an error code and a value - for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkError.h"
+
+/**
+ * @brief The result of an operation that returns a value - the error code, and the value.
+ *
+ * The value is always defined - on failure it is value initialized (0 for the integer types), so it is never
+ * read uninitialized. The type is small and trivially copyable, so for the register sized values returned by the
+ * bus it is returned in registers where the ABI allows (up to 8 bytes in r18-r25 on AVR, 16 bytes in rax/rdx on
+ * x86-64). 32-bit ARM returns structures over 4 bytes through memory, but the bus overloads that return a result
+ * are inline, so the compiler keeps the result in registers in the caller.
+ *
+ * @code
+ *     sfeTkResult<uint8_t> id = theBus.readRegisterByte(kRegWhoAmI);
+ *     if (!id)
+ *         return id.error();
+ *     if (id.value() != kExpectedId)
+ *         return kSTkErrFail;
+ * @endcode
+ *
+ * @tparam T The type of the value - an integer or other small, trivially copyable type
+ */
+template <typename T> class sfeTkResult
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - a successful result
+
+        @param value The value
+    */
+    constexpr sfeTkResult(T value) : _error{kSTkErrOk}, _value{value}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Constructor - an error result, or a result with both an error code and a value
+
+        @param error The error code
+        @param value The value - value initialized by default
+    */
+    constexpr sfeTkResult(sfeTkError_t error, T value) : _error{error}, _value{value}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief An error result, with a value initialized value
+
+        @param error The error code
+
+        @retval sfeTkResult The result
+    */
+    static constexpr sfeTkResult failure(sfeTkError_t error)
+    {
+        return sfeTkResult(error, T());
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Did the operation succeed? Only kSTkErrOk is success - a positive code such as kSTkErrBusUnderRead
+        means the value is not all there, so it is a failure too. Check error() to tell the two apart.
+
+        @retval bool true if the error code is kSTkErrOk
+    */
+    constexpr bool ok(void) const
+    {
+        return _error == kSTkErrOk;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Did the operation succeed? Same as ok()
+    */
+    constexpr explicit operator bool(void) const
+    {
+        return ok();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The error code of the operation
+
+        @retval sfeTkError_t kSTkErrOk on success
+    */
+    constexpr sfeTkError_t error(void) const
+    {
+        return _error;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The value - value initialized if the operation failed before producing one
+
+        @retval T The value
+    */
+    constexpr T value(void) const
+    {
+        return _value;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The value on success, or the given fallback on failure
+
+        @param fallback The value returned on failure
+
+        @retval T The value or the fallback
+    */
+    constexpr T valueOr(T fallback) const
+    {
+        return ok() ? _value : fallback;
+    }
+
+  private:
+    sfeTkError_t _error;
+    T _value;
+};
@@ -0,0 +1,185 @@
+// sfeTkRing.h
+//
+// Defines a fixed capacity ring buffer - no heap - for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A FIFO ring buffer with a fixed capacity, stored in the object - no heap, no exceptions.
+ *
+ * For use within one task. To pass items between tasks, use sfeTkBusQueue.
+ *
+ * When kCapacity is a power of two, the index wrap compiles to a mask.
+ *
+ * @tparam T The element type - default constructible and copyable
+ * @tparam kCapacity The maximum number of elements
+ */
+template <typename T, size_t kCapacity> class sfeTkRing
+{
+    static_assert(kCapacity > 0, "sfeTkRing capacity must be > 0");
+
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - an empty ring
+    */
+    sfeTkRing() : _head{0}, _size{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add an element to the back of the ring
+
+        @param value The element to add
+
+        @retval bool true on success, false if full
+    */
+    bool push(const T &value)
+    {
+        if (_size >= kCapacity)
+            return false;
+
+        _data[wrap(_head + _size)] = value;
+        _size++;
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add an element to the back of the ring, dropping the oldest element if full
+
+        @param value The element to add
+
+        @retval bool true if an element was dropped
+    */
+    bool pushOverwrite(const T &value)
+    {
+        bool bDropped = _size >= kCapacity;
+        if (bDropped)
+            pop();
+
+        push(value);
+        return bDropped;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Remove the element at the front of the ring
+
+        @param[out] value The removed element
+
+        @retval bool true on success, false if empty
+    */
+    bool pop(T &value)
+    {
+        if (_size == 0)
+            return false;
+
+        value = _data[_head];
+        return pop();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Drop the element at the front of the ring
+
+        @retval bool true on success, false if empty
+    */
+    bool pop(void)
+    {
+        if (_size == 0)
+            return false;
+
+        _head = wrap(_head + 1);
+        _size--;
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The element at the front of the ring - the ring must not be empty
+    */
+    T &front(void)
+    {
+        return _data[_head];
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Element access, 0 is the oldest element - the index is not checked
+    */
+    T &operator[](size_t index)
+    {
+        return _data[wrap(_head + index)];
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Element access, 0 is the oldest element - the index is not checked
+    */
+    const T &operator[](size_t index) const
+    {
+        return _data[wrap(_head + index)];
+    }
+
+    /** Remove all elements */
+    void clear(void)
+    {
+        _head = 0;
+        _size = 0;
+    }
+
+    /** The number of elements */
+    size_t size(void) const
+    {
+        return _size;
+    }
+
+    /** Is the ring empty? */
+    bool empty(void) const
+    {
+        return _size == 0;
+    }
+
+    /** Is the ring full? */
+    bool full(void) const
+    {
+        return _size == kCapacity;
+    }
+
+    /** The maximum number of elements */
+    static constexpr size_t capacity(void)
+    {
+        return kCapacity;
+    }
+
+  private:
+    // index is always < 2 * kCapacity
+    static size_t wrap(size_t index)
+    {
+        return (kCapacity & (kCapacity - 1)) == 0 ? index & (kCapacity - 1)
+                                                   : (index >= kCapacity ? index - kCapacity : index);
+    }
+
+    T _data[kCapacity];
+    size_t _head;
+    size_t _size;
+};
@@ -0,0 +1,236 @@
+// sfeTkStaticVector.h
+//
+// Defines a fixed capacity vector - no heap - for the SparkFun Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A vector with a fixed capacity, stored in the object - no heap, no exceptions.
+ *
+ * The elements are held in a plain array, so T must be default constructible and copyable. All kCapacity elements
+ * are constructed with the vector; size() tracks how many are in use. Methods that can fail return false.
+ *
+ * @tparam T The element type
+ * @tparam kCapacity The maximum number of elements
+ */
+template <typename T, size_t kCapacity> class sfeTkStaticVector
+{
+    static_assert(kCapacity > 0, "sfeTkStaticVector capacity must be > 0");
+
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - an empty vector
+    */
+    sfeTkStaticVector() : _size{0}
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Add an element to the end of the vector
+
+        @param value The element to add
+
+        @retval bool true on success, false if full
+    */
+    bool push_back(const T &value)
+    {
+        if (_size >= kCapacity)
+            return false;
+
+        _data[_size++] = value;
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Remove the last element
+
+        @retval bool true on success, false if empty
+    */
+    bool pop_back(void)
+    {
+        if (_size == 0)
+            return false;
+
+        _size--;
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Insert an element, moving the elements after it up
+
+        @param index The position of the new element - 0 to size()
+        @param value The element to insert
+
+        @retval bool true on success, false if full or index is out of range
+    */
+    bool insert(size_t index, const T &value)
+    {
+        if (_size >= kCapacity || index > _size)
+            return false;
+
+        for (size_t i = _size; i > index; i--)
+            _data[i] = _data[i - 1];
+
+        _data[index] = value;
+        _size++;
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Remove an element, moving the elements after it down
+
+        @param index The position of the element to remove
+
+        @retval bool true on success, false if index is out of range
+    */
+    bool erase(size_t index)
+    {
+        if (index >= _size)
+            return false;
+
+        for (size_t i = index + 1; i < _size; i++)
+            _data[i - 1] = _data[i];
+
+        _size--;
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Set the number of elements in use. New elements have the value passed in.
+
+        @param newSize The new size - up to the capacity
+        @param value The value of added elements
+
+        @retval bool true on success, false if newSize is larger than the capacity
+    */
+    bool resize(size_t newSize, const T &value = T())
+    {
+        if (newSize > kCapacity)
+            return false;
+
+        for (size_t i = _size; i < newSize; i++)
+            _data[i] = value;
+
+        _size = newSize;
+        return true;
+    }
+
+    /** Remove all elements */
+    void clear(void)
+    {
+        _size = 0;
+    }
+
+    /** Element access - the index is not checked */
+    T &operator[](size_t index)
+    {
+        return _data[index];
+    }
+
+    /** Element access - the index is not checked */
+    const T &operator[](size_t index) const
+    {
+        return _data[index];
+    }
+
+    /** The first element - the vector must not be empty */
+    T &front(void)
+    {
+        return _data[0];
+    }
+
+    /** The last element - the vector must not be empty */
+    T &back(void)
+    {
+        return _data[_size - 1];
+    }
+
+    /** The element storage */
+    T *data(void)
+    {
+        return _data;
+    }
+
+    /** The element storage */
+    const T *data(void) const
+    {
+        return _data;
+    }
+
+    /** Iterator support - the elements are contiguous */
+    T *begin(void)
+    {
+        return _data;
+    }
+
+    /** Iterator support - the elements are contiguous */
+    T *end(void)
+    {
+        return _data + _size;
+    }
+
+    /** Iterator support - the elements are contiguous */
+    const T *begin(void) const
+    {
+        return _data;
+    }
+
+    /** Iterator support - the elements are contiguous */
+    const T *end(void) const
+    {
+        return _data + _size;
+    }
+
+    /** The number of elements */
+    size_t size(void) const
+    {
+        return _size;
+    }
+
+    /** Is the vector empty? */
+    bool empty(void) const
+    {
+        return _size == 0;
+    }
+
+    /** Is the vector full? */
+    bool full(void) const
+    {
+        return _size == kCapacity;
+    }
+
+    /** The maximum number of elements */
+    static constexpr size_t capacity(void)
+    {
+        return kCapacity;
+    }
+
+  private:
+    T _data[kCapacity];
+    size_t _size;
+};
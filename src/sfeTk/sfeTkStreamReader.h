@@ -0,0 +1,384 @@
+// sfeTkStreamReader.h
+//
+// Defines a multi-buffered streaming reader - overlapping block transfers with processing - for the SparkFun
+// Electronics Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkIAsyncTransfer.h"
+
+/**
+ * @brief Continuous streaming reads of a device register (ADC data, FIFO) into a ring of buffers.
+ *
+ * While the consumer processes block N, block N+1 is being transferred by the asynchronous transfer backend.
+ * When a transfer completes, the next read is started right away from the completion - if a free buffer is
+ * available. If a completion finds the consumer still holds every buffer, the stream stalls: this is an overrun
+ * (the device may be losing data), it is counted, and the stream restarts as soon as the consumer releases a
+ * buffer. A backend that completes inside start() (the CPU fallback) only reads when the consumer asks, so it
+ * never overruns.
+ *
+ * A failed transfer is retried on the same buffer, from the next poll() or release() - never from the
+ * completion. After kMaxRetries failures in a row the stream stops - running() returns false and lastError()
+ * holds the error.
+ *
+ * Consumer use:
+ *
+ *      uint8_t *block = reader.acquire();
+ *      if (block)
+ *      {
+ *          process(block, reader.blockSize());
+ *          reader.release();
+ *      }
+ *
+ * acquire()/release()/poll() are called from one consumer task, the completion may run in an interrupt or
+ * another task.
+ *
+ * @tparam kBlockSize The size of each block (one transfer)
+ * @tparam kBuffers The number of buffers - 2 for ping-pong
+ */
+template <size_t kBlockSize, uint8_t kBuffers = 2> class sfeTkStreamReader
+{
+    static_assert(kBuffers >= 2, "sfeTkStreamReader requires at least 2 buffers");
+
+  public:
+    /** Failed transfers in a row before the stream stops */
+    static constexpr uint8_t kMaxRetries = 3;
+
+    /**--------------------------------------------------------------------------
+        @brief Constructor
+
+        @param now Time source for the throughput statistics - typically micros()
+    */
+    sfeTkStreamReader(uint32_t (*now)(void))
+        : _now{now}, _bus{nullptr}, _transfer{nullptr}, _op{kSTkBusOpReadRegisterRegion}, _reg{0}, _running{false},
+          _inFlight{false}, _starting{false}, _kick{false}, _inStart{false}, _nFailures{0}, _writeIdx{0}, _readIdx{0}
+    {
+        resetStats();
+        for (uint8_t i = 0; i < kBuffers; i++)
+        {
+            _state[i] = kFree;
+            _requests[i].set(_op, 0, _buffers[i], kBlockSize);
+        }
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Start streaming
+
+        @param bus The bus (device) to read
+        @param transfer The asynchronous transfer backend
+        @param devReg The register to read the blocks from
+        @param b16BitReg true if devReg is a 16 bit register address
+
+        @retval sfeTkError_t kSTkErrOk on success, or the error starting the first transfer - with a backend that
+                completes inside start(), the error of the first transfers
+    */
+    sfeTkError_t begin(sfeTkIBus &bus, sfeTkIAsyncTransfer &transfer, uint16_t devReg, bool b16BitReg = false)
+    {
+        if (_running)
+            return kSTkErrFail;
+
+        _bus = &bus;
+        _transfer = &transfer;
+        _reg = devReg;
+        _op = b16BitReg ? kSTkBusOpReadRegister16Region : kSTkBusOpReadRegisterRegion;
+
+        for (uint8_t i = 0; i < kBuffers; i++)
+            _state[i] = kFree;
+        _writeIdx = _readIdx = 0;
+        __atomic_store_n(&_nFailures, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&_lastError, kSTkErrOk, __ATOMIC_RELAXED);
+        resetStats();
+
+        _running = true;
+        startNext();
+
+        return lastError();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Stop streaming. A transfer in flight completes, but no new transfers are started.
+    */
+    void end(void)
+    {
+        stop();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Get the next filled block - in transfer order.
+
+        @retval uint8_t* The block, or nullptr if no block is ready
+    */
+    uint8_t *acquire(void)
+    {
+        if (__atomic_load_n(&_state[_readIdx], __ATOMIC_ACQUIRE) != kReady)
+            return nullptr;
+
+        __atomic_store_n(&_state[_readIdx], kInUse, __ATOMIC_RELAXED);
+        return _buffers[_readIdx];
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Release the block returned by acquire(), making the buffer available for the next transfer
+    */
+    void release(void)
+    {
+        if (__atomic_load_n(&_state[_readIdx], __ATOMIC_RELAXED) != kInUse)
+            return;
+
+        __atomic_store_n(&_state[_readIdx], kFree, __ATOMIC_RELEASE);
+        _readIdx = (_readIdx + 1) % kBuffers;
+
+        // restart a stalled stream
+        startNext();
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Drive the stream - polls the backend, and restarts the stream if stalled. Call from the consumer loop.
+    */
+    void poll(void)
+    {
+        if (_transfer)
+            _transfer->poll();
+        startNext();
+    }
+
+    /** The size of a block */
+    static constexpr size_t blockSize(void)
+    {
+        return kBlockSize;
+    }
+
+    /** Is the stream running? */
+    bool running(void) const
+    {
+        return __atomic_load_n(&_running, __ATOMIC_ACQUIRE);
+    }
+
+    /** The number of blocks transferred */
+    uint32_t nBlocks(void) const
+    {
+        return __atomic_load_n(&_nBlocks, __ATOMIC_RELAXED);
+    }
+
+    /** The number of bytes transferred */
+    uint32_t nBytes(void) const
+    {
+        return __atomic_load_n(&_nBytes, __ATOMIC_RELAXED);
+    }
+
+    /** The number of overruns - completions that found the consumer holding every buffer */
+    uint32_t nOverruns(void) const
+    {
+        return __atomic_load_n(&_nOverruns, __ATOMIC_RELAXED);
+    }
+
+    /** The number of failed transfers */
+    uint32_t nErrors(void) const
+    {
+        return __atomic_load_n(&_nErrors, __ATOMIC_RELAXED);
+    }
+
+    /** The last transfer error */
+    sfeTkError_t lastError(void) const
+    {
+        return __atomic_load_n(&_lastError, __ATOMIC_RELAXED);
+    }
+
+    /** Time streaming, in time source units - up to now, or to end() */
+    uint32_t elapsed(void) const
+    {
+        return running() ? _now() - __atomic_load_n(&_startTime, __ATOMIC_RELAXED)
+                         : __atomic_load_n(&_elapsed, __ATOMIC_RELAXED);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief Throughput in bytes per second - assumes a microsecond time source
+
+        @retval uint32_t bytes per second
+    */
+    uint32_t throughput(void) const
+    {
+        uint32_t usecs = elapsed();
+        return usecs == 0 ? 0 : (uint32_t)((uint64_t)nBytes() * 1000000 / usecs);
+    }
+
+    /** Reset the statistics */
+    void resetStats(void)
+    {
+        __atomic_store_n(&_nBlocks, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&_nBytes, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&_nOverruns, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&_nErrors, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&_startTime, _now(), __ATOMIC_RELAXED);
+        __atomic_store_n(&_elapsed, 0, __ATOMIC_RELAXED);
+    }
+
+  private:
+    enum : uint8_t
+    {
+        kFree = 0,
+        kFilling,
+        kReady,
+        kInUse
+    };
+
+    // Run startNext() passes until no caller asks for another. Called from the consumer and from the completion.
+    // Only one caller runs the loop - a caller that finds it taken (another task, or a completion nested in the
+    // backend's start()) sets _kick and returns, and the running loop makes the pass for it. So a completion
+    // never starts a transfer from inside start(), and the stack stays flat with a synchronous backend.
+    void startNext(void)
+    {
+        __atomic_store_n(&_kick, true, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&_kick, __ATOMIC_SEQ_CST))
+        {
+            bool expected = false;
+            if (!__atomic_compare_exchange_n(&_starting, &expected, true, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+                return;
+
+            __atomic_store_n(&_kick, false, __ATOMIC_SEQ_CST);
+            startOne();
+            __atomic_store_n(&_starting, false, __ATOMIC_SEQ_CST);
+        }
+    }
+
+    // Start the next transfer, if the stream is running, no transfer is in flight and the next buffer is free
+    void startOne(void)
+    {
+        if (!running() || __atomic_load_n(&_inFlight, __ATOMIC_ACQUIRE))
+            return;
+
+        uint8_t idx = _writeIdx;
+        if (__atomic_load_n(&_state[idx], __ATOMIC_ACQUIRE) != kFree)
+            return;
+
+        // each buffer has its own request. The backend publishes the status after the completion returns - until
+        // then the last transfer on this request is still completing, and it is not re-armed
+        sfeTkBusRequest &request = _requests[idx];
+        if (!request.done())
+            return;
+
+        __atomic_store_n(&_inFlight, true, __ATOMIC_RELEASE);
+        __atomic_store_n(&_state[idx], kFilling, __ATOMIC_RELAXED);
+        request.set(_op, _reg, _buffers[idx], kBlockSize);
+        request.onComplete = onComplete;
+        request.context = this;
+
+        __atomic_store_n(&_inStart, true, __ATOMIC_RELEASE);
+        sfeTkError_t status = _transfer->start(*_bus, request);
+        __atomic_store_n(&_inStart, false, __ATOMIC_RELEASE);
+
+        if (status != kSTkErrOk)
+        {
+            // not retried here - the next poll() or release() tries again
+            __atomic_store_n(&_lastError, status, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&_nErrors, 1, __ATOMIC_RELAXED);
+            failed();
+            __atomic_store_n(&_state[idx], kFree, __ATOMIC_RELEASE);
+            __atomic_store_n(&_inFlight, false, __ATOMIC_RELEASE);
+        }
+    }
+
+    // A transfer failed - stop the stream after kMaxRetries failures in a row
+    void failed(void)
+    {
+        if (__atomic_add_fetch(&_nFailures, 1, __ATOMIC_RELAXED) > kMaxRetries)
+            stop();
+    }
+
+    // Stop starting transfers, and freeze the elapsed time
+    void stop(void)
+    {
+        __atomic_store_n(&_elapsed, _now() - __atomic_load_n(&_startTime, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+        __atomic_store_n(&_running, false, __ATOMIC_RELEASE);
+    }
+
+    // Transfer completion - runs in the backend's completion context
+    static void onComplete(sfeTkBusRequest &request, void *context)
+    {
+        sfeTkStreamReader *self = static_cast<sfeTkStreamReader *>(context);
+        uint8_t idx = (uint8_t)(&request - self->_requests);
+
+        // the status is published after this callback returns - so check the transfer count
+        if (request.transferred == kBlockSize)
+        {
+            __atomic_fetch_add(&self->_nBlocks, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&self->_nBytes, (uint32_t)kBlockSize, __ATOMIC_RELAXED);
+            __atomic_store_n(&self->_nFailures, 0, __ATOMIC_RELAXED);
+            self->_writeIdx = (idx + 1) % kBuffers;
+            __atomic_store_n(&self->_state[idx], kReady, __ATOMIC_RELEASE);
+
+            // the bus is ready for the next block, but the consumer holds every buffer - an overrun. Not for a
+            // completion inside start(): that backend reads when the consumer asks, and the data waits in the device
+            if (!__atomic_load_n(&self->_inStart, __ATOMIC_ACQUIRE) &&
+                __atomic_load_n(&self->_state[self->_writeIdx], __ATOMIC_ACQUIRE) != kFree)
+                __atomic_fetch_add(&self->_nOverruns, 1, __ATOMIC_RELAXED);
+        }
+        else
+        {
+            // retry the same buffer - from the next poll() or release(), as the request is still completing
+            __atomic_store_n(&self->_lastError, kSTkErrBusUnderRead, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&self->_nErrors, 1, __ATOMIC_RELAXED);
+            self->failed();
+            __atomic_store_n(&self->_state[idx], kFree, __ATOMIC_RELEASE);
+            __atomic_store_n(&self->_inFlight, false, __ATOMIC_RELEASE);
+            return;
+        }
+
+        __atomic_store_n(&self->_inFlight, false, __ATOMIC_RELEASE);
+
+        // keep the bus busy - start the next block (on the next request) now, or have the running startNext()
+        // loop start it
+        self->startNext();
+    }
+
+    uint32_t (*_now)(void);
+
+    sfeTkIBus *_bus;
+    sfeTkIAsyncTransfer *_transfer;
+    sfeTkBusOp_t _op;
+    uint16_t _reg;
+
+    bool _running;
+    bool _inFlight;
+    bool _starting;
+    bool _kick;
+    bool _inStart;
+    uint8_t _nFailures;
+
+    uint8_t _writeIdx;
+    uint8_t _readIdx;
+    uint8_t _state[kBuffers];
+    uint8_t _buffers[kBuffers][kBlockSize];
+
+    sfeTkBusRequest _requests[kBuffers];
+    sfeTkError_t _lastError;
+
+    uint32_t _nBlocks;
+    uint32_t _nBytes;
+    uint32_t _nOverruns;
+    uint32_t _nErrors;
+    uint32_t _startTime;
+    uint32_t _elapsed;
+};
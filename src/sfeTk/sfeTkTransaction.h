@@ -0,0 +1,373 @@
+// sfeTkTransaction.h
+//
+// Defines bus transactions - a fixed sequence of register operations run as one operation on the bus
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "sfeTkConfig.h"
+#include "sfeTkError.h"
+#include <stddef.h>
+
+/**
+ * @brief The operations a bus request, or a transaction step, can perform. These map directly to sfeTkIBus
+ *        methods.
+ */
+enum sfeTkBusOp_t : uint8_t
+{
+    kSTkBusOpWriteRegion = 0,
+    kSTkBusOpWriteRegisterRegion,
+    kSTkBusOpWriteRegister16Region,
+    kSTkBusOpReadRegisterRegion,
+    kSTkBusOpReadRegister16Region
+};
+
+/**
+ * @brief One step of a transaction - a register write or read.
+ *
+ * A write of one or two bytes carries the data in the step (value, low byte first), so a transaction of
+ * register writes has no buffers at all. Otherwise data points to the buffer, owned by the caller.
+ */
+struct sfeTkTxnStep
+{
+    /** The operation */
+    sfeTkBusOp_t op;
+
+    /** The number of bytes of value written - 0 if the data buffer is used */
+    uint8_t nValue;
+
+    /** The register - 8 or 16 bit depending on the operation */
+    uint16_t reg;
+
+    /** The value written, low byte first - used when nValue > 0 */
+    uint16_t value;
+
+    /** The data buffer - read into, or written from when nValue is 0 */
+    uint8_t *data;
+
+    /** The length of the data buffer */
+    size_t length;
+};
+
+/**
+ * @brief A list of indices - used to copy the steps of a transaction at compile time
+ */
+template <size_t... I> struct sfeTkTxnIndices
+{
+};
+
+template <size_t N, size_t... I> struct sfeTkTxnMakeIndices : sfeTkTxnMakeIndices<N - 1, N - 1, I...>
+{
+};
+
+template <size_t... I> struct sfeTkTxnMakeIndices<0, I...>
+{
+    typedef sfeTkTxnIndices<I...> type;
+};
+
+/**
+ * @brief A transaction - a fixed number of steps, run on a bus as one operation with sfeTkIBus::transaction().
+ *
+ * A transaction is built with << (and >>, which reads better for reads) from sfeTkTxn(). Each step adds one to
+ * the length, which is part of the type - so the steps are a fixed array, sized at compile time, and nothing is
+ * allocated or parsed at run time. When the registers and values are constants, the whole transaction can be a
+ * constexpr, and is built by the compiler:
+ *
+ * @code
+ *     static uint8_t sample[6];
+ *     static constexpr auto kReadSample =
+ *         sfeTkTxn() << sfeTkWrite(kRegCtrl1, 0x40) << sfeTkWrite(kRegCtrl2, 0x04) >> sfeTkRead(kRegOut, sample);
+ *
+ *     sfeTkError_t retval = theBus.transaction(kReadSample);
+ * @endcode
+ *
+ * The bus runs the steps in order, and stops at the first step that fails. The Arduino I2C bus joins the steps
+ * with repeated starts, so the transaction is one start ... stop on the wire, and the Arduino SPI bus applies its
+ * settings once for all steps. Other buses run one bus operation a step.
+ *
+ * transaction() is only available when the build sets SFE_TK_ENABLE_TRANSACTIONS to 1 - see sfeTkConfig.h.
+ *
+ * @tparam N The number of steps
+ */
+template <size_t N> class sfeTkTransaction
+{
+  public:
+    /**--------------------------------------------------------------------------
+        @brief Constructor - a transaction, and one more step
+
+        @param prev The transaction
+        @param next The step added to the end
+    */
+    constexpr sfeTkTransaction(const sfeTkTransaction<N - 1> &prev, const sfeTkTxnStep &next)
+        : sfeTkTransaction(prev, next, typename sfeTkTxnMakeIndices<N - 1>::type())
+    {
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief This transaction with a step added
+
+        @param next The step added to the end
+
+        @retval sfeTkTransaction<N + 1> The new transaction
+    */
+    constexpr sfeTkTransaction<N + 1> operator<<(const sfeTkTxnStep &next) const
+    {
+        return sfeTkTransaction<N + 1>(*this, next);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief This transaction with a step added - the same as <<, for reads
+    */
+    constexpr sfeTkTransaction<N + 1> operator>>(const sfeTkTxnStep &next) const
+    {
+        return sfeTkTransaction<N + 1>(*this, next);
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief A step of the transaction
+
+        @param i The index of the step
+
+        @retval sfeTkTxnStep The step
+    */
+    constexpr const sfeTkTxnStep &operator[](size_t i) const
+    {
+        return _steps[i];
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The steps of the transaction
+
+        @retval sfeTkTxnStep* The array of steps
+    */
+    constexpr const sfeTkTxnStep *steps(void) const
+    {
+        return _steps;
+    }
+
+    /**--------------------------------------------------------------------------
+        @brief The number of steps
+
+        @retval size_t The number of steps
+    */
+    static constexpr size_t size(void)
+    {
+        return N;
+    }
+
+  private:
+    template <size_t... I>
+    constexpr sfeTkTransaction(const sfeTkTransaction<N - 1> &prev, const sfeTkTxnStep &next, sfeTkTxnIndices<I...>)
+        : _steps{prev[I]..., next}
+    {
+    }
+
+    sfeTkTxnStep _steps[N];
+};
+
+/**
+ * @brief The empty transaction - the start of every transaction. See sfeTkTxn().
+ */
+template <> class sfeTkTransaction<0>
+{
+  public:
+    constexpr sfeTkTransaction(void)
+    {
+    }
+
+    constexpr sfeTkTransaction<1> operator<<(const sfeTkTxnStep &next) const
+    {
+        return sfeTkTransaction<1>(*this, next);
+    }
+
+    constexpr sfeTkTransaction<1> operator>>(const sfeTkTxnStep &next) const
+    {
+        return sfeTkTransaction<1>(*this, next);
+    }
+
+    constexpr const sfeTkTxnStep *steps(void) const
+    {
+        return nullptr;
+    }
+
+    static constexpr size_t size(void)
+    {
+        return 0;
+    }
+};
+
+/**
+ * @brief Start a transaction
+ *
+ * @retval sfeTkTransaction<0> The empty transaction - add steps with << and >>
+ */
+constexpr sfeTkTransaction<0> sfeTkTxn(void)
+{
+    return sfeTkTransaction<0>();
+}
+
+/**
+ * @brief A step that writes a byte to a register
+ *
+ * @param devReg The register
+ * @param value The value to write
+ *
+ * @retval sfeTkTxnStep The step
+ */
+constexpr sfeTkTxnStep sfeTkWrite(uint8_t devReg, uint8_t value)
+{
+    return sfeTkTxnStep{kSTkBusOpWriteRegisterRegion, 1, devReg, value, nullptr, 0};
+}
+
+/**
+ * @brief A step that writes a word to a register, low byte first
+ *
+ * @param devReg The register
+ * @param value The value to write
+ *
+ * @retval sfeTkTxnStep The step
+ */
+constexpr sfeTkTxnStep sfeTkWriteWord(uint8_t devReg, uint16_t value)
+{
+    return sfeTkTxnStep{kSTkBusOpWriteRegisterRegion, 2, devReg, value, nullptr, 0};
+}
+
+/**
+ * @brief A step that writes a block of data, starting at a register
+ *
+ * @param devReg The register
+ * @param data The data to write - must stay valid until the transaction has run
+ * @param length The length of the data
+ *
+ * @retval sfeTkTxnStep The step
+ */
+constexpr sfeTkTxnStep sfeTkWrite(uint8_t devReg, const uint8_t *data, size_t length)
+{
+    return sfeTkTxnStep{kSTkBusOpWriteRegisterRegion, 0, devReg, 0, const_cast<uint8_t *>(data), length};
+}
+
+/**
+ * @brief A step that reads a block of data, starting at a register
+ *
+ * @param devReg The register
+ * @param data The buffer read into - must stay valid until the transaction has run
+ * @param length The number of bytes to read
+ *
+ * @retval sfeTkTxnStep The step
+ */
+constexpr sfeTkTxnStep sfeTkRead(uint8_t devReg, uint8_t *data, size_t length)
+{
+    return sfeTkTxnStep{kSTkBusOpReadRegisterRegion, 0, devReg, 0, data, length};
+}
+
+/**
+ * @brief A step that fills a buffer, reading from a register - the length is the size of the buffer
+ *
+ * @param devReg The register
+ * @param data The buffer read into - must stay valid until the transaction has run
+ *
+ * @retval sfeTkTxnStep The step
+ */
+template <size_t L> constexpr sfeTkTxnStep sfeTkRead(uint8_t devReg, uint8_t (&data)[L])
+{
+    return sfeTkRead(devReg, data, L);
+}
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+/**
+ * @brief A step that writes a byte to a 16-bit register
+ *
+ * @param devReg The 16-bit register
+ * @param value The value to write
+ *
+ * @retval sfeTkTxnStep The step
+ */
+constexpr sfeTkTxnStep sfeTkWrite16(uint16_t devReg, uint8_t value)
+{
+    return sfeTkTxnStep{kSTkBusOpWriteRegister16Region, 1, devReg, value, nullptr, 0};
+}
+
+/**
+ * @brief A step that writes a block of data, starting at a 16-bit register
+ *
+ * @param devReg The 16-bit register
+ * @param data The data to write - must stay valid until the transaction has run
+ * @param length The length of the data
+ *
+ * @retval sfeTkTxnStep The step
+ */
+constexpr sfeTkTxnStep sfeTkWrite16(uint16_t devReg, const uint8_t *data, size_t length)
+{
+    return sfeTkTxnStep{kSTkBusOpWriteRegister16Region, 0, devReg, 0, const_cast<uint8_t *>(data), length};
+}
+
+/**
+ * @brief A step that reads a block of data, starting at a 16-bit register
+ *
+ * @param devReg The 16-bit register
+ * @param data The buffer read into - must stay valid until the transaction has run
+ * @param length The number of bytes to read
+ *
+ * @retval sfeTkTxnStep The step
+ */
+constexpr sfeTkTxnStep sfeTkRead16(uint16_t devReg, uint8_t *data, size_t length)
+{
+    return sfeTkTxnStep{kSTkBusOpReadRegister16Region, 0, devReg, 0, data, length};
+}
+
+/**
+ * @brief A step that fills a buffer, reading from a 16-bit register - the length is the size of the buffer
+ *
+ * @param devReg The 16-bit register
+ * @param data The buffer read into - must stay valid until the transaction has run
+ *
+ * @retval sfeTkTxnStep The step
+ */
+template <size_t L> constexpr sfeTkTxnStep sfeTkRead16(uint16_t devReg, uint8_t (&data)[L])
+{
+    return sfeTkRead16(devReg, data, L);
+}
+#endif
+
+/**
+ * @brief The data of a step - the step's value, or its buffer. Used by bus implementations.
+ *
+ * @param step The step
+ * @param value Storage for the value bytes - at least 2 bytes
+ * @param[out] length The length of the data
+ *
+ * @retval const uint8_t* The data
+ */
+inline const uint8_t *sfeTkTxnStepData(const sfeTkTxnStep &step, uint8_t *value, size_t &length)
+{
+    if (step.nValue == 0)
+    {
+        length = step.length;
+        return step.data;
+    }
+    value[0] = (uint8_t)step.value;
+    value[1] = (uint8_t)(step.value >> 8);
+    length = step.nValue;
+    return value;
+}
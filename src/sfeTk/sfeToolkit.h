@@ -29,4 +29,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 /**
     @brief Common include file for the core of the SparkFun Electronics Toolkit
 */
+#include "sfeTkConfig.h"
 #include "sfeTkError.h"
+#include "sfeTkResult.h"
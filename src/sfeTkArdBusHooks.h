@@ -0,0 +1,100 @@
+/*
+sfeTkArdBusHooks.h
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+Arduino versions of the bus hooks (sfeTk/sfeTkBusHooks.h) - a micros()
+clock, a run time hook function policy, the register analyzer
+(sfeTk/sfeTkRegAnalyzer.h), the bus utilization monitor
+(sfeTk/sfeTkBusMonitor.h), the interrupt latency probe
+(sfeTk/sfeTkLatency.h) and the hooked I2C and SPI bus classes.
+
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "sfeTkArdCriticalSection.h"
+#include "sfeTkArdCycles.h"
+#include "sfeTkArdI2C.h"
+#include "sfeTkArdSPI.h"
+#include <sfeTk/sfeTkBusBudget.h>
+#include <sfeTk/sfeTkBusHooks.h>
+#include <sfeTk/sfeTkBusMonitor.h>
+#include <sfeTk/sfeTkLatency.h>
+#include <sfeTk/sfeTkRegAnalyzer.h>
+
+/**
+ * @brief A hook clock - micros()
+ */
+struct sfeTkArdMicros
+{
+    static uint32_t now(void)
+    {
+        return (uint32_t)micros();
+    }
+};
+
+/**
+ * @brief A hook policy that calls a function set at run time, with durations in microseconds
+ */
+typedef sfeTkBusHookCallback<sfeTkArdMicros> sfeTkArdBusHookCallback;
+
+/**
+ * @brief A register analyzer with times in microseconds - 64 registers on up to 8 devices
+ */
+typedef sfeTkRegAnalyzer<sfeTkArdMicros> sfeTkArdRegAnalyzer;
+
+/**
+ * @brief The hook policy that feeds a bus's register operations to an sfeTkArdRegAnalyzer
+ */
+typedef sfeTkRegAnalyzerHooks<sfeTkArdRegAnalyzer> sfeTkArdRegAnalyzerHooks;
+
+/**
+ * @brief A bus utilization monitor with a micros() time base - the window is in microseconds
+ */
+typedef sfeTkBusMonitor<sfeTkArdMicros> sfeTkArdBusMonitor;
+
+/**
+ * @brief The hook policy that adds a bus's operations to an sfeTkArdBusMonitor
+ */
+typedef sfeTkBusMonitorHooks<sfeTkArdBusMonitor> sfeTkArdBusMonitorHooks;
+
+/**
+ * @brief A latency probe on the cycle counter, stamped from an interrupt in a critical section - see
+ * sfeTkArdCyclesHz() for the rate
+ */
+typedef sfeTkLatencyProbe<sfeTkArdCycleClock, 176, 4, sfeTkArdCriticalSection> sfeTkArdLatencyProbe;
+
+/**
+ * @brief A hook policy that stamps the bus start and done of an sfeTkArdLatencyProbe
+ */
+typedef sfeTkLatencyHooks<sfeTkArdLatencyProbe> sfeTkArdLatencyHooks;
+
+/**
+ * @brief The Arduino I2C bus class with the hooks of a policy - sfeTkArdI2C itself for sfeTkNoBusHooks
+ */
+template <typename Hooks> using sfeTkArdI2CHooked = typename sfeTkHookedBus<sfeTkArdI2C, Hooks>::type;
+
+/**
+ * @brief The Arduino SPI bus class with the hooks of a policy - sfeTkArdSPI itself for sfeTkNoBusHooks
+ */
+template <typename Hooks> using sfeTkArdSPIHooked = typename sfeTkHookedBus<sfeTkArdSPI, Hooks>::type;
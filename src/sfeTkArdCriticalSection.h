@@ -0,0 +1,82 @@
+/*
+sfeTkArdCriticalSection.h
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+Defines an interrupt guard for Arduino, used as the guard policy of the
+toolkit allocators when they are shared with an interrupt handler.
+
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * @brief Disables interrupts for the life of the object, and restores the previous state when destroyed - so
+ *        critical sections can nest.
+ *
+ * On AVR the status register is saved and restored, on ARM Cortex-M the PRIMASK register. On other cores,
+ * noInterrupts()/interrupts() are used, which do not nest - don't take the guard with interrupts already off.
+ * On multi-core parts (ESP32, RP2040) this only guards against interrupts on the calling core.
+ */
+class sfeTkArdCriticalSection
+{
+  public:
+    /**
+        @brief Constructor - disables interrupts
+    */
+    sfeTkArdCriticalSection(void)
+    {
+#if defined(__AVR__)
+        _state = SREG;
+        cli();
+#elif defined(__arm__) && defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+        __asm__ volatile("mrs %0, primask" : "=r"(_state));
+        __asm__ volatile("cpsid i" ::: "memory");
+#else
+        noInterrupts();
+#endif
+    }
+
+    /**
+        @brief Destructor - restores the interrupt state
+    */
+    ~sfeTkArdCriticalSection()
+    {
+#if defined(__AVR__)
+        SREG = _state;
+#elif defined(__arm__) && defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+        __asm__ volatile("msr primask, %0" ::"r"(_state) : "memory");
+#else
+        interrupts();
+#endif
+    }
+
+    sfeTkArdCriticalSection(const sfeTkArdCriticalSection &) = delete;
+    sfeTkArdCriticalSection &operator=(const sfeTkArdCriticalSection &) = delete;
+
+  private:
+#if defined(__AVR__)
+    uint8_t _state;
+#elif defined(__arm__) && defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+    uint32_t _state;
+#endif
+};
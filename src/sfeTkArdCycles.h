@@ -0,0 +1,99 @@
+/*
+sfeTkArdCycles.h
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+The fastest clock of the board, for timing short intervals - the CPU
+cycle counter where there is one (ESP32/ESP8266, Cortex-M3 and later,
+x86 hosts), else micros(). Used by the phase profiler and the latency
+probe.
+
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+// The DWT registers are addressed directly, so no CMSIS header is needed
+#define kSfeTkDemCR (*(volatile uint32_t *)0xE000EDFCUL)
+#define kSfeTkDwtCtrl (*(volatile uint32_t *)0xE0001000UL)
+#define kSfeTkDwtCycCnt (*(volatile uint32_t *)0xE0001004UL)
+#endif
+
+/**
+ * @brief The cycle count, or micros() on a board without a cycle counter (AVR, Cortex-M0)
+ */
+inline uint32_t sfeTkArdCycles(void)
+{
+#if defined(ARDUINO_ARCH_ESP32) || defined(ESP8266)
+    return ESP.getCycleCount();
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+    // the counter is started on first use
+    if (!(kSfeTkDwtCtrl & 1))
+    {
+        kSfeTkDemCR |= (1UL << 24); // TRCENA - enable the trace unit
+        kSfeTkDwtCycCnt = 0;
+        kSfeTkDwtCtrl |= 1; // CYCCNTENA
+    }
+    return kSfeTkDwtCycCnt;
+#elif defined(__x86_64__) || defined(__i386__)
+    // a host build against the simulated core - the time stamp counter
+    return (uint32_t)__rdtsc();
+#else
+    // the resolution of the core - 4 us on a 16 MHz AVR
+    return (uint32_t)micros();
+#endif
+}
+
+/**
+ * @brief The rate of sfeTkArdCycles() in ticks a second - 0 if it is not known (x86 hosts)
+ */
+inline uint32_t sfeTkArdCyclesHz(void)
+{
+#if defined(ARDUINO_ARCH_ESP32) || defined(ESP8266)
+    return (uint32_t)ESP.getCpuFreqMHz() * 1000000UL;
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#if defined(F_CPU)
+    return (uint32_t)F_CPU;
+#else
+    return 0;
+#endif
+#elif defined(__x86_64__) || defined(__i386__)
+    return 0;
+#else
+    return 1000000UL;
+#endif
+}
+
+/**
+ * @brief A clock class for the toolkit's timing templates - sfeTkArdCycles()
+ */
+struct sfeTkArdCycleClock
+{
+    static uint32_t now(void)
+    {
+        return sfeTkArdCycles();
+    }
+};
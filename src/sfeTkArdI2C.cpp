@@ -22,6 +22,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "sfeTkArdI2C.h"
+#include <sfeTk/sfeTkHotPath.h>
+#include <sfeTk/sfeTkLog.h>
+#include <sfeTk/sfeTkProfiler.h>
 
 //---------------------------------------------------------------------------------
 // init()
@@ -69,6 +72,20 @@ sfeTkError_t sfeTkArdI2C::init(void)
     // call with our currently set address ...
     return init(address());
 }
+//---------------------------------------------------------------------------------
+// setClock()
+//
+// The clock is a setting of the port, shared by all devices on it.
+//
+sfeTkError_t sfeTkArdI2C::setClock(uint32_t clock)
+{
+    if (!_i2cPort)
+        return kSTkErrBusNotInit;
+
+    _i2cPort->setClock(clock);
+    return kSTkErrOk;
+}
+
 //---------------------------------------------------------------------------------
 // ping()
 //
@@ -76,6 +93,8 @@ sfeTkError_t sfeTkArdI2C::init(void)
 //
 sfeTkError_t sfeTkArdI2C::ping()
 {
+    SFE_TK_HOT_PATH();
+
     // no port, no
     if (!_i2cPort)
         return kSTkErrBusNotInit;
@@ -93,15 +112,16 @@ sfeTkError_t sfeTkArdI2C::ping()
 //
 sfeTkError_t sfeTkArdI2C::writeByte(uint8_t dataToWrite)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteByte);
+
     if (!_i2cPort)
         return kSTkErrBusNotInit;
 
-    // do the Arduino I2C work
-    _i2cPort->beginTransmission(address());
-    _i2cPort->write(dataToWrite);
-    return _i2cPort->endTransmission() == 0 ? kSTkErrOk : kSTkErrFail;
+    return writeByteUnchecked(dataToWrite);
 }
 
+#if SFE_TK_ENABLE_WORD_OPS
 //---------------------------------------------------------------------------------
 // writeWord()
 //
@@ -111,11 +131,12 @@ sfeTkError_t sfeTkArdI2C::writeByte(uint8_t dataToWrite)
 //
 sfeTkError_t sfeTkArdI2C::writeWord(uint16_t dataToWrite)
 {
-    if (!_i2cPort)
-        return kSTkErrBusNotInit;
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteWord);
 
-    return writeRegion((uint8_t *)&dataToWrite, sizeof(uint16_t));
+    return writeRegisterRegionAddress(nullptr, 0, (uint8_t *)&dataToWrite, sizeof(uint16_t));
 }
+#endif
 
 //---------------------------------------------------------------------------------
 // writeRegion()
@@ -126,6 +147,9 @@ sfeTkError_t sfeTkArdI2C::writeWord(uint16_t dataToWrite)
 //
 sfeTkError_t sfeTkArdI2C::writeRegion(const uint8_t *data, size_t length)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegion);
+
     return writeRegisterRegionAddress(nullptr, 0, data, length) == 0 ? kSTkErrOk : kSTkErrFail;
 }
 
@@ -138,16 +162,16 @@ sfeTkError_t sfeTkArdI2C::writeRegion(const uint8_t *data, size_t length)
 //
 sfeTkError_t sfeTkArdI2C::writeRegisterByte(uint8_t devReg, uint8_t dataToWrite)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegisterByte);
+
     if (!_i2cPort)
         return kSTkErrBusNotInit;
 
-    // do the Arduino I2C work
-    _i2cPort->beginTransmission(address());
-    _i2cPort->write(devReg);
-    _i2cPort->write(dataToWrite);
-    return _i2cPort->endTransmission() == 0 ? kSTkErrOk : kSTkErrFail;
+    return writeRegisterByteUnchecked(devReg, dataToWrite);
 }
 
+#if SFE_TK_ENABLE_WORD_OPS
 //---------------------------------------------------------------------------------
 // writeRegisterWord()
 //
@@ -157,27 +181,43 @@ sfeTkError_t sfeTkArdI2C::writeRegisterByte(uint8_t devReg, uint8_t dataToWrite)
 //
 sfeTkError_t sfeTkArdI2C::writeRegisterWord(uint8_t devReg, uint16_t dataToWrite)
 {
-    if (!_i2cPort)
-        return kSTkErrBusNotInit;
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegisterWord);
 
-    return writeRegisterRegion(devReg, (uint8_t *)&dataToWrite, sizeof(uint16_t));
+    return writeRegisterRegionAddress(&devReg, 1, (uint8_t *)&dataToWrite, sizeof(uint16_t));
 }
+#endif
 
 /**
  * @brief Writes an array of bytes to a register on the target address. Supports any address size
  *
+ * Checks the port - the only check of the operations that call it.
+ *
  * @param devReg The device's register's address - can be any size
  * @param regLength The length of the register address
  * @param data The data to write
  * @param length The length of the data buffer
+ * @param bEndStop Send a stop at the end - false to leave the bus held for a repeated start. Transactions only
  * @return sfeTkError_t Returns kSTkErrOk on success, or kSTkErrFail code
  */
+#if SFE_TK_ENABLE_TRANSACTIONS
+sfeTkError_t sfeTkArdI2C::writeRegisterRegionAddress(uint8_t *devReg, size_t regLength, const uint8_t *data,
+                                                     size_t length, bool bEndStop)
+#else
 sfeTkError_t sfeTkArdI2C::writeRegisterRegionAddress(uint8_t *devReg, size_t regLength, const uint8_t *data,
                                                      size_t length)
+#endif
 {
+    SFE_TK_HOT_PATH();
+
+#if !SFE_TK_ENABLE_TRANSACTIONS
+    const bool bEndStop = true;
+#endif
+
     if (!_i2cPort)
         return kSTkErrBusNotInit;
 
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
     _i2cPort->beginTransmission(address());
 
     if(devReg != nullptr && regLength > 0)
@@ -185,7 +225,12 @@ sfeTkError_t sfeTkArdI2C::writeRegisterRegionAddress(uint8_t *devReg, size_t reg
 
     _i2cPort->write(data, (int)length);
 
-    return _i2cPort->endTransmission() ? kSTkErrFail : kSTkErrOk;
+    uint8_t status = _i2cPort->endTransmission(bEndStop);
+    SFE_TK_PROFILE_CHUNK();
+    if (status != 0)
+        SFE_TK_LOG_WARN("I2C 0x%02x: write of %u bytes failed, status %u", address(), regLength + length, status);
+
+    return status ? kSTkErrFail : kSTkErrOk;
 }
 
 //---------------------------------------------------------------------------------
@@ -197,9 +242,13 @@ sfeTkError_t sfeTkArdI2C::writeRegisterRegionAddress(uint8_t *devReg, size_t reg
 //
 sfeTkError_t sfeTkArdI2C::writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegisterRegion);
+
     return writeRegisterRegionAddress(&devReg, 1, data, length);
 }
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
 //---------------------------------------------------------------------------------
 // write16BitRegisterRegion()
 //
@@ -209,25 +258,47 @@ sfeTkError_t sfeTkArdI2C::writeRegisterRegion(uint8_t devReg, const uint8_t *dat
 //
 sfeTkError_t sfeTkArdI2C::writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegister16Region);
+
     devReg = ((devReg << 8) & 0xff00) | ((devReg >> 8) & 0x00ff);
     return writeRegisterRegionAddress((uint8_t *)&devReg, 2, data, length);
 }
+#endif
 
 
 
 /**
  * @brief Reads an array of bytes to a register on the target address. Supports any address size
  *
+ * Checks the port - the only check of the operations that call it.
+ *
  * @param devReg The device's register's address - can be any size
  * @param regLength The length of the register address
  * @param data The data to buffer to read into
  * @param numBytes The length of the data buffer
  * @param readBytes[out] The number of bytes read
+ * @param bRestarts Join the phases with repeated starts - else a stop is sent between them when stop() is set.
+ *        Transactions only
+ * @param bEndStop Send a stop at the end - false to leave the bus held for a repeated start. Transactions only
  * @return sfeTkError_t Returns kSTkErrOk on success, or kSTkErrFail code
  */
+#if SFE_TK_ENABLE_TRANSACTIONS
+sfeTkError_t sfeTkArdI2C::readRegisterRegionAnyAddress(uint8_t *devReg, size_t regLength, uint8_t *data,
+                                                       size_t numBytes, size_t &readBytes, bool bRestarts,
+                                                       bool bEndStop)
+#else
 sfeTkError_t sfeTkArdI2C::readRegisterRegionAnyAddress(uint8_t *devReg, size_t regLength, uint8_t *data,
                                                        size_t numBytes, size_t &readBytes)
+#endif
 {
+    SFE_TK_HOT_PATH();
+
+#if !SFE_TK_ENABLE_TRANSACTIONS
+    // without transactions, the phases are separated as stop() says and the read always ends with a stop
+    const bool bRestarts = false;
+    const bool bEndStop = true;
+#endif
 
     // got port
     if (!_i2cPort)
@@ -249,29 +320,41 @@ sfeTkError_t sfeTkArdI2C::readRegisterRegionAnyAddress(uint8_t *devReg, size_t r
     {
         if (bFirstInter)
         {
+            SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
             _i2cPort->beginTransmission(address());
 
             _i2cPort->write(devReg, regLength);
 
-            if (_i2cPort->endTransmission(stop()) != 0)
+            uint8_t status = _i2cPort->endTransmission(!bRestarts && stop());
+            if (status != 0)
+            {
+                SFE_TK_LOG_WARN("I2C 0x%02x: write of %u bytes failed, status %u", address(), regLength, status);
                 return kSTkErrFail; // error with the end transmission
+            }
 
+            SFE_TK_PROFILE_PHASE(kSTkProfileAddress);
             bFirstInter = false;
         }
 
         // We're chunking in data - keeping the max chunk to kMaxI2CBufferLength
         nChunk = numBytes > _bufferChunkSize ? _bufferChunkSize : numBytes;
 
-        // Request the bytes. If this is the last chunk, always send a stop
-        nReturned = _i2cPort->requestFrom((int)address(), (int)nChunk, (int)(nChunk == numBytes ? true : stop()));
+        // Request the bytes. If this is the last chunk, send the end stop
+        nReturned = _i2cPort->requestFrom((int)address(), (int)nChunk,
+                                          (int)(nChunk == numBytes ? bEndStop : !bRestarts && stop()));
+        SFE_TK_PROFILE_CHUNK();
 
         // No data returned, no dice
         if (nReturned == 0)
+        {
+            SFE_TK_LOG_WARN("I2C 0x%02x: read %u of %u bytes", address(), nOrig - numBytes, nOrig);
             return kSTkErrBusUnderRead; // error
+        }
 
         // Copy the retrieved data chunk to the current index in the data segment
         for (i = 0; i < nReturned; i++)
             *data++ = _i2cPort->read();
+        SFE_TK_PROFILE_PHASE(kSTkProfileCopy);
 
         // Decrement the amount of data received from the overall data request amount
         numBytes = numBytes - nReturned;
@@ -292,31 +375,16 @@ sfeTkError_t sfeTkArdI2C::readRegisterRegionAnyAddress(uint8_t *devReg, size_t r
 //
 sfeTkError_t sfeTkArdI2C::readRegisterByte(uint8_t devReg, uint8_t &dataToRead)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookReadRegisterByte);
+
     if (!_i2cPort)
         return kSTkErrBusNotInit;
 
-    // Return value
-    uint8_t result = 0;
-
-    int nData = 0;
-
-    _i2cPort->beginTransmission(address());
-    _i2cPort->write(devReg);
-    _i2cPort->endTransmission(stop());
-    _i2cPort->requestFrom(address(), (uint8_t)1);
-
-    while (_i2cPort->available()) // slave may send less than requested
-    {
-        result = _i2cPort->read(); // receive a byte as a proper uint8_t
-        nData++;
-    }
-
-    if (nData == sizeof(uint8_t)) // Only update outputPointer if a single byte was returned
-        dataToRead = result;
-
-    return (nData == sizeof(uint8_t) ? kSTkErrOk : kSTkErrFail);
+    return readRegisterByteUnchecked(devReg, dataToRead);
 }
 
+#if SFE_TK_ENABLE_WORD_OPS
 //---------------------------------------------------------------------------------
 // readRegisterWord()
 //
@@ -326,14 +394,15 @@ sfeTkError_t sfeTkArdI2C::readRegisterByte(uint8_t devReg, uint8_t &dataToRead)
 //
 sfeTkError_t sfeTkArdI2C::readRegisterWord(uint8_t devReg, uint16_t &dataToRead)
 {
-    if (!_i2cPort)
-        return kSTkErrBusNotInit;
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookReadRegisterWord);
 
     size_t nRead;
-    sfeTkError_t retval = readRegisterRegion(devReg, (uint8_t *)&dataToRead, sizeof(uint16_t), nRead);
+    sfeTkError_t retval = readRegisterRegionAnyAddress(&devReg, 1, (uint8_t *)&dataToRead, sizeof(uint16_t), nRead);
 
     return (retval == kSTkErrOk && nRead == sizeof(uint16_t) ? kSTkErrOk : retval);
 }
+#endif
 
 //---------------------------------------------------------------------------------
 // readRegisterRegion()
@@ -344,9 +413,13 @@ sfeTkError_t sfeTkArdI2C::readRegisterWord(uint8_t devReg, uint16_t &dataToRead)
 //
 sfeTkError_t sfeTkArdI2C::readRegisterRegion(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookReadRegisterRegion);
+
     return readRegisterRegionAnyAddress(&devReg, 1, data, numBytes, readBytes);
 }
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
 //---------------------------------------------------------------------------------
 // read16BitRegisterRegion()
 //
@@ -356,6 +429,134 @@ sfeTkError_t sfeTkArdI2C::readRegisterRegion(uint8_t devReg, uint8_t *data, size
 //
 sfeTkError_t sfeTkArdI2C::readRegister16Region(uint16_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookReadRegister16Region);
+
     devReg = ((devReg << 8) & 0xff00) | ((devReg >> 8) & 0x00ff);
     return readRegisterRegionAnyAddress((uint8_t *)&devReg, 2, data, numBytes, readBytes);
 }
+#endif
+
+#if SFE_TK_ENABLE_TRANSACTIONS
+//---------------------------------------------------------------------------------
+// executeSteps()
+//
+// Runs the steps of a transaction as one I2C transaction - each step ends with a repeated start, the last with
+// a stop. On an error the Arduino core ends the transaction.
+//
+sfeTkError_t sfeTkArdI2C::executeSteps(const sfeTkTxnStep *steps, size_t nSteps)
+{
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookTransaction);
+
+    if (!_i2cPort)
+        return kSTkErrBusNotInit;
+
+    for (size_t i = 0; i < nSteps; i++)
+    {
+        bool bLast = i + 1 == nSteps;
+
+        // the register address, sent MSB first
+        uint8_t devReg[2] = {(uint8_t)(steps[i].reg >> 8), (uint8_t)steps[i].reg};
+
+        uint8_t value[2];
+        size_t length, readBytes;
+        const uint8_t *data = sfeTkTxnStepData(steps[i], value, length);
+        sfeTkError_t retval = kSTkErrFail;
+
+        switch (steps[i].op)
+        {
+        case kSTkBusOpWriteRegion:
+            retval = writeRegisterRegionAddress(nullptr, 0, data, length, bLast);
+            break;
+
+        case kSTkBusOpWriteRegisterRegion:
+            retval = writeRegisterRegionAddress(&devReg[1], 1, data, length, bLast);
+            break;
+
+        case kSTkBusOpReadRegisterRegion:
+            retval = readRegisterRegionAnyAddress(&devReg[1], 1, steps[i].data, length, readBytes, true, bLast);
+            break;
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+        case kSTkBusOpWriteRegister16Region:
+            retval = writeRegisterRegionAddress(devReg, 2, data, length, bLast);
+            break;
+
+        case kSTkBusOpReadRegister16Region:
+            retval = readRegisterRegionAnyAddress(devReg, 2, steps[i].data, length, readBytes, true, bLast);
+            break;
+#endif
+        default: // a compiled out operation
+            SFE_TK_LOG_ERROR("transaction step %u: operation %u is compiled out", i, steps[i].op);
+            break;
+        }
+        if (retval != kSTkErrOk)
+            return retval;
+    }
+    return kSTkErrOk;
+}
+#endif
+
+#if SFE_TK_ENABLE_ASYNC
+//---------------------------------------------------------------------------------
+// startAsync()
+//
+// Hands a request to the asynchronous transfer backend - or the CPU fallback if none is set.
+// The request's callback and context are left as set by the caller.
+//
+sfeTkError_t sfeTkArdI2C::startAsync(sfeTkBusOp_t op, uint16_t devReg, uint8_t *data, size_t numBytes,
+                                     sfeTkBusRequest &request)
+{
+    SFE_TK_HOT_PATH();
+
+    if (!_i2cPort)
+        return kSTkErrBusNotInit;
+
+    if (!data)
+        return kSTkErrBusNullBuffer;
+
+    request.op = op;
+    request.reg = devReg;
+    request.data = data;
+    request.length = numBytes;
+    request.transferred = 0;
+
+    if (!_asyncTransfer)
+    {
+        sfeTkCpuTransfer cpuTransfer;
+        return cpuTransfer.start(*this, request);
+    }
+    return _asyncTransfer->start(*this, request);
+}
+#endif
+
+#if SFE_TK_ENABLE_ASYNC
+//---------------------------------------------------------------------------------
+// readRegisterRegionAsync()
+//
+// Reads an array of bytes from a given register, using the async transfer backend
+//
+sfeTkError_t sfeTkArdI2C::readRegisterRegionAsync(uint8_t devReg, uint8_t *data, size_t numBytes,
+                                                  sfeTkBusRequest &request)
+{
+    SFE_TK_HOT_PATH();
+
+    return startAsync(kSTkBusOpReadRegisterRegion, devReg, data, numBytes, request);
+}
+#endif
+
+#if SFE_TK_ENABLE_ASYNC && SFE_TK_ENABLE_16BIT_REGISTERS
+//---------------------------------------------------------------------------------
+// readRegister16RegionAsync()
+//
+// Reads an array of bytes from a given 16-bit register, using the async transfer backend
+//
+sfeTkError_t sfeTkArdI2C::readRegister16RegionAsync(uint16_t devReg, uint8_t *data, size_t numBytes,
+                                                    sfeTkBusRequest &request)
+{
+    SFE_TK_HOT_PATH();
+
+    return startAsync(kSTkBusOpReadRegister16Region, devReg, data, numBytes, request);
+}
+#endif
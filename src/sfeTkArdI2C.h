@@ -31,7 +31,13 @@ over Inter-Integrated Circuit (I2C) in Arduino
 #include <Wire.h>
 
 // Include our platform I2C interface definition.
+#include <sfeTk/sfeTkHotPath.h>
+#include <sfeTk/sfeTkIAsyncTransfer.h>
 #include <sfeTk/sfeTkII2C.h>
+#include <sfeTk/sfeTkLog.h>
+#include <sfeTk/sfeTkProfiler.h>
+
+class sfeTkArdI2CChecked;
 
 /**
  * @brief The sfeTkArdI2C implements an sfeTkII2C interface, defining the Arduino implementation for I2C in the Toolkit
@@ -51,15 +57,20 @@ class sfeTkArdI2C : public sfeTkII2C
 
         @param addr The address of the device
     */
-    sfeTkArdI2C(uint8_t addr) : sfeTkII2C(addr)
+    sfeTkArdI2C(uint8_t addr)
+        : sfeTkII2C(addr), _i2cPort{nullptr}, _bufferChunkSize{kDefaultBufferChunk}
     {
     }
 
     /**
      * @brief copy constructor
      */
-    sfeTkArdI2C(sfeTkArdI2C const &rhs) : sfeTkII2C(), _i2cPort{rhs._i2cPort}
+    sfeTkArdI2C(sfeTkArdI2C const &rhs)
+        : sfeTkII2C(rhs), _i2cPort{rhs._i2cPort}, _bufferChunkSize{rhs._bufferChunkSize}
     {
+#if SFE_TK_ENABLE_ASYNC
+        _asyncTransfer = rhs._asyncTransfer;
+#endif
     }
 
     /**
@@ -70,7 +81,12 @@ class sfeTkArdI2C : public sfeTkII2C
      */
     sfeTkArdI2C &operator=(const sfeTkArdI2C &rhs)
     {
+        sfeTkII2C::operator=(rhs);
         _i2cPort = rhs._i2cPort;
+#if SFE_TK_ENABLE_ASYNC
+        _asyncTransfer = rhs._asyncTransfer;
+#endif
+        _bufferChunkSize = rhs._bufferChunkSize;
         return *this;
     }
 
@@ -118,6 +134,7 @@ class sfeTkArdI2C : public sfeTkII2C
     */
     sfeTkError_t writeByte(uint8_t data);
 
+#if SFE_TK_ENABLE_WORD_OPS
     /**
         @brief Sends a word to the device.
         @note sfeTkIBus interface method
@@ -127,6 +144,7 @@ class sfeTkArdI2C : public sfeTkII2C
         @retval returns  kStkErrOk on success
     */
     sfeTkError_t writeWord(uint16_t data);
+#endif
 
     /**
         @brief Sends a block of data to the device.
@@ -150,6 +168,7 @@ class sfeTkArdI2C : public sfeTkII2C
     */
     sfeTkError_t writeRegisterByte(uint8_t devReg, uint8_t data);
 
+#if SFE_TK_ENABLE_WORD_OPS
     /**
         @brief Write a single word to the given register
         @note sfeTkIBus interface method
@@ -160,6 +179,7 @@ class sfeTkArdI2C : public sfeTkII2C
         @retval returns  kStkErrOk on success
     */
     sfeTkError_t writeRegisterWord(uint8_t devReg, uint16_t data);
+#endif
 
     /**
         @brief Writes a number of bytes starting at the given register's address.
@@ -175,6 +195,7 @@ class sfeTkArdI2C : public sfeTkII2C
     */
     sfeTkError_t writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length);
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
     /**
         @brief Writes a number of bytes starting at the given register's 16-bit address.
 
@@ -186,6 +207,7 @@ class sfeTkArdI2C : public sfeTkII2C
 
     */
     sfeTkError_t writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length);
+#endif
 
     /**
         @brief Reads a byte of data from the given register.
@@ -199,6 +221,7 @@ class sfeTkArdI2C : public sfeTkII2C
     */
     sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data);
 
+#if SFE_TK_ENABLE_WORD_OPS
     /**
         @brief Reads a word of data from the given register.
 
@@ -210,6 +233,7 @@ class sfeTkArdI2C : public sfeTkII2C
         @retval kSTkErrOk on success
     */
     sfeTkError_t readRegisterWord(uint8_t devReg, uint16_t &data);
+#endif
 
     /**
         @brief Reads a block of data from the given register.
@@ -227,6 +251,7 @@ class sfeTkArdI2C : public sfeTkII2C
     */
     sfeTkError_t readRegisterRegion(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes);
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
     /**
         @brief Reads a block of data from the given 16-bit register address.
 
@@ -239,6 +264,83 @@ class sfeTkArdI2C : public sfeTkII2C
 
     */
     sfeTkError_t readRegister16Region(uint16_t reg, uint8_t *data, size_t numBytes, size_t &readBytes);
+#endif
+
+#if SFE_TK_ENABLE_TRANSACTIONS
+    /**
+        @brief Runs the steps of a transaction as one I2C transaction - the steps are joined with repeated starts,
+               and the stop is sent after the last step. See sfeTk/sfeTkTransaction.h
+        @note sfeTkIBus interface method
+
+        @param steps The steps
+        @param nSteps The number of steps
+
+        @retval kSTkErrOk if every step succeeded, else the result of the step that failed
+    */
+    sfeTkError_t executeSteps(const sfeTkTxnStep *steps, size_t nSteps);
+#endif
+
+    // Value returning reads - see sfeTk/sfeTkResult.h. These are the sfeTkIBus versions: they call the read methods
+    // through the vtable, so a subclass that overrides a read method is used by the value form too.
+    using sfeTkIBus::readRegisterByte;
+#if SFE_TK_ENABLE_WORD_OPS
+    using sfeTkIBus::readRegisterWord;
+#endif
+    using sfeTkIBus::readRegisterRegion;
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    using sfeTkIBus::readRegister16Region;
+#endif
+
+#if SFE_TK_ENABLE_ASYNC
+    /**
+        @brief Reads a block of data from the given register, using the asynchronous transfer backend.
+
+        @note With no backend set, the CPU fallback is used and the request is complete on return.
+        @note The request's callback and context are kept - set them before calling.
+
+        @param devReg The device's register's address.
+        @param[out] data Data buffer to read into
+        @param numBytes Number of bytes to read/length of data buffer
+        @param request The request used to track the transfer. Must remain valid until done.
+
+        @retval kSTkErrOk if the transfer was started
+    */
+    sfeTkError_t readRegisterRegionAsync(uint8_t devReg, uint8_t *data, size_t numBytes, sfeTkBusRequest &request);
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**
+        @brief Reads a block of data from the given 16-bit register address, using the asynchronous transfer backend.
+
+        @param devReg The device's 16 bit register's address.
+        @param[out] data Data buffer to read into
+        @param numBytes Number of bytes to read/length of data buffer
+        @param request The request used to track the transfer. Must remain valid until done.
+
+        @retval kSTkErrOk if the transfer was started
+    */
+    sfeTkError_t readRegister16RegionAsync(uint16_t devReg, uint8_t *data, size_t numBytes, sfeTkBusRequest &request);
+#endif
+
+    /**
+        @brief Set the asynchronous transfer backend (DMA) used by the Async methods.
+
+        @param theBackend The backend - nullptr selects the CPU fallback
+    */
+    void setAsyncTransfer(sfeTkIAsyncTransfer *theBackend)
+    {
+        _asyncTransfer = theBackend;
+    }
+
+    /**
+        @brief The asynchronous transfer backend
+
+        @retval The backend, nullptr if the CPU fallback is used
+    */
+    sfeTkIAsyncTransfer *asyncTransfer(void)
+    {
+        return _asyncTransfer;
+    }
+#endif
 
     // Buffer size chunk getter/setter
     /**
@@ -266,6 +368,35 @@ class sfeTkArdI2C : public sfeTkII2C
         return _bufferChunkSize;
     }
 
+    /**
+        @brief Set the clock of the Arduino I2C port - the clock of every device on the port
+
+        @param clock The clock rate in Hz
+
+        @retval kSTkErrOk on success, kSTkErrBusNotInit if the port is not set
+    */
+    sfeTkError_t setClock(uint32_t clock);
+
+    /**
+        @brief The Arduino I2C port - for use by asynchronous transfer backends
+
+        @retval The port, nullptr if not initialized
+    */
+    TwoWire *port(void)
+    {
+        return _i2cPort;
+    }
+
+    /**
+        @brief A checked handle to this bus - its operations skip the port check made by each method of this class.
+
+        @note Call after a successful init(). The handle refers to this object, and stays valid while this
+              object exists and its port is not changed.
+
+        @retval sfeTkResult<sfeTkArdI2CChecked> The handle, or kSTkErrBusNotInit if the bus is not initialized
+    */
+    sfeTkResult<sfeTkArdI2CChecked> checked(void);
+
   protected:
     // note: The wire port is protected, allowing access if a sub-class is
     //      created to implement a special read/write routine
@@ -273,11 +404,39 @@ class sfeTkArdI2C : public sfeTkII2C
     /** The actual Arduino i2c port */
     TwoWire *_i2cPort;
 
+#if SFE_TK_ENABLE_ASYNC
+    /** The asynchronous transfer backend - nullptr for the CPU fallback */
+    sfeTkIAsyncTransfer *_asyncTransfer = nullptr;
+#endif
+
   private:
+    friend class sfeTkArdI2CChecked;
+
+    // The operations without the port check - used once the port is checked, and by sfeTkArdI2CChecked
+    inline sfeTkError_t writeByteUnchecked(uint8_t data);
+
+    inline sfeTkError_t writeRegisterByteUnchecked(uint8_t devReg, uint8_t data);
+
+    inline sfeTkError_t readRegisterByteUnchecked(uint8_t devReg, uint8_t &data);
+
+#if SFE_TK_ENABLE_TRANSACTIONS
+    // a transaction joins its steps with repeated starts - the restart and stop flags are only needed for that
+    sfeTkError_t writeRegisterRegionAddress(uint8_t *devReg, size_t regLength, const uint8_t *data, size_t length,
+                                            bool bEndStop = true);
+
+    sfeTkError_t readRegisterRegionAnyAddress(uint8_t *devReg, size_t regLength, uint8_t *data, size_t numBytes,
+                                              size_t &readBytes, bool bRestarts = false, bool bEndStop = true);
+#else
     sfeTkError_t writeRegisterRegionAddress(uint8_t *devReg, size_t regLength, const uint8_t *data, size_t length);
 
     sfeTkError_t readRegisterRegionAnyAddress(uint8_t *devReg, size_t regLength, uint8_t *data, size_t numBytes,
                                               size_t &readBytes);
+#endif
+
+#if SFE_TK_ENABLE_ASYNC
+    sfeTkError_t startAsync(sfeTkBusOp_t op, uint16_t devReg, uint8_t *data, size_t numBytes,
+                            sfeTkBusRequest &request);
+#endif
 
     /** Default buffer chunk size*/
     static constexpr size_t kDefaultBufferChunk = 32;
@@ -285,3 +444,300 @@ class sfeTkArdI2C : public sfeTkII2C
     /** The I2C buffer chunker - chunk size*/
     size_t _bufferChunkSize;
 };
+
+// The byte transfers without the port check. Inline - each folds into the bus method that checks the port and
+// calls it, so a build that does not use the checked handles has no extra functions.
+
+//---------------------------------------------------------------------------------
+// writeByteUnchecked()
+//
+// writeByte() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdI2C::writeByteUnchecked(uint8_t dataToWrite)
+{
+    SFE_TK_HOT_PATH();
+
+    // do the Arduino I2C work
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+    _i2cPort->beginTransmission(address());
+    _i2cPort->write(dataToWrite);
+    uint8_t status = _i2cPort->endTransmission();
+    SFE_TK_PROFILE_CHUNK();
+    if (status != 0)
+        SFE_TK_LOG_WARN("I2C 0x%02x: write of %u bytes failed, status %u", address(), 1, status);
+    return status == 0 ? kSTkErrOk : kSTkErrFail;
+}
+
+//---------------------------------------------------------------------------------
+// writeRegisterByteUnchecked()
+//
+// writeRegisterByte() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdI2C::writeRegisterByteUnchecked(uint8_t devReg, uint8_t dataToWrite)
+{
+    SFE_TK_HOT_PATH();
+
+    // do the Arduino I2C work
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+    _i2cPort->beginTransmission(address());
+    _i2cPort->write(devReg);
+    _i2cPort->write(dataToWrite);
+    uint8_t status = _i2cPort->endTransmission();
+    SFE_TK_PROFILE_CHUNK();
+    if (status != 0)
+        SFE_TK_LOG_WARN("I2C 0x%02x: write of %u bytes failed, status %u", address(), 2, status);
+    return status == 0 ? kSTkErrOk : kSTkErrFail;
+}
+
+//---------------------------------------------------------------------------------
+// readRegisterByteUnchecked()
+//
+// readRegisterByte() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdI2C::readRegisterByteUnchecked(uint8_t devReg, uint8_t &dataToRead)
+{
+    SFE_TK_HOT_PATH();
+
+    // Return value
+    uint8_t result = 0;
+
+    int nData = 0;
+
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+    _i2cPort->beginTransmission(address());
+    _i2cPort->write(devReg);
+    _i2cPort->endTransmission(stop());
+    SFE_TK_PROFILE_PHASE(kSTkProfileAddress);
+    _i2cPort->requestFrom(address(), (uint8_t)1);
+    SFE_TK_PROFILE_CHUNK();
+
+    while (_i2cPort->available()) // slave may send less than requested
+    {
+        result = _i2cPort->read(); // receive a byte as a proper uint8_t
+        nData++;
+    }
+    SFE_TK_PROFILE_PHASE(kSTkProfileCopy);
+
+    if (nData == sizeof(uint8_t)) // Only update outputPointer if a single byte was returned
+        dataToRead = result;
+    else
+        SFE_TK_LOG_WARN("I2C 0x%02x: read %u of %u bytes", address(), nData, 1);
+
+    return (nData == sizeof(uint8_t) ? kSTkErrOk : kSTkErrFail);
+}
+
+/**
+ * @brief A checked handle to an initialized sfeTkArdI2C bus.
+ *
+ * Each sfeTkArdI2C method checks the bus is initialized before any work. A handle is only returned by
+ * sfeTkArdI2C::checked() once the bus is initialized, so its byte operations skip the check. Word, region and
+ * 16-bit operations go straight to the region transfer they share with the bus methods, which checks the port
+ * once. Results are the same as the sfeTkArdI2C methods.
+ *
+ * @code
+ *     sfeTkResult<sfeTkArdI2CChecked> bus = myI2C.checked();
+ *     if (!bus)
+ *         return bus.error();
+ *     sfeTkArdI2CChecked theBus = bus.value();
+ *     theBus.readRegisterByte(kRegStatus, status);
+ * @endcode
+ *
+ * The handle is a pointer to the bus - copy it freely. Use the value of a successful result only.
+ */
+class sfeTkArdI2CChecked
+{
+  public:
+    /**
+        @brief Sends a single byte to the device
+
+        @param data Data to write.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeByte(uint8_t data)
+    {
+        return _bus->writeByteUnchecked(data);
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**
+        @brief Sends a word to the device.
+
+        @param data Data to write.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeWord(uint16_t data)
+    {
+        return _bus->writeRegisterRegionAddress(nullptr, 0, (uint8_t *)&data, sizeof(uint16_t));
+    }
+#endif
+
+    /**
+        @brief Sends a block of data to the device.
+
+        @param data Data to write.
+        @param length Length of the data.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegion(const uint8_t *data, size_t length)
+    {
+        return _bus->writeRegisterRegionAddress(nullptr, 0, data, length) == 0 ? kSTkErrOk : kSTkErrFail;
+    }
+
+    /**
+        @brief Write a single byte to the given register
+
+        @param devReg The device's register's address.
+        @param data Data to write.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegisterByte(uint8_t devReg, uint8_t data)
+    {
+        return _bus->writeRegisterByteUnchecked(devReg, data);
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**
+        @brief Write a single word (two bytes) to the given register
+
+        @param devReg The device's register's address.
+        @param data Data to write.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegisterWord(uint8_t devReg, uint16_t data)
+    {
+        return _bus->writeRegisterRegionAddress(&devReg, 1, (uint8_t *)&data, sizeof(uint16_t));
+    }
+#endif
+
+    /**
+        @brief Writes a number of bytes starting at the given register's address.
+
+        @param devReg The device's register's address.
+        @param data Data to write.
+        @param length Length of the data.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
+    {
+        return _bus->writeRegisterRegionAddress(&devReg, 1, data, length);
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**
+        @brief Writes a number of bytes starting at the given 16-bit register's address.
+
+        @param devReg The device's 16 bit register's address.
+        @param data Data to write.
+        @param length Length of the data.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
+    {
+        devReg = ((devReg << 8) & 0xff00) | ((devReg >> 8) & 0x00ff);
+        return _bus->writeRegisterRegionAddress((uint8_t *)&devReg, 2, data, length);
+    }
+#endif
+
+    /**
+        @brief Reads a byte of data from the given register.
+
+        @param devReg The device's register's address.
+        @param[out] data Data buffer to read into
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data)
+    {
+        return _bus->readRegisterByteUnchecked(devReg, data);
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**
+        @brief Reads a word of data from the given register.
+
+        @param devReg The device's register's address.
+        @param[out] data Data buffer to read into
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegisterWord(uint8_t devReg, uint16_t &data)
+    {
+        size_t nRead;
+        sfeTkError_t retval = _bus->readRegisterRegionAnyAddress(&devReg, 1, (uint8_t *)&data, sizeof(uint16_t), nRead);
+        return (retval == kSTkErrOk && nRead == sizeof(uint16_t) ? kSTkErrOk : retval);
+    }
+#endif
+
+    /**
+        @brief Reads a block of data from the given register.
+
+        @param devReg The device's register's address.
+        @param[out] data Data buffer to read into
+        @param numBytes Number of bytes to read/length of data buffer
+        @param[out] readBytes Number of bytes read
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegisterRegion(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        return _bus->readRegisterRegionAnyAddress(&devReg, 1, data, numBytes, readBytes);
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**
+        @brief Reads a block of data from the given 16-bit register address.
+
+        @param devReg The device's 16 bit register's address.
+        @param[out] data Data buffer to read into
+        @param numBytes Number of bytes to read/length of data buffer
+        @param[out] readBytes Number of bytes read
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegister16Region(uint16_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        devReg = ((devReg << 8) & 0xff00) | ((devReg >> 8) & 0x00ff);
+        return _bus->readRegisterRegionAnyAddress((uint8_t *)&devReg, 2, data, numBytes, readBytes);
+    }
+#endif
+
+    /**
+        @brief The bus of this handle
+
+        @retval The bus
+    */
+    sfeTkArdI2C &bus(void)
+    {
+        return *_bus;
+    }
+
+  private:
+    friend class sfeTkArdI2C;
+    template <typename> friend class sfeTkResult;
+
+    // Handles are made by sfeTkArdI2C::checked() - the default handle is the value of a failed result
+    sfeTkArdI2CChecked(void) : _bus{nullptr}
+    {
+    }
+
+    explicit sfeTkArdI2CChecked(sfeTkArdI2C *theBus) : _bus{theBus}
+    {
+    }
+
+    sfeTkArdI2C *_bus;
+};
+
+inline sfeTkResult<sfeTkArdI2CChecked> sfeTkArdI2C::checked(void)
+{
+    if (!_i2cPort)
+        return sfeTkResult<sfeTkArdI2CChecked>::failure(kSTkErrBusNotInit);
+
+    return sfeTkResult<sfeTkArdI2CChecked>(sfeTkArdI2CChecked(this));
+}
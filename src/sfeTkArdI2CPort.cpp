@@ -0,0 +1,131 @@
+/*
+sfeTkArdI2CPort.cpp
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "sfeTkArdI2CPort.h"
+
+//---------------------------------------------------------------------------------
+// init()
+//
+// Set the Arduino port of the context. The I2C address is set per transaction by the device handles.
+//
+sfeTkError_t sfeTkArdI2CPort::init(TwoWire &wirePort, bool bInit)
+{
+    return _bus.init(wirePort, sfeTkII2C::kNoAddress, bInit);
+}
+
+//---------------------------------------------------------------------------------
+// setClock()
+//
+sfeTkError_t sfeTkArdI2CPort::setClock(uint32_t clock)
+{
+    TwoWire *thePort = _bus.port();
+    if (!thePort)
+        return kSTkErrBusNotInit;
+
+    sfeTkLockGuard guard(_lock);
+    thePort->setClock(clock);
+    _clock = clock;
+
+    return kSTkErrOk;
+}
+
+//---------------------------------------------------------------------------------
+// Device handle methods - each runs the sfeTkArdI2C method on the port, for this device
+//---------------------------------------------------------------------------------
+
+sfeTkError_t sfeTkArdI2CDevice::ping(void)
+{
+    return transact([](sfeTkArdI2C &bus) { return bus.ping(); });
+}
+
+sfeTkError_t sfeTkArdI2CDevice::writeByte(uint8_t data)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.writeByte(data); });
+}
+
+#if SFE_TK_ENABLE_WORD_OPS
+sfeTkError_t sfeTkArdI2CDevice::writeWord(uint16_t data)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.writeWord(data); });
+}
+#endif
+
+sfeTkError_t sfeTkArdI2CDevice::writeRegion(const uint8_t *data, size_t length)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.writeRegion(data, length); });
+}
+
+sfeTkError_t sfeTkArdI2CDevice::writeRegisterByte(uint8_t devReg, uint8_t data)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.writeRegisterByte(devReg, data); });
+}
+
+#if SFE_TK_ENABLE_WORD_OPS
+sfeTkError_t sfeTkArdI2CDevice::writeRegisterWord(uint8_t devReg, uint16_t data)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.writeRegisterWord(devReg, data); });
+}
+#endif
+
+sfeTkError_t sfeTkArdI2CDevice::writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.writeRegisterRegion(devReg, data, length); });
+}
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+sfeTkError_t sfeTkArdI2CDevice::writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.writeRegister16Region(devReg, data, length); });
+}
+#endif
+
+sfeTkError_t sfeTkArdI2CDevice::readRegisterByte(uint8_t devReg, uint8_t &data)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.readRegisterByte(devReg, data); });
+}
+
+#if SFE_TK_ENABLE_WORD_OPS
+sfeTkError_t sfeTkArdI2CDevice::readRegisterWord(uint8_t devReg, uint16_t &data)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.readRegisterWord(devReg, data); });
+}
+#endif
+
+sfeTkError_t sfeTkArdI2CDevice::readRegisterRegion(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.readRegisterRegion(devReg, data, numBytes, readBytes); });
+}
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+sfeTkError_t sfeTkArdI2CDevice::readRegister16Region(uint16_t devReg, uint8_t *data, size_t numBytes,
+                                                     size_t &readBytes)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.readRegister16Region(devReg, data, numBytes, readBytes); });
+}
+#endif
+
+#if SFE_TK_ENABLE_TRANSACTIONS
+sfeTkError_t sfeTkArdI2CDevice::executeSteps(const sfeTkTxnStep *steps, size_t nSteps)
+{
+    return transact([&](sfeTkArdI2C &bus) { return bus.executeSteps(steps, nSteps); });
+}
+#endif
@@ -0,0 +1,53 @@
+/*
+sfeTkArdLog.cpp
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+The Arduino log of the toolkit (sfeTk/sfeTkLog.h).
+Built only when SFE_TK_LOG_LEVEL > 0.
+
+*/
+
+#include "sfeTkArdLog.h"
+
+#if SFE_TK_LOG_LEVEL > 0
+
+//---------------------------------------------------------------------------------
+// sfeTkArdLogInstance()
+//
+// The log of the program - a static buffer, so it is there before any constructor logs to it
+//
+sfeTkArdLog_t &sfeTkArdLogInstance(void)
+{
+    static sfeTkArdLog_t theLog;
+    return theLog;
+}
+
+//---------------------------------------------------------------------------------
+// sfeTkLogWrite()
+//
+// Records a log site, with the time in microseconds
+//
+void sfeTkLogWrite(uint32_t id, uint8_t level, const uint32_t *args, uint8_t nArgs)
+{
+    sfeTkArdLogInstance().write(id, level, (uint32_t)micros(), args, nArgs);
+}
+
+#endif // SFE_TK_LOG_LEVEL
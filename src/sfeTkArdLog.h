@@ -0,0 +1,99 @@
+/*
+sfeTkArdLog.h
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+The Arduino log of the toolkit (sfeTk/sfeTkLog.h) - the log sites of the
+program write to one ring buffer, with micros() time stamps, safe to use
+from interrupts. sfeTkArdLogDump() sends the records out as text lines
+for tools/sfeTkLog.py to decode.
+
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "sfeTkArdCriticalSection.h"
+#include <sfeTk/sfeTkLog.h>
+
+// The size of the log buffer in bytes - a record is 9 bytes plus 4 for each argument
+#ifndef SFE_TK_LOG_BUFFER_SIZE
+#define SFE_TK_LOG_BUFFER_SIZE 256
+#endif
+
+/**
+ * @brief The type of the program's log
+ */
+typedef sfeTkLog<SFE_TK_LOG_BUFFER_SIZE, sfeTkArdCriticalSection> sfeTkArdLog_t;
+
+/**
+ * @brief The log of the program - the log sites write to it. Built when SFE_TK_LOG_LEVEL > 0.
+ */
+sfeTkArdLog_t &sfeTkArdLogInstance(void);
+
+/**
+ * @brief Sends the records in the log to a stream, and removes them.
+ *
+ * Each record is a line - "#L" and the record bytes in hex. When records were dropped since the last dump, a line
+ * "#LD" and the count comes first. The lines can be mixed with other output - tools/sfeTkLog.py picks them out of
+ * a capture of the serial port.
+ *
+ * @param out Where to send the lines - Serial, or any class with print() and println()
+ *
+ * @retval size_t The number of records sent
+ */
+template <typename Out> size_t sfeTkArdLogDump(Out &out)
+{
+    uint32_t dropped = sfeTkArdLogInstance().takeDropped();
+    if (dropped > 0)
+    {
+        out.print("#LD ");
+        out.println((unsigned long)dropped);
+    }
+
+    static const char kHex[] = "0123456789abcdef";
+    uint8_t record[kSTkLogHeaderSize + 4 * kSTkLogMaxArgs];
+    char line[2 + 2 * sizeof(record) + 1];
+    size_t nRecords = 0;
+
+    size_t length;
+    while ((length = sfeTkArdLogInstance().read(record, sizeof(record))) > 0)
+    {
+        // read() can return more than one record - a line for each
+        for (size_t start = 0; start < length;)
+        {
+            size_t recordLength = kSTkLogHeaderSize + 4 * (record[start + kSTkLogHeaderSize - 1] & 0x0F);
+            line[0] = '#';
+            line[1] = 'L';
+            for (size_t i = 0; i < recordLength; i++)
+            {
+                line[2 + 2 * i] = kHex[record[start + i] >> 4];
+                line[3 + 2 * i] = kHex[record[start + i] & 0x0F];
+            }
+            line[2 + 2 * recordLength] = '\0';
+            out.println(line);
+
+            start += recordLength;
+            nRecords++;
+        }
+    }
+    return nRecords;
+}
@@ -0,0 +1,59 @@
+/*
+sfeTkArdProfiler.cpp
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+The Arduino clock and instance of the bus phase profiler (sfeTk/sfeTkProfiler.h).
+Built only when SFE_TK_PROFILE_PHASES is defined.
+
+*/
+
+#if defined(SFE_TK_PROFILE_PHASES)
+
+#include "sfeTkArdCycles.h"
+#include <sfeTk/sfeTkProfiler.h>
+
+//---------------------------------------------------------------------------------
+// sfeTkProfilerInstance()
+//
+// The profiler of the program - made on first use
+//
+sfeTkProfiler &sfeTkProfilerInstance(void)
+{
+    static sfeTkProfiler theProfiler;
+    return theProfiler;
+}
+
+//---------------------------------------------------------------------------------
+// sfeTkProfileClock()
+//
+// The cycle counter where there is one, else micros() - see sfeTkArdCycles.h
+//
+uint32_t sfeTkProfileClock(void)
+{
+    return sfeTkArdCycles();
+}
+
+uint32_t sfeTkProfileClockHz(void)
+{
+    return sfeTkArdCyclesHz();
+}
+
+#endif // SFE_TK_PROFILE_PHASES
@@ -24,15 +24,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "sfeTkArdSPI.h"
+#include <sfeTk/sfeTkHotPath.h>
+#include <sfeTk/sfeTkLog.h>
+#include <sfeTk/sfeTkProfiler.h>
 #include <Arduino.h>
 
-// Note: A leading "1" must be added to transfer with register to indicate a "read"
-// Note to our future selves:
-//   This works / is required on both the ISM330 and MMC5983,
-//   but will cause badness with other SPI devices.
-//   We may need to add an alternate method if we ever add another SPI device.
-#define kSPIReadBit 0x80
-
 //---------------------------------------------------------------------------------
 // init()
 //
@@ -90,24 +86,16 @@ sfeTkError_t sfeTkArdSPI::init(bool bInit)
 //
 sfeTkError_t sfeTkArdSPI::writeByte(uint8_t dataToWrite)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteByte);
 
     if (!_spiPort)
         return kSTkErrBusNotInit;
 
-    // Apply settings
-    _spiPort->beginTransaction(_sfeSPISettings);
-    // Signal communication start
-    digitalWrite(cs(), LOW);
-
-    _spiPort->transfer(dataToWrite);
-
-    // End communication
-    digitalWrite(cs(), HIGH);
-    _spiPort->endTransaction();
-
-    return kSTkErrOk;
+    return writeByteUnchecked(dataToWrite);
 }
 
+#if SFE_TK_ENABLE_WORD_OPS
 //---------------------------------------------------------------------------------
 // writeWord()
 //
@@ -117,8 +105,12 @@ sfeTkError_t sfeTkArdSPI::writeByte(uint8_t dataToWrite)
 //
 sfeTkError_t sfeTkArdSPI::writeWord(uint16_t dataToWrite)
 {
-    return writeRegion((uint8_t *)&dataToWrite, sizeof(uint8_t)) > 0;
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteWord);
+
+    return writeRegionTransfer((uint8_t *)&dataToWrite, sizeof(uint16_t));
 }
+#endif
 
 
 //---------------------------------------------------------------------------------
@@ -130,22 +122,23 @@ sfeTkError_t sfeTkArdSPI::writeWord(uint16_t dataToWrite)
 //
 sfeTkError_t sfeTkArdSPI::writeRegion(const uint8_t *dataToWrite, size_t length)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegion);
+
+    return writeRegionTransfer(dataToWrite, length);
+}
 
+//---------------------------------------------------------------------------------
+// writeRegionTransfer()
+//
+// The transfer of writeRegion() and writeWord() - the one port check of each.
+//
+sfeTkError_t sfeTkArdSPI::writeRegionTransfer(const uint8_t *dataToWrite, size_t length)
+{
     if (!_spiPort)
         return kSTkErrBusNotInit;
 
-    _spiPort->beginTransaction(_sfeSPISettings);
-    // Signal communication start
-    digitalWrite(cs(), LOW);
-
-    for (size_t i = 0; i < length; i++)
-        _spiPort->transfer(*dataToWrite++);
-
-    // End communication
-    digitalWrite(cs(), HIGH);
-    _spiPort->endTransaction();
-
-    return kSTkErrOk;
+    return writeRegionUnchecked(dataToWrite, length);
 }
 
 //---------------------------------------------------------------------------------
@@ -157,25 +150,16 @@ sfeTkError_t sfeTkArdSPI::writeRegion(const uint8_t *dataToWrite, size_t length)
 //
 sfeTkError_t sfeTkArdSPI::writeRegisterByte(uint8_t devReg, uint8_t dataToWrite)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegisterByte);
 
     if (!_spiPort)
         return kSTkErrBusNotInit;
 
-    // Apply settings
-    _spiPort->beginTransaction(_sfeSPISettings);
-    // Signal communication start
-    digitalWrite(cs(), LOW);
-
-    _spiPort->transfer(devReg);
-    _spiPort->transfer(dataToWrite);
-
-    // End communication
-    digitalWrite(cs(), HIGH);
-    _spiPort->endTransaction();
-
-    return kSTkErrOk;
+    return writeRegisterByteUnchecked(devReg, dataToWrite);
 }
 
+#if SFE_TK_ENABLE_WORD_OPS
 //---------------------------------------------------------------------------------
 // writeRegisterWord()
 //
@@ -185,8 +169,12 @@ sfeTkError_t sfeTkArdSPI::writeRegisterByte(uint8_t devReg, uint8_t dataToWrite)
 //
 sfeTkError_t sfeTkArdSPI::writeRegisterWord(uint8_t devReg, uint16_t dataToWrite)
 {
-    return writeRegisterRegion(devReg, (uint8_t *)&dataToWrite, sizeof(uint8_t)) > 0;
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegisterWord);
+
+    return writeRegisterRegionTransfer(devReg, (uint8_t *)&dataToWrite, sizeof(uint16_t));
 }
+#endif
 //---------------------------------------------------------------------------------
 // writeRegisterRegion()
 //
@@ -196,65 +184,62 @@ sfeTkError_t sfeTkArdSPI::writeRegisterWord(uint8_t devReg, uint16_t dataToWrite
 //
 sfeTkError_t sfeTkArdSPI::writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
 {
-    if (!_spiPort)
-        return kSTkErrBusNotInit;
-
-    // Apply settings before work
-    _spiPort->beginTransaction(_sfeSPISettings);
-
-    // Signal communication start
-    digitalWrite(cs(), LOW);
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegisterRegion);
 
-    _spiPort->transfer(devReg);
-
-    for (size_t i = 0; i < length; i++)
-        _spiPort->transfer(*data++);
+    return writeRegisterRegionTransfer(devReg, data, length);
+}
 
-    // End communication
-    digitalWrite(cs(), HIGH);
-    _spiPort->endTransaction();
+//---------------------------------------------------------------------------------
+// writeRegisterRegionTransfer()
+//
+// The transfer of writeRegisterRegion() and writeRegisterWord() - the one port check of each.
+//
+sfeTkError_t sfeTkArdSPI::writeRegisterRegionTransfer(uint8_t devReg, const uint8_t *data, size_t length)
+{
+    if (!_spiPort)
+        return kSTkErrBusNotInit;
 
-    return kSTkErrOk;
+    return writeRegisterRegionUnchecked(devReg, data, length);
 }
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
 // 16 bit address version ...
 sfeTkError_t sfeTkArdSPI::writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookWriteRegister16Region);
+
     if (!_spiPort)
         return kSTkErrBusNotInit;
 
-    // Apply settings before work
-    _spiPort->beginTransaction(_sfeSPISettings);
-
-    // Signal communication start
-    digitalWrite(cs(), LOW);
-    _spiPort->transfer16(devReg);
-
-    for (size_t i = 0; i < length; i++)
-        _spiPort->transfer(*data++);
-
-    // End communication
-    digitalWrite(cs(), HIGH);
-    _spiPort->endTransaction();
-
-    return kSTkErrOk;
+    return writeRegister16RegionUnchecked(devReg, data, length);
 }
+#endif
 
 sfeTkError_t sfeTkArdSPI::readRegisterByte(uint8_t devReg, uint8_t &data)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookReadRegisterByte);
+
     size_t nRead;
-    sfeTkError_t retval = readRegisterRegion(devReg, (uint8_t *)&data, sizeof(uint8_t), nRead);
+    sfeTkError_t retval = readRegisterRegionTransfer(devReg, (uint8_t *)&data, sizeof(uint8_t), nRead);
 
     return (retval == kSTkErrOk && nRead == sizeof(uint8_t) ? kSTkErrOk : retval);
 }
 
+#if SFE_TK_ENABLE_WORD_OPS
 sfeTkError_t sfeTkArdSPI::readRegisterWord(uint8_t devReg, uint16_t &data)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookReadRegisterWord);
+
     size_t nRead;
-    sfeTkError_t retval = readRegisterRegion(devReg, (uint8_t *)&data, sizeof(uint16_t), nRead);
+    sfeTkError_t retval = readRegisterRegionTransfer(devReg, (uint8_t *)&data, sizeof(uint16_t), nRead);
 
     return (retval == kSTkErrOk && nRead == sizeof(uint16_t) ? kSTkErrOk : retval);
 }
+#endif
 //---------------------------------------------------------------------------------
 // readRegisterRegion()
 //
@@ -264,30 +249,27 @@ sfeTkError_t sfeTkArdSPI::readRegisterWord(uint8_t devReg, uint16_t &data)
 //
 sfeTkError_t sfeTkArdSPI::readRegisterRegion(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
 {
-    if (!_spiPort)
-        return kSTkErrBusNotInit;
-
-    // Apply settings
-    _spiPort->beginTransaction(_sfeSPISettings);
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookReadRegisterRegion);
 
-    // Signal communication start
-    digitalWrite(cs(), LOW);
-
-    // A leading "1" must be added to transfer with devRegister to indicate a "read"
-    _spiPort->transfer(devReg | kSPIReadBit);
-
-    for (size_t i = 0; i < numBytes; i++)
-        *data++ = _spiPort->transfer(0x00);
-
-    // End transaction
-    digitalWrite(cs(), HIGH);
-    _spiPort->endTransaction();
+    return readRegisterRegionTransfer(devReg, data, numBytes, readBytes);
+}
 
-    readBytes = numBytes;
+//---------------------------------------------------------------------------------
+// readRegisterRegionTransfer()
+//
+// The transfer of readRegisterRegion(), readRegisterByte() and readRegisterWord() - the one port check of each.
+//
+sfeTkError_t sfeTkArdSPI::readRegisterRegionTransfer(uint8_t devReg, uint8_t *data, size_t numBytes,
+                                                     size_t &readBytes)
+{
+    if (!_spiPort)
+        return kSTkErrBusNotInit;
 
-    return kSTkErrOk;
+    return readRegisterRegionUnchecked(devReg, data, numBytes, readBytes);
 }
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
 //---------------------------------------------------------------------------------
 // readRegister16Region()
 //
@@ -297,26 +279,170 @@ sfeTkError_t sfeTkArdSPI::readRegisterRegion(uint8_t devReg, uint8_t *data, size
 //
 sfeTkError_t sfeTkArdSPI::readRegister16Region(uint16_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
 {
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookReadRegister16Region);
+
     if (!_spiPort)
         return kSTkErrBusNotInit;
 
-    // Apply settings
-    _spiPort->beginTransaction(_sfeSPISettings);
+    return readRegister16RegionUnchecked(devReg, data, numBytes, readBytes);
+}
+#endif
 
-    // Signal communication start
-    digitalWrite(cs(), LOW);
+#if SFE_TK_ENABLE_TRANSACTIONS
+//---------------------------------------------------------------------------------
+// executeSteps()
+//
+// Runs the steps of a transaction in one SPI transaction - the settings are applied once, and each step is
+// framed by the chip select.
+//
+sfeTkError_t sfeTkArdSPI::executeSteps(const sfeTkTxnStep *steps, size_t nSteps)
+{
+    SFE_TK_HOT_PATH();
+    SFE_TK_PROFILE_OP(kSTkBusHookTransaction);
 
-    // A leading "1" must be added to transfer with devRegister to indicate a "read"
-    _spiPort->transfer16(devReg | kSPIReadBit);
+    if (!_spiPort)
+        return kSTkErrBusNotInit;
 
-    for (size_t i = 0; i < numBytes; i++)
-        *data++ = _spiPort->transfer(0x00);
+    // Check the steps before any work, so a bad step doesn't leave a partial transaction
+    for (size_t i = 0; i < nSteps; i++)
+    {
+        if (steps[i].nValue == 0 && steps[i].length > 0 && !steps[i].data)
+            return kSTkErrBusNullBuffer;
+    }
+
+    // Apply settings
+    _spiPort->beginTransaction(_sfeSPISettings);
+
+    sfeTkError_t retval = kSTkErrOk;
+    for (size_t i = 0; i < nSteps && retval == kSTkErrOk; i++)
+    {
+        uint8_t value[2];
+        size_t length;
+        const uint8_t *data = sfeTkTxnStepData(steps[i], value, length);
+
+        // Signal communication start
+        digitalWrite(cs(), LOW);
+        SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+
+        // The register - a leading "1" must be added to transfer with devRegister to indicate a "read"
+        bool bRead = false;
+        switch (steps[i].op)
+        {
+        case kSTkBusOpWriteRegion:
+            break;
+
+        case kSTkBusOpWriteRegisterRegion:
+            _spiPort->transfer((uint8_t)steps[i].reg);
+            break;
+
+        case kSTkBusOpReadRegisterRegion:
+            _spiPort->transfer((uint8_t)steps[i].reg | kSPIReadBit);
+            bRead = true;
+            break;
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+        case kSTkBusOpWriteRegister16Region:
+            _spiPort->transfer16(steps[i].reg);
+            break;
+
+        case kSTkBusOpReadRegister16Region:
+            _spiPort->transfer16(steps[i].reg | kSPIReadBit);
+            bRead = true;
+            break;
+#endif
+        default: // a compiled out operation
+            SFE_TK_LOG_ERROR("transaction step %u: operation %u is compiled out", i, steps[i].op);
+            retval = kSTkErrFail;
+            length = 0;
+            break;
+        }
+        SFE_TK_PROFILE_PHASE(kSTkProfileAddress);
+
+        if (bRead)
+        {
+            // Clock out zeros, reading the whole block in one call
+            memset(steps[i].data, 0, length);
+            SFE_TK_PROFILE_PHASE(kSTkProfileCopy);
+            _spiPort->transfer(steps[i].data, length);
+        }
+        else
+        {
+            for (size_t n = 0; n < length; n++)
+                _spiPort->transfer(*data++);
+        }
+        SFE_TK_PROFILE_CHUNK();
+
+        // End communication
+        digitalWrite(cs(), HIGH);
+    }
 
     // End transaction
-    digitalWrite(cs(), HIGH);
     _spiPort->endTransaction();
 
-    readBytes = numBytes;
+    return retval;
+}
+#endif
 
-    return kSTkErrOk;
+#if SFE_TK_ENABLE_ASYNC
+//---------------------------------------------------------------------------------
+// startAsync()
+//
+// Hands a request to the asynchronous transfer backend - or the CPU fallback if none is set.
+// The request's callback and context are left as set by the caller.
+//
+sfeTkError_t sfeTkArdSPI::startAsync(sfeTkBusOp_t op, uint16_t devReg, uint8_t *data, size_t numBytes,
+                                     sfeTkBusRequest &request)
+{
+    SFE_TK_HOT_PATH();
+
+    if (!_spiPort)
+        return kSTkErrBusNotInit;
+
+    if (!data)
+        return kSTkErrBusNullBuffer;
+
+    request.op = op;
+    request.reg = devReg;
+    request.data = data;
+    request.length = numBytes;
+    request.transferred = 0;
+
+    if (!_asyncTransfer)
+    {
+        sfeTkCpuTransfer cpuTransfer;
+        return cpuTransfer.start(*this, request);
+    }
+    return _asyncTransfer->start(*this, request);
+}
+#endif
+
+#if SFE_TK_ENABLE_ASYNC
+//---------------------------------------------------------------------------------
+// readRegisterRegionAsync()
+//
+// Reads an array of bytes from a given register, using the async transfer backend
+//
+sfeTkError_t sfeTkArdSPI::readRegisterRegionAsync(uint8_t devReg, uint8_t *data, size_t numBytes,
+                                                  sfeTkBusRequest &request)
+{
+    SFE_TK_HOT_PATH();
+
+    return startAsync(kSTkBusOpReadRegisterRegion, devReg, data, numBytes, request);
+}
+#endif
+
+#if SFE_TK_ENABLE_ASYNC && SFE_TK_ENABLE_16BIT_REGISTERS
+//---------------------------------------------------------------------------------
+// readRegister16RegionAsync()
+//
+// Reads an array of bytes from a given 16-bit register, using the async transfer backend
+//
+sfeTkError_t sfeTkArdSPI::readRegister16RegionAsync(uint16_t devReg, uint8_t *data, size_t numBytes,
+                                                    sfeTkBusRequest &request)
+{
+    SFE_TK_HOT_PATH();
+
+    return startAsync(kSTkBusOpReadRegister16Region, devReg, data, numBytes, request);
 }
+#endif
@@ -28,7 +28,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include <SPI.h>
+#include <sfeTk/sfeTkHotPath.h>
+#include <sfeTk/sfeTkIAsyncTransfer.h>
 #include <sfeTk/sfeTkISPI.h>
+#include <sfeTk/sfeTkLog.h>
+#include <sfeTk/sfeTkProfiler.h>
+
+class sfeTkArdSPIChecked;
 
 /**
   @brief This class implements the IBus interface for an SPI Implementation on Arduino
@@ -48,7 +54,7 @@ class sfeTkArdSPI : public sfeTkISPI
 
         @param csPin The CS Pin for the device
     */
-    sfeTkArdSPI(uint8_t csPin) : sfeTkISPI(csPin)
+    sfeTkArdSPI(uint8_t csPin) : sfeTkISPI(csPin), _spiPort{nullptr}
     {
     }
     /**
@@ -56,8 +62,12 @@ class sfeTkArdSPI : public sfeTkISPI
 
         @param rhs source of the copy operation
     */
-    sfeTkArdSPI(sfeTkArdSPI const &rhs) : sfeTkISPI(), _spiPort{rhs._spiPort}, _sfeSPISettings{rhs._sfeSPISettings}
+    sfeTkArdSPI(sfeTkArdSPI const &rhs)
+        : sfeTkISPI(rhs), _spiPort{rhs._spiPort}, _sfeSPISettings{rhs._sfeSPISettings}
     {
+#if SFE_TK_ENABLE_ASYNC
+        _asyncTransfer = rhs._asyncTransfer;
+#endif
     }
 
     /**
@@ -68,8 +78,12 @@ class sfeTkArdSPI : public sfeTkISPI
     */
     sfeTkArdSPI &operator=(const sfeTkArdSPI &rhs)
     {
+        sfeTkISPI::operator=(rhs);
         _spiPort = rhs._spiPort;
         _sfeSPISettings = rhs._sfeSPISettings;
+#if SFE_TK_ENABLE_ASYNC
+        _asyncTransfer = rhs._asyncTransfer;
+#endif
         return *this;
     }
 
@@ -115,6 +129,7 @@ class sfeTkArdSPI : public sfeTkISPI
     */
     sfeTkError_t writeByte(uint8_t data);
 
+#if SFE_TK_ENABLE_WORD_OPS
     /**
         @brief Write a word to the device without indexing to a register.
 
@@ -123,6 +138,7 @@ class sfeTkArdSPI : public sfeTkISPI
         @retval sfeTkError_t - kSTkErrOk on success
     */
     sfeTkError_t writeWord(uint16_t data);
+#endif
 
     /**
         @brief Write an array of data to the device without indexing to a register.
@@ -144,6 +160,7 @@ class sfeTkArdSPI : public sfeTkISPI
     */
     sfeTkError_t writeRegisterByte(uint8_t devReg, uint8_t data);
 
+#if SFE_TK_ENABLE_WORD_OPS
     /**
         @brief Write a single word to the given register
 
@@ -153,6 +170,7 @@ class sfeTkArdSPI : public sfeTkISPI
         @retval sfeTkError_t - kSTkErrOk on success
     */
     sfeTkError_t writeRegisterWord(uint8_t devReg, uint16_t data);
+#endif
 
     /**
         @brief Writes a number of bytes starting at the given register's address.
@@ -166,6 +184,7 @@ class sfeTkArdSPI : public sfeTkISPI
     */
     sfeTkError_t writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length);
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
     /**
         @brief Writes a number of bytes starting at the given register's address.
         @note This method is virtual to allow it to be overridden to support a device that requires a unique impl
@@ -177,6 +196,7 @@ class sfeTkArdSPI : public sfeTkISPI
         @retval sfeTkError_t - kSTkErrOk on success
     */
     sfeTkError_t writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length);
+#endif
 
     /**
         @brief Read a single byte from the given register
@@ -188,6 +208,7 @@ class sfeTkArdSPI : public sfeTkISPI
     */
     sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data);
 
+#if SFE_TK_ENABLE_WORD_OPS
     /**
         @brief read a single word to the given register
 
@@ -197,6 +218,7 @@ class sfeTkArdSPI : public sfeTkISPI
         @retval sfeTkError_t - true on success
     */
     sfeTkError_t readRegisterWord(uint8_t devReg, uint16_t &data);
+#endif
 
     /**
         @brief Reads a block of data from the given register.
@@ -211,6 +233,7 @@ class sfeTkArdSPI : public sfeTkISPI
     */
     virtual sfeTkError_t readRegisterRegion(uint8_t reg, uint8_t *data, size_t numBytes, size_t &readBytes);
 
+#if SFE_TK_ENABLE_16BIT_REGISTERS
     /**
         @brief Reads a block of data from the given register.
         @note This method is virtual to allow it to be overridden to support a device that requires a unique impl
@@ -223,6 +246,113 @@ class sfeTkArdSPI : public sfeTkISPI
         @retval sfeTkError_t - true on success
     */
     virtual sfeTkError_t readRegister16Region(uint16_t reg, uint8_t *data, size_t numBytes, size_t &readBytes);
+#endif
+
+#if SFE_TK_ENABLE_TRANSACTIONS
+    /**
+        @brief Runs the steps of a transaction as one SPI transaction - the settings are applied once, and each
+               step is framed by the chip select. See sfeTk/sfeTkTransaction.h
+        @note sfeTkIBus interface method
+
+        @param steps The steps
+        @param nSteps The number of steps
+
+        @retval kSTkErrOk if every step succeeded, else the result of the step that failed
+    */
+    sfeTkError_t executeSteps(const sfeTkTxnStep *steps, size_t nSteps);
+#endif
+
+    // Value returning reads - see sfeTk/sfeTkResult.h. These are the sfeTkIBus versions: they call the read methods
+    // through the vtable, so a subclass that overrides a read method is used by the value form too.
+    using sfeTkIBus::readRegisterByte;
+#if SFE_TK_ENABLE_WORD_OPS
+    using sfeTkIBus::readRegisterWord;
+#endif
+    using sfeTkIBus::readRegisterRegion;
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    using sfeTkIBus::readRegister16Region;
+#endif
+
+#if SFE_TK_ENABLE_ASYNC
+    /**
+        @brief Reads a block of data from the given register, using the asynchronous transfer backend.
+
+        @note With no backend set, the CPU fallback is used and the request is complete on return.
+        @note The request's callback and context are kept - set them before calling.
+
+        @param devReg The device's register's address.
+        @param[out] data Data buffer to read into
+        @param numBytes Number of bytes to read/length of data buffer
+        @param request The request used to track the transfer. Must remain valid until done.
+
+        @retval kSTkErrOk if the transfer was started
+    */
+    sfeTkError_t readRegisterRegionAsync(uint8_t devReg, uint8_t *data, size_t numBytes, sfeTkBusRequest &request);
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**
+        @brief Reads a block of data from the given 16-bit register address, using the asynchronous transfer backend.
+
+        @param devReg The device's 16 bit register's address.
+        @param[out] data Data buffer to read into
+        @param numBytes Number of bytes to read/length of data buffer
+        @param request The request used to track the transfer. Must remain valid until done.
+
+        @retval kSTkErrOk if the transfer was started
+    */
+    sfeTkError_t readRegister16RegionAsync(uint16_t devReg, uint8_t *data, size_t numBytes, sfeTkBusRequest &request);
+#endif
+
+    /**
+        @brief Set the asynchronous transfer backend (DMA) used by the Async methods.
+
+        @param theBackend The backend - nullptr selects the CPU fallback
+    */
+    void setAsyncTransfer(sfeTkIAsyncTransfer *theBackend)
+    {
+        _asyncTransfer = theBackend;
+    }
+
+    /**
+        @brief The asynchronous transfer backend
+
+        @retval The backend, nullptr if the CPU fallback is used
+    */
+    sfeTkIAsyncTransfer *asyncTransfer(void)
+    {
+        return _asyncTransfer;
+    }
+#endif
+
+    /**
+        @brief The Arduino SPI port - for use by asynchronous transfer backends
+
+        @retval The port, nullptr if not initialized
+    */
+    SPIClass *port(void)
+    {
+        return _spiPort;
+    }
+
+    /**
+        @brief The SPI settings used for every transaction - for use by asynchronous transfer backends
+
+        @retval The settings
+    */
+    const SPISettings &settings(void)
+    {
+        return _sfeSPISettings;
+    }
+
+    /**
+        @brief A checked handle to this bus - its operations skip the port check made by each method of this class.
+
+        @note Call after a successful init(). The handle refers to this object, and stays valid while this
+              object exists and its port is not changed.
+
+        @retval sfeTkResult<sfeTkArdSPIChecked> The handle, or kSTkErrBusNotInit if the bus is not initialized
+    */
+    sfeTkResult<sfeTkArdSPIChecked> checked(void);
 
   protected:
     // note: The instance data is protected, allowing access if a sub-class is
@@ -233,4 +363,480 @@ class sfeTkArdSPI : public sfeTkISPI
 
     /** This objects spi settings are used for every transaction. */
     SPISettings _sfeSPISettings;
+
+#if SFE_TK_ENABLE_ASYNC
+    /** The asynchronous transfer backend - nullptr for the CPU fallback */
+    sfeTkIAsyncTransfer *_asyncTransfer = nullptr;
+#endif
+
+  private:
+    friend class sfeTkArdSPIChecked;
+
+    // Note: A leading "1" must be added to transfer with register to indicate a "read"
+    // Note to our future selves:
+    //   This works / is required on both the ISM330 and MMC5983,
+    //   but will cause badness with other SPI devices.
+    //   We may need to add an alternate method if we ever add another SPI device.
+    static constexpr uint8_t kSPIReadBit = 0x80;
+
+    // The operations without the port check - used once the port is checked, and by sfeTkArdSPIChecked
+    inline sfeTkError_t writeByteUnchecked(uint8_t data);
+
+    inline sfeTkError_t writeRegionUnchecked(const uint8_t *data, size_t length);
+
+    inline sfeTkError_t writeRegisterByteUnchecked(uint8_t devReg, uint8_t data);
+
+    inline sfeTkError_t writeRegisterRegionUnchecked(uint8_t devReg, const uint8_t *data, size_t length);
+
+    inline sfeTkError_t readRegisterRegionUnchecked(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes);
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    inline sfeTkError_t writeRegister16RegionUnchecked(uint16_t devReg, const uint8_t *data, size_t length);
+
+    inline sfeTkError_t readRegister16RegionUnchecked(uint16_t devReg, uint8_t *data, size_t numBytes,
+                                                      size_t &readBytes);
+#endif
+
+    // The transfers the region, word and byte methods share - these check the port
+    sfeTkError_t writeRegionTransfer(const uint8_t *data, size_t length);
+
+    sfeTkError_t writeRegisterRegionTransfer(uint8_t devReg, const uint8_t *data, size_t length);
+
+    sfeTkError_t readRegisterRegionTransfer(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes);
+
+#if SFE_TK_ENABLE_ASYNC
+    sfeTkError_t startAsync(sfeTkBusOp_t op, uint16_t devReg, uint8_t *data, size_t numBytes,
+                            sfeTkBusRequest &request);
+#endif
+};
+
+// The transfers without the port check - used by sfeTkArdSPIChecked, and by the bus method or shared transfer
+// that checks the port for each. Inline, so without the handles each folds into that caller and adds no function.
+
+//---------------------------------------------------------------------------------
+// writeByteUnchecked()
+//
+// writeByte() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdSPI::writeByteUnchecked(uint8_t dataToWrite)
+{
+    SFE_TK_HOT_PATH();
+
+    // Apply settings
+    _spiPort->beginTransaction(_sfeSPISettings);
+    // Signal communication start
+    digitalWrite(cs(), LOW);
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+
+    _spiPort->transfer(dataToWrite);
+    SFE_TK_PROFILE_CHUNK();
+
+    // End communication
+    digitalWrite(cs(), HIGH);
+    _spiPort->endTransaction();
+
+    return kSTkErrOk;
+}
+
+//---------------------------------------------------------------------------------
+// writeRegionUnchecked()
+//
+// writeRegion() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdSPI::writeRegionUnchecked(const uint8_t *dataToWrite, size_t length)
+{
+    SFE_TK_HOT_PATH();
+
+    _spiPort->beginTransaction(_sfeSPISettings);
+    // Signal communication start
+    digitalWrite(cs(), LOW);
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+
+    for (size_t i = 0; i < length; i++)
+        _spiPort->transfer(*dataToWrite++);
+    SFE_TK_PROFILE_CHUNK();
+
+    // End communication
+    digitalWrite(cs(), HIGH);
+    _spiPort->endTransaction();
+
+    return kSTkErrOk;
+}
+
+//---------------------------------------------------------------------------------
+// writeRegisterByteUnchecked()
+//
+// writeRegisterByte() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdSPI::writeRegisterByteUnchecked(uint8_t devReg, uint8_t dataToWrite)
+{
+    SFE_TK_HOT_PATH();
+
+    // Apply settings
+    _spiPort->beginTransaction(_sfeSPISettings);
+    // Signal communication start
+    digitalWrite(cs(), LOW);
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+
+    _spiPort->transfer(devReg);
+    SFE_TK_PROFILE_PHASE(kSTkProfileAddress);
+    _spiPort->transfer(dataToWrite);
+    SFE_TK_PROFILE_CHUNK();
+
+    // End communication
+    digitalWrite(cs(), HIGH);
+    _spiPort->endTransaction();
+
+    return kSTkErrOk;
+}
+
+//---------------------------------------------------------------------------------
+// writeRegisterRegionUnchecked()
+//
+// writeRegisterRegion() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdSPI::writeRegisterRegionUnchecked(uint8_t devReg, const uint8_t *data, size_t length)
+{
+    SFE_TK_HOT_PATH();
+
+    // Apply settings before work
+    _spiPort->beginTransaction(_sfeSPISettings);
+
+    // Signal communication start
+    digitalWrite(cs(), LOW);
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+
+    _spiPort->transfer(devReg);
+    SFE_TK_PROFILE_PHASE(kSTkProfileAddress);
+
+    for (size_t i = 0; i < length; i++)
+        _spiPort->transfer(*data++);
+    SFE_TK_PROFILE_CHUNK();
+
+    // End communication
+    digitalWrite(cs(), HIGH);
+    _spiPort->endTransaction();
+
+    return kSTkErrOk;
+}
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+//---------------------------------------------------------------------------------
+// writeRegister16RegionUnchecked()
+//
+// writeRegister16Region() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdSPI::writeRegister16RegionUnchecked(uint16_t devReg, const uint8_t *data,
+                                                                size_t length)
+{
+    SFE_TK_HOT_PATH();
+
+    // Apply settings before work
+    _spiPort->beginTransaction(_sfeSPISettings);
+
+    // Signal communication start
+    digitalWrite(cs(), LOW);
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+    _spiPort->transfer16(devReg);
+    SFE_TK_PROFILE_PHASE(kSTkProfileAddress);
+
+    for (size_t i = 0; i < length; i++)
+        _spiPort->transfer(*data++);
+    SFE_TK_PROFILE_CHUNK();
+
+    // End communication
+    digitalWrite(cs(), HIGH);
+    _spiPort->endTransaction();
+
+    return kSTkErrOk;
+}
+#endif
+
+//---------------------------------------------------------------------------------
+// readRegisterRegionUnchecked()
+//
+// readRegisterRegion() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdSPI::readRegisterRegionUnchecked(uint8_t devReg, uint8_t *data, size_t numBytes,
+                                                             size_t &readBytes)
+{
+    SFE_TK_HOT_PATH();
+
+    // Apply settings
+    _spiPort->beginTransaction(_sfeSPISettings);
+
+    // Signal communication start
+    digitalWrite(cs(), LOW);
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+
+    // A leading "1" must be added to transfer with devRegister to indicate a "read"
+    _spiPort->transfer(devReg | kSPIReadBit);
+    SFE_TK_PROFILE_PHASE(kSTkProfileAddress);
+
+    // Clock out zeros, reading the whole block in one call - the core can use its FIFO/DMA support
+    memset(data, 0, numBytes);
+    SFE_TK_PROFILE_PHASE(kSTkProfileCopy);
+    _spiPort->transfer(data, numBytes);
+    SFE_TK_PROFILE_CHUNK();
+
+    // End transaction
+    digitalWrite(cs(), HIGH);
+    _spiPort->endTransaction();
+
+    readBytes = numBytes;
+
+    return kSTkErrOk;
+}
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+//---------------------------------------------------------------------------------
+// readRegister16RegionUnchecked()
+//
+// readRegister16Region() without the port check - the caller has checked the port.
+//
+inline sfeTkError_t sfeTkArdSPI::readRegister16RegionUnchecked(uint16_t devReg, uint8_t *data, size_t numBytes,
+                                                               size_t &readBytes)
+{
+    SFE_TK_HOT_PATH();
+
+    // Apply settings
+    _spiPort->beginTransaction(_sfeSPISettings);
+
+    // Signal communication start
+    digitalWrite(cs(), LOW);
+    SFE_TK_PROFILE_PHASE(kSTkProfileSetup);
+
+    // A leading "1" must be added to transfer with devRegister to indicate a "read"
+    _spiPort->transfer16(devReg | kSPIReadBit);
+    SFE_TK_PROFILE_PHASE(kSTkProfileAddress);
+
+    // Clock out zeros, reading the whole block in one call - the core can use its FIFO/DMA support
+    memset(data, 0, numBytes);
+    SFE_TK_PROFILE_PHASE(kSTkProfileCopy);
+    _spiPort->transfer(data, numBytes);
+    SFE_TK_PROFILE_CHUNK();
+
+    // End transaction
+    digitalWrite(cs(), HIGH);
+    _spiPort->endTransaction();
+
+    readBytes = numBytes;
+
+    return kSTkErrOk;
+}
+#endif
+
+/**
+ * @brief A checked handle to an initialized sfeTkArdSPI bus.
+ *
+ * Each sfeTkArdSPI method checks the bus is initialized before any work. A handle is only returned by
+ * sfeTkArdSPI::checked() once the bus is initialized, so its operations skip the check and go straight to the
+ * transfer. Results are the same as the sfeTkArdSPI methods.
+ *
+ * @code
+ *     sfeTkResult<sfeTkArdSPIChecked> bus = mySPI.checked();
+ *     if (!bus)
+ *         return bus.error();
+ *     sfeTkArdSPIChecked theBus = bus.value();
+ *     theBus.readRegisterByte(kRegStatus, status);
+ * @endcode
+ *
+ * The handle is a pointer to the bus - copy it freely. Use the value of a successful result only.
+ */
+class sfeTkArdSPIChecked
+{
+  public:
+    /**
+        @brief Sends a single byte to the device
+
+        @param data Data to write.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeByte(uint8_t data)
+    {
+        return _bus->writeByteUnchecked(data);
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**
+        @brief Sends a word to the device.
+
+        @param data Data to write.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeWord(uint16_t data)
+    {
+        return _bus->writeRegionUnchecked((uint8_t *)&data, sizeof(uint16_t));
+    }
+#endif
+
+    /**
+        @brief Sends a block of data to the device.
+
+        @param data Data to write.
+        @param length Length of the data.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegion(const uint8_t *data, size_t length)
+    {
+        return _bus->writeRegionUnchecked(data, length);
+    }
+
+    /**
+        @brief Write a single byte to the given register
+
+        @param devReg The device's register's address.
+        @param data Data to write.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegisterByte(uint8_t devReg, uint8_t data)
+    {
+        return _bus->writeRegisterByteUnchecked(devReg, data);
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**
+        @brief Write a single word (two bytes) to the given register
+
+        @param devReg The device's register's address.
+        @param data Data to write.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegisterWord(uint8_t devReg, uint16_t data)
+    {
+        return _bus->writeRegisterRegionUnchecked(devReg, (uint8_t *)&data, sizeof(uint16_t));
+    }
+#endif
+
+    /**
+        @brief Writes a number of bytes starting at the given register's address.
+
+        @param devReg The device's register's address.
+        @param data Data to write.
+        @param length Length of the data.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
+    {
+        return _bus->writeRegisterRegionUnchecked(devReg, data, length);
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**
+        @brief Writes a number of bytes starting at the given 16-bit register's address.
+
+        @param devReg The device's 16 bit register's address.
+        @param data Data to write.
+        @param length Length of the data.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
+    {
+        return _bus->writeRegister16RegionUnchecked(devReg, data, length);
+    }
+#endif
+
+    /**
+        @brief Reads a byte of data from the given register.
+
+        @param devReg The device's register's address.
+        @param[out] data Data buffer to read into
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data)
+    {
+        size_t nRead;
+        sfeTkError_t retval = _bus->readRegisterRegionUnchecked(devReg, (uint8_t *)&data, sizeof(uint8_t), nRead);
+        return (retval == kSTkErrOk && nRead == sizeof(uint8_t) ? kSTkErrOk : retval);
+    }
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**
+        @brief Reads a word of data from the given register.
+
+        @param devReg The device's register's address.
+        @param[out] data Data buffer to read into
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegisterWord(uint8_t devReg, uint16_t &data)
+    {
+        size_t nRead;
+        sfeTkError_t retval = _bus->readRegisterRegionUnchecked(devReg, (uint8_t *)&data, sizeof(uint16_t), nRead);
+        return (retval == kSTkErrOk && nRead == sizeof(uint16_t) ? kSTkErrOk : retval);
+    }
+#endif
+
+    /**
+        @brief Reads a block of data from the given register.
+
+        @param devReg The device's register's address.
+        @param[out] data Data buffer to read into
+        @param numBytes Number of bytes to read/length of data buffer
+        @param[out] readBytes Number of bytes read
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegisterRegion(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        return _bus->readRegisterRegionUnchecked(devReg, data, numBytes, readBytes);
+    }
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**
+        @brief Reads a block of data from the given 16-bit register address.
+
+        @param devReg The device's 16 bit register's address.
+        @param[out] data Data buffer to read into
+        @param numBytes Number of bytes to read/length of data buffer
+        @param[out] readBytes Number of bytes read
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegister16Region(uint16_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        return _bus->readRegister16RegionUnchecked(devReg, data, numBytes, readBytes);
+    }
+#endif
+
+    /**
+        @brief The bus of this handle
+
+        @retval The bus
+    */
+    sfeTkArdSPI &bus(void)
+    {
+        return *_bus;
+    }
+
+  private:
+    friend class sfeTkArdSPI;
+    template <typename> friend class sfeTkResult;
+
+    // Handles are made by sfeTkArdSPI::checked() - the default handle is the value of a failed result
+    sfeTkArdSPIChecked(void) : _bus{nullptr}
+    {
+    }
+
+    explicit sfeTkArdSPIChecked(sfeTkArdSPI *theBus) : _bus{theBus}
+    {
+    }
+
+    sfeTkArdSPI *_bus;
 };
+
+inline sfeTkResult<sfeTkArdSPIChecked> sfeTkArdSPI::checked(void)
+{
+    if (!_spiPort)
+        return sfeTkResult<sfeTkArdSPIChecked>::failure(kSTkErrBusNotInit);
+
+    return sfeTkResult<sfeTkArdSPIChecked>(sfeTkArdSPIChecked(this));
+}
@@ -0,0 +1,120 @@
+/*
+sfeTkArdSPIPort.cpp
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "sfeTkArdSPIPort.h"
+
+//---------------------------------------------------------------------------------
+// init()
+//
+// Set the Arduino port and settings of the context. The CS pin is set per transaction by the device handles.
+//
+sfeTkError_t sfeTkArdSPIPort::init(SPIClass &spiPort, SPISettings &busSPISettings, bool bInit)
+{
+    return _bus.init(spiPort, busSPISettings, sfeTkISPI::kNoCSPin, bInit);
+}
+
+//---------------------------------------------------------------------------------
+// init()
+//
+// The default port and settings - the same defaults as sfeTkArdSPI
+//
+sfeTkError_t sfeTkArdSPIPort::init(bool bInit)
+{
+    return _bus.init(sfeTkISPI::kNoCSPin, bInit);
+}
+
+//---------------------------------------------------------------------------------
+// Device handle methods - each runs the sfeTkArdSPI method on the port, for this device
+//---------------------------------------------------------------------------------
+
+sfeTkError_t sfeTkArdSPIDevice::writeByte(uint8_t data)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.writeByte(data); });
+}
+
+#if SFE_TK_ENABLE_WORD_OPS
+sfeTkError_t sfeTkArdSPIDevice::writeWord(uint16_t data)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.writeWord(data); });
+}
+#endif
+
+sfeTkError_t sfeTkArdSPIDevice::writeRegion(const uint8_t *data, size_t length)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.writeRegion(data, length); });
+}
+
+sfeTkError_t sfeTkArdSPIDevice::writeRegisterByte(uint8_t devReg, uint8_t data)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.writeRegisterByte(devReg, data); });
+}
+
+#if SFE_TK_ENABLE_WORD_OPS
+sfeTkError_t sfeTkArdSPIDevice::writeRegisterWord(uint8_t devReg, uint16_t data)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.writeRegisterWord(devReg, data); });
+}
+#endif
+
+sfeTkError_t sfeTkArdSPIDevice::writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.writeRegisterRegion(devReg, data, length); });
+}
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+sfeTkError_t sfeTkArdSPIDevice::writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.writeRegister16Region(devReg, data, length); });
+}
+#endif
+
+sfeTkError_t sfeTkArdSPIDevice::readRegisterByte(uint8_t devReg, uint8_t &data)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.readRegisterByte(devReg, data); });
+}
+
+#if SFE_TK_ENABLE_WORD_OPS
+sfeTkError_t sfeTkArdSPIDevice::readRegisterWord(uint8_t devReg, uint16_t &data)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.readRegisterWord(devReg, data); });
+}
+#endif
+
+sfeTkError_t sfeTkArdSPIDevice::readRegisterRegion(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.readRegisterRegion(devReg, data, numBytes, readBytes); });
+}
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+sfeTkError_t sfeTkArdSPIDevice::readRegister16Region(uint16_t devReg, uint8_t *data, size_t numBytes,
+                                                     size_t &readBytes)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.readRegister16Region(devReg, data, numBytes, readBytes); });
+}
+#endif
+
+#if SFE_TK_ENABLE_TRANSACTIONS
+sfeTkError_t sfeTkArdSPIDevice::executeSteps(const sfeTkTxnStep *steps, size_t nSteps)
+{
+    return transact([&](sfeTkArdSPI &bus) { return bus.executeSteps(steps, nSteps); });
+}
+#endif
@@ -0,0 +1,401 @@
+/*
+sfeTkArdSPIPort.h
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+The following classes share one Arduino SPI port between many devices - a port
+context per physical bus, and a small handle per device.
+
+*/
+
+#pragma once
+
+#include "sfeTkArdSPI.h"
+#include <sfeTk/sfeTkILock.h>
+
+/**
+ * @brief The shared context of one physical SPI bus - the Arduino port, the transaction settings, lock and
+ *        statistics.
+ *
+ * Devices on the bus use a sfeTkArdSPIDevice handle, which holds the device CS pin and a pointer to the port
+ * context. Every transaction runs under the port lock, when one is set. Devices that need different settings
+ * (mode, clock) use their own port context on the same Arduino port.
+ */
+class sfeTkArdSPIPort
+{
+  public:
+    /**
+        @brief Constructor
+    */
+    sfeTkArdSPIPort(void) : _lock{nullptr}, _nTransactions{0}, _nErrors{0}
+    {
+    }
+
+    // The port context is shared by its device handles - it is not copied
+    sfeTkArdSPIPort(const sfeTkArdSPIPort &) = delete;
+    sfeTkArdSPIPort &operator=(const sfeTkArdSPIPort &) = delete;
+
+    /**
+        @brief Set up the port context
+
+        @param spiPort Port for SPI communication.
+        @param busSPISettings Settings for speed, endianness, and spi mode of the SPI bus.
+        @param bInit Call begin() on the port
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t init(SPIClass &spiPort, SPISettings &busSPISettings, bool bInit = false);
+
+    /**
+        @brief Set up the port context on the default SPI port, with the default settings
+
+        @param bInit Call begin() on the port
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t init(bool bInit = false);
+
+    /**
+        @brief The SPI settings used for each transaction
+
+        @retval The settings
+    */
+    const SPISettings &settings(void)
+    {
+        return _bus.settings();
+    }
+
+    /**
+        @brief Set the lock taken around each transaction - needed when devices on the bus are used from more
+               than one task.
+
+        @param theLock The lock, nullptr for none
+    */
+    void setLock(sfeTkILock *theLock)
+    {
+        _lock = theLock;
+    }
+
+    /**
+        @brief The Arduino SPI port
+
+        @retval The port, nullptr if not initialized
+    */
+    SPIClass *port(void)
+    {
+        return _bus.port();
+    }
+
+    /**
+        @brief The number of transactions run on the port
+    */
+    uint32_t nTransactions(void) const
+    {
+        return _nTransactions;
+    }
+
+    /**
+        @brief The number of transactions that returned an error
+    */
+    uint32_t nErrors(void) const
+    {
+        return _nErrors;
+    }
+
+    /**
+        @brief Reset the transaction statistics
+    */
+    void resetStats(void)
+    {
+        _nTransactions = 0;
+        _nErrors = 0;
+    }
+
+    /**
+        @brief Run an operation on the bus for a device, under the port lock
+
+        @param csPin The CS pin of the device
+        @param op A callable taking a sfeTkArdSPI& and returning a sfeTkError_t
+
+        @retval The result of the operation
+    */
+    template <typename Op> sfeTkError_t transact(uint8_t csPin, Op op)
+    {
+        sfeTkLockGuard guard(_lock);
+
+        _bus.setCS(csPin);
+
+        sfeTkError_t retval = op(_bus);
+
+        _nTransactions++;
+        if (retval < kSTkErrOk)
+            _nErrors++;
+
+        return retval;
+    }
+
+  private:
+    /** Runs the transactions - the CS pin is set for each device */
+    sfeTkArdSPI _bus;
+
+    sfeTkILock *_lock;
+
+    uint32_t _nTransactions;
+    uint32_t _nErrors;
+};
+
+/**
+ * @brief A per-device handle on a shared SPI port - the device CS pin, and a pointer to the port context.
+ *        Handles are small, and copy and move without losing state.
+ *
+ * The methods match sfeTkIBus, but are not virtual.
+ */
+class sfeTkArdSPIDevice : public sfeTkBusValueReads<sfeTkArdSPIDevice>
+{
+  public:
+    /**
+        @brief Constructor - not attached to a port
+    */
+    sfeTkArdSPIDevice(void) : _port{nullptr}, _cs{sfeTkISPI::kNoCSPin}
+    {
+    }
+
+    /**
+        @brief Constructor
+
+        @param thePort The port context of the bus the device is on
+        @param csPin The CS pin of the device
+    */
+    sfeTkArdSPIDevice(sfeTkArdSPIPort &thePort, uint8_t csPin) : _port{&thePort}, _cs{csPin}
+    {
+    }
+
+    /**
+        @brief Attach the handle to a port
+
+        @param thePort The port context of the bus the device is on
+        @param csPin The CS pin of the device
+    */
+    void init(sfeTkArdSPIPort &thePort, uint8_t csPin)
+    {
+        _port = &thePort;
+        _cs = csPin;
+    }
+
+    /**
+        @brief setter for the CS Pin
+
+        @param devCS The device's CS Pin
+    */
+    void setCS(uint8_t devCS)
+    {
+        _cs = devCS;
+    }
+
+    /**
+        @brief getter for the cs pin
+
+        @retval uint8_t returns the CS pin for the device
+    */
+    uint8_t cs(void) const
+    {
+        return _cs;
+    }
+
+    /**
+        @brief The port context of the handle
+
+        @retval The port, nullptr if not attached
+    */
+    sfeTkArdSPIPort *port(void) const
+    {
+        return _port;
+    }
+
+    /**
+        @brief Sends a single byte to the device
+
+        @param data Data to write.
+
+        @retval returns  kStkErrOk on success
+    */
+    sfeTkError_t writeByte(uint8_t data);
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**
+        @brief Sends a word to the device.
+
+        @param data Data to write.
+
+        @retval returns  kStkErrOk on success
+    */
+    sfeTkError_t writeWord(uint16_t data);
+#endif
+
+    /**
+        @brief Sends a block of data to the device.
+
+        @param data Data to write.
+        @param length - length of data
+
+        @retval returns  kStkErrOk on success
+    */
+    sfeTkError_t writeRegion(const uint8_t *data, size_t length);
+
+    /**
+        @brief Write a single byte to the given register
+
+        @param devReg The device's register's address.
+        @param data Data to write.
+
+        @retval returns  kStkErrOk on success
+    */
+    sfeTkError_t writeRegisterByte(uint8_t devReg, uint8_t data);
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**
+        @brief Write a single word to the given register
+
+        @param devReg The device's register's address.
+        @param data Data to write.
+
+        @retval returns  kStkErrOk on success
+    */
+    sfeTkError_t writeRegisterWord(uint8_t devReg, uint16_t data);
+#endif
+
+    /**
+        @brief Writes a number of bytes starting at the given register's address.
+
+        @param devReg The device's register's address.
+        @param data Data to write.
+        @param length - length of data
+
+        @retval kStkErrOk on success
+    */
+    sfeTkError_t writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length);
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**
+        @brief Writes a number of bytes starting at the given register's 16-bit address.
+
+        @param devReg The device's register's address - 16 bit.
+        @param data Data to write.
+        @param length - length of data
+
+        @retval sfeTkError_t kSTkErrOk on successful execution
+    */
+    sfeTkError_t writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length);
+#endif
+
+    /**
+        @brief Reads a byte of data from the given register.
+
+        @param devReg The device's register's address.
+        @param[out] data Data to read.
+
+        @retval  kStkErrOk on success
+    */
+    sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data);
+
+#if SFE_TK_ENABLE_WORD_OPS
+    /**
+        @brief Reads a word of data from the given register.
+
+        @param devReg The device's register's address.
+        @param[out] data Data to read.
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegisterWord(uint8_t devReg, uint16_t &data);
+#endif
+
+    /**
+        @brief Reads a block of data from the given register.
+
+        @param devReg The device's register's address.
+        @param[out] data Data buffer to read into
+        @param numBytes Number of bytes to read/length of data buffer
+        @param[out] readBytes - Number of bytes read
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegisterRegion(uint8_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes);
+
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    /**
+        @brief Reads a block of data from the given 16-bit register address.
+
+        @param devReg The device's 16 bit register's address.
+        @param data Data buffer to read into
+        @param numBytes - Number of bytes to read/length of data buffer
+        @param[out] readBytes - number of bytes read
+
+        @retval kSTkErrOk on success
+    */
+    sfeTkError_t readRegister16Region(uint16_t devReg, uint8_t *data, size_t numBytes, size_t &readBytes);
+#endif
+
+#if SFE_TK_ENABLE_TRANSACTIONS
+    /**
+        @brief Runs a transaction - all of its steps under one hold of the port lock. See sfeTk/sfeTkTransaction.h
+
+        @param txn The transaction
+
+        @retval kSTkErrOk if every step succeeded, else the result of the step that failed
+    */
+    template <size_t N> sfeTkError_t transaction(const sfeTkTransaction<N> &txn)
+    {
+        return executeSteps(txn.steps(), N);
+    }
+
+    /**
+        @brief Runs the steps of a transaction, under one hold of the port lock
+
+        @param steps The steps
+        @param nSteps The number of steps
+
+        @retval kSTkErrOk if every step succeeded, else the result of the step that failed
+    */
+    sfeTkError_t executeSteps(const sfeTkTxnStep *steps, size_t nSteps);
+#endif
+
+    // Value returning reads - see sfeTk/sfeTkIBus.h
+    using sfeTkBusValueReads<sfeTkArdSPIDevice>::readRegisterByte;
+#if SFE_TK_ENABLE_WORD_OPS
+    using sfeTkBusValueReads<sfeTkArdSPIDevice>::readRegisterWord;
+#endif
+    using sfeTkBusValueReads<sfeTkArdSPIDevice>::readRegisterRegion;
+#if SFE_TK_ENABLE_16BIT_REGISTERS
+    using sfeTkBusValueReads<sfeTkArdSPIDevice>::readRegister16Region;
+#endif
+
+  private:
+    template <typename Op> sfeTkError_t transact(Op op)
+    {
+        if (!_port)
+            return kSTkErrBusNotInit;
+
+        return _port->transact(_cs, op);
+    }
+
+    sfeTkArdSPIPort *_port;
+    uint8_t _cs;
+};
@@ -0,0 +1,184 @@
+// bench_bus_service.cpp - host test and benchmark of the bus service task
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o bench_bus_service
+//       tests/host/bench_bus_service.cpp src/sfeTkArdI2C.cpp
+
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#include <sfeTk/sfeTkBusServiceThread.h>
+#include <sfeTkArdI2C.h>
+
+static const uint8_t kDevAddress = 0x42;
+static const size_t kReadLength = 8;
+
+static double secondsSince(unsigned long start)
+{
+    return (micros() - start) / 1e6;
+}
+
+// Baseline - the application task calls the bus directly
+static void benchDirect(sfeTkArdI2C &bus, uint32_t nOps)
+{
+    uint8_t buffer[kReadLength];
+    size_t nRead;
+
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < nOps; i++)
+        bus.readRegisterRegion((uint8_t)(i % 64), buffer, sizeof(buffer), nRead);
+
+    double secs = secondsSince(start);
+    printf("direct            : %8u ops  %10.0f ops/s\n", nOps, nOps / secs);
+}
+
+// Many application tasks submit to a single service thread that owns the bus
+static bool benchService(sfeTkArdI2C &bus, sfeTkSimDevice &device, int nTasks, uint32_t nOpsPerTask)
+{
+    sfeTkBusServiceThread<16, 2> service(bus);
+    service.start();
+
+    std::atomic<uint32_t> nErrors{0};
+    std::atomic<uint64_t> latencySum{0};
+    std::atomic<unsigned long> latencyMax{0};
+
+    unsigned long start = micros();
+
+    std::vector<std::thread> tasks;
+    for (int t = 0; t < nTasks; t++)
+    {
+        tasks.emplace_back([&, t] {
+            uint8_t buffer[kReadLength];
+            sfeTkBusRequest request;
+
+            for (uint32_t i = 0; i < nOpsPerTask; i++)
+            {
+                uint8_t reg = (uint8_t)((t * 8 + i) % 64);
+                request.set(kSTkBusOpReadRegisterRegion, reg, buffer, sizeof(buffer), (uint8_t)(t & 1));
+
+                unsigned long t0 = micros();
+                // retry while the queue is full - the application decides how to handle back pressure
+                while (service.submit(request) == kSTkErrBusQueueFull)
+                    std::this_thread::yield();
+
+                while (!request.done())
+                    std::this_thread::yield();
+
+                unsigned long latency = micros() - t0;
+                latencySum += latency;
+                unsigned long prev = latencyMax.load();
+                while (latency > prev && !latencyMax.compare_exchange_weak(prev, latency))
+                    ;
+
+                if (request.result() != kSTkErrOk || request.transferred != sizeof(buffer))
+                {
+                    nErrors++;
+                    continue;
+                }
+                for (size_t n = 0; n < sizeof(buffer); n++)
+                {
+                    if (buffer[n] != device.reg(reg + n))
+                        nErrors++;
+                }
+            }
+        });
+    }
+    for (auto &task : tasks)
+        task.join();
+
+    double secs = secondsSince(start);
+    service.stop();
+
+    uint32_t nOps = nTasks * nOpsPerTask;
+    printf("service %2d tasks  : %8u ops  %10.0f ops/s  latency avg %6.1f us max %6lu us  rejected %u  errors %u\n",
+           nTasks, nOps, nOps / secs, (double)latencySum / nOps, latencyMax.load(), service.nRejected(),
+           nErrors.load());
+
+    return nErrors == 0 && service.nCompleted() == nOps;
+}
+
+// Priority ordering - queue work with no service task running, then run it inline
+struct orderLog
+{
+    sfeTkBusRequest *first;
+    int order[4];
+    int count;
+};
+
+static void logCompletion(sfeTkBusRequest &request, void *context)
+{
+    orderLog *log = (orderLog *)context;
+    log->order[log->count++] = (int)(&request - log->first);
+}
+
+static bool testPriority(sfeTkArdI2C &bus)
+{
+    sfeTkBusService<8, 2> service(bus);
+    uint8_t buffer[4];
+    sfeTkBusRequest requests[4];
+    orderLog log = {requests, {0}, 0};
+
+    for (int i = 0; i < 4; i++)
+    {
+        requests[i].set(kSTkBusOpReadRegisterRegion, (uint16_t)i, &buffer[i], 1, i < 2 ? 1 : 0);
+        requests[i].onComplete = logCompletion;
+        requests[i].context = &log;
+        service.submit(requests[i]);
+    }
+    size_t nDone = service.serviceAll();
+
+    // priority 0 first (2, 3) then priority 1 (0, 1) - submit order within a priority
+    bool bOk = nDone == 4 && log.order[0] == 2 && log.order[1] == 3 && log.order[2] == 0 && log.order[3] == 1;
+    printf("priority ordering : %s\n", bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+int main(void)
+{
+    sfeTkSimDevice device;
+    for (int i = 0; i < 256; i++)
+        device.setReg((uint16_t)i, (uint8_t)(i * 7 + 3));
+
+    Wire.attach(kDevAddress, device);
+
+    sfeTkArdI2C bus;
+    bus.init(Wire, kDevAddress);
+
+    bool bOk = testPriority(bus);
+
+    benchDirect(bus, 200000);
+    for (int nTasks : {1, 2, 4, 8})
+        bOk = benchService(bus, device, nTasks, 200000 / nTasks) && bOk;
+
+    // with modeled wire time (400kHz), application tasks no longer block on the wire
+    Wire.setClock(400000);
+    Wire.setRealTime(true);
+    benchDirect(bus, 2000);
+    bOk = benchService(bus, device, 4, 500) && bOk;
+
+    printf("%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+// bench_checked.cpp - host test and benchmark of the checked bus handles (sfeTkArdI2CChecked, sfeTkArdSPIChecked)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o bench_checked tests/host/bench_checked.cpp
+//       src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+//
+// Checks a handle is only returned by an initialized bus, and that its operations give the same results as the
+// bus methods. Then measures the cost of a small register read - a byte and a word - through sfeTkIBus&, on the
+// concrete bus class, and on a checked handle. The simulated core does no wire time here (not real time), so the
+// cost is the toolkit and simulated core software path. Cycles are the time stamp counter on x86, else ns.
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include <sfeTkArdI2C.h>
+#include <sfeTkArdSPI.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define kUnits "cycles"
+static inline uint64_t now(void)
+{
+    return __rdtsc();
+}
+#else
+#define kUnits "ns"
+static inline uint64_t now(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+#endif
+
+static const uint8_t kAddress = 0x42;
+static const uint8_t kCS = 10;
+static const uint8_t kRegId = 0x0F;
+static const uint8_t kRegData = 0x28;
+static const uint8_t kRegOut = 0x40;
+static const uint8_t kId = 0x6B;
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-44s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+template <typename Bus, typename Handle> static bool testHandle(const char *title, Bus &bus, Handle theBus,
+                                                              sfeTkSimDevice &sim)
+{
+    char name[64];
+    bool bOk = true;
+
+    uint8_t byteBus = 0, byteHandle = 0;
+    uint16_t wordBus = 0, wordHandle = 0;
+    sfeTkError_t errBus = bus.readRegisterByte(kRegId, byteBus);
+    sfeTkError_t errHandle = theBus.readRegisterByte(kRegId, byteHandle);
+    snprintf(name, sizeof(name), "%s readRegisterByte()", title);
+    bOk = check(name, errBus == kSTkErrOk && errHandle == kSTkErrOk && byteBus == kId && byteHandle == kId) && bOk;
+
+    errBus = bus.readRegisterWord(kRegData, wordBus);
+    errHandle = theBus.readRegisterWord(kRegData, wordHandle);
+    snprintf(name, sizeof(name), "%s readRegisterWord()", title);
+    bOk = check(name, errBus == kSTkErrOk && errHandle == kSTkErrOk && wordBus == 0x1234 && wordHandle == 0x1234) &&
+          bOk;
+
+    uint8_t block[4] = {0};
+    size_t nRead = 0;
+    errHandle = theBus.readRegisterRegion(kRegData, block, sizeof(block), nRead);
+    snprintf(name, sizeof(name), "%s readRegisterRegion()", title);
+    bOk = check(name, errHandle == kSTkErrOk && nRead == sizeof(block) && block[0] == 0x34 && block[1] == 0x12) &&
+          bOk;
+
+    // writes land in the device - a word is two bytes, low byte first
+    const uint8_t out[3] = {0xA1, 0xA2, 0xA3};
+    errHandle = theBus.writeRegisterByte(kRegOut, 0x55);
+    errHandle = errHandle == kSTkErrOk ? theBus.writeRegisterWord(kRegOut + 1, 0xBEEF) : errHandle;
+    errHandle = errHandle == kSTkErrOk ? theBus.writeRegisterRegion(kRegOut + 3, out, sizeof(out)) : errHandle;
+    snprintf(name, sizeof(name), "%s register writes", title);
+    bOk = check(name, errHandle == kSTkErrOk && sim.reg(kRegOut) == 0x55 && sim.reg(kRegOut + 1) == 0xEF &&
+                          sim.reg(kRegOut + 2) == 0xBE && sim.reg(kRegOut + 3) == 0xA1 &&
+                          sim.reg(kRegOut + 5) == 0xA3) &&
+          bOk;
+
+    // the bus word write matches the handle
+    errBus = bus.writeRegisterWord(kRegOut + 1, 0xCAFE);
+    snprintf(name, sizeof(name), "%s bus writeRegisterWord()", title);
+    bOk = check(name, errBus == kSTkErrOk && sim.reg(kRegOut + 1) == 0xFE && sim.reg(kRegOut + 2) == 0xCA) && bOk;
+
+    return bOk;
+}
+
+static bool testChecked(sfeTkArdI2C &i2c, sfeTkArdSPI &spi, sfeTkSimDevice &i2cSim, sfeTkSimDevice &spiSim)
+{
+    // no handle before init
+    sfeTkArdI2C i2cNotInit;
+    sfeTkArdSPI spiNotInit;
+    bool bOk = check("no handle from a bus that is not initialized",
+                     i2cNotInit.checked().error() == kSTkErrBusNotInit &&
+                         spiNotInit.checked().error() == kSTkErrBusNotInit);
+
+    // the bus methods keep their checks
+    uint8_t data;
+    bOk = check("bus methods still check the port", i2cNotInit.readRegisterByte(kRegId, data) == kSTkErrBusNotInit &&
+                                                        spiNotInit.readRegisterByte(kRegId, data) ==
+                                                            kSTkErrBusNotInit) &&
+          bOk;
+
+    sfeTkResult<sfeTkArdI2CChecked> i2cChecked = i2c.checked();
+    sfeTkResult<sfeTkArdSPIChecked> spiChecked = spi.checked();
+    bOk = check("handle from an initialized bus", i2cChecked.ok() && &i2cChecked.value().bus() == &i2c &&
+                                                      spiChecked.ok() && &spiChecked.value().bus() == &spi) &&
+          bOk;
+    if (!i2cChecked || !spiChecked)
+        return false;
+
+    bOk = testHandle("I2C", i2c, i2cChecked.value(), i2cSim) && bOk;
+    bOk = testHandle("SPI", spi, spiChecked.value(), spiSim) && bOk;
+    return bOk;
+}
+
+static const int kReads = 100000;
+static const int kRounds = 15;
+
+// The mean cost of a read over a batch of reads
+template <typename Fn> static double perRead(Fn fn)
+{
+    uint64_t start = now();
+    for (int i = 0; i < kReads; i++)
+        fn();
+    return (double)(now() - start) / kReads;
+}
+
+static void keepMin(double &best, double value)
+{
+    if (best == 0 || value < best)
+        best = value;
+}
+
+template <typename Bus, typename Handle> static bool benchmarkBus(const char *title, Bus &bus, Handle theBus)
+{
+    uint8_t byteData;
+    uint16_t wordData;
+    uint32_t sum = 0;
+    sfeTkIBus &ibus = bus;
+
+    // the batches of each kind are interleaved, and the best batch is kept - so each kind sees the same machine
+    double byteVirtual = 0, byteDirect = 0, byteHandle = 0, wordVirtual = 0, wordDirect = 0, wordHandle = 0;
+    for (int round = 0; round < kRounds; round++)
+    {
+        keepMin(byteVirtual, perRead([&] { sum += ibus.readRegisterByte(kRegId, byteData) == kSTkErrOk; }));
+        keepMin(byteDirect, perRead([&] { sum += bus.readRegisterByte(kRegId, byteData) == kSTkErrOk; }));
+        keepMin(byteHandle, perRead([&] { sum += theBus.readRegisterByte(kRegId, byteData) == kSTkErrOk; }));
+        keepMin(wordVirtual, perRead([&] { sum += ibus.readRegisterWord(kRegData, wordData) == kSTkErrOk; }));
+        keepMin(wordDirect, perRead([&] { sum += bus.readRegisterWord(kRegData, wordData) == kSTkErrOk; }));
+        keepMin(wordHandle, perRead([&] { sum += theBus.readRegisterWord(kRegData, wordData) == kSTkErrOk; }));
+    }
+
+    printf("\n%s - %s per read (saved: sfeTkIBus& less handle):\n", title, kUnits);
+    printf("  %-22s %10s %10s %10s %8s\n", "", "sfeTkIBus&", "bus", "handle", "saved");
+    printf("  %-22s %10.1f %10.1f %10.1f %8.1f\n", "readRegisterByte()", byteVirtual, byteDirect, byteHandle,
+           byteVirtual - byteHandle);
+    printf("  %-22s %10.1f %10.1f %10.1f %8.1f\n", "readRegisterWord()", wordVirtual, wordDirect, wordHandle,
+           wordVirtual - wordHandle);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s reads all succeeded", title);
+    return check(name, sum == 6u * kRounds * kReads);
+}
+
+int main()
+{
+    sfeTkSimDevice i2cSim, spiSim;
+    for (sfeTkSimDevice *sim : {&i2cSim, &spiSim})
+    {
+        sim->setReg(kRegId, kId);
+        sim->setReg(kRegData, 0x34);
+        sim->setReg(kRegData + 1, 0x12);
+    }
+    Wire.attach(kAddress, i2cSim);
+    SPI.attach(kCS, spiSim);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kAddress);
+    sfeTkArdSPI spi;
+    spi.init(kCS, true);
+
+    bool bOk = testChecked(i2c, spi, i2cSim, spiSim);
+
+    bOk = benchmarkBus("I2C", i2c, i2c.checked().value()) && bOk;
+    bOk = benchmarkBus("SPI", spi, spi.checked().value()) && bOk;
+
+    Wire.detach(kAddress);
+    SPI.detach(kCS);
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,298 @@
+// bench_containers.cpp - host test and benchmark of the fixed capacity containers against their std counterparts
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -Isrc -o bench_containers tests/host/bench_containers.cpp
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <bitset>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <new>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include <sfeTk/sfeTkBitset.h>
+#include <sfeTk/sfeTkFlatMap.h>
+#include <sfeTk/sfeTkRing.h>
+#include <sfeTk/sfeTkStaticVector.h>
+
+// count heap allocations - the toolkit containers should make none
+static size_t nAllocs = 0;
+
+void *operator new(size_t size)
+{
+    nAllocs++;
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+static const int kRounds = 200000;
+
+// keeps results alive, so the loops are not optimized out
+static volatile uint32_t sink;
+
+template <typename Fn> static void bench(const char *name, Fn fn)
+{
+    size_t allocs = nAllocs;
+    auto start = std::chrono::steady_clock::now();
+    uint32_t result = 0;
+    for (int i = 0; i < kRounds; i++)
+        result += fn(i);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    sink = result;
+    printf("  %-28s: %8.1f ns/round  %8zu allocations\n", name, ns / kRounds, nAllocs - allocs);
+}
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-30s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+//---------------------------------------------------------------------------
+static bool testVector(void)
+{
+    sfeTkStaticVector<int, 8> vec;
+    bool bOk = vec.empty() && vec.capacity() == 8;
+    for (int i = 0; i < 8; i++)
+        bOk = vec.push_back(i) && bOk;
+    bOk = !vec.push_back(99) && vec.full() && bOk;
+    bOk = vec.erase(0) && vec.insert(3, 42) && vec[3] == 42 && vec.front() == 1 && vec.back() == 7 && bOk;
+    bOk = !vec.insert(9, 1) && vec.pop_back() && vec.size() == 7 && bOk;
+
+    int sum = 0;
+    for (int value : vec)
+        sum += value;
+    bOk = sum == 1 + 2 + 3 + 42 + 4 + 5 + 6 && bOk;
+    bOk = vec.resize(2) && vec.resize(4, 9) && vec[3] == 9 && !vec.resize(9) && bOk;
+
+    return check("static vector", bOk);
+}
+
+static bool testRing(void)
+{
+    sfeTkRing<int, 3> ring; // not a power of two - the wrap compare path
+    bool bOk = ring.push(1) && ring.push(2) && ring.push(3) && !ring.push(4) && ring.full();
+
+    int value = 0;
+    bOk = ring.pop(value) && value == 1 && ring.push(4) && ring[0] == 2 && ring[2] == 4 && bOk;
+    bOk = ring.pushOverwrite(5) && ring.front() == 3 && ring.size() == 3 && bOk;
+    bOk = ring.pop(value) && ring.pop(value) && ring.pop(value) && value == 5 && !ring.pop(value) && bOk;
+
+    sfeTkRing<uint8_t, 4> masked;
+    for (int i = 0; i < 10; i++)
+        bOk = masked.push((uint8_t)i) && masked.pop() && bOk;
+    bOk = masked.empty() && bOk;
+
+    return check("ring", bOk);
+}
+
+static bool testFlatMap(void)
+{
+    sfeTkFlatMap<uint8_t, uint16_t, 4> map;
+    bool bOk = map.set(0x20, 1) && map.set(0x05, 2) && map.set(0x7F, 3) && map.set(0x10, 4) && !map.set(0x30, 5);
+    bOk = map.set(0x05, 6) && *map.find(0x05) == 6 && map.find(0x30) == nullptr && bOk;
+    bOk = map.keyAt(0) == 0x05 && map.keyAt(1) == 0x10 && map.keyAt(3) == 0x7F && bOk;
+    bOk = map.erase(0x10) && !map.erase(0x10) && !map.contains(0x10) && map.size() == 3 && map.valueAt(1) == 1 && bOk;
+
+    return check("flat map", bOk);
+}
+
+static bool testBitset(void)
+{
+    sfeTkBitset<70> bits;
+    bool bOk = bits.none() && bits.findNext() == 70;
+    bits.set(3);
+    bits.set(33);
+    bits.set(69);
+    bits.flip(4);
+    bits.flip(4);
+    bOk = bits.test(3) && !bits.test(4) && bits[69] && bits.count() == 3 && bOk;
+    bOk = bits.findNext() == 3 && bits.findNext(4) == 33 && bits.findNext(34) == 69 && bits.findNext(70) == 70 && bOk;
+    bits.reset(33);
+    bits.set(1, true);
+    bOk = bits.count() == 3 && bits.findNext(2) == 3 && bOk;
+
+    return check("bitset", bOk);
+}
+
+//---------------------------------------------------------------------------
+static void benchVector(void)
+{
+    printf("\nfill 32 elements, sum, clear:\n");
+    bench("sfeTkStaticVector", [](int round) {
+        sfeTkStaticVector<uint32_t, 32> vec;
+        for (uint32_t i = 0; i < 32; i++)
+            vec.push_back(i + round);
+        uint32_t sum = 0;
+        for (uint32_t value : vec)
+            sum += value;
+        return sum;
+    });
+    bench("std::vector", [](int round) {
+        std::vector<uint32_t> vec;
+        for (uint32_t i = 0; i < 32; i++)
+            vec.push_back(i + round);
+        uint32_t sum = 0;
+        for (uint32_t value : vec)
+            sum += value;
+        return sum;
+    });
+    bench("std::vector + reserve", [](int round) {
+        std::vector<uint32_t> vec;
+        vec.reserve(32);
+        for (uint32_t i = 0; i < 32; i++)
+            vec.push_back(i + round);
+        uint32_t sum = 0;
+        for (uint32_t value : vec)
+            sum += value;
+        return sum;
+    });
+}
+
+static void benchRing(void)
+{
+    // a long lived queue, as a driver would keep one - 16 pushes and pops per round
+    printf("\nFIFO, 16 push/pop per round:\n");
+    static sfeTkRing<uint32_t, 16> ring;
+    bench("sfeTkRing", [](int round) {
+        uint32_t sum = 0, value;
+        for (uint32_t i = 0; i < 16; i++)
+            ring.push(i + round);
+        while (ring.pop(value))
+            sum += value;
+        return sum;
+    });
+    static std::queue<uint32_t> queue;
+    bench("std::queue (deque)", [](int round) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < 16; i++)
+            queue.push(i + round);
+        while (!queue.empty())
+        {
+            sum += queue.front();
+            queue.pop();
+        }
+        return sum;
+    });
+}
+
+static void benchMap(void)
+{
+    // 24 registers of a device, looked up by address
+    printf("\n24 entry register map, 64 lookups per round:\n");
+    static sfeTkFlatMap<uint8_t, uint32_t, 32> flat;
+    static std::map<uint8_t, uint32_t> tree;
+    static std::unordered_map<uint8_t, uint32_t> hash;
+    for (uint32_t i = 0; i < 24; i++)
+    {
+        uint8_t reg = (uint8_t)(i * 5 + 3);
+        flat.set(reg, i);
+        tree[reg] = i;
+        hash[reg] = i;
+    }
+
+    bench("sfeTkFlatMap", [](int round) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            const uint32_t *value = flat.find((uint8_t)((i * 7 + round) & 0x7F));
+            sum += value ? *value : 1;
+        }
+        return sum;
+    });
+    bench("std::map", [](int round) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            auto it = tree.find((uint8_t)((i * 7 + round) & 0x7F));
+            sum += it != tree.end() ? it->second : 1;
+        }
+        return sum;
+    });
+    bench("std::unordered_map", [](int round) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            auto it = hash.find((uint8_t)((i * 7 + round) & 0x7F));
+            sum += it != hash.end() ? it->second : 1;
+        }
+        return sum;
+    });
+}
+
+static void benchBitset(void)
+{
+    printf("\n256 bit set, 32 sets, 64 tests and a count per round:\n");
+    bench("sfeTkBitset", [](int round) {
+        sfeTkBitset<256> bits;
+        for (uint32_t i = 0; i < 32; i++)
+            bits.set((i * 37 + round) & 0xFF);
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < 64; i++)
+            n += bits.test((i * 11 + round) & 0xFF);
+        return n + (uint32_t)bits.count();
+    });
+    bench("std::bitset", [](int round) {
+        std::bitset<256> bits;
+        for (uint32_t i = 0; i < 32; i++)
+            bits.set((i * 37 + round) & 0xFF);
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < 64; i++)
+            n += bits.test((i * 11 + round) & 0xFF);
+        return n + (uint32_t)bits.count();
+    });
+}
+
+int main(void)
+{
+    bool bOk = testVector();
+    bOk = testRing() && bOk;
+    bOk = testFlatMap() && bOk;
+    bOk = testBitset() && bOk;
+
+    benchVector();
+    benchRing();
+    benchMap();
+    benchBitset();
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
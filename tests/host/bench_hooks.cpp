@@ -0,0 +1,321 @@
+// bench_hooks.cpp - host test and benchmark of the bus hooks (sfeTkBusHooks.h)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -DSFE_TK_ENABLE_TRANSACTIONS=1 -Itests/host/sim -Isrc -o bench_hooks
+//       tests/host/bench_hooks.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+//
+// Checks the hooked bus classes call the hooks once for each operation - however it is called - with the
+// operation, register, length, result and duration. Then compares the cost of a register read on the plain bus
+// class, with hooks off (sfeTkNoBusHooks), with an enabled policy of empty inline hooks, and with the run time
+// callback policy unset and set. With hooks off the bus class is the plain class - checked at compile time - so
+// the cost is zero by construction; the timing shows it. Cycles are the time stamp counter on x86, else ns.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <type_traits>
+
+#include <sfeTkArdBusHooks.h>
+
+#if !SFE_TK_ENABLE_TRANSACTIONS
+#error "build with -DSFE_TK_ENABLE_TRANSACTIONS=1"
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define kUnits "cycles"
+static inline uint64_t now(void)
+{
+    return __rdtsc();
+}
+#else
+#define kUnits "ns"
+static inline uint64_t now(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+#endif
+
+static const uint8_t kAddress = 0x42;
+static const uint8_t kCS = 10;
+static const uint8_t kRegId = 0x0F;
+static const uint8_t kRegData = 0x28;
+static const uint8_t kId = 0x6B;
+
+// With hooks off, the hooked class is the bus class - no wrapper, no extra vtable, no extra state
+static_assert(std::is_same<sfeTkArdI2CHooked<sfeTkNoBusHooks>, sfeTkArdI2C>::value, "no hooks is the I2C class");
+static_assert(std::is_same<sfeTkArdSPIHooked<sfeTkNoBusHooks>, sfeTkArdSPI>::value, "no hooks is the SPI class");
+
+// A clock for the host
+struct HostClock
+{
+    static uint32_t now(void)
+    {
+        return (uint32_t)::now();
+    }
+};
+
+// An enabled policy that does nothing - the cost of the hook points themselves
+struct EmptyHooks
+{
+    static const bool kEnabled = true;
+    uint32_t now(void)
+    {
+        return 0;
+    }
+    void before(const sfeTkBusHookInfo &)
+    {
+    }
+    void after(const sfeTkBusHookInfo &)
+    {
+    }
+};
+
+// A policy that records what it is told
+struct RecordHooks
+{
+    static const bool kEnabled = true;
+    uint32_t nBefore = 0;
+    uint32_t nAfter = 0;
+    uint32_t tick = 0;
+    sfeTkBusHookInfo last = {};
+
+    uint32_t now(void)
+    {
+        return tick += 5;
+    }
+    void before(const sfeTkBusHookInfo &info)
+    {
+        nBefore++;
+        last = info;
+    }
+    void after(const sfeTkBusHookInfo &info)
+    {
+        nAfter++;
+        last = info;
+    }
+};
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-52s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+// Runs an operation, and checks it called the hooks once each, with the expected details
+template <typename Bus, typename Fn>
+static bool checkOp(const char *title, const char *opName, Bus &bus, Fn fn, sfeTkBusHookOp_t op, uint16_t reg,
+                    size_t length, sfeTkError_t result = kSTkErrOk)
+{
+    RecordHooks &hooks = bus.hooks();
+    uint32_t nBefore = hooks.nBefore, nAfter = hooks.nAfter;
+    sfeTkError_t retval = fn();
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s %s", title, opName);
+    return check(name, retval == result && hooks.nBefore == nBefore + 1 && hooks.nAfter == nAfter + 1 &&
+                           hooks.last.bus == &bus && hooks.last.op == op && hooks.last.reg == reg &&
+                           hooks.last.length == length && hooks.last.result == result &&
+                           hooks.last.duration == 5);
+}
+
+template <typename Bus> static bool testHooks(const char *title, Bus &bus)
+{
+    bool bOk = true;
+    sfeTkIBus &ibus = bus;
+    uint8_t data = 0;
+    uint16_t word = 0;
+    uint8_t block[4];
+    size_t nRead = 0;
+
+    bOk = checkOp(title, "writeByte()", bus, [&] { return bus.writeByte(0x01); }, kSTkBusHookWriteByte, 0, 1) &&
+          bOk;
+    bOk = checkOp(title, "writeRegisterWord()", bus, [&] { return bus.writeRegisterWord(0x40, 0x1234); },
+                  kSTkBusHookWriteRegisterWord, 0x40, 2) &&
+          bOk;
+    bOk = checkOp(title, "writeRegisterRegion()", bus, [&] { return bus.writeRegisterRegion(0x40, block, 3); },
+                  kSTkBusHookWriteRegisterRegion, 0x40, 3) &&
+          bOk;
+    bOk = checkOp(title, "readRegisterByte() on the class", bus,
+                  [&] { return bus.readRegisterByte(kRegId, data); }, kSTkBusHookReadRegisterByte, kRegId, 1) &&
+          bOk;
+    bOk = checkOp(title, "readRegisterByte() through sfeTkIBus", bus,
+                  [&] { return ibus.readRegisterByte(kRegId, data); }, kSTkBusHookReadRegisterByte, kRegId, 1) &&
+          bOk;
+    bOk = checkOp(title, "readRegisterByte() result overload", bus,
+                  [&] { return bus.readRegisterByte(kRegId).error(); }, kSTkBusHookReadRegisterByte, kRegId, 1) &&
+          bOk;
+    bOk = checkOp(title, "readRegisterWord()", bus, [&] { return bus.readRegisterWord(kRegData, word); },
+                  kSTkBusHookReadRegisterWord, kRegData, 2) &&
+          bOk;
+    bOk = checkOp(title, "readRegisterRegion()", bus,
+                  [&] { return bus.readRegisterRegion(kRegData, block, sizeof(block), nRead); },
+                  kSTkBusHookReadRegisterRegion, kRegData, sizeof(block)) &&
+          bOk;
+    bOk = checkOp(title, "transaction() is one operation", bus,
+                  [&] { return bus.transaction(sfeTkTxn() << sfeTkWrite(0x40, 0x55) >> sfeTkRead(kRegData, block)); },
+                  kSTkBusHookTransaction, 0, 2) &&
+          bOk;
+    return bOk;
+}
+
+static bool testCallback(void)
+{
+    struct Counts
+    {
+        int nBefore, nAfter;
+        sfeTkError_t result;
+    } counts = {0, 0, kSTkErrOk};
+
+    sfeTkHookedBus<sfeTkArdI2C, sfeTkBusHookCallback<HostClock>>::type bus;
+    bus.init(Wire, kAddress);
+    uint8_t data = 0;
+    bool bOk = bus.readRegisterByte(kRegId, data) == kSTkErrOk && data == kId; // no hook set
+
+    bus.hooks().setHook(
+        [](const sfeTkBusHookInfo &info, bool bAfter, void *context) {
+            Counts *counts = (Counts *)context;
+            if (bAfter)
+            {
+                counts->nAfter++;
+                counts->result = info.result;
+            }
+            else
+                counts->nBefore++;
+        },
+        &counts);
+    bOk = bus.readRegisterByte(kRegId, data) == kSTkErrOk && data == kId && bOk;
+    bOk = check("callback policy - called before and after", bOk && counts.nBefore == 1 && counts.nAfter == 1 &&
+                                                                 counts.result == kSTkErrOk) &&
+          bOk;
+
+    // no calls once the hook is cleared
+    bus.hooks().setHook(nullptr);
+    bOk = bus.readRegisterByte(kRegId, data) == kSTkErrOk && bOk;
+    return check("callback policy - cleared", bOk && counts.nBefore == 1 && counts.nAfter == 1) && bOk;
+}
+
+static const int kReads = 100000;
+static const int kRounds = 15;
+
+template <typename Fn> static double perRead(Fn fn)
+{
+    uint64_t start = now();
+    for (int i = 0; i < kReads; i++)
+        fn();
+    return (double)(now() - start) / kReads;
+}
+
+static void keepMin(double &best, double value)
+{
+    if (best == 0 || value < best)
+        best = value;
+}
+
+static void countHook(const sfeTkBusHookInfo &, bool, void *context)
+{
+    (*(uint32_t *)context)++;
+}
+
+static bool benchmark(void)
+{
+    sfeTkArdI2C plain;
+    plain.init(Wire, kAddress);
+    sfeTkArdI2CHooked<sfeTkNoBusHooks> off;
+    off.init(Wire, kAddress);
+    sfeTkArdI2CHooked<EmptyHooks> empty;
+    empty.init(Wire, kAddress);
+    sfeTkArdI2CHooked<sfeTkBusHookCallback<HostClock>> unset;
+    unset.init(Wire, kAddress);
+    sfeTkArdI2CHooked<sfeTkBusHookCallback<HostClock>> set;
+    set.init(Wire, kAddress);
+    uint32_t nHooks = 0;
+    set.hooks().setHook(countHook, &nHooks);
+
+    sfeTkIBus *buses[5] = {&plain, &off, &empty, &unset, &set};
+    const char *names[5] = {"sfeTkArdI2C", "sfeTkNoBusHooks", "empty inline hooks", "callback, not set",
+                            "callback, set"};
+    double best[5] = {0};
+    uint32_t sum = 0;
+    uint8_t data;
+
+    // through sfeTkIBus, as a driver calls the bus - batches interleaved, best batch kept
+    for (int round = 0; round < kRounds; round++)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            sfeTkIBus *bus = buses[i];
+            keepMin(best[i], perRead([&] { sum += bus->readRegisterByte(kRegId, data) == kSTkErrOk; }));
+        }
+    }
+
+    printf("\nI2C readRegisterByte() - %s per read, through sfeTkIBus:\n", kUnits);
+    for (int i = 0; i < 5; i++)
+        printf("  %-22s %8.1f %+8.1f\n", names[i], best[i], best[i] - best[0]);
+    printf("  object size: sfeTkArdI2C %u, no hooks %u, empty hooks %u, callback %u bytes\n",
+           (unsigned)sizeof(plain), (unsigned)sizeof(off), (unsigned)sizeof(empty), (unsigned)sizeof(set));
+
+    bool bOk = check("benchmark reads all succeeded", sum == 5u * kRounds * kReads);
+    return check("callback called twice a read", nHooks == 2u * kRounds * kReads) && bOk;
+}
+
+int main()
+{
+    sfeTkSimDevice i2cSim, spiSim;
+    for (sfeTkSimDevice *sim : {&i2cSim, &spiSim})
+    {
+        sim->setReg(kRegId, kId);
+        sim->setReg(kRegData, 0x34);
+        sim->setReg(kRegData + 1, 0x12);
+    }
+    Wire.attach(kAddress, i2cSim);
+    SPI.attach(kCS, spiSim);
+
+    sfeTkArdI2CHooked<RecordHooks> i2c;
+    i2c.init(Wire, kAddress);
+    sfeTkArdSPIHooked<RecordHooks> spi;
+    spi.init(kCS, true);
+
+    bool bOk = testHooks("I2C", i2c);
+    bOk = testHooks("SPI", spi) && bOk;
+
+    // errors reach the after hook
+    sfeTkArdI2CHooked<RecordHooks> notInit;
+    uint8_t data;
+    bOk = checkOp("I2C", "error result", notInit, [&] { return notInit.readRegisterByte(kRegId, data); },
+                  kSTkBusHookReadRegisterByte, kRegId, 1, kSTkErrBusNotInit) &&
+          bOk;
+
+    bOk = testCallback() && bOk;
+
+    bOk = benchmark() && bOk;
+
+    Wire.detach(kAddress);
+    SPI.detach(kCS);
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
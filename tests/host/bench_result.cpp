@@ -0,0 +1,347 @@
+// bench_result.cpp - host test and benchmark of the value returning bus reads (sfeTkResult)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o bench_result tests/host/bench_result.cpp
+//       src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp src/sfeTkArdI2CPort.cpp src/sfeTkArdSPIPort.cpp
+
+#include <stdio.h>
+
+#include <chrono>
+#include <type_traits>
+
+#include <sfeTkArdI2CPort.h>
+#include <sfeTkArdSPIPort.h>
+
+static_assert(std::is_trivially_copyable<sfeTkResult<uint8_t>>::value, "sfeTkResult must be trivially copyable");
+static_assert(std::is_trivially_copyable<sfeTkResult<size_t>>::value, "sfeTkResult must be trivially copyable");
+static_assert(sizeof(sfeTkResult<uint8_t>) <= 8, "sfeTkResult<uint8_t> must fit in a register pair");
+
+static const uint8_t kAddress = 0x42;
+static const uint8_t kCS = 10;
+static const uint8_t kRegId = 0x0F;
+static const uint8_t kRegStatus = 0x27;
+static const uint8_t kRegData = 0x28;
+static const uint8_t kId = 0x6B;
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-40s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+// A bus with no wire - a register file. Keeps the bus cost small, so the cost of the calling convention shows.
+class RegisterBus final : public sfeTkIBus
+{
+  public:
+    sfeTkError_t writeByte(uint8_t)
+    {
+        return kSTkErrOk;
+    }
+    sfeTkError_t writeWord(uint16_t)
+    {
+        return kSTkErrOk;
+    }
+    sfeTkError_t writeRegion(const uint8_t *, size_t)
+    {
+        return kSTkErrOk;
+    }
+    sfeTkError_t writeRegisterByte(uint8_t devReg, uint8_t data)
+    {
+        regs[devReg] = data;
+        return kSTkErrOk;
+    }
+    sfeTkError_t writeRegisterWord(uint8_t devReg, uint16_t data)
+    {
+        return writeRegisterRegion(devReg, (const uint8_t *)&data, sizeof(data));
+    }
+    sfeTkError_t writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
+    {
+        for (size_t i = 0; i < length; i++)
+            regs[(uint8_t)(devReg + i)] = data[i];
+        return kSTkErrOk;
+    }
+    sfeTkError_t writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
+    {
+        return writeRegisterRegion((uint8_t)devReg, data, length);
+    }
+    sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data)
+    {
+        data = regs[devReg];
+        return kSTkErrOk;
+    }
+    sfeTkError_t readRegisterWord(uint8_t devReg, uint16_t &data)
+    {
+        data = (uint16_t)(regs[devReg] | regs[(uint8_t)(devReg + 1)] << 8);
+        return kSTkErrOk;
+    }
+    sfeTkError_t readRegisterRegion(uint8_t reg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        for (size_t i = 0; i < numBytes; i++)
+            data[i] = regs[(uint8_t)(reg + i)];
+        readBytes = numBytes;
+        return kSTkErrOk;
+    }
+    sfeTkError_t readRegister16Region(uint16_t reg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        return readRegisterRegion((uint8_t)reg, data, numBytes, readBytes);
+    }
+
+    // direct value returning reads - safe in a final class, where no subclass can override the read methods
+    sfeTkResult<uint8_t> readRegisterByte(uint8_t devReg)
+    {
+        uint8_t data;
+        sfeTkError_t retval = RegisterBus::readRegisterByte(devReg, data);
+        return sfeTkResult<uint8_t>(retval, retval == kSTkErrOk ? data : 0);
+    }
+    sfeTkResult<uint16_t> readRegisterWord(uint8_t devReg)
+    {
+        uint16_t data;
+        sfeTkError_t retval = RegisterBus::readRegisterWord(devReg, data);
+        return sfeTkResult<uint16_t>(retval, retval == kSTkErrOk ? data : 0);
+    }
+
+    uint8_t regs[256] = {0};
+};
+
+// A bus with a special read routine - the value returning reads must use it, through any reference
+class SpecialReadI2C : public sfeTkArdI2C
+{
+  public:
+    sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data)
+    {
+        sfeTkError_t retval = sfeTkArdI2C::readRegisterByte(devReg, data);
+        data ^= 0xFF;
+        return retval;
+    }
+    using sfeTkArdI2C::readRegisterByte;
+};
+
+// A typical driver step - check the id, wait for data ready and read a sample. The two versions differ only in
+// how the values come back from the bus. Bus is sfeTkIBus (virtual calls), or a concrete final class, where
+// the compiler can inline the bus methods.
+template <typename Bus> __attribute__((noinline)) static sfeTkError_t sampleOutParam(Bus &bus, int32_t &sample)
+{
+    uint8_t id, status;
+    uint16_t data;
+
+    sfeTkError_t retval = bus.readRegisterByte(kRegId, id);
+    if (retval != kSTkErrOk)
+        return retval;
+    if (id != kId)
+        return kSTkErrFail;
+
+    retval = bus.readRegisterByte(kRegStatus, status);
+    if (retval != kSTkErrOk)
+        return retval;
+    if (!(status & 0x01))
+        return kSTkErrBusNotEnabled;
+
+    retval = bus.readRegisterWord(kRegData, data);
+    if (retval != kSTkErrOk)
+        return retval;
+
+    sample = (int16_t)data;
+    return kSTkErrOk;
+}
+
+template <typename Bus> __attribute__((noinline)) static sfeTkError_t sampleResult(Bus &bus, int32_t &sample)
+{
+    sfeTkResult<uint8_t> id = bus.readRegisterByte(kRegId);
+    if (!id)
+        return id.error();
+    if (id.value() != kId)
+        return kSTkErrFail;
+
+    sfeTkResult<uint8_t> status = bus.readRegisterByte(kRegStatus);
+    if (!status)
+        return status.error();
+    if (!(status.value() & 0x01))
+        return kSTkErrBusNotEnabled;
+
+    sfeTkResult<uint16_t> data = bus.readRegisterWord(kRegData);
+    if (!data)
+        return data.error();
+
+    sample = (int16_t)data.value();
+    return kSTkErrOk;
+}
+
+static bool testResult(void)
+{
+    bool bOk = check("result value and error", [] {
+        sfeTkResult<uint8_t> good(0x5A), bad = sfeTkResult<uint8_t>::failure(kSTkErrBusTimeout);
+        sfeTkResult<size_t> warn(kSTkErrBusUnderRead, 3);
+        return good.ok() && good.value() == 0x5A && good.error() == kSTkErrOk && !bad && bad.value() == 0 &&
+               bad.error() == kSTkErrBusTimeout && bad.valueOr(0xEE) == 0xEE && good.valueOr(0xEE) == 0x5A &&
+               !warn && warn.value() == 3 && warn.valueOr(0) == 0;
+    }());
+
+    sfeTkSimDevice i2cSim, spiSim;
+    for (sfeTkSimDevice *sim : {&i2cSim, &spiSim})
+    {
+        sim->setReg(kRegId, kId);
+        sim->setReg(kRegData, 0x34);
+        sim->setReg(kRegData + 1, 0x12);
+    }
+    Wire.attach(kAddress, i2cSim);
+    SPI.attach(kCS, spiSim);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kAddress);
+    sfeTkArdSPI spi;
+    spi.init(kCS, true);
+
+    uint8_t block[2];
+    for (sfeTkIBus *bus : {(sfeTkIBus *)&i2c, (sfeTkIBus *)&spi})
+    {
+        sfeTkResult<uint8_t> id = bus->readRegisterByte(kRegId);
+        sfeTkResult<size_t> nRead = bus->readRegisterRegion(kRegData, block, sizeof(block));
+        bOk = check(bus == &i2c ? "I2C value returning reads" : "SPI value returning reads",
+                    id.ok() && id.value() == kId && nRead.ok() && nRead.value() == 2 && block[0] == 0x34 &&
+                        block[1] == 0x12) &&
+              bOk;
+    }
+
+    // the concrete classes expose the overloads too
+    sfeTkResult<uint16_t> word = i2c.readRegisterWord(kRegData);
+    bOk = check("I2C readRegisterWord() result", word.ok() && word.value() == 0x1234) && bOk;
+
+    // a subclass read routine is used by the value form, called through the concrete class too
+    SpecialReadI2C special;
+    special.init(Wire, kAddress);
+    sfeTkArdI2C &specialI2C = special;
+    sfeTkIBus &specialBus = special;
+    const uint8_t kSpecialId = kId ^ 0xFF;
+    bOk = check("value reads use a subclass override",
+                specialI2C.readRegisterByte(kRegId).value() == kSpecialId &&
+                    specialBus.readRegisterByte(kRegId).value() == kSpecialId &&
+                    special.readRegisterByte(kRegId).value() == kSpecialId) &&
+          bOk;
+
+    // an error leaves a defined value
+    sfeTkArdI2C notInit;
+    sfeTkResult<uint8_t> failed = notInit.readRegisterByte(kRegId);
+    bOk = check("error result has a defined value",
+                !failed && failed.error() == kSTkErrBusNotInit && failed.value() == 0) &&
+          bOk;
+
+    // an under-read (kSTkErrBusUnderRead, a positive code) is not a success - the device NACKs the read request now
+    // and then when its clock errors are on, after the register write went through
+    i2cSim.setClockErrors(100000, 300000);
+    Wire.setClock(200000);
+    int nUnderReads = 0, nUnderReadsOk = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        sfeTkResult<uint16_t> value = i2c.readRegisterWord(kRegData);
+        sfeTkResult<size_t> n = i2c.readRegisterRegion(kRegData, block, sizeof(block));
+        for (sfeTkError_t error : {value.error(), n.error()})
+            nUnderReads += error == kSTkErrBusUnderRead;
+        if ((value.error() == kSTkErrBusUnderRead && (value || value.value() != 0)) ||
+            (n.error() == kSTkErrBusUnderRead && (n.ok() || n.value() != 0)))
+            nUnderReadsOk++;
+    }
+    i2cSim.setClockErrors(0, 0);
+    Wire.setClock(100000);
+    char label[80];
+    snprintf(label, sizeof(label), "under-reads fail (%d under-reads)", nUnderReads);
+    bOk = check(label, nUnderReads > 0 && nUnderReadsOk == 0) && bOk;
+
+    // device handles
+    sfeTkArdI2CPort i2cPort;
+    i2cPort.init(Wire);
+    sfeTkArdI2CDevice i2cDevice(i2cPort, kAddress);
+    sfeTkArdSPIPort spiPort;
+    spiPort.init(true);
+    sfeTkArdSPIDevice spiDevice(spiPort, kCS);
+    bOk = check("device handle value returning reads",
+                i2cDevice.readRegisterByte(kRegId).value() == kId &&
+                    spiDevice.readRegisterWord(kRegData).value() == 0x1234 &&
+                    sfeTkArdI2CDevice().readRegisterByte(kRegId).error() == kSTkErrBusNotInit) &&
+          bOk;
+
+    Wire.detach(kAddress);
+    SPI.detach(kCS);
+    return bOk;
+}
+
+template <typename Fn> static double nsPerCall(Fn fn, int nCalls)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nCalls; i++)
+        fn();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / nCalls;
+}
+
+template <typename Bus> static bool benchmarkBus(const char *title, Bus &bus)
+{
+    const int kCalls = 2000000;
+    int64_t sumOut = 0, sumResult = 0;
+    int32_t sample = 0;
+
+    // alternate the runs so neither gets a frequency or cache advantage
+    double outNs = 0, resultNs = 0;
+    for (int pass = 0; pass < 3; pass++)
+    {
+        outNs += nsPerCall(
+            [&] {
+                if (sampleOutParam(bus, sample) == kSTkErrOk)
+                    sumOut += sample;
+            },
+            kCalls);
+        resultNs += nsPerCall(
+            [&] {
+                if (sampleResult(bus, sample) == kSTkErrOk)
+                    sumResult += sample;
+            },
+            kCalls);
+    }
+
+    printf("\n%s:\n", title);
+    printf("  out parameters          : %6.2f ns/step\n", outNs / 3);
+    printf("  sfeTkResult             : %6.2f ns/step\n", resultNs / 3);
+
+    return check("both forms read the same values", sumOut == sumResult && sumOut == 3LL * kCalls * 0x1234);
+}
+
+static bool benchmark(void)
+{
+    RegisterBus regBus;
+    regBus.regs[kRegId] = kId;
+    regBus.regs[kRegStatus] = 0x01;
+    regBus.regs[kRegData] = 0x34;
+    regBus.regs[kRegData + 1] = 0x12;
+
+    bool bOk = benchmarkBus("Driver step, 3 register reads through sfeTkIBus& (virtual)", (sfeTkIBus &)regBus);
+    bOk = benchmarkBus("Driver step, 3 register reads on the concrete bus (inlined)", regBus) && bOk;
+    return bOk;
+}
+
+int main()
+{
+    bool bOk = testResult();
+    bOk = benchmark() && bOk;
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,407 @@
+// bench_scale.cpp - host benchmark of toolkit costs against the number of devices
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o bench_scale tests/host/bench_scale.cpp
+//       src/sfeTkArdI2C.cpp src/sfeTkArdI2CPort.cpp
+//
+// Runs N simulated devices (N = 1 .. 512) spread over 8 simulated I2C buses - up to 64 addresses a bus - with a
+// mixed workload: each visit to a device reads a status byte and a 6 byte data block, and every fourth visit
+// writes a control register. The same workload runs on
+//
+//   bus objects      an sfeTkArdI2C for each device, called through sfeTkIBus
+//   device handles   an sfeTkArdI2CDevice for each device on a shared sfeTkArdI2CPort for each bus
+//   reactor          a periodic sfeTkReactor timer for each device - all due on each pass, or one due a pass
+//   bus service      an sfeTkBusService for each device, serviced by one task - all pending, or one pending
+//
+// and reports the CPU time per bus operation of the direct calls, the scheduling overhead per visit of the
+// reactor and the service (their time less the direct time), the toolkit RAM per device, and the highest sample
+// rate per device the wire time of the busiest bus allows at 400 kHz. A cost per operation or visit that grows
+// with N is super-linear total cost - the growth column compares the largest N with N = 8. Times are the best of
+// several runs. The simulated bus looks a device up in a map, so part of the per operation cost is the
+// simulator, and caches hold less of the working set as N grows - compare the columns, not the absolute values.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <sfeTk/sfeTkBusService.h>
+#include <sfeTk/sfeTkBusWire.h>
+#include <sfeTk/sfeTkReactor.h>
+#include <sfeTkArdI2C.h>
+#include <sfeTkArdI2CPort.h>
+
+static const size_t kMaxDevices = 512;
+static const size_t kBuses = 8;
+static const uint32_t kClock = 400000;
+static const uint32_t kVisits = 40000; // visits a run, across all devices
+static const int kRuns = 3;
+
+static const uint8_t kRegCtrl = 0x20;
+static const uint8_t kRegStatus = 0x27;
+static const uint8_t kRegData = 0x28;
+static const size_t kDataLength = 6;
+
+static TwoWire buses[kBuses];
+static sfeTkSimDevice sims[kMaxDevices];
+
+// device i is on bus i % kBuses, at an address from 0x08
+static TwoWire &busOf(size_t device)
+{
+    return buses[device % kBuses];
+}
+
+static uint8_t addressOf(size_t device)
+{
+    return (uint8_t)(0x08 + device / kBuses);
+}
+
+// the status register of each device has its own value - so a read from the wrong device is caught
+static uint8_t tagOf(size_t device)
+{
+    return (uint8_t)(device * 37 + 1);
+}
+
+static uint64_t nanos(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static uint32_t nOps = 0;
+static uint32_t nWrong = 0;
+
+// One visit to a device - the mixed workload
+template <typename Bus> static void visit(Bus &bus, size_t device, uint32_t round)
+{
+    uint8_t status = 0;
+    uint8_t data[kDataLength];
+    size_t nRead = 0;
+
+    if (bus.readRegisterByte(kRegStatus, status) != kSTkErrOk || status != tagOf(device))
+        nWrong++;
+    if (bus.readRegisterRegion(kRegData, data, sizeof(data), nRead) != kSTkErrOk || nRead != sizeof(data))
+        nWrong++;
+    nOps += 2;
+
+    if ((round + device) % 4 == 0)
+    {
+        if (bus.writeRegisterByte(kRegCtrl, (uint8_t)round) != kSTkErrOk)
+            nWrong++;
+        nOps++;
+    }
+}
+
+// The result of a run - ns per operation and per visit
+struct Run
+{
+    double perOp;
+    double perVisit;
+};
+
+static void keepBest(Run &best, const Run &run)
+{
+    if (best.perVisit == 0 || run.perVisit < best.perVisit)
+        best = run;
+}
+
+// Visits every device, in rounds, through direct calls
+template <typename Bus> static Run runDirect(Bus *devices, size_t n)
+{
+    uint32_t rounds = kVisits / n > 0 ? kVisits / n : 1;
+    uint32_t ops = nOps;
+    uint64_t start = nanos();
+    for (uint32_t round = 0; round < rounds; round++)
+        for (size_t i = 0; i < n; i++)
+            visit(devices[i], i, round);
+    double elapsed = (double)(nanos() - start);
+    return Run{elapsed / (nOps - ops), elapsed / ((double)rounds * n)};
+}
+
+// Reactor - a timer for each device; the clock is set by the benchmark
+static uint32_t reactorTime = 0;
+static uint32_t reactorClock(void)
+{
+    return reactorTime;
+}
+
+struct Visit
+{
+    sfeTkIBus *bus;
+    size_t device;
+    uint32_t round;
+};
+
+static void onTimer(void *context)
+{
+    Visit *theVisit = (Visit *)context;
+    visit(*theVisit->bus, theVisit->device, theVisit->round++);
+}
+
+typedef sfeTkReactor<kMaxDevices> Reactor;
+
+// bAllDue: every timer is due on each pass. Else the deadlines are spread so one is due a pass.
+static Run runReactor(sfeTkArdI2C *devices, size_t n, bool bAllDue)
+{
+    static Visit visits[kMaxDevices];
+    std::unique_ptr<Reactor> reactor(new Reactor(reactorClock));
+
+    reactorTime = 0;
+    uint32_t period = bAllDue ? 1000 : (uint32_t)n;
+    for (size_t i = 0; i < n; i++)
+    {
+        visits[i] = Visit{&devices[i], i, 0};
+        if (!bAllDue)
+            reactorTime = (uint32_t)i;
+        reactor->addTimer(period, onTimer, &visits[i]);
+    }
+
+    uint32_t passes = bAllDue ? (kVisits / n > 0 ? kVisits / n : 1) : kVisits;
+    uint32_t visited = 0;
+    uint64_t start = nanos();
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        reactorTime += bAllDue ? period : 1;
+        visited += reactor->runOnce();
+    }
+    double elapsed = (double)(nanos() - start);
+    return Run{0, elapsed / visited};
+}
+
+// Bus service - a service for each device, with the requests of a visit
+typedef sfeTkBusService<4, 1> Service;
+
+struct Requests
+{
+    uint8_t status;
+    uint8_t data[kDataLength];
+    uint8_t ctrl;
+    sfeTkBusRequest read[2];
+    sfeTkBusRequest write;
+};
+
+static void submitVisit(Service &service, Requests &requests, size_t device, uint32_t round)
+{
+    service.submit(requests.read[0]);
+    service.submit(requests.read[1]);
+    nOps += 2;
+    if ((round + device) % 4 == 0)
+    {
+        requests.ctrl = (uint8_t)round;
+        service.submit(requests.write);
+        nOps++;
+    }
+}
+
+static void checkVisit(Requests &requests, size_t device)
+{
+    if (requests.read[0].result() != kSTkErrOk || requests.status != tagOf(device) ||
+        requests.read[1].result() != kSTkErrOk || requests.read[1].transferred != kDataLength)
+        nWrong++;
+}
+
+// bAllPending: each device has a visit pending, and one pass of the service task runs them all. Else one device
+// has a visit pending, and the service task looks at each service in turn to find it.
+static Run runService(sfeTkArdI2C *devices, size_t n, bool bAllPending)
+{
+    std::vector<std::unique_ptr<Service>> services;
+    std::vector<Requests> requests(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        services.emplace_back(new Service(devices[i]));
+        requests[i].read[0].set(kSTkBusOpReadRegisterRegion, kRegStatus, &requests[i].status, 1);
+        requests[i].read[1].set(kSTkBusOpReadRegisterRegion, kRegData, requests[i].data, kDataLength);
+        requests[i].write.set(kSTkBusOpWriteRegisterRegion, kRegCtrl, &requests[i].ctrl, 1);
+    }
+
+    uint32_t rounds = kVisits / n > 0 ? kVisits / n : 1;
+    uint64_t visited = 0;
+    uint64_t start = nanos();
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        if (bAllPending)
+        {
+            for (size_t i = 0; i < n; i++)
+                submitVisit(*services[i], requests[i], i, round);
+            for (size_t i = 0; i < n; i++)
+                services[i]->serviceAll();
+            visited += n;
+        }
+        else
+        {
+            // every device in turn, one at a time
+            for (size_t device = 0; device < n; device++)
+            {
+                submitVisit(*services[device], requests[device], device, round);
+                for (size_t i = 0; i < n; i++)
+                    services[i]->serviceAll();
+            }
+            visited += n;
+        }
+    }
+    double elapsed = (double)(nanos() - start);
+
+    for (size_t i = 0; i < n; i++)
+        checkVisit(requests[i], i);
+    return Run{0, elapsed / visited};
+}
+
+// The highest sample rate a device can have - a visit to every device in the wire time of the busiest bus
+static double wireRate(size_t n)
+{
+    sfeTkBusWire wire = sfeTkBusWire::i2c(kClock);
+    uint32_t bits = wire.bits(true, 1, 1) + wire.bits(true, 1, kDataLength) + wire.bits(false, 1, 1) / 4;
+    size_t busiest = (n + kBuses - 1) / kBuses;
+    return 1e6 / (wire.time(bits) * (double)busiest);
+}
+
+struct Row
+{
+    size_t n;
+    Run busObjects;
+    Run handles;
+    Run reactorAll;
+    Run reactorOne;
+    Run serviceAll;
+    Run serviceOne;
+};
+
+static double growth(double last, double base)
+{
+    return base > 0 ? last / base : 0;
+}
+
+int main()
+{
+    for (size_t b = 0; b < kBuses; b++)
+        buses[b].setClock(kClock);
+    for (size_t i = 0; i < kMaxDevices; i++)
+    {
+        sims[i].setReg(kRegStatus, tagOf(i));
+        busOf(i).attach(addressOf(i), sims[i]);
+    }
+
+    std::unique_ptr<sfeTkArdI2C[]> busObjects(new sfeTkArdI2C[kMaxDevices]);
+    std::unique_ptr<sfeTkArdI2CDevice[]> handles(new sfeTkArdI2CDevice[kMaxDevices]);
+    sfeTkArdI2CPort ports[kBuses];
+    for (size_t b = 0; b < kBuses; b++)
+        ports[b].init(buses[b]);
+    for (size_t i = 0; i < kMaxDevices; i++)
+    {
+        busObjects[i].init(busOf(i), addressOf(i));
+        handles[i].init(ports[i % kBuses], addressOf(i));
+    }
+
+    // the bus objects through sfeTkIBus, as a driver calls them
+    std::unique_ptr<sfeTkIBus *[]> interfaces(new sfeTkIBus *[kMaxDevices]);
+    struct Interface
+    {
+        sfeTkIBus *bus;
+        sfeTkError_t readRegisterByte(uint8_t reg, uint8_t &data)
+        {
+            return bus->readRegisterByte(reg, data);
+        }
+        sfeTkError_t readRegisterRegion(uint8_t reg, uint8_t *data, size_t length, size_t &nRead)
+        {
+            return bus->readRegisterRegion(reg, data, length, nRead);
+        }
+        sfeTkError_t writeRegisterByte(uint8_t reg, uint8_t data)
+        {
+            return bus->writeRegisterByte(reg, data);
+        }
+    };
+    std::unique_ptr<Interface[]> viaIBus(new Interface[kMaxDevices]);
+    for (size_t i = 0; i < kMaxDevices; i++)
+        viaIBus[i].bus = &busObjects[i];
+
+    std::vector<Row> rows;
+    for (size_t n = 1; n <= kMaxDevices; n *= 2)
+    {
+        Row row = {n, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+        for (int run = 0; run < kRuns; run++)
+        {
+            keepBest(row.busObjects, runDirect(viaIBus.get(), n));
+            keepBest(row.handles, runDirect(handles.get(), n));
+            keepBest(row.reactorAll, runReactor(busObjects.get(), n, true));
+            keepBest(row.reactorOne, runReactor(busObjects.get(), n, false));
+            keepBest(row.serviceAll, runService(busObjects.get(), n, true));
+            keepBest(row.serviceOne, runService(busObjects.get(), n, false));
+        }
+        rows.push_back(row);
+    }
+
+    printf("%zu buses at %lu kHz, %zu visits a run - a visit is a status byte read, a %zu byte read and every\n",
+           kBuses, (unsigned long)(kClock / 1000), (size_t)kVisits, kDataLength);
+    printf("fourth visit a register write. ns per bus operation (direct), and scheduling overhead in ns per visit\n\n");
+    printf("  %5s %9s %9s | %9s %9s | %9s %9s\n", "", "bus", "device", "reactor", "reactor", "service", "service");
+    printf("  %5s %9s %9s | %9s %9s | %9s %9s\n", "N", "objects", "handles", "all due", "one due", "all pend",
+           "one pend");
+    for (const Row &row : rows)
+    {
+        double direct = row.busObjects.perVisit;
+        printf("  %5zu %9.1f %9.1f | %+9.1f %+9.1f | %+9.1f %+9.1f\n", row.n, row.busObjects.perOp, row.handles.perOp,
+               row.reactorAll.perVisit - direct, row.reactorOne.perVisit - direct, row.serviceAll.perVisit - direct,
+               row.serviceOne.perVisit - direct);
+    }
+
+    // growth - the largest N with the column against N = 8
+    const Row &base = rows[3];
+    const Row &last = rows.back();
+    printf("\n  growth, N = %zu against N = %zu:\n", last.n, base.n);
+    printf("    bus objects %.2fx, device handles %.2fx, per operation\n",
+           growth(last.busObjects.perOp, base.busObjects.perOp), growth(last.handles.perOp, base.handles.perOp));
+    printf("    reactor all due %.2fx, one due %.2fx, per visit\n",
+           growth(last.reactorAll.perVisit, base.reactorAll.perVisit),
+           growth(last.reactorOne.perVisit, base.reactorOne.perVisit));
+    printf("    service all pending %.2fx, one pending %.2fx, per visit\n",
+           growth(last.serviceAll.perVisit, base.serviceAll.perVisit),
+           growth(last.serviceOne.perVisit, base.serviceOne.perVisit));
+    printf("  A reactor pass reads the clock and looks at every handler, and a task servicing a service for each\n");
+    printf("  device looks at every service - with one visit due, the overhead of a visit grows with N.\n");
+
+    // RAM - the toolkit objects of each arrangement, per device
+    printf("\nToolkit RAM per device, bytes (host sizes - pointers are half the size on a 32 bit target):\n\n");
+    printf("  %5s %9s %9s %9s %9s %14s\n", "N", "bus obj", "handles", "reactor", "service", "max rate Hz");
+    for (const Row &row : rows)
+    {
+        size_t nPorts = row.n < kBuses ? row.n : kBuses;
+        double handleBytes = sizeof(sfeTkArdI2CDevice) + (double)(nPorts * sizeof(sfeTkArdI2CPort)) / row.n;
+        printf("  %5zu %9zu %9.1f %9zu %9zu %14.0f\n", row.n, sizeof(sfeTkArdI2C), handleBytes,
+               sizeof(sfeTkArdI2C) + sizeof(Reactor) / kMaxDevices,
+               sizeof(sfeTkArdI2C) + sizeof(Service) + sizeof(Requests), wireRate(row.n));
+    }
+    printf("  (reactor: the bus object and a handler slot; service: the bus object, its service and the requests\n");
+    printf("   of a visit; max rate: a visit to every device on the busiest bus, wire time only)\n");
+
+    for (size_t i = 0; i < kMaxDevices; i++)
+        busOf(i).detach(addressOf(i));
+
+    bool bOk = nWrong == 0 && nOps > 0;
+    printf("\n%u operations, %u wrong\n", (unsigned)nOps, (unsigned)nWrong);
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+#!/usr/bin/env python3
+# footprint.py - reports the code size and RAM footprint of representative toolkit usage
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2023 SparkFun Electronics
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions: The
+# above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+# "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+# NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+# ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+# Builds the tests/test_size* sketches - one I2C device, one SPI device and batched usage over shared
+# port handles - with and without instrumentation (SFE_TK_HOT_PATH_CHECK), and I2C with the phase profiler
+# (SFE_TK_PROFILE_PHASES) and with the warning log sites (SFE_TK_LOG_LEVEL=2), and reports the toolkit's text,
+# rodata, data and bss, and the size of each toolkit symbol.
+#
+#  - Host (always): the sketch is built against the simulated core with the embedded size flags (-Os,
+#    section garbage collection, no exceptions), and the toolkit symbols are read with nm. Only toolkit
+#    symbols are counted, so the simulated core does not skew the result.
+#  - Board (when arduino-cli is installed): the sketch is built for --fqbn. The flash and RAM reported by
+#    the core are shown, and when the board's nm is found the toolkit symbols of the board image are
+#    reported the same way as the host.
+#
+# The Cross-compilation workflow builds the same sketches with enable-deltas-report, so a pull request also
+# shows the per-board size change of each sketch.
+#
+# Run from the repository root:
+#   python3 tests/host/footprint.py [--fqbn arduino:avr:uno] [--symbols] [--baseline file] [--save file]
+
+import argparse
+import glob
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+TARGETS = [
+    ("i2c", "tests/test_size01", []),
+    ("spi", "tests/test_size02", []),
+    ("batched", "tests/test_size03", []),
+    ("i2c+instr", "tests/test_size01", ["SFE_TK_HOT_PATH_CHECK"]),
+    ("spi+instr", "tests/test_size02", ["SFE_TK_HOT_PATH_CHECK"]),
+    ("batched+instr", "tests/test_size03", ["SFE_TK_HOT_PATH_CHECK"]),
+    ("i2c+profile", "tests/test_size01", ["SFE_TK_PROFILE_PHASES"]),
+    ("i2c+log", "tests/test_size01", ["SFE_TK_LOG_LEVEL=2"]),
+]
+
+LIB_SOURCES = ["src/sfeTkArdI2C.cpp", "src/sfeTkArdSPI.cpp", "src/sfeTkArdI2CPort.cpp", "src/sfeTkArdSPIPort.cpp",
+               "src/sfeTkArdProfiler.cpp", "src/sfeTkArdLog.cpp"]
+
+HOST_FLAGS = ["-std=c++17", "-Os", "-fno-exceptions", "-fno-threadsafe-statics", "-ffunction-sections",
+              "-fdata-sections", "-Wl,--gc-sections", "-pthread"]
+
+# toolkit symbols - the sfeTkArd classes and the interfaces they implement
+TOOLKIT_SYMBOL = re.compile(r"\bsfeTk(Ard|II2C|ISPI|IBus|CpuTransfer|Profile|Log)")
+
+# the nm prefix of each board architecture
+NM_PREFIX = {
+    "avr": "avr-",
+    "samd": "arm-none-eabi-",
+    "mbed": "arm-none-eabi-",
+    "apollo3": "arm-none-eabi-",
+    "rp2040": "arm-none-eabi-",
+    "stm32": "arm-none-eabi-",
+    "esp8266": "xtensa-lx106-elf-",
+}
+
+DRIVER = """
+#include "{sketch}"
+int main()
+{{
+    setup();
+    loop();
+    return 0;
+}}
+"""
+
+
+def sketch_file(sketch_dir):
+    return os.path.join(sketch_dir, os.path.basename(os.path.normpath(sketch_dir)) + ".ino")
+
+
+def sketch_objects(sketch_dir):
+    """The names of the toolkit objects the sketch defines - they are counted as toolkit data/bss"""
+    names = set()
+    with open(sketch_file(sketch_dir)) as f:
+        for line in f:
+            m = re.match(r"^\s*sfeTk\w+\s*\*?\s*(\w+)\s*[;(=]", line)
+            if m:
+                names.add(m.group(1))
+    return names
+
+
+def build_host(sketch_dir, defines, workdir):
+    """Build the sketch against the simulated core - returns the image path"""
+    driver = os.path.join(workdir, "driver.cpp")
+    with open(driver, "w") as f:
+        f.write(DRIVER.format(sketch=os.path.abspath(sketch_file(sketch_dir))))
+
+    image = os.path.join(workdir, "image")
+    cmd = ["g++"] + HOST_FLAGS + ["-D" + d for d in defines] + ["-Itests/host/sim", "-Isrc", "-o", image, driver]
+    subprocess.run(cmd + LIB_SOURCES, check=True)
+    return image
+
+
+def toolkit_symbols(image, objects=(), nm="nm"):
+    """The toolkit symbols of an image, and the named objects - a list of (section, size, name), section is
+    text/rodata/data/bss"""
+    out = subprocess.run([nm, "-C", "-S", "--size-sort", image], check=True, capture_output=True, text=True)
+
+    symbols = []
+    for line in out.stdout.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4 or not (TOOLKIT_SYMBOL.search(parts[3]) or parts[3] in objects):
+            continue
+        size, kind, name = int(parts[1], 16), parts[2], parts[3]
+        if kind in "tTwW":
+            section = "text"
+        elif kind in "rRvV":
+            section = "rodata"
+        elif kind in "dDgG":
+            section = "data"
+        elif kind in "bBsS":
+            section = "bss"
+        else:
+            continue
+        symbols.append((section, size, name))
+    return symbols
+
+
+def section_totals(symbols):
+    totals = {"text": 0, "rodata": 0, "data": 0, "bss": 0}
+    for section, size, _ in symbols:
+        totals[section] += size
+    return totals
+
+
+def build_board(sketch_dir, defines, fqbn, build_path):
+    """Build the sketch with arduino-cli - returns (flash, ram) as reported by the core, or None"""
+    cmd = ["arduino-cli", "compile", "--fqbn", fqbn, "--library", ".", "--build-path", build_path, sketch_dir]
+    if defines:
+        cmd += ["--build-property", "compiler.cpp.extra_flags=" + " ".join("-D" + d for d in defines)]
+    out = subprocess.run(cmd, capture_output=True, text=True)
+    if out.returncode != 0:
+        sys.stderr.write(out.stdout + out.stderr)
+        return None
+    flash = re.search(r"Sketch uses (\d+) bytes", out.stdout)
+    ram = re.search(r"Global variables use (\d+) bytes", out.stdout)
+    return (int(flash.group(1)) if flash else 0, int(ram.group(1)) if ram else 0)
+
+
+def board_nm(fqbn):
+    """Find the nm of the board's toolchain - on the path, or installed by the board package"""
+    arch = fqbn.split(":")[1] if ":" in fqbn else fqbn
+    prefix = NM_PREFIX.get(arch, "xtensa-" + arch + "-elf-" if arch.startswith("esp32") else None)
+    if prefix is None:
+        return None
+    if shutil.which(prefix + "nm"):
+        return prefix + "nm"
+    found = glob.glob(os.path.expanduser("~/.arduino15/packages/*/tools/*/*/bin/" + prefix + "nm"))
+    return sorted(found)[-1] if found else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report the toolkit footprint of representative usage")
+    parser.add_argument("--fqbn", default="arduino:avr:uno", help="the board used when arduino-cli is available")
+    parser.add_argument("--symbols", action="store_true", help="list the toolkit symbols of each build")
+    parser.add_argument("--save", help="save the host results to a JSON file")
+    parser.add_argument("--baseline", help="compare the host results to a JSON file saved with --save")
+    args = parser.parse_args()
+
+    use_board = shutil.which("arduino-cli") is not None
+    nm = board_nm(args.fqbn) if use_board else None
+
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    header = "%-14s %6s %6s %6s %6s %7s" % ("target", "text", "rodata", "data", "bss", "delta")
+    print("Host - toolkit sections (bytes)")
+    print(header)
+
+    results = {}
+    board_rows = []
+    with tempfile.TemporaryDirectory() as workdir:
+        for name, sketch, defines in TARGETS:
+            symbols = toolkit_symbols(build_host(sketch, defines, workdir), sketch_objects(sketch))
+            totals = section_totals(symbols)
+            results[name] = totals
+
+            flash = totals["text"] + totals["rodata"] + totals["data"]
+            delta = ""
+            if name in baseline:
+                old = baseline[name]
+                delta = "%+d" % (flash - (old["text"] + old["rodata"] + old["data"]))
+            print("%-14s %6d %6d %6d %6d %7s" % (name, totals["text"], totals["rodata"], totals["data"],
+                                                 totals["bss"], delta))
+            if args.symbols:
+                for section, size, sym in sorted(symbols, key=lambda s: -s[1]):
+                    print("    %-6s %6d  %s" % (section, size, sym))
+
+            if use_board:
+                build_path = os.path.join(workdir, "board-" + re.sub(r"\W", "_", name))
+                board_rows.append((name, sketch, build_board(sketch, defines, args.fqbn, build_path), build_path))
+
+        # the board images are in the work folder, report them before it is removed
+        if use_board:
+            print()
+            print("Board %s - image flash/RAM, and toolkit sections (bytes)" % args.fqbn)
+            print("%-14s %7s %7s %6s %6s %6s %6s" % ("target", "flash", "ram", "text", "rodata", "data", "bss"))
+            for name, sketch, sizes, build_path in board_rows:
+                if sizes is None:
+                    print("%-14s %7s" % (name, "failed"))
+                    continue
+                line = "%-14s %7d %7d" % (name, sizes[0], sizes[1])
+                elf = glob.glob(os.path.join(build_path, "*.elf"))
+                if nm and elf:
+                    totals = section_totals(toolkit_symbols(elf[0], sketch_objects(sketch), nm))
+                    line += " %6d %6d %6d %6d" % (totals["text"], totals["rodata"], totals["data"], totals["bss"])
+                print(line)
+        else:
+            print()
+            print("Board - arduino-cli not found, skipped")
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(results, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,113 @@
+// ExampleImuRegs.h
+//
+// The register map of the ExampleImu - generated by tools/sfeTkRegGen.py from sfeExampleImu.json. Do not edit.
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <sfeTk/sfeTkRegister.h>
+
+/** The default I2C address */
+const uint8_t kExampleImuAddress = 0x6A;
+
+// Registers
+/** Device id */
+constexpr sfeTkRegister kExampleImuRegWhoAmI = {0x0F, 1, kSTkRegReadOnly, 0, 0, 0x6B};
+/** Data rate and scale */
+constexpr sfeTkRegister kExampleImuRegCtrl1 = {0x10, 1, kSTkRegReadWrite, 0, 1, 0x00};
+/** Interface control */
+constexpr sfeTkRegister kExampleImuRegCtrl2 = {0x11, 1, kSTkRegReadWrite, 0, 2, 0x04};
+/** Interrupt pin */
+constexpr sfeTkRegister kExampleImuRegIntCfg = {0x12, 1, kSTkRegWriteOnly, 0, 3, 0x00};
+/** Wake threshold */
+constexpr sfeTkRegister kExampleImuRegThreshold = {0x13, 2, kSTkRegReadWrite, 0, 4, 0x0100};
+/** Data status */
+constexpr sfeTkRegister kExampleImuRegStatus = {0x1E, 1, kSTkRegReadOnly, kSTkRegVolatile, kSTkRegNoShadow, 0x00};
+constexpr sfeTkRegister kExampleImuRegTemp = {0x20, 2, kSTkRegReadOnly, kSTkRegVolatile, kSTkRegNoShadow, 0x0000};
+constexpr sfeTkRegister kExampleImuRegOutX = {0x22, 2, kSTkRegReadOnly, kSTkRegVolatile, kSTkRegNoShadow, 0x0000};
+constexpr sfeTkRegister kExampleImuRegOutY = {0x24, 2, kSTkRegReadOnly, kSTkRegVolatile, kSTkRegNoShadow, 0x0000};
+constexpr sfeTkRegister kExampleImuRegOutZ = {0x26, 2, kSTkRegReadOnly, kSTkRegVolatile, kSTkRegNoShadow, 0x0000};
+/** Sample time, high byte first */
+constexpr sfeTkRegister kExampleImuRegTimestamp =
+    {0x40, 3, kSTkRegReadOnly, kSTkRegVolatile | kSTkRegBigEndian, kSTkRegNoShadow, 0x000000};
+
+// Fields
+/** Output data rate */
+constexpr sfeTkRegField kExampleImuCtrl1Odr = {kExampleImuRegCtrl1, 4, 4};
+/** Full scale */
+constexpr sfeTkRegField kExampleImuCtrl1Fs = {kExampleImuRegCtrl1, 2, 2};
+/** Low pass filter enable */
+constexpr sfeTkRegField kExampleImuCtrl1Lpf = {kExampleImuRegCtrl1, 1, 1};
+/** Block data update */
+constexpr sfeTkRegField kExampleImuCtrl2Bdu = {kExampleImuRegCtrl2, 6, 1};
+/** Register address auto increment */
+constexpr sfeTkRegField kExampleImuCtrl2IfInc = {kExampleImuRegCtrl2, 2, 1};
+/** Software reset */
+constexpr sfeTkRegField kExampleImuCtrl2SwReset = {kExampleImuRegCtrl2, 0, 1};
+/** Data ready on the interrupt pin */
+constexpr sfeTkRegField kExampleImuIntCfgDrdyEn = {kExampleImuRegIntCfg, 0, 1};
+/** Active low */
+constexpr sfeTkRegField kExampleImuIntCfgPolarity = {kExampleImuRegIntCfg, 1, 1};
+constexpr sfeTkRegField kExampleImuThresholdLevel = {kExampleImuRegThreshold, 0, 12};
+/** New sample available */
+constexpr sfeTkRegField kExampleImuStatusDrdy = {kExampleImuRegStatus, 0, 1};
+
+// Burst groups - read with sfeTkRegReadBurst(), or as a transaction step with sfeTkRegBurstStep()
+constexpr sfeTkRegBurst kExampleImuBurstSample = {0x20, 8, 0};
+const size_t kExampleImuBurstSampleLength = 8;
+static_assert(kExampleImuBurstSample.contains(kExampleImuRegTemp), "Temp is in burst Sample");
+static_assert(kExampleImuBurstSample.contains(kExampleImuRegOutX), "OutX is in burst Sample");
+static_assert(kExampleImuBurstSample.contains(kExampleImuRegOutY), "OutY is in burst Sample");
+static_assert(kExampleImuBurstSample.contains(kExampleImuRegOutZ), "OutZ is in burst Sample");
+constexpr sfeTkRegBurst kExampleImuBurstStatusSample = {0x1E, 10, 0};
+const size_t kExampleImuBurstStatusSampleLength = 10;
+static_assert(kExampleImuBurstStatusSample.contains(kExampleImuRegStatus), "Status is in burst StatusSample");
+static_assert(kExampleImuBurstStatusSample.contains(kExampleImuRegTemp), "Temp is in burst StatusSample");
+static_assert(kExampleImuBurstStatusSample.contains(kExampleImuRegOutX), "OutX is in burst StatusSample");
+static_assert(kExampleImuBurstStatusSample.contains(kExampleImuRegOutY), "OutY is in burst StatusSample");
+static_assert(kExampleImuBurstStatusSample.contains(kExampleImuRegOutZ), "OutZ is in burst StatusSample");
+constexpr sfeTkRegBurst kExampleImuBurstConfig = {0x10, 2, 0};
+const size_t kExampleImuBurstConfigLength = 2;
+static_assert(kExampleImuBurstConfig.contains(kExampleImuRegCtrl1), "Ctrl1 is in burst Config");
+static_assert(kExampleImuBurstConfig.contains(kExampleImuRegCtrl2), "Ctrl2 is in burst Config");
+
+// All registers, in address order - for sfeTkRegShadow::loadReset()
+constexpr sfeTkRegister kExampleImuRegisters[] = {
+    kExampleImuRegWhoAmI,
+    kExampleImuRegCtrl1,
+    kExampleImuRegCtrl2,
+    kExampleImuRegIntCfg,
+    kExampleImuRegThreshold,
+    kExampleImuRegStatus,
+    kExampleImuRegTemp,
+    kExampleImuRegOutX,
+    kExampleImuRegOutY,
+    kExampleImuRegOutZ,
+    kExampleImuRegTimestamp,
+};
+const size_t kExampleImuRegisterCount = 11;
+
+// The shadow cache - 6 bytes for 5 registers the device does not change
+const size_t kExampleImuShadowSize = 6;
+typedef sfeTkRegShadow<kExampleImuShadowSize> sfeExampleImuShadow_t;
@@ -0,0 +1,100 @@
+// Arduino.h - host simulation of the Arduino core, for host testing of the SparkFun Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+// Only the parts of the Arduino core used by the toolkit are simulated. Time is real (steady clock) time.
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+
+#define LOW 0x0
+#define HIGH 0x1
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+typedef uint8_t byte;
+
+namespace sfeTkSim
+{
+/** Called on every digitalWrite() - used by the simulated SPI port to track chip selects */
+inline void (*pinListener)(uint8_t pin, uint8_t val) = nullptr;
+
+inline std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+/** Wait for the given number of nanoseconds - used to model wire time. Yields, so other threads run meanwhile */
+inline void spinNanos(uint64_t nanos)
+{
+    auto end = std::chrono::steady_clock::now() + std::chrono::nanoseconds(nanos);
+    while (std::chrono::steady_clock::now() < end)
+        std::this_thread::yield();
+}
+} // namespace sfeTkSim
+
+inline unsigned long micros(void)
+{
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                                sfeTkSim::startTime)
+        .count();
+}
+
+inline unsigned long millis(void)
+{
+    return micros() / 1000;
+}
+
+inline void delay(unsigned long ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void delayMicroseconds(unsigned int us)
+{
+    sfeTkSim::spinNanos((uint64_t)us * 1000);
+}
+
+inline void pinMode(uint8_t, uint8_t)
+{
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (sfeTkSim::pinListener)
+        sfeTkSim::pinListener(pin, val);
+}
+
+inline void noInterrupts(void)
+{
+}
+
+inline void interrupts(void)
+{
+}
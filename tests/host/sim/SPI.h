@@ -0,0 +1,176 @@
+// SPI.h - host simulation of the Arduino SPI library, for host testing of the SparkFun Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Arduino.h"
+#include "sfeTkSimDevice.h"
+
+#include <map>
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+class SPISettings
+{
+  public:
+    SPISettings() : _clock{4000000}, _bitOrder{MSBFIRST}, _dataMode{SPI_MODE0}
+    {
+    }
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+        : _clock{clock}, _bitOrder{bitOrder}, _dataMode{dataMode}
+    {
+    }
+
+    uint32_t clock(void) const
+    {
+        return _clock;
+    }
+
+  private:
+    uint32_t _clock;
+    uint8_t _bitOrder;
+    uint8_t _dataMode;
+};
+
+namespace sfeTkSim
+{
+/** Simulated SPI devices by chip select pin - shared by all SPI ports */
+inline std::map<uint8_t, sfeTkSimDevice *> spiDevices;
+
+/** The device that currently has its chip select low */
+inline sfeTkSimDevice *spiSelected = nullptr;
+
+inline void spiPinListener(uint8_t pin, uint8_t val)
+{
+    auto it = spiDevices.find(pin);
+    if (it == spiDevices.end())
+        return;
+
+    if (val == LOW)
+    {
+        spiSelected = it->second;
+        spiSelected->beginFrame();
+    }
+    else if (spiSelected == it->second)
+        spiSelected = nullptr;
+}
+} // namespace sfeTkSim
+
+/**
+ * @brief A simulated SPI port. Devices are attached to a chip select pin, digitalWrite() on that pin
+ *        selects the device.
+ */
+class SPIClass
+{
+  public:
+    SPIClass() : _clock{4000000}, _realTime{false}, _busyNanos{0}, _nTransactions{0}
+    {
+    }
+
+    void begin(void)
+    {
+    }
+
+    void beginTransaction(SPISettings settings)
+    {
+        _clock = settings.clock();
+        _nTransactions++;
+    }
+
+    void endTransaction(void)
+    {
+    }
+
+    uint8_t transfer(uint8_t value)
+    {
+        wireTime(1);
+        return exchange(value);
+    }
+
+    void transfer(void *buffer, size_t count)
+    {
+        // the wire time of a block is spent in one go, as a FIFO or DMA driven core would
+        wireTime(count);
+        uint8_t *data = static_cast<uint8_t *>(buffer);
+        for (size_t i = 0; i < count; i++)
+            data[i] = exchange(data[i]);
+    }
+
+    uint16_t transfer16(uint16_t value)
+    {
+        uint16_t msb = transfer((uint8_t)(value >> 8));
+        return (uint16_t)((msb << 8) | transfer((uint8_t)(value & 0xFF)));
+    }
+
+    // Simulation control
+    void attach(uint8_t csPin, sfeTkSimDevice &device)
+    {
+        sfeTkSim::spiDevices[csPin] = &device;
+        sfeTkSim::pinListener = sfeTkSim::spiPinListener;
+    }
+
+    void detach(uint8_t csPin)
+    {
+        sfeTkSim::spiDevices.erase(csPin);
+    }
+
+    void setRealTime(bool realTime)
+    {
+        _realTime = realTime;
+    }
+
+    uint64_t busyNanos(void) const
+    {
+        return _busyNanos;
+    }
+
+    uint32_t nTransactions(void) const
+    {
+        return _nTransactions;
+    }
+
+  private:
+    uint8_t exchange(uint8_t value)
+    {
+        return sfeTkSim::spiSelected ? sfeTkSim::spiSelected->spiTransfer(value) : 0xFF;
+    }
+
+    void wireTime(size_t nBytes)
+    {
+        uint64_t nanos = (uint64_t)nBytes * 8 * 1000000000ull / _clock;
+        _busyNanos += nanos;
+        if (_realTime)
+            sfeTkSim::spinNanos(nanos);
+    }
+
+    uint32_t _clock;
+    bool _realTime;
+    uint64_t _busyNanos;
+    uint32_t _nTransactions;
+};
+
+inline SPIClass SPI;
@@ -0,0 +1,223 @@
+// Wire.h - host simulation of the Arduino Wire (I2C) library, for host testing of the SparkFun Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include "Arduino.h"
+#include "sfeTkSimDevice.h"
+
+#include <map>
+
+// The size of the transmit and receive buffers - fixed, as in the Arduino cores (32 on AVR, 128 on most others)
+#ifndef BUFFER_LENGTH
+#define BUFFER_LENGTH 128
+#endif
+
+/**
+ * @brief A simulated I2C port. Devices are attached at an address, and transactions are routed to them.
+ *
+ * Wire time is accounted from the clock rate (9 bits per byte, plus start and stop), and optionally spent
+ * in real time (setRealTime()) so throughput and latency measurements reflect a real bus. A device with clock
+ * errors (sfeTkSimDevice::setClockErrors()) NACKs a corrupted address byte, and gets or returns a corrupted data
+ * byte with a bit flipped.
+ *
+ * Like the Arduino cores, the buffers are fixed (BUFFER_LENGTH) - writes beyond the buffer are dropped, and
+ * requestFrom() is limited to the buffer - and no transaction allocates memory.
+ */
+class TwoWire
+{
+  public:
+    TwoWire()
+        : _clock{100000}, _realTime{false}, _txAddress{0}, _txLength{0}, _rxLength{0}, _rxIndex{0}, _busyNanos{0},
+          _nTransactions{0}, _nStops{0}
+    {
+    }
+
+    void begin(void)
+    {
+    }
+
+    void setClock(uint32_t clock)
+    {
+        _clock = clock;
+    }
+
+    uint32_t clock(void) const
+    {
+        return _clock;
+    }
+
+    void beginTransmission(uint8_t address)
+    {
+        _txAddress = address;
+        _txLength = 0;
+    }
+
+    void beginTransmission(int address)
+    {
+        beginTransmission((uint8_t)address);
+    }
+
+    size_t write(uint8_t value)
+    {
+        if (_txLength >= BUFFER_LENGTH)
+            return 0;
+
+        _txBuffer[_txLength++] = value;
+        return 1;
+    }
+
+    size_t write(const uint8_t *data, size_t length)
+    {
+        size_t n = 0;
+        while (n < length && write(data[n]))
+            n++;
+        return n;
+    }
+
+    uint8_t endTransmission(bool sendStop = true)
+    {
+        _nTransactions++;
+        wireTime(_txLength + 1, sendStop);
+
+        sfeTkSimDevice *device = find(_txAddress);
+        if (!device || device->byteError(_clock))
+        {
+            _txLength = 0;
+            return 2; // NACK on address
+        }
+
+        device->beginFrame();
+        for (size_t i = 0; i < _txLength; i++)
+            device->i2cWrite(device->byteError(_clock) ? device->corrupt(_txBuffer[i]) : _txBuffer[i]);
+
+        _txLength = 0;
+        return 0;
+    }
+
+    size_t requestFrom(int address, int quantity, int sendStop = 1)
+    {
+        _nTransactions++;
+        _rxLength = 0;
+        _rxIndex = 0;
+        if (quantity > BUFFER_LENGTH)
+            quantity = BUFFER_LENGTH;
+
+        sfeTkSimDevice *device = find((uint8_t)address);
+        if (device && device->byteError(_clock))
+            device = nullptr; // NACK on address
+        wireTime(device ? quantity + 1 : 1, sendStop != 0);
+        if (!device)
+            return 0;
+
+        for (int i = 0; i < quantity; i++)
+        {
+            uint8_t value = device->i2cRead();
+            _rxBuffer[_rxLength++] = device->byteError(_clock) ? device->corrupt(value) : value;
+        }
+
+        return _rxLength;
+    }
+
+    int available(void)
+    {
+        return (int)(_rxLength - _rxIndex);
+    }
+
+    int read(void)
+    {
+        if (_rxIndex >= _rxLength)
+            return -1;
+
+        return _rxBuffer[_rxIndex++];
+    }
+
+    // Simulation control
+    void attach(uint8_t address, sfeTkSimDevice &device)
+    {
+        _devices[address] = &device;
+    }
+
+    void detach(uint8_t address)
+    {
+        _devices.erase(address);
+    }
+
+    void setRealTime(bool realTime)
+    {
+        _realTime = realTime;
+    }
+
+    uint64_t busyNanos(void) const
+    {
+        return _busyNanos;
+    }
+
+    uint32_t nTransactions(void) const
+    {
+        return _nTransactions;
+    }
+
+    // the number of stops sent - a transaction joined with repeated starts sends one
+    uint32_t nStops(void) const
+    {
+        return _nStops;
+    }
+
+  private:
+    sfeTkSimDevice *find(uint8_t address)
+    {
+        auto it = _devices.find(address);
+        return it == _devices.end() ? nullptr : it->second;
+    }
+
+    void wireTime(size_t nBytes, bool sendStop)
+    {
+        // 9 clocks a byte (8 data + ack), ~1 clock for the start or repeated start and ~1 for the stop
+        if (sendStop)
+            _nStops++;
+        uint64_t nanos = ((uint64_t)nBytes * 9 + (sendStop ? 2 : 1)) * 1000000000ull / _clock;
+        _busyNanos += nanos;
+        if (_realTime)
+            sfeTkSim::spinNanos(nanos);
+    }
+
+    uint32_t _clock;
+    bool _realTime;
+
+    uint8_t _txAddress;
+    uint8_t _txBuffer[BUFFER_LENGTH];
+    size_t _txLength;
+    uint8_t _rxBuffer[BUFFER_LENGTH];
+    size_t _rxLength;
+    size_t _rxIndex;
+
+    std::map<uint8_t, sfeTkSimDevice *> _devices;
+
+    uint64_t _busyNanos;
+    uint32_t _nTransactions;
+    uint32_t _nStops;
+};
+
+inline TwoWire Wire;
@@ -0,0 +1,116 @@
+// sfeTkSimDMA.h - a simulated DMA asynchronous transfer backend, for host testing of the SparkFun Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <sfeTk/sfeTkIAsyncTransfer.h>
+
+/**
+ * @brief A simulated DMA engine - transfers run on a separate thread, and complete from that thread.
+ *
+ * The transfer itself uses the bus's CPU methods on the simulated core, so set the simulated port to real
+ * time to model a transfer that takes wire time while the application thread keeps running.
+ */
+class sfeTkSimDMA : public sfeTkIAsyncTransfer
+{
+  public:
+    sfeTkSimDMA() : _bus{nullptr}, _request{nullptr}, _running{true}, _nTransfers{0}
+    {
+        _thread = std::thread(&sfeTkSimDMA::run, this);
+    }
+
+    ~sfeTkSimDMA()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _wakeup.notify_one();
+        _thread.join();
+    }
+
+    sfeTkError_t start(sfeTkIBus &bus, sfeTkBusRequest &request)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_request)
+            return kSTkErrBusQueueFull;
+
+        request.transferred = 0;
+        __atomic_store_n(&request.status, kSTkErrBusPending, __ATOMIC_RELEASE);
+        _bus = &bus;
+        _request = &request;
+        _wakeup.notify_one();
+        return kSTkErrOk;
+    }
+
+    bool busy(void)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _request != nullptr;
+    }
+
+    uint32_t nTransfers(void) const
+    {
+        return _nTransfers;
+    }
+
+  private:
+    void run(void)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;)
+        {
+            _wakeup.wait(lock, [this] { return _request != nullptr || !_running; });
+            if (!_running)
+                return;
+
+            sfeTkBusRequest *request = _request;
+            sfeTkIBus *bus = _bus;
+
+            lock.unlock();
+            sfeTkError_t status = sfeTkBusExecute(*bus, *request);
+            lock.lock();
+
+            // free the engine before completing, so the completion callback can start the next transfer
+            _request = nullptr;
+            _nTransfers++;
+
+            lock.unlock();
+            request->complete(status);
+            lock.lock();
+        }
+    }
+
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _wakeup;
+
+    sfeTkIBus *_bus;
+    sfeTkBusRequest *_request;
+    bool _running;
+    uint32_t _nTransfers;
+};
@@ -0,0 +1,214 @@
+// sfeTkSimDevice.h - a simulated register based device for host testing of the SparkFun Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief A simulated device - a register file with an auto-incrementing register pointer.
+ *
+ * I2C: The first addrBytes of a write set the register pointer (MSB first), any following bytes are written
+ *      to the registers. Reads return registers from the pointer.
+ *
+ * SPI: The first byte (or 16 bit word) of a frame is the register, with 0x80 set for a read. The following
+ *      transfers read or write registers from there.
+ *
+ * Sub-classes override onRead()/onWrite() to model volatile registers (data, FIFOs, status).
+ *
+ * setClockErrors() models the signal integrity of the wiring to the device - bytes sent on the I2C bus faster than
+ * the pull-ups and the wiring allow are corrupted, at a rate that rises with the clock.
+ */
+class sfeTkSimDevice
+{
+  public:
+    sfeTkSimDevice(size_t nRegisters = 256, uint8_t addrBytes = 1)
+        : _regs(nRegisters, 0), _addrBytes{addrBytes}, _pointer{0}, _nAddr{0}, _spiRead{false}, _nFrames{0},
+          _nReadBytes{0}, _nWriteBytes{0}, _goodClock{0}, _badClock{0}, _seed{1}, _nByteErrors{0}
+    {
+    }
+
+    virtual ~sfeTkSimDevice() = default;
+
+    uint8_t reg(uint16_t theReg) const
+    {
+        return _regs[theReg % _regs.size()];
+    }
+
+    void setReg(uint16_t theReg, uint8_t value)
+    {
+        _regs[theReg % _regs.size()] = value;
+    }
+
+    size_t size(void) const
+    {
+        return _regs.size();
+    }
+
+    uint8_t addrBytes(void) const
+    {
+        return _addrBytes;
+    }
+
+    // Bus side - a frame is an I2C start...stop or an SPI CS low...high
+    void beginFrame(void)
+    {
+        _nAddr = 0;
+        _nFrames++;
+    }
+
+    // I2C write phase byte
+    void i2cWrite(uint8_t value)
+    {
+        if (_nAddr < _addrBytes)
+        {
+            _pointer = _nAddr == 0 ? value : (uint16_t)((_pointer << 8) | value);
+            _nAddr++;
+            return;
+        }
+        _nWriteBytes++;
+        onWrite(_pointer, value);
+        _pointer = (uint16_t)((_pointer + 1) % _regs.size());
+    }
+
+    // I2C read phase byte
+    uint8_t i2cRead(void)
+    {
+        _nReadBytes++;
+        uint8_t value = onRead(_pointer);
+        _pointer = (uint16_t)((_pointer + 1) % _regs.size());
+        return value;
+    }
+
+    // SPI full duplex byte
+    uint8_t spiTransfer(uint8_t value)
+    {
+        if (_nAddr < _addrBytes)
+        {
+            _pointer = _nAddr == 0 ? value : (uint16_t)((_pointer << 8) | value);
+            if (++_nAddr == _addrBytes)
+            {
+                _spiRead = (_pointer & 0x80) != 0;
+                _pointer = (uint16_t)((_pointer & ~0x80) % _regs.size());
+            }
+            return 0;
+        }
+        if (_spiRead)
+            return i2cRead();
+
+        i2cWrite(value);
+        return 0;
+    }
+
+    uint32_t nFrames(void) const
+    {
+        return _nFrames;
+    }
+    uint32_t nReadBytes(void) const
+    {
+        return _nReadBytes;
+    }
+    uint32_t nWriteBytes(void) const
+    {
+        return _nWriteBytes;
+    }
+
+    // Signal integrity - the chance a byte is corrupted is none at or below goodClock, rising in a straight line to
+    // every byte at badClock. goodClock 0 turns the errors off.
+    void setClockErrors(uint32_t goodClock, uint32_t badClock, uint32_t seed = 1)
+    {
+        _goodClock = goodClock;
+        _badClock = badClock > goodClock ? badClock : goodClock + 1;
+        _seed = seed ? seed : 1;
+        _nByteErrors = 0;
+    }
+
+    // The chance of a byte error at a clock, in parts per million
+    uint32_t errorPpm(uint32_t clock) const
+    {
+        if (_goodClock == 0 || clock <= _goodClock)
+            return 0;
+        if (clock >= _badClock)
+            return 1000000;
+        return (uint32_t)((uint64_t)(clock - _goodClock) * 1000000 / (_badClock - _goodClock));
+    }
+
+    // Bus side - is a byte at the clock corrupted?
+    bool byteError(uint32_t clock)
+    {
+        uint32_t ppm = errorPpm(clock);
+        if (ppm == 0)
+            return false;
+
+        // xorshift32
+        _seed ^= _seed << 13;
+        _seed ^= _seed >> 17;
+        _seed ^= _seed << 5;
+        if (_seed % 1000000 >= ppm)
+            return false;
+        _nByteErrors++;
+        return true;
+    }
+
+    // A bit of a corrupted byte flipped
+    uint8_t corrupt(uint8_t value)
+    {
+        return (uint8_t)(value ^ (1 << ((_seed >> 8) % 8)));
+    }
+
+    uint32_t nByteErrors(void) const
+    {
+        return _nByteErrors;
+    }
+
+  protected:
+    virtual uint8_t onRead(uint16_t theReg)
+    {
+        return _regs[theReg];
+    }
+
+    virtual void onWrite(uint16_t theReg, uint8_t value)
+    {
+        _regs[theReg] = value;
+    }
+
+    std::vector<uint8_t> _regs;
+
+  private:
+    uint8_t _addrBytes;
+    uint16_t _pointer;
+    uint8_t _nAddr;
+    bool _spiRead;
+
+    uint32_t _nFrames;
+    uint32_t _nReadBytes;
+    uint32_t _nWriteBytes;
+
+    uint32_t _goodClock;
+    uint32_t _badClock;
+    uint32_t _seed;
+    uint32_t _nByteErrors;
+};
@@ -0,0 +1,103 @@
+// sfeTkSimInterrupt.h - a simulated interrupt source, for host testing of the SparkFun Toolkit
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+/**
+ * @brief A simulated interrupt line - a thread that calls a handler at a period, with random jitter, like a
+ * sensor raising data ready. The handler runs on that thread, so it preempts the application thread the way an
+ * interrupt would - with the difference that both can run at once on a host.
+ */
+class sfeTkSimInterrupt
+{
+  public:
+    typedef void (*Handler)(void *context);
+
+    sfeTkSimInterrupt() : _bRunning{false}, _count{0}
+    {
+    }
+
+    ~sfeTkSimInterrupt()
+    {
+        stop();
+    }
+
+    /**
+        @brief Start raising the interrupt
+
+        @param handler The interrupt handler
+        @param context Passed to the handler
+        @param periodMicros The time between interrupts
+        @param jitterMicros Each interrupt is late by a random time up to this
+        @param seed The seed of the jitter - the same seed gives the same sequence
+    */
+    void start(Handler handler, void *context, uint32_t periodMicros, uint32_t jitterMicros = 0, uint32_t seed = 1)
+    {
+        stop();
+        _count = 0;
+        _bRunning = true;
+        _thread = std::thread([=]() {
+            std::minstd_rand random(seed);
+            auto next = std::chrono::steady_clock::now();
+            while (_bRunning)
+            {
+                next += std::chrono::microseconds(periodMicros);
+                auto at = next + std::chrono::microseconds(jitterMicros > 0 ? random() % jitterMicros : 0);
+
+                // spin the last part - sleeping alone is too coarse for the period. Yields, so the application
+                // thread keeps running on a single core host
+                std::this_thread::sleep_until(at - std::chrono::microseconds(200));
+                while (std::chrono::steady_clock::now() < at)
+                    std::this_thread::yield();
+                if (!_bRunning)
+                    break;
+                handler(context);
+                _count++;
+            }
+        });
+    }
+
+    /** Stop raising the interrupt */
+    void stop()
+    {
+        _bRunning = false;
+        if (_thread.joinable())
+            _thread.join();
+    }
+
+    /** The number of interrupts raised */
+    uint32_t count() const
+    {
+        return _count;
+    }
+
+  private:
+    std::atomic<bool> _bRunning;
+    std::atomic<uint32_t> _count;
+    std::thread _thread;
+};
@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# size_configs.py - reports the flash and RAM used by the toolkit for each feature configuration
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2023 SparkFun Electronics
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions: The
+# above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+# "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+# NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+# ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+# Each configuration of the SFE_TK_ENABLE_* options (see src/sfeTk/sfeTkConfig.h) is built with the
+# tests/test_size01 sketch, and the toolkit's share of the image is reported.
+#
+#  - Host model (always): the sketch is built against the simulated core with the embedded size flags
+#    (-Os, section garbage collection, no exceptions). Only toolkit symbols are counted, so the simulated
+#    core does not skew the result. The numbers are for the host ABI - use them to compare configurations.
+#  - Board (when arduino-cli is installed): the sketch is built for --fqbn, and the sketch and global
+#    variable sizes reported by the core are shown.
+#
+# Run from the repository root:
+#   python3 tests/host/size_configs.py [--fqbn arduino:avr:uno] [--sketch tests/test_size01]
+
+import argparse
+import os
+import shutil
+import sys
+import tempfile
+
+from footprint import build_board, build_host, section_totals, sketch_objects, toolkit_symbols
+
+CONFIGS = [
+    ("default", []),
+    ("no-16bit", ["SFE_TK_ENABLE_16BIT_REGISTERS=0"]),
+    ("no-word", ["SFE_TK_ENABLE_WORD_OPS=0"]),
+    ("no-async", ["SFE_TK_ENABLE_ASYNC=0"]),
+    ("txn", ["SFE_TK_ENABLE_TRANSACTIONS=1"]),
+    ("minimal", ["SFE_TK_ENABLE_16BIT_REGISTERS=0", "SFE_TK_ENABLE_WORD_OPS=0", "SFE_TK_ENABLE_ASYNC=0"]),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report toolkit flash/RAM for each SFE_TK_ENABLE_* configuration")
+    parser.add_argument("--sketch", default="tests/test_size01", help="the sketch folder to build")
+    parser.add_argument("--fqbn", default="arduino:avr:uno", help="the board used when arduino-cli is available")
+    parser.add_argument("--symbols", action="store_true", help="list the toolkit symbols of each configuration")
+    args = parser.parse_args()
+
+    use_board = shutil.which("arduino-cli") is not None
+
+    print("Sketch: %s" % args.sketch)
+    print("Host model - toolkit code, vtables/typeinfo, and toolkit objects (bytes)")
+    if use_board:
+        print("Board %s - sketch flash and global RAM (bytes)" % args.fqbn)
+    else:
+        print("Board      - arduino-cli not found, skipped")
+    print()
+
+    header = "%-10s %8s %8s %8s %8s" % ("config", "code", "vtables", "flash", "ram")
+    if use_board:
+        header += " %10s %10s" % ("brd flash", "brd ram")
+    print(header)
+
+    base = None
+    with tempfile.TemporaryDirectory() as workdir:
+        for name, defines in CONFIGS:
+            symbols = toolkit_symbols(build_host(args.sketch, defines, workdir), sketch_objects(args.sketch))
+            totals = section_totals(symbols)
+            text, rodata, ram = totals["text"], totals["rodata"], totals["data"] + totals["bss"]
+            flash = text + rodata
+            if base is None:
+                base = flash
+            line = "%-10s %8d %8d %8d %8d" % (name, text, rodata, flash, ram)
+            if use_board:
+                board = build_board(args.sketch, defines, args.fqbn, os.path.join(workdir, "board-" + name))
+                line += " %10s %10s" % board if board else " %10s %10s" % ("fail", "fail")
+            line += "   (%+d)" % (flash - base)
+            print(line)
+
+            if args.symbols:
+                for _, size, sym in sorted(symbols, key=lambda s: -s[1]):
+                    print("    %6d  %s" % (size, sym))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,143 @@
+// test_async_transfer.cpp - host test of the asynchronous transfer backends
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o test_async_transfer
+//       tests/host/test_async_transfer.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+
+#include <stdio.h>
+
+#include <sfeTkArdI2C.h>
+#include <sfeTkArdSPI.h>
+
+#include "sim/sfeTkSimDMA.h"
+
+static const uint8_t kDevAddress = 0x1D;
+static const uint8_t kDevCS = 10;
+static const uint8_t kRegFifo = 0x40;
+static const size_t kBlockLength = 96;
+
+static bool checkBlock(const char *name, sfeTkSimDevice &device, const uint8_t *data, sfeTkBusRequest &request)
+{
+    bool bOk = request.result() == kSTkErrOk && request.transferred == kBlockLength;
+    for (size_t i = 0; bOk && i < kBlockLength; i++)
+        bOk = data[i] == device.reg((uint16_t)(kRegFifo + i));
+
+    printf("%-28s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+static void onDone(sfeTkBusRequest &request, void *context)
+{
+    (void)request;
+    // called on the DMA thread
+    __atomic_store_n((bool *)context, true, __ATOMIC_RELEASE);
+}
+
+// the transfer is handed off, and the application thread keeps working until the completion
+template <typename Bus, typename Port>
+static bool testDMA(const char *name, Bus &bus, Port &port, sfeTkSimDevice &device, sfeTkSimDMA &dma)
+{
+    uint8_t data[kBlockLength] = {0};
+    sfeTkBusRequest request;
+    bool bCallback = false;
+
+    request.set(kSTkBusOpReadRegisterRegion, 0, nullptr, 0);
+    request.onComplete = onDone;
+    request.context = &bCallback;
+
+    port.setRealTime(true);
+    bus.setAsyncTransfer(&dma);
+
+    uint32_t nSpins = 0;
+    unsigned long start = micros();
+    sfeTkError_t rc = bus.readRegisterRegionAsync(kRegFifo, data, sizeof(data), request);
+
+    // a second transfer is rejected while the first is in flight
+    sfeTkBusRequest second;
+    second.set(kSTkBusOpReadRegisterRegion, 0, nullptr, 0);
+    uint8_t other[4];
+    bool bBusyOk = bus.readRegisterRegionAsync(kRegFifo, other, sizeof(other), second) == kSTkErrBusQueueFull;
+
+    // the application loop - yields, as the DMA "engine" is a thread on the same host
+    while (!request.done())
+    {
+        nSpins++;
+        std::this_thread::yield();
+    }
+
+    unsigned long elapsed = micros() - start;
+    bus.setAsyncTransfer(nullptr);
+    port.setRealTime(false);
+
+    printf("%-28s: %lu us, application loop ran %u times during the transfer\n", name, elapsed, nSpins);
+    return rc == kSTkErrOk && bBusyOk && __atomic_load_n(&bCallback, __ATOMIC_ACQUIRE) &&
+           checkBlock(name, device, data, request);
+}
+
+// no backend set - the CPU fallback, complete on return
+template <typename Bus> static bool testCPU(const char *name, Bus &bus, sfeTkSimDevice &device)
+{
+    uint8_t data[kBlockLength] = {0};
+    sfeTkBusRequest request;
+    request.set(kSTkBusOpReadRegisterRegion, 0, nullptr, 0);
+
+    sfeTkError_t rc = bus.readRegisterRegionAsync(kRegFifo, data, sizeof(data), request);
+    return rc == kSTkErrOk && request.done() && checkBlock(name, device, data, request);
+}
+
+int main(void)
+{
+    sfeTkSimDevice i2cDevice, spiDevice;
+    for (int i = 0; i < 256; i++)
+    {
+        i2cDevice.setReg((uint16_t)i, (uint8_t)(i ^ 0x5A));
+        spiDevice.setReg((uint16_t)i, (uint8_t)(i * 3));
+    }
+    Wire.attach(kDevAddress, i2cDevice);
+    SPI.attach(kDevCS, spiDevice);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kDevAddress);
+    Wire.setClock(400000);
+
+    sfeTkArdSPI spi;
+    SPISettings settings(1000000, MSBFIRST, SPI_MODE0);
+    spi.init(SPI, settings, kDevCS);
+
+    // the async read of an uninitialized bus fails up front
+    sfeTkArdI2C noPort;
+    sfeTkBusRequest request;
+    uint8_t data[4];
+    bool bOk = noPort.readRegisterRegionAsync(0, data, sizeof(data), request) == kSTkErrBusNotInit;
+
+    bOk = testCPU("I2C CPU fallback", i2c, i2cDevice) && bOk;
+    bOk = testCPU("SPI CPU fallback", spi, spiDevice) && bOk;
+
+    sfeTkSimDMA dma;
+    bOk = testDMA("I2C simulated DMA", i2c, Wire, i2cDevice, dma) && bOk;
+    bOk = testDMA("SPI simulated DMA", spi, SPI, spiDevice, dma) && bOk;
+
+    printf("%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+// test_bus_budget.cpp - host test of the bus bandwidth budget (sfeTkBusBudget.h)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -DSFE_TK_ENABLE_TRANSACTIONS=1 -Itests/host/sim -Isrc -o test_bus_budget
+//       tests/host/test_bus_budget.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+//
+// Checks the budget of each kind of device - a transaction, separate operations and a read longer than the chunk
+// size - against the wire time the simulated buses account when a second of samples is run, on I2C and SPI. Then
+// checks admission control at startup - the warning level, a device refused over the limit, or added with a
+// warning when rejection is off - and the budget after a clock change, the clock the devices need and the fastest
+// rate of a device, each at the edge of the limit. Prints the report of an example budget.
+
+#include <stdio.h>
+
+#include <sfeTkArdBusHooks.h>
+
+#if !SFE_TK_ENABLE_TRANSACTIONS
+#error "build with -DSFE_TK_ENABLE_TRANSACTIONS=1"
+#endif
+
+static const uint8_t kAddress = 0x42;
+static const uint8_t kCS = 10;
+static const uint8_t kRegCtrl = 0x20;
+static const uint8_t kRegData = 0x28;
+
+static uint8_t imuData[12];
+static uint8_t baroData[3];
+static uint8_t fifoData[40];
+
+// the sample of each device - kept by reference in the budget
+static const auto kReadImu = sfeTkTxn() << sfeTkWrite(kRegCtrl, 0x01) >> sfeTkRead(kRegData, imuData);
+static const sfeTkTxnStep kBaroSteps[] = {sfeTkWrite(kRegCtrl, 0x02), sfeTkRead(kRegData, baroData)};
+static const sfeTkTxnStep kFifoSteps[] = {sfeTkRead(kRegData, fifoData)};
+
+static bool check(const char *name, bool bOk)
+{
+    printf("  %-58s %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+static uint64_t wireBusy(void)
+{
+    return Wire.busyNanos();
+}
+
+static uint64_t spiBusy(void)
+{
+    return SPI.busyNanos();
+}
+
+// Run a second of samples of one device, and compare the wire time with the budget of the device alone
+template <typename Bus, typename Sample>
+static bool checkSecond(const char *title, const char *name, Bus &bus, const sfeTkBusWire &wire,
+                        uint64_t (*busy)(void), Sample sample, uint32_t rate,
+                        sfeTkError_t (*add)(sfeTkBusBudget<> &, uint32_t))
+{
+    sfeTkBusBudget<> budget(wire, kSTkBusMonitorFull, kSTkBusMonitorFull);
+    add(budget, rate);
+
+    uint64_t start = busy();
+    for (uint32_t i = 0; i < rate; i++)
+        sample(bus);
+    uint64_t actual = busy() - start;
+
+    // the simulated buses round each transfer to the ns
+    uint64_t expect = (uint64_t)budget.busyMicros() * 1000;
+    char label[80];
+    snprintf(label, sizeof(label), "%s %s: %lu us/s, budget %lu us/s", title, name, (unsigned long)(actual / 1000),
+             (unsigned long)budget.busyMicros());
+    return check(label, expect + 1000 + rate >= actual && expect <= actual + 1000 + rate);
+}
+
+static sfeTkError_t addImu(sfeTkBusBudget<> &budget, uint32_t rate)
+{
+    return budget.add("imu", kReadImu, rate);
+}
+
+static sfeTkError_t addBaro(sfeTkBusBudget<> &budget, uint32_t rate)
+{
+    return budget.addOperations("baro", kBaroSteps, 2, rate);
+}
+
+static sfeTkError_t addFifo(sfeTkBusBudget<> &budget, uint32_t rate)
+{
+    return budget.addOperations("fifo", kFifoSteps, 1, rate);
+}
+
+template <typename Bus> static void readImu(Bus &bus)
+{
+    bus.transaction(kReadImu);
+}
+
+template <typename Bus> static void readBaro(Bus &bus)
+{
+    bus.writeRegisterByte(kRegCtrl, 0x02);
+    bus.readRegisterRegion(kRegData, baroData, sizeof(baroData));
+}
+
+template <typename Bus> static void readFifo(Bus &bus)
+{
+    size_t nRead = 0;
+    bus.readRegisterRegion(kRegData, fifoData, sizeof(fifoData), nRead);
+}
+
+static bool testWireTime(void)
+{
+    bool bOk = true;
+
+    Wire.setClock(400000);
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kAddress);
+    sfeTkBusWire i2cWire = sfeTkBusWire::i2c(400000);
+    bOk = checkSecond("I2C", "transaction", i2c, i2cWire, wireBusy, readImu<sfeTkArdI2C>, 1000, addImu) && bOk;
+    bOk = checkSecond("I2C", "operations", i2c, i2cWire, wireBusy, readBaro<sfeTkArdI2C>, 200, addBaro) && bOk;
+    bOk = checkSecond("I2C", "chunked read", i2c, i2cWire, wireBusy, readFifo<sfeTkArdI2C>, 500, addFifo) && bOk;
+
+    sfeTkArdSPI spi;
+    spi.init(kCS, true);
+    sfeTkBusWire spiWire = sfeTkBusWire::spi(3000000);
+    bOk = checkSecond("SPI", "transaction", spi, spiWire, spiBusy, readImu<sfeTkArdSPI>, 1000, addImu) && bOk;
+    bOk = checkSecond("SPI", "operations", spi, spiWire, spiBusy, readBaro<sfeTkArdSPI>, 200, addBaro) && bOk;
+
+    // the same steps as operations - a stop after the write, and between the phases of the read
+    sfeTkBusBudget<> budget(i2cWire);
+    budget.addOperations("separate", kReadImu.steps(), kReadImu.size(), 1);
+    budget.add("joined", kReadImu, 1);
+    bOk = check("operations cost more than a transaction", budget.clocks(0) == budget.clocks(1) + 2) && bOk;
+    return bOk;
+}
+
+static bool testAdmission(void)
+{
+    bool bOk = true;
+
+    // the imu transaction is a start and 3 bytes for the write, a repeated start and 2 bytes for the register of
+    // the read, a repeated start and 13 bytes for the data, and the stop - 166 clocks, 16.6 ms at 100 kHz
+    sfeTkBusBudget<4> budget(sfeTkBusWire::i2c(100000), 7000, 5000);
+    bOk = check("transaction clocks", budget.add("imu", kReadImu, 100) == kSTkErrOk && budget.clocks(0) == 166) && bOk;
+    bOk = check("utilization", budget.utilization() == 1660 && budget.busyMicros() == 166000) && bOk;
+
+    // 16.6% + 2 x 19.92% - over the warning level, under the limit
+    budget.add("imu 2", kReadImu, 120);
+    bOk = check("over the warning level", budget.add("imu 3", kReadImu, 120) == kSTkErrBusBudgetWarning) && bOk;
+    bOk = check("check() warns", budget.check() == kSTkErrBusBudgetWarning && budget.size() == 3) && bOk;
+
+    // a device that takes the bus over the limit is refused, and the budget is as it was
+    bOk = check("refused over the limit", budget.add("imu 4", kReadImu, 200) == kSTkErrBusOverBudget &&
+                                              budget.size() == 3 && budget.utilization() == 5644) &&
+          bOk;
+    bOk = check("a device that fits is added", budget.addClocks("misc", 1000, 2) == kSTkErrBusBudgetWarning &&
+                                                   budget.size() == 4 && budget.clocks(3) == 1000) &&
+          bOk;
+    bOk = check("no room", budget.addClocks("more", 1, 1) == kSTkErrFail && budget.size() == 4) && bOk;
+
+    // with rejection off the device is added, and the budget stays over
+    sfeTkBusBudget<4> loose(sfeTkBusWire::i2c(100000));
+    loose.setLimits(2000, 1000, false);
+    loose.add("imu", kReadImu, 100);
+    bOk = check("added over the limit", loose.add("imu 2", kReadImu, 100) == kSTkErrBusOverBudget &&
+                                            loose.size() == 2 && loose.check() == kSTkErrBusOverBudget) &&
+          bOk;
+
+    // more than the bus can carry
+    loose.setRate(1, 1000);
+    bOk = check("over 100%", loose.utilization() == kSTkBusMonitorFull && loose.busyMicros() > 1000000) && bOk;
+    return bOk;
+}
+
+static bool testClock(void)
+{
+    bool bOk = true;
+
+    sfeTkBusBudget<> budget(sfeTkBusWire::i2c(400000), 7000, 5000);
+    budget.add("imu", kReadImu, 500);
+    budget.addOperations("baro", kBaroSteps, 2, 200);
+    budget.addOperations("fifo", kFifoSteps, 1, 100);
+    bOk = check("fits at 400 kHz", budget.check() == kSTkErrOk) && bOk;
+
+    // the same devices on a 100 kHz bus
+    budget.setWire(sfeTkBusWire::i2c(100000));
+    bOk = check("over the limit at 100 kHz", budget.check() == kSTkErrBusOverBudget) && bOk;
+
+    // the clock the devices need, at the edge of the limit
+    uint32_t clock = budget.requiredClock();
+    budget.setWire(sfeTkBusWire::i2c(clock));
+    bool bFits = budget.check() != kSTkErrBusOverBudget;
+    budget.setWire(sfeTkBusWire::i2c(clock - 1));
+    bOk = check("the required clock is the slowest that fits", bFits && budget.check() == kSTkErrBusOverBudget) &&
+          bOk;
+
+    // a larger chunk size saves the address of the second chunk of the fifo read
+    budget.setWire(sfeTkBusWire::i2c(400000));
+    uint32_t before = budget.clocks(2);
+    budget.setWire(sfeTkBusWire::i2c(400000, 64));
+    bOk = check("chunk size", before - budget.clocks(2) == 11) && bOk;
+
+    // the fastest rate of the imu with the others as they are
+    budget.setWire(sfeTkBusWire::i2c(400000));
+    uint32_t rate = budget.maxRate(0);
+    budget.setRate(0, rate);
+    bFits = budget.check() != kSTkErrBusOverBudget;
+    budget.setRate(0, rate + 1);
+    bOk = check("the max rate is the fastest that fits", bFits && budget.check() == kSTkErrBusOverBudget) && bOk;
+    return bOk;
+}
+
+// Prints to stdout, like Serial
+struct Printer
+{
+    void println(const char *line)
+    {
+        printf("%s\n", line);
+    }
+};
+
+static void report(void)
+{
+    static uint8_t magData[6];
+    static const auto kReadMag = sfeTkTxn() >> sfeTkRead(0x03, magData);
+
+    sfeTkBusBudget<> budget(sfeTkBusWire::i2c(400000), 7000, 5000);
+    budget.add("imu", kReadImu, 1000);
+    budget.add("mag", kReadMag, 100);
+    budget.addOperations("baro", kBaroSteps, 2, 50);
+    budget.addOperations("fifo", kFifoSteps, 1, 200);
+    budget.addClocks("eeprom", 2000, 5);
+
+    Printer out;
+    printf("\n");
+    budget.report(out);
+    budget.setWire(sfeTkBusWire::i2c(100000));
+    printf("\n");
+    budget.report(out);
+}
+
+int main()
+{
+    sfeTkSimDevice i2cSim, spiSim;
+    Wire.attach(kAddress, i2cSim);
+    SPI.attach(kCS, spiSim);
+
+    printf("Wire time:\n");
+    bool bOk = testWireTime();
+    printf("Admission:\n");
+    bOk = testAdmission() && bOk;
+    printf("Clock and rate:\n");
+    bOk = testClock() && bOk;
+
+    report();
+
+    Wire.detach(kAddress);
+    SPI.detach(kCS);
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,404 @@
+// test_bus_monitor.cpp - host test of the bus utilization monitor (sfeTkBusMonitor.h) and wire model
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -DSFE_TK_ENABLE_TRANSACTIONS=1 -Itests/host/sim -Isrc -o test_bus_monitor
+//       tests/host/test_bus_monitor.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+//
+// Checks the sliding window of the monitor with a manual clock - utilization of a partial and a full window, the
+// peak, the window sliding past idle time and the threshold callback with hysteresis. Then checks the wire model
+// (sfeTkBusWire.h) against the wire time the simulated buses account, for each operation type, chunked reads and
+// transactions, and runs devices sharing one I2C bus and its monitor - estimated and measured - at a sample rate,
+// adding sensors until the monitor reports the bus over its threshold. Last, compares the cost of a register read
+// with no hooks and with the monitor hooks. Cycles are the time stamp counter on x86, else ns.
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include <sfeTkArdBusHooks.h>
+
+#if !SFE_TK_ENABLE_TRANSACTIONS
+#error "build with -DSFE_TK_ENABLE_TRANSACTIONS=1"
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define kUnits "cycles"
+static inline uint64_t cycles(void)
+{
+    return __rdtsc();
+}
+#else
+#define kUnits "ns"
+static inline uint64_t cycles(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+#endif
+
+static const uint8_t kAddress = 0x42;
+static const uint8_t kCS = 10;
+static const uint8_t kRegId = 0x0F;
+static const uint8_t kRegData = 0x28;
+
+// A clock set by the test
+struct ManualClock
+{
+    static uint32_t tick;
+    static uint32_t now(void)
+    {
+        return tick;
+    }
+};
+uint32_t ManualClock::tick = 0;
+
+// Simulated time in microseconds - the wire time of both buses, and the idle time the test adds
+struct SimClock
+{
+    static uint64_t idleNanos;
+    static uint32_t now(void)
+    {
+        return (uint32_t)((idleNanos + Wire.busyNanos() + SPI.busyNanos()) / 1000);
+    }
+};
+uint64_t SimClock::idleNanos = 0;
+
+struct Crossings
+{
+    int nAbove;
+    int nBelow;
+    uint16_t last;
+};
+
+static void onCross(bool bAbove, uint16_t utilization, void *context)
+{
+    Crossings *crossings = (Crossings *)context;
+    if (bAbove)
+        crossings->nAbove++;
+    else
+        crossings->nBelow++;
+    crossings->last = utilization;
+}
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-52s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+static bool testWindow(void)
+{
+    bool bOk = true;
+    ManualClock::tick = 0;
+    sfeTkBusMonitor<ManualClock, 4> monitor(1000); // 4 slots of 250
+    Crossings crossings = {0, 0, 0};
+    monitor.setThreshold(4000, onCross, &crossings, 500);
+
+    monitor.addBusy(100, 10);
+    monitor.addBusy(100, 300);
+    ManualClock::tick = 500;
+    bOk = check("partial window utilization", monitor.utilization() == 4000 && monitor.peak() == 0) && bOk;
+
+    // 500 busy in the first full window
+    monitor.addBusy(300, 900);
+    ManualClock::tick = 1000;
+    monitor.update();
+    bOk = check("full window peak", monitor.peak() == 5000) && bOk;
+    bOk = check("threshold crossed", crossings.nAbove == 1 && crossings.nBelow == 0 && monitor.above()) && bOk;
+
+    // the sliding window ending now - three full slots and none of this one
+    bOk = check("window ending now", monitor.utilization() == 5333) && bOk;
+
+    // the window slides - the next full window is 40%, within the hysteresis
+    ManualClock::tick = 1250;
+    monitor.update();
+    bOk = check("within hysteresis stays above", crossings.nBelow == 0 && monitor.above()) && bOk;
+
+    // 30% is under the threshold less the hysteresis
+    ManualClock::tick = 1500;
+    bOk = check("window slides", monitor.utilization() == 4000) && bOk;
+    bOk = check("back under the threshold", crossings.nBelow == 1 && crossings.last == 3000 && !monitor.above()) &&
+          bOk;
+
+    // idle - the window empties, the peak stays
+    ManualClock::tick = 100000;
+    monitor.update();
+    bOk = check("idle bus", monitor.utilization() == 0 && monitor.peak() == 5000) && bOk;
+    bOk = check("one callback each way", crossings.nAbove == 1 && crossings.nBelow == 1) && bOk;
+
+    // an overloaded slot counts as a full bus
+    monitor.addBusy(2000, 100010);
+    bOk = check("utilization is at most 100%", monitor.utilization() == kSTkBusMonitorFull) && bOk;
+
+    bOk = check("totals", monitor.busy() == 2500 && monitor.operations() == 4) && bOk;
+    monitor.reset();
+    bOk = check("reset", monitor.busy() == 0 && monitor.peak() == 0 && monitor.utilization() == 0) && bOk;
+    return bOk;
+}
+
+// Checks the wire model of each operation against the simulated bus
+template <typename Bus> static bool checkWire(const char *title, Bus &bus, uint64_t (*busy)(void))
+{
+    bool bOk = true;
+    uint8_t data = 0;
+    uint8_t block[80] = {0};
+    size_t nRead = 0;
+
+    // each operation, and the estimate of the monitor hooks for it - the model is in clocks, so compare the time
+    sfeTkBusMonitor<SimClock> monitor(1000000, 1000000000); // nanoseconds
+    bus.hooks().attach(monitor, bus.hooks().wire());
+
+    auto run = [&](const char *name, auto fn) {
+        uint64_t start = busy();
+        uint32_t estimateStart = monitor.busy();
+        fn();
+        uint64_t actual = busy() - start;
+        uint32_t estimate = monitor.busy() - estimateStart;
+        char label[64];
+        snprintf(label, sizeof(label), "%s %s wire time", title, name);
+        // the simulated buses round each transfer to the ns
+        bOk = check(label, estimate + 20 >= actual && estimate <= actual + 20) && bOk;
+    };
+
+    run("writeRegisterByte()", [&] { bus.writeRegisterByte(kRegData, 0x12); });
+    run("writeRegisterRegion()", [&] { bus.writeRegisterRegion(kRegData, block, 10); });
+    run("readRegisterByte()", [&] { bus.readRegisterByte(kRegId, data); });
+    run("readRegisterRegion() 80 bytes", [&] { bus.readRegisterRegion(kRegData, block, 80, nRead); });
+    run("transaction", [&] {
+        bus.transaction(sfeTkTxn() << sfeTkWrite(kRegData, 0x55) << sfeTkWrite(kRegData, 0x66)
+                                   >> sfeTkRead(kRegData, block, 40));
+    });
+    bus.hooks().detach();
+    return bOk;
+}
+
+// The monitor hooks, with the wire model kept for the wire check
+class WireHooks : public sfeTkBusMonitorHooks<sfeTkBusMonitor<SimClock>>
+{
+  public:
+    void setWire(const sfeTkBusWire &wire)
+    {
+        _theWire = wire;
+    }
+    const sfeTkBusWire &wire(void) const
+    {
+        return _theWire;
+    }
+
+  private:
+    sfeTkBusWire _theWire;
+};
+
+static uint64_t wireBusy(void)
+{
+    return Wire.busyNanos();
+}
+
+static uint64_t spiBusy(void)
+{
+    return SPI.busyNanos();
+}
+
+static bool testWireModel(void)
+{
+    bool bOk = true;
+
+    Wire.setClock(400000);
+    sfeTkArdI2CHooked<WireHooks> i2c;
+    i2c.init(Wire, kAddress);
+    i2c.hooks().setWire(sfeTkBusWire::i2c(400000));
+    bOk = checkWire("I2C", i2c, wireBusy) && bOk;
+
+    sfeTkArdSPIHooked<WireHooks> spi;
+    spi.init(kCS, true);
+    spi.hooks().setWire(sfeTkBusWire::spi(3000000));
+    bOk = checkWire("SPI", spi, spiBusy) && bOk;
+
+    // the model in clocks - a register byte read is start, address, register, stop, start, address, data, stop
+    sfeTkBusWire wire = sfeTkBusWire::i2c(100000);
+    bOk = check("I2C register read clocks", wire.bits(true, 1, 1) == 40 && wire.time(40) == 400) && bOk;
+    bOk = check("I2C read chunks", wire.bits(true, 1, 64) - wire.bits(true, 1, 32) == 32 * 9 + 11) && bOk;
+    bOk = check("I2C read with repeated starts", sfeTkBusWire::i2c(100000, 32, false).bits(true, 1, 1) == 39) && bOk;
+    return bOk;
+}
+
+typedef sfeTkBusMonitor<SimClock> SimMonitor;
+
+// A sensor read at a sample rate - a status read and a 6 byte sample
+template <typename Bus> static void readSample(Bus &bus)
+{
+    uint8_t status = 0;
+    uint8_t sample[6];
+    bus.readRegisterByte(kRegId, status);
+    bus.readRegisterRegion(kRegData, sample, sizeof(sample));
+}
+
+// A second of sample periods - the sensors read, then the bus is idle for the rest of the period
+template <typename Bus> static void runSecond(Bus *sensors, int nActive, uint32_t rate)
+{
+    for (uint32_t period = 0; period < rate; period++)
+    {
+        uint32_t start = SimClock::now();
+        for (int i = 0; i < nActive; i++)
+            readSample(sensors[i]);
+        uint32_t used = SimClock::now() - start;
+        if (used < 1000000 / rate)
+            SimClock::idleNanos += (uint64_t)(1000000 / rate - used) * 1000;
+    }
+}
+
+static bool testSharedBus(void)
+{
+    bool bOk = true;
+    static const int kSensors = 10;
+    static const uint32_t kRate = 100; // samples a second, each sensor
+    static const uint8_t kFirst = 0x50;
+
+    sfeTkSimDevice sims[kSensors];
+    Wire.setClock(100000);
+
+    // one monitor for the bus - the bus objects of all sensors add to it. Estimated from the bytes, then measured.
+    SimMonitor estimated(100000);
+    SimMonitor measured(100000);
+    Crossings crossings = {0, 0, 0};
+    estimated.setThreshold(5000, onCross, &crossings, 500);
+
+    sfeTkArdI2CHooked<sfeTkBusMonitorHooks<SimMonitor>> sensors[kSensors];
+    sfeTkArdI2CHooked<sfeTkBusMonitorHooks<SimMonitor>> twins[kSensors];
+    for (int i = 0; i < kSensors; i++)
+    {
+        Wire.attach(kFirst + i, sims[i]);
+        sensors[i].init(Wire, kFirst + i);
+        sensors[i].hooks().attach(estimated, sfeTkBusWire::i2c(100000));
+        twins[i].init(Wire, kFirst + i);
+        twins[i].hooks().attach(measured);
+    }
+
+    printf("\nI2C at 100 kHz, each sensor read %u times a second (status + 6 bytes), 100 ms window:\n",
+           (unsigned)kRate);
+    printf("  sensors  estimated  measured   peak\n");
+    int nOverAt = 0;
+    int nExpectOver = 0;
+    bool bAgree = true;
+    for (int nActive = 1; nActive <= kSensors; nActive++)
+    {
+        estimated.resetPeak();
+        runSecond(sensors, nActive, kRate);
+        uint16_t estimate = estimated.utilization();
+        uint16_t peak = estimated.peak();
+        bool bAbove = estimated.above();
+
+        measured.resetPeak();
+        runSecond(twins, nActive, kRate);
+        uint16_t measure = measured.utilization();
+
+        printf("  %7d %9.2f%% %8.2f%% %5.1f%%\n", nActive, estimate / 100.0, measure / 100.0, peak / 100.0);
+        if (!nOverAt && bAbove)
+            nOverAt = nActive;
+        if (!nExpectOver && peak >= 5000)
+            nExpectOver = nActive;
+        bAgree = bAgree && estimate <= measure + 100 && measure <= estimate + 100;
+    }
+    printf("  over 50%% with %d sensors\n", nOverAt);
+    bOk = check("estimated and measured agree within 1%", bAgree) && bOk;
+    // the estimated monitor sees the measured runs as idle time - so it goes under, and over again, each time
+    bOk = check("threshold callback when the bus fills", nOverAt > 1 && nOverAt == nExpectOver &&
+                                                             crossings.nAbove == kSensors - nOverAt + 1 &&
+                                                             crossings.nBelow == kSensors - nOverAt) &&
+          bOk;
+
+    for (int i = 0; i < kSensors; i++)
+        Wire.detach(kFirst + i);
+    return bOk;
+}
+
+static const int kReads = 100000;
+static const int kRounds = 15;
+
+template <typename Bus> static double perRead(Bus &bus)
+{
+    uint8_t data;
+    sfeTkIBus &ibus = bus;
+    uint64_t start = cycles();
+    for (int i = 0; i < kReads; i++)
+        ibus.readRegisterByte(kRegId, data);
+    return (double)(cycles() - start) / kReads;
+}
+
+static void keepMin(double &best, double value)
+{
+    if (best == 0 || value < best)
+        best = value;
+}
+
+static void benchmark(void)
+{
+    sfeTkArdI2C plain;
+    plain.init(Wire, kAddress);
+    sfeTkArdI2CHooked<sfeTkArdBusMonitorHooks> measured;
+    measured.init(Wire, kAddress);
+    sfeTkArdI2CHooked<sfeTkArdBusMonitorHooks> estimated;
+    estimated.init(Wire, kAddress);
+
+    sfeTkArdBusMonitor monitor(1000000);
+    measured.hooks().attach(monitor);
+    estimated.hooks().attach(monitor, sfeTkBusWire::i2c(400000));
+
+    double best[3] = {0};
+    for (int round = 0; round < kRounds; round++)
+    {
+        keepMin(best[0], perRead(plain));
+        keepMin(best[1], perRead(measured));
+        keepMin(best[2], perRead(estimated));
+    }
+
+    printf("\nI2C readRegisterByte() - %s per read, through sfeTkIBus:\n", kUnits);
+    printf("  %-22s %8.1f\n", "sfeTkArdI2C", best[0]);
+    printf("  %-22s %8.1f %+8.1f\n", "monitor, measured", best[1], best[1] - best[0]);
+    printf("  %-22s %8.1f %+8.1f\n", "monitor, estimated", best[2], best[2] - best[0]);
+    printf("  monitor %u bytes, hooks %u bytes a bus object\n", (unsigned)sizeof(monitor),
+           (unsigned)(sizeof(measured) - sizeof(plain)));
+}
+
+int main()
+{
+    sfeTkSimDevice i2cSim, spiSim;
+    Wire.attach(kAddress, i2cSim);
+    SPI.attach(kCS, spiSim);
+
+    bool bOk = testWindow();
+    printf("\n");
+    bOk = testWireModel() && bOk;
+    bOk = testSharedBus() && bOk;
+
+    benchmark();
+
+    Wire.detach(kAddress);
+    SPI.detach(kCS);
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
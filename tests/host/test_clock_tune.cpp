@@ -0,0 +1,285 @@
+// test_clock_tune.cpp - host test of the I2C clock tuner (sfeTkClockTune.h)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o test_clock_tune tests/host/test_clock_tune.cpp
+//       src/sfeTkArdI2C.cpp
+//
+// Devices on the simulated I2C bus have clock errors (sfeTkSimDevice::setClockErrors()) - a byte is corrupted at
+// a rate that rises with the clock past what the wiring allows. Checks the error model, then tunes a clean device,
+// one that fails at 600 kHz, a marginal one that fails a byte now and then at 800 kHz and one that fails at the
+// slowest clock - the fastest reliable clock, the clock selected with the margin, errors allowed and the clock left
+// set. Compares how often few and many reads a clock pick a clock that is too fast. Checks the tuning record
+// survives a store and load, and is not valid when changed, erased or for another device, and runs the devices
+// on a shared bus at the slowest of their clocks. Prints the tuning reports and the wire time a tuning takes.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <SparkFun_Toolkit.h>
+#include <sfeTk/sfeTkClockTune.h>
+
+static const uint8_t kRegWhoAmI = 0x0F;
+static const uint8_t kWhoAmI = 0x6C;
+
+static const uint8_t kClean = 0x40;     // reliable at every clock
+static const uint8_t kSlow = 0x41;      // long wires - fails from 600 kHz
+static const uint8_t kMarginal = 0x42;  // a byte in a few hundred fails at 800 kHz
+static const uint8_t kBroken = 0x43;    // fails at 100 kHz
+
+static bool check(const char *name, bool bOk)
+{
+    printf("  %-62s %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+// Prints to stdout, like Serial
+struct Printer
+{
+    void println(const char *line)
+    {
+        printf("%s\n", line);
+    }
+};
+
+// Read errors in a number of reads at a clock
+static uint32_t readErrors(sfeTkArdI2C &bus, uint32_t clock, uint32_t nReads)
+{
+    bus.setClock(clock);
+    uint32_t nErrors = 0;
+    for (uint32_t i = 0; i < nReads; i++)
+    {
+        uint8_t value = 0;
+        if (bus.readRegisterByte(kRegWhoAmI, value) != kSTkErrOk || value != kWhoAmI)
+            nErrors++;
+    }
+    return nErrors;
+}
+
+static bool testErrorModel(sfeTkSimDevice &slow)
+{
+    bool bOk = true;
+    sfeTkArdI2C bus;
+    bus.init(Wire, kSlow);
+
+    bOk = check("no errors at or under the good clock", readErrors(bus, 400000, 10000) == 0) && bOk;
+
+    // a read checks 4 bytes - the address and register, the address again and the data
+    uint32_t ppm = slow.errorPpm(600000);
+    double expect = 1 - (1 - ppm / 1e6) * (1 - ppm / 1e6) * (1 - ppm / 1e6) * (1 - ppm / 1e6);
+    uint32_t nErrors = readErrors(bus, 600000, 10000);
+    char label[80];
+    snprintf(label, sizeof(label), "errors at 600 kHz: %.1f%% of reads, expect %.1f%%", nErrors / 100.0,
+             expect * 100);
+    bOk = check(label, nErrors > expect * 10000 * 0.9 && nErrors < expect * 10000 * 1.1) && bOk;
+    bOk = check("more errors at a faster clock", readErrors(bus, 1000000, 10000) > nErrors) && bOk;
+    bOk = check("every byte fails at the bad clock", readErrors(bus, 2000000, 100) == 100) && bOk;
+    return bOk;
+}
+
+static bool testTune(void)
+{
+    bool bOk = true;
+    Printer out;
+    sfeTkClockTuneRecord record;
+
+    sfeTkArdI2C clean;
+    clean.init(Wire, kClean);
+    sfeTkClockTuner<> tuner;
+    uint64_t start = Wire.busyNanos();
+    sfeTkError_t retval = tuner.tune(clean, kRegWhoAmI, kWhoAmI, record);
+    double seconds = (Wire.busyNanos() - start) / 1e9;
+    bOk = check("clean - reliable at 1 MHz, 800 kHz with a 20% margin",
+                retval == kSTkErrOk && record.fastest == 1000000 && record.clock == 800000) &&
+          bOk;
+    bOk = check("the clock is left at the clock selected", Wire.clock() == 800000) && bOk;
+    bOk = check("every clock was read at", tuner.tried() == kSTkClockTuneNSteps && tuner.reads(5) == 1000) && bOk;
+    tuner.report(out, record);
+    printf("  wire time of the tuning %.3f s\n", seconds);
+
+    tuner.setMargin(0);
+    bOk = check("no margin - 1 MHz", tuner.tune(clean, kRegWhoAmI, kWhoAmI, record) == kSTkErrOk &&
+                                         record.clock == 1000000 && record.margin == 0) &&
+          bOk;
+    tuner.setMargin(20);
+
+    sfeTkArdI2C slow;
+    slow.init(Wire, kSlow);
+    retval = tuner.tune(slow, kRegWhoAmI, kWhoAmI, record);
+    bOk = check("slow - reliable at 400 kHz, 200 kHz with the margin",
+                retval == kSTkErrOk && record.fastest == 400000 && record.clock == 200000) &&
+          bOk;
+    bOk = check("faster clocks are not tried after a failure",
+                tuner.tried() == 4 && tuner.errors(3) == 1 && tuner.reads(3) < 1000) &&
+          bOk;
+    tuner.report(out, record);
+
+    sfeTkArdI2C marginal;
+    marginal.init(Wire, kMarginal);
+    retval = tuner.tune(marginal, kRegWhoAmI, kWhoAmI, record);
+    bOk = check("marginal - reliable at 600 kHz", retval == kSTkErrOk && record.fastest == 600000) && bOk;
+    tuner.report(out, record);
+
+    sfeTkClockTuner<> tolerant;
+    tolerant.setReads(1000, 50);
+    bOk = check("marginal, 50 errors allowed - faster than 600 kHz",
+                tolerant.tune(marginal, kRegWhoAmI, kWhoAmI, record) == kSTkErrOk && record.fastest > 600000) &&
+          bOk;
+
+    sfeTkArdI2C broken;
+    broken.init(Wire, kBroken);
+    retval = tuner.tune(broken, kRegWhoAmI, kWhoAmI, record);
+    bOk = check("broken - not reliable, left at 100 kHz", retval == kSTkErrBusUnreliable && Wire.clock() == 100000 &&
+                                                              !record.valid(kBroken, kRegWhoAmI, kWhoAmI)) &&
+          bOk;
+    tuner.report(out, record);
+
+    // a list of clocks of its own
+    static const uint32_t kFine[] = {100000, 300000, 500000, 700000, 900000};
+    sfeTkClockTuner<4> fine(kFine, 5);
+    fine.setMargin(10);
+    bOk = check("own list, capped at kMaxSteps - slow at 500 kHz fails, 300 kHz",
+                fine.tune(slow, kRegWhoAmI, kWhoAmI, record) == kSTkErrOk && record.fastest == 300000 &&
+                    record.clock == 100000 && fine.clock(4) == 0) &&
+          bOk;
+    return bOk;
+}
+
+// How often a tuning picks a clock the marginal device is not reliable at - with few and with many reads
+static bool testReads(sfeTkSimDevice &marginalSim)
+{
+    static const int kTunings = 40;
+    sfeTkArdI2C marginal;
+    marginal.init(Wire, kMarginal);
+
+    int nTooFast[2] = {0, 0};
+    const uint32_t kReads[2] = {20, 1000};
+    for (int r = 0; r < 2; r++)
+    {
+        sfeTkClockTuner<> tuner;
+        tuner.setReads(kReads[r]);
+        for (int i = 0; i < kTunings; i++)
+        {
+            marginalSim.setClockErrors(700000, 30000000, 1000 + i);
+            sfeTkClockTuneRecord record;
+            tuner.tune(marginal, kRegWhoAmI, kWhoAmI, record);
+            if (record.fastest > 600000)
+                nTooFast[r]++;
+        }
+    }
+
+    printf("  marginal device, %d tunings - reliable clock too fast: %d with %lu reads, %d with %lu reads\n",
+           kTunings, nTooFast[0], (unsigned long)kReads[0], nTooFast[1], (unsigned long)kReads[1]);
+    bool bOk = check("few reads miss the errors of a marginal clock", nTooFast[0] > kTunings / 4);
+    return check("1000 reads catch them", nTooFast[1] == 0) && bOk;
+}
+
+static bool testRecord(void)
+{
+    bool bOk = true;
+
+    sfeTkArdI2C slow;
+    slow.init(Wire, kSlow);
+    sfeTkClockTuner<> tuner;
+    sfeTkClockTuneRecord record;
+    tuner.tune(slow, kRegWhoAmI, kWhoAmI, record);
+
+    // stored and loaded - as EEPROM.put() and EEPROM.get() copy it
+    uint8_t eeprom[64];
+    memcpy(eeprom, &record, sizeof(record));
+    sfeTkClockTuneRecord loaded;
+    memcpy(&loaded, eeprom, sizeof(loaded));
+    bOk = check("valid after a store and load",
+                loaded.valid(kSlow, kRegWhoAmI, kWhoAmI) && loaded.clock == record.clock) &&
+          bOk;
+    bOk = check("not valid for another device", !loaded.valid(kClean, kRegWhoAmI, kWhoAmI) &&
+                                                    !loaded.valid(kSlow, kRegWhoAmI + 1, kWhoAmI) &&
+                                                    !loaded.valid(kSlow, kRegWhoAmI, kWhoAmI + 1)) &&
+          bOk;
+
+    loaded.clock = 1000000;
+    bOk = check("not valid when changed", !loaded.valid(kSlow, kRegWhoAmI, kWhoAmI)) && bOk;
+
+    memset(&loaded, 0xFF, sizeof(loaded));
+    bool bErased = !loaded.valid(0xFF, 0xFF, 0xFF);
+    memset(&loaded, 0, sizeof(loaded));
+    bOk = check("not valid erased or zeroed", bErased && !loaded.valid(0, 0, 0)) && bOk;
+    printf("  record %u bytes\n", (unsigned)sizeof(record));
+    return bOk;
+}
+
+static bool testSharedBus(void)
+{
+    sfeTkArdI2C devices[3];
+    const uint8_t kAddresses[3] = {kClean, kSlow, kMarginal};
+    sfeTkClockTuneRecord records[3];
+    sfeTkClockTuner<> tuner;
+    for (int i = 0; i < 3; i++)
+    {
+        devices[i].init(Wire, kAddresses[i]);
+        tuner.tune(devices[i], kRegWhoAmI, kWhoAmI, records[i]);
+    }
+
+    uint32_t clock = sfeTkClockTuneSlowest(records, 3);
+    uint32_t nErrors = 0;
+    for (int i = 0; i < 3; i++)
+        nErrors += readErrors(devices[i], clock, 10000);
+
+    char label[80];
+    snprintf(label, sizeof(label), "shared bus at the slowest, %lu kHz - no errors in 30000 reads",
+             (unsigned long)(clock / 1000));
+    return check(label, clock == 200000 && nErrors == 0);
+}
+
+int main()
+{
+    sfeTkSimDevice cleanSim, slowSim, marginalSim, brokenSim;
+    sfeTkSimDevice *sims[] = {&cleanSim, &slowSim, &marginalSim, &brokenSim};
+    const uint8_t kAddresses[] = {kClean, kSlow, kMarginal, kBroken};
+    for (int i = 0; i < 4; i++)
+    {
+        sims[i]->setReg(kRegWhoAmI, kWhoAmI);
+        Wire.attach(kAddresses[i], *sims[i]);
+    }
+    slowSim.setClockErrors(400000, 2000000);
+    marginalSim.setClockErrors(700000, 30000000);
+    brokenSim.setClockErrors(50000, 150000);
+
+    printf("Error model:\n");
+    bool bOk = testErrorModel(slowSim);
+    printf("Tuning:\n");
+    bOk = testTune() && bOk;
+    printf("Reads a clock:\n");
+    bOk = testReads(marginalSim) && bOk;
+    marginalSim.setClockErrors(700000, 30000000);
+    printf("Record:\n");
+    bOk = testRecord() && bOk;
+    printf("Shared bus:\n");
+    bOk = testSharedBus() && bOk;
+
+    for (int i = 0; i < 4; i++)
+        Wire.detach(kAddresses[i]);
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+// test_coroutine.cpp - host test of the coroutine bus interface
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++20 -O2 -pthread -Itests/host/sim -Isrc -o test_coroutine
+//       tests/host/test_coroutine.cpp src/sfeTkArdI2C.cpp
+
+#include <stdio.h>
+
+#include <sfeTk/sfeTkBusServiceThread.h>
+#include <sfeTk/sfeTkCoroutine.h>
+#include <sfeTkArdI2C.h>
+
+static const uint8_t kDevAddress = 0x48;
+
+static const uint8_t kRegControl = 0x10;
+static const uint8_t kRegStatus = 0x11;
+static const uint8_t kRegData = 0x20;
+static const uint8_t kRegScratch = 0x30;
+
+static const uint8_t kControlStart = 0x01;
+static const uint8_t kStatusReady = 0x01;
+
+// A device that takes 3 ms to complete a conversion once started
+class simConverter : public sfeTkSimDevice
+{
+  public:
+    simConverter() : _readyAt{0}, _nConversions{0}
+    {
+    }
+
+  protected:
+    void onWrite(uint16_t theReg, uint8_t value) override
+    {
+        sfeTkSimDevice::onWrite(theReg, value);
+        if (theReg == kRegControl && (value & kControlStart))
+        {
+            _readyAt = millis() + 3;
+            _regs[kRegStatus] = 0;
+            // the result is the conversion count - the reader can check it got a fresh sample
+            _nConversions++;
+            _regs[kRegData] = (uint8_t)(_nConversions & 0xFF);
+            _regs[kRegData + 1] = (uint8_t)(_nConversions >> 8);
+        }
+    }
+
+    uint8_t onRead(uint16_t theReg) override
+    {
+        if (theReg == kRegStatus && millis() >= _readyAt)
+            _regs[kRegStatus] = kStatusReady;
+
+        return sfeTkSimDevice::onRead(theReg);
+    }
+
+  private:
+    unsigned long _readyAt;
+    uint16_t _nConversions;
+};
+
+static uint32_t nowMS(void)
+{
+    return millis();
+}
+
+typedef sfeTkBusService<8, 2> busService;
+
+// trigger, wait, poll for ready, read and compute - as straight line code
+static sfeTkCoTask measure(sfeTkCoBus<busService> &bus, sfeTkCoExecutor &executor, uint16_t &sample)
+{
+    sfeTkError_t rc = co_await bus.writeRegisterByte(kRegControl, kControlStart);
+    if (rc != kSTkErrOk)
+        co_return rc;
+
+    co_await executor.delay(2);
+
+    uint8_t status = 0;
+    for (int tries = 0; tries < 10; tries++)
+    {
+        rc = co_await bus.readRegisterByte(kRegStatus, status);
+        if (rc != kSTkErrOk || (status & kStatusReady))
+            break;
+        co_await executor.delay(1);
+    }
+    if (rc != kSTkErrOk)
+        co_return rc;
+    if (!(status & kStatusReady))
+        co_return kSTkErrBusTimeout;
+
+    co_return co_await bus.readRegisterWord(kRegData, sample);
+}
+
+// a measurement loop that uses the measure() sub-operation
+static sfeTkCoTask sampler(sfeTkCoBus<busService> &bus, sfeTkCoExecutor &executor, int nSamples, bool &bOk)
+{
+    uint16_t last = 0;
+    bOk = true;
+
+    for (int i = 0; i < nSamples; i++)
+    {
+        uint16_t sample = 0;
+        sfeTkError_t rc = co_await measure(bus, executor, sample);
+        if (rc != kSTkErrOk || sample <= last)
+            bOk = false;
+        last = sample;
+        co_await executor.delay(5);
+    }
+    co_return kSTkErrOk;
+}
+
+// a task that only uses timers - must interleave with the bus work
+static sfeTkCoTask ticker(sfeTkCoExecutor &executor, int nTicks, int &count)
+{
+    for (int i = 0; i < nTicks; i++)
+    {
+        co_await executor.delay(4);
+        count++;
+    }
+    co_return kSTkErrOk;
+}
+
+// every write operation - a raw byte sets the register pointer, a raw word or region is the register and its
+// data, as the device sees it
+static sfeTkCoTask writer(sfeTkCoBus<busService> &bus)
+{
+    static const uint8_t kRegion[] = {kRegScratch, 0xA5, 0x5A};
+    static const uint8_t kBlock[] = {0x11, 0x22};
+
+    sfeTkError_t rc = co_await bus.writeByte(kRegScratch);
+    if (rc == kSTkErrOk)
+        rc = co_await bus.writeRegion(kRegion, sizeof(kRegion));
+    if (rc == kSTkErrOk)
+        rc = co_await bus.writeWord((uint16_t)(0xC3 << 8 | (kRegScratch + 2)));
+    if (rc == kSTkErrOk)
+        rc = co_await bus.writeRegisterByte(kRegScratch + 3, 0x3C);
+    if (rc == kSTkErrOk)
+        rc = co_await bus.writeRegisterWord(kRegScratch + 4, 0x1234);
+    if (rc == kSTkErrOk)
+        rc = co_await bus.writeRegisterRegion(kRegScratch + 6, kBlock, sizeof(kBlock));
+
+    uint16_t value = 0;
+    if (rc == kSTkErrOk)
+        rc = co_await bus.readRegisterWord(kRegScratch + 4, value);
+    if (rc == kSTkErrOk && value != 0x1234)
+        rc = kSTkErrFail;
+
+    co_return rc;
+}
+
+static bool runWrites(const char *name, busService &service, bool bInline, simConverter &device)
+{
+    static const uint8_t kExpected[] = {0xA5, 0x5A, 0xC3, 0x3C, 0x34, 0x12, 0x11, 0x22};
+    for (size_t i = 0; i < sizeof(kExpected); i++)
+        device.setReg(kRegScratch + i, 0);
+
+    sfeTkCoExecutor executor(nowMS);
+    sfeTkCoBus<busService> bus(service, executor);
+    sfeTkError_t result = kSTkErrFail;
+
+    unsigned long start = millis();
+    executor.spawn(writer(bus), &result);
+    while (executor.nActive() > 0 && millis() - start < 2000)
+    {
+        if (bInline)
+            service.serviceAll();
+        executor.runOnce();
+    }
+
+    bool bOk = result == kSTkErrOk && sfeTkCoFramePool::nInUse() == 0;
+    for (size_t i = 0; i < sizeof(kExpected); i++)
+        bOk = bOk && device.reg(kRegScratch + i) == kExpected[i];
+
+    printf("%-16s: write operations  %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+static bool runTest(const char *name, busService &service, bool bInline)
+{
+    sfeTkCoExecutor executor(nowMS);
+    sfeTkCoBus<busService> bus(service, executor);
+
+    bool bSamplesOk = false;
+    int nTicks = 0;
+    sfeTkError_t samplerResult, tickerResult;
+
+    unsigned long start = millis();
+    executor.spawn(sampler(bus, executor, 10, bSamplesOk), &samplerResult);
+    executor.spawn(ticker(executor, 20, nTicks), &tickerResult);
+
+    size_t nResumes = 0;
+    while (executor.nActive() > 0 && millis() - start < 2000)
+    {
+        if (bInline)
+            service.serviceAll();
+        nResumes += executor.runOnce();
+    }
+
+    bool bOk = bSamplesOk && nTicks == 20 && samplerResult == kSTkErrOk && tickerResult == kSTkErrOk &&
+               sfeTkCoFramePool::nInUse() == 0 && sfeTkCoFramePool::nHeapFrames() == 0;
+
+    printf("%-16s: %lu ms  %zu resumes  frame pool high water %zu/%zu  heap frames %zu  %s\n", name,
+           millis() - start, nResumes, sfeTkCoFramePool::highWater(), sfeTkCoFramePool::kBlockCount,
+           sfeTkCoFramePool::nHeapFrames(), bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+int main(void)
+{
+    simConverter device;
+    Wire.attach(kDevAddress, device);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kDevAddress);
+
+    busService inlineService(i2c);
+    bool bOk = runTest("inline service", inlineService, true);
+    bOk = runWrites("inline service", inlineService, true, device) && bOk;
+
+    sfeTkBusServiceThread<8, 2> threadService(i2c);
+    threadService.start();
+    bOk = runTest("service thread", threadService, false) && bOk;
+    bOk = runWrites("service thread", threadService, false, device) && bOk;
+    threadService.stop();
+
+    printf("%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+// test_device_handles.cpp - host test of the shared port contexts and per-device handles
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o test_device_handles tests/host/test_device_handles.cpp
+//       src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp src/sfeTkArdI2CPort.cpp src/sfeTkArdSPIPort.cpp
+
+#include <stdio.h>
+
+#include <mutex>
+#include <utility>
+
+#include <sfeTkArdI2CPort.h>
+#include <sfeTkArdSPIPort.h>
+
+static const int kDevices = 20;
+static const uint8_t kFirstAddress = 0x20;
+static const uint8_t kFirstCS = 10;
+static const uint8_t kRegId = 0x0F;
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-36s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+class CountingLock : public sfeTkILock
+{
+  public:
+    void lock(void)
+    {
+        _mutex.lock();
+        nLocks++;
+    }
+    void unlock(void)
+    {
+        _mutex.unlock();
+    }
+    int nLocks = 0;
+
+  private:
+    std::mutex _mutex;
+};
+
+// Each device answers its own id - a read that goes to the wrong device is caught
+template <typename Handle> static bool readIds(Handle *devices, sfeTkSimDevice *sims)
+{
+    for (int i = 0; i < kDevices; i++)
+    {
+        uint8_t id = 0;
+        if (devices[i].readRegisterByte(kRegId, id) != kSTkErrOk || id != sims[i].reg(kRegId))
+            return false;
+    }
+    return true;
+}
+
+static bool testI2C(void)
+{
+    sfeTkSimDevice sims[kDevices];
+    for (int i = 0; i < kDevices; i++)
+    {
+        sims[i].setReg(kRegId, (uint8_t)(0xA0 + i));
+        Wire.attach((uint8_t)(kFirstAddress + i), sims[i]);
+    }
+
+    sfeTkArdI2CPort port;
+    CountingLock lock;
+    port.init(Wire);
+    port.setLock(&lock);
+    port.setClock(400000);
+
+    sfeTkArdI2CDevice devices[kDevices];
+    for (int i = 0; i < kDevices; i++)
+        devices[i].init(port, (uint8_t)(kFirstAddress + i));
+
+    bool bOk = check("I2C handles read their own device", readIds(devices, sims));
+
+    // write through one handle, read back through a copy
+    uint8_t data[4] = {1, 2, 3, 4}, back[4] = {0};
+    size_t nRead = 0;
+    sfeTkArdI2CDevice copy = devices[7];
+    copy.setStop(false);
+    sfeTkArdI2CDevice moved = std::move(copy);
+    bOk = check("I2C handle copy and move keep state",
+                moved.address() == kFirstAddress + 7 && !moved.stop() && moved.port() == &port &&
+                    devices[7].writeRegisterRegion(0x30, data, sizeof(data)) == kSTkErrOk &&
+                    moved.readRegisterRegion(0x30, back, sizeof(back), nRead) == kSTkErrOk && nRead == 4 &&
+                    memcmp(data, back, 4) == 0) &&
+          bOk;
+
+    bOk = check("I2C port lock and statistics", lock.nLocks == (int)port.nTransactions() + 1 &&
+                                                    port.nTransactions() == kDevices + 2 && port.nErrors() == 0 &&
+                                                    port.clock() == 400000 && Wire.clock() == 400000) &&
+          bOk;
+
+    sfeTkArdI2CDevice unattached;
+    uint8_t value;
+    bOk = check("I2C unattached handle", unattached.readRegisterByte(kRegId, value) == kSTkErrBusNotInit) && bOk;
+
+    // the full bus object now keeps its address and chunk size when copied
+    sfeTkArdI2C full;
+    full.init(Wire, kFirstAddress + 3);
+    full.setBufferChunkSize(8);
+    full.setStop(false);
+    sfeTkArdI2C fullCopy(full), fullAssigned;
+    fullAssigned = full;
+    sfeTkArdI2C byAddress(kFirstAddress + 4);
+    bOk = check("sfeTkArdI2C copy keeps state",
+                fullCopy.address() == kFirstAddress + 3 && fullCopy.bufferChunkSize() == 8 && !fullCopy.stop() &&
+                    fullAssigned.address() == kFirstAddress + 3 && fullAssigned.bufferChunkSize() == 8 &&
+                    byAddress.port() == nullptr && byAddress.bufferChunkSize() == 32 && byAddress.stop() &&
+                    fullCopy.readRegisterByte(kRegId, value) == kSTkErrOk && value == 0xA3) &&
+          bOk;
+
+    for (int i = 0; i < kDevices; i++)
+        Wire.detach((uint8_t)(kFirstAddress + i));
+
+    printf("\n%d I2C devices on one bus, RAM on this host:\n", kDevices);
+    printf("  sfeTkArdI2C per device         : %3zu bytes, %4zu total\n", sizeof(sfeTkArdI2C),
+           kDevices * sizeof(sfeTkArdI2C));
+    printf("  sfeTkArdI2CDevice per device   : %3zu bytes, %4zu total + %zu byte port context\n\n",
+           sizeof(sfeTkArdI2CDevice), kDevices * sizeof(sfeTkArdI2CDevice), sizeof(sfeTkArdI2CPort));
+    return bOk;
+}
+
+static bool testSPI(void)
+{
+    sfeTkSimDevice sims[kDevices];
+    for (int i = 0; i < kDevices; i++)
+    {
+        sims[i].setReg(kRegId, (uint8_t)(0x50 + i));
+        SPI.attach((uint8_t)(kFirstCS + i), sims[i]);
+    }
+
+    sfeTkArdSPIPort port;
+    SPISettings settings(4000000, MSBFIRST, SPI_MODE0);
+    port.init(SPI, settings);
+
+    sfeTkArdSPIDevice devices[kDevices];
+    for (int i = 0; i < kDevices; i++)
+        devices[i] = sfeTkArdSPIDevice(port, (uint8_t)(kFirstCS + i));
+
+    bool bOk = check("SPI handles read their own device", readIds(devices, sims));
+
+    sfeTkArdSPIDevice copy(devices[5]);
+    bOk = check("SPI handle copy keeps state", copy.cs() == kFirstCS + 5 && copy.port() == &port) && bOk;
+
+    // the full bus object keeps its CS pin when copied
+    sfeTkArdSPI full;
+    full.init(SPI, settings, kFirstCS + 2);
+    sfeTkArdSPI fullCopy(full), fullAssigned;
+    fullAssigned = full;
+    sfeTkArdSPI byCS(kFirstCS);
+    uint8_t value = 0;
+    bOk = check("sfeTkArdSPI copy keeps state", fullCopy.cs() == kFirstCS + 2 && fullAssigned.cs() == kFirstCS + 2 &&
+                                                   byCS.port() == nullptr &&
+                                                   fullCopy.readRegisterByte(kRegId, value) == kSTkErrOk &&
+                                                   value == 0x52) &&
+          bOk;
+
+    printf("\n%d SPI devices on one bus, RAM on this host:\n", kDevices);
+    printf("  sfeTkArdSPI per device         : %3zu bytes, %4zu total\n", sizeof(sfeTkArdSPI),
+           kDevices * sizeof(sfeTkArdSPI));
+    printf("  sfeTkArdSPIDevice per device   : %3zu bytes, %4zu total + %zu byte port context\n\n",
+           sizeof(sfeTkArdSPIDevice), kDevices * sizeof(sfeTkArdSPIDevice), sizeof(sfeTkArdSPIPort));
+    return bOk;
+}
+
+int main(void)
+{
+    bool bOk = testI2C();
+    bOk = testSPI() && bOk;
+
+    printf("%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
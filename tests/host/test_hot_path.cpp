@@ -0,0 +1,348 @@
+// test_hot_path.cpp - verifies the bus operations don't allocate, and measures their stack depth
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root) - the toolkit sources must be built with SFE_TK_HOT_PATH_CHECK:
+//   g++ -std=c++17 -O2 -DSFE_TK_HOT_PATH_CHECK -Itests/host/sim -Isrc -o test_hot_path
+//       tests/host/test_hot_path.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+//
+// Allocation: operator new and malloc are replaced, and any allocation made while a SFE_TK_HOT_PATH() scope is
+// active is recorded as a violation.
+//
+// Stack depth: each operation runs on its own stack (ucontext), painted with a pattern beforehand. The deepest
+// overwritten byte gives the worst case depth of the call, less the depth of an empty call (the harness).
+// Depths are for this host - they track changes, they are not the depths on a board.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include <new>
+
+#include <sfeTk/sfeTkHotPath.h>
+#include <sfeTkArdI2C.h>
+#include <sfeTkArdSPI.h>
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+//---------------------------------------------------------------------------
+// Hot path tracking - the hooks called by SFE_TK_HOT_PATH() scopes
+
+static thread_local int hotDepth = 0;
+static thread_local const char *hotName = nullptr;
+
+static const int kMaxViolations = 16;
+static const char *violationNames[kMaxViolations];
+static size_t violationSizes[kMaxViolations];
+static int nViolations = 0;
+
+void sfeTkHotPathEnter(const char *name)
+{
+    if (hotDepth++ == 0)
+        hotName = name;
+}
+
+void sfeTkHotPathLeave(void)
+{
+    hotDepth--;
+}
+
+static void checkAlloc(size_t size)
+{
+    if (hotDepth == 0)
+        return;
+
+    if (nViolations < kMaxViolations)
+    {
+        violationNames[nViolations] = hotName;
+        violationSizes[nViolations] = size;
+    }
+    nViolations++;
+}
+
+extern "C" void *malloc(size_t size)
+{
+    checkAlloc(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    checkAlloc(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    checkAlloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+//---------------------------------------------------------------------------
+// Stack painting
+
+static const size_t kStackSize = 64 * 1024;
+static const uint8_t kPaint = 0xA5;
+
+static uint8_t opStack[kStackSize] __attribute__((aligned(16)));
+static ucontext_t mainContext, opContext;
+
+typedef void (*OpFn)(void);
+static OpFn currentOp;
+
+static void runOp(void)
+{
+    currentOp();
+}
+
+// returns the number of stack bytes used while running op
+static size_t stackDepth(OpFn op)
+{
+    memset(opStack, kPaint, sizeof(opStack));
+
+    currentOp = op;
+    getcontext(&opContext);
+    opContext.uc_stack.ss_sp = opStack;
+    opContext.uc_stack.ss_size = sizeof(opStack);
+    opContext.uc_link = &mainContext;
+    makecontext(&opContext, runOp, 0);
+    swapcontext(&mainContext, &opContext);
+
+    // the stack grows down - find the lowest byte that was written
+    size_t untouched = 0;
+    while (untouched < kStackSize && opStack[untouched] == kPaint)
+        untouched++;
+    return kStackSize - untouched;
+}
+
+//---------------------------------------------------------------------------
+// The operations - called through sfeTkIBus, as a driver would
+
+static const uint8_t kDevAddress = 0x6A;
+static const uint8_t kDevCS = 7;
+static const size_t kRegionLength = 64;
+
+static sfeTkIBus *theBus;
+static uint8_t buffer[kRegionLength];
+static sfeTkError_t lastResult;
+
+static void opNone(void)
+{
+}
+
+static void opWriteByte(void)
+{
+    lastResult = theBus->writeByte(0x11);
+}
+
+static void opWriteWord(void)
+{
+    lastResult = theBus->writeWord(0x1122);
+}
+
+static void opWriteRegion(void)
+{
+    lastResult = theBus->writeRegion(buffer, kRegionLength);
+}
+
+static void opWriteRegisterByte(void)
+{
+    lastResult = theBus->writeRegisterByte(0x20, 0x33);
+}
+
+static void opWriteRegisterWord(void)
+{
+    lastResult = theBus->writeRegisterWord(0x20, 0x3344);
+}
+
+static void opWriteRegisterRegion(void)
+{
+    lastResult = theBus->writeRegisterRegion(0x20, buffer, kRegionLength);
+}
+
+static void opWriteRegister16Region(void)
+{
+    lastResult = theBus->writeRegister16Region(0x0020, buffer, kRegionLength);
+}
+
+static void opReadRegisterByte(void)
+{
+    uint8_t value;
+    lastResult = theBus->readRegisterByte(0x20, value);
+}
+
+static void opReadRegisterWord(void)
+{
+    uint16_t value;
+    lastResult = theBus->readRegisterWord(0x20, value);
+}
+
+static void opReadRegisterRegion(void)
+{
+    size_t nRead;
+    lastResult = theBus->readRegisterRegion(0x20, buffer, kRegionLength, nRead);
+}
+
+static void opReadRegister16Region(void)
+{
+    size_t nRead;
+    lastResult = theBus->readRegister16Region(0x0020, buffer, kRegionLength, nRead);
+}
+
+struct Operation
+{
+    const char *name;
+    OpFn fn;
+};
+
+static const Operation operations[] = {
+    {"writeByte", opWriteByte},
+    {"writeWord", opWriteWord},
+    {"writeRegion", opWriteRegion},
+    {"writeRegisterByte", opWriteRegisterByte},
+    {"writeRegisterWord", opWriteRegisterWord},
+    {"writeRegisterRegion", opWriteRegisterRegion},
+    {"writeRegister16Region", opWriteRegister16Region},
+    {"readRegisterByte", opReadRegisterByte},
+    {"readRegisterWord", opReadRegisterWord},
+    {"readRegisterRegion", opReadRegisterRegion},
+    {"readRegister16Region", opReadRegister16Region},
+};
+
+// A budget per operation, on this host - well above today's depths, catches a large buffer on the stack or
+// unexpected recursion.
+static const size_t kStackBudget = 512;
+
+struct Measured
+{
+    size_t stack;
+    int nAllocs;
+    bool bOk;
+};
+
+static Measured measure(sfeTkIBus &bus, OpFn fn, size_t baseline)
+{
+    theBus = &bus;
+    int before = nViolations;
+    size_t depth = stackDepth(fn);
+
+    Measured result;
+    result.stack = depth > baseline ? depth - baseline : 0;
+    result.nAllocs = nViolations - before;
+    result.bOk = lastResult == kSTkErrOk;
+    return result;
+}
+
+// The harness must catch an allocation in a hot path - or a clean result means nothing
+static void leakyHotPath(void)
+{
+    SFE_TK_HOT_PATH();
+    int *value = new int(1);
+    lastResult = *value == 1 ? kSTkErrOk : kSTkErrFail;
+    delete value;
+}
+
+int main(void)
+{
+    sfeTkSimDevice i2cDevice, spiDevice;
+    Wire.attach(kDevAddress, i2cDevice);
+    SPI.attach(kDevCS, spiDevice);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kDevAddress);
+
+    sfeTkArdSPI spi;
+    SPISettings settings(4000000, MSBFIRST, SPI_MODE0);
+    spi.init(SPI, settings, kDevCS);
+
+    size_t baseline = stackDepth(opNone);
+
+    int before = nViolations;
+    stackDepth(leakyHotPath);
+    bool bOk = nViolations == before + 1;
+    printf("%-24s: %s\n", "harness self check", bOk ? "ok" : "FAILED - an allocation was not detected");
+    nViolations = before;
+
+    printf("\n%-24s %14s %14s\n", "operation", "I2C stack/allocs", "SPI stack/allocs");
+    for (const Operation &op : operations)
+    {
+        Measured onI2C = measure(i2c, op.fn, baseline);
+        Measured onSPI = measure(spi, op.fn, baseline);
+
+        bool bOpOk = onI2C.bOk && onSPI.bOk && onI2C.nAllocs == 0 && onSPI.nAllocs == 0 &&
+                     onI2C.stack <= kStackBudget && onSPI.stack <= kStackBudget;
+
+        printf("%-24s %8zu B / %d %8zu B / %d  %s\n", op.name, onI2C.stack, onI2C.nAllocs, onSPI.stack, onSPI.nAllocs,
+               bOpOk ? "" : "FAILED");
+        bOk = bOpOk && bOk;
+    }
+    printf("(stack in bytes on this host, less the %zu byte harness baseline, budget %zu bytes)\n\n", baseline,
+           kStackBudget);
+
+    for (int i = 0; i < nViolations && i < kMaxViolations; i++)
+        printf("allocation of %zu bytes in %s\n", violationSizes[i], violationNames[i]);
+
+    printf("%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
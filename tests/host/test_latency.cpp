@@ -0,0 +1,341 @@
+// test_latency.cpp - host test of the interrupt latency probe (sfeTkLatency.h)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o test_latency tests/host/test_latency.cpp
+//       src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+//
+// Checks the bins and percentiles of the log-linear histogram, and the probe with a manual clock - the three
+// stages of an event, overruns, failed reads and the worst cases. Then stamps the bus start and done with the
+// latency hooks on the simulated I2C bus, on a clock of simulated wire time, so the bus stage is exactly the wire
+// time of the reads. Last, a simulated interrupt source (sfeTkSimInterrupt.h) raises data ready every 2 ms with
+// jitter, and the main loop - busy with other work for a random time between polls - reads the data over a real
+// time 400 kHz bus. The probe is the Arduino one, on the cycle counter, and the report is printed.
+
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <random>
+
+#include <sfeTkArdBusHooks.h>
+#include <sfeTkSimInterrupt.h>
+
+static const uint8_t kAddress = 0x42;
+static const uint8_t kAbsent = 0x43;
+static const uint8_t kRegStatus = 0x27;
+static const uint8_t kRegData = 0x28;
+
+// A clock set by the test
+struct ManualClock
+{
+    static uint32_t tick;
+    static uint32_t now(void)
+    {
+        return tick;
+    }
+};
+uint32_t ManualClock::tick = 0;
+
+// Simulated time in nanoseconds - the wire time of the bus, and the time the test adds
+struct SimClock
+{
+    static uint64_t idleNanos;
+    static uint32_t now(void)
+    {
+        return (uint32_t)(idleNanos + Wire.busyNanos());
+    }
+};
+uint64_t SimClock::idleNanos = 0;
+
+// Report output
+struct Print
+{
+    void println(const char *line)
+    {
+        printf("%s\n", line);
+    }
+};
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-52s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+template <typename Histogram> static bool ordered(const Histogram &histogram)
+{
+    return histogram.min() <= histogram.percentile(500) && histogram.percentile(500) <= histogram.percentile(900) &&
+           histogram.percentile(900) <= histogram.percentile(990) &&
+           histogram.percentile(990) <= histogram.percentile(999) && histogram.percentile(999) <= histogram.max();
+}
+
+static bool testHistogram(void)
+{
+    bool bOk = true;
+    typedef sfeTkLatencyHistogram<> Histogram;
+
+    // every value is in the bin that claims it, and bins are contiguous
+    bool bBins = true;
+    for (uint32_t value = 0; value < 100000; value += value < 64 ? 1 : 7)
+    {
+        size_t bin = Histogram::binOf(value);
+        bBins = bBins && Histogram::binLow(bin) <= value && value <= Histogram::binHigh(bin);
+    }
+    for (size_t bin = 1; bin < 16 + 28 * 8; bin++)
+        bBins = bBins && Histogram::binLow(bin) == Histogram::binHigh(bin - 1) + 1;
+    bOk = check("bins cover the values", bBins && Histogram::binOf(0xFFFFFFFFUL) == 16 + 28 * 8 - 1) && bOk;
+    bOk = check("values under 16 are exact", Histogram::binOf(15) == 15 && Histogram::binHigh(15) == 15) && bOk;
+    bOk = check("8 bins a power of two", Histogram::binOf(1024) - Histogram::binOf(512) == 8) && bOk;
+
+    Histogram histogram;
+    for (uint32_t value = 1; value <= 1000; value++)
+        histogram.add(value);
+    uint32_t p50 = histogram.percentile(500);
+    uint32_t p99 = histogram.percentile(990);
+    bOk = check("min, max and mean", histogram.min() == 1 && histogram.max() == 1000 && histogram.mean() == 500) &&
+          bOk;
+    bOk = check("median within a bin", p50 >= 500 && p50 <= 500 + 500 / 8) && bOk;
+    bOk = check("p99 within a bin", p99 >= 990 && p99 <= 1000) && bOk;
+    bOk = check("p100 is the maximum", histogram.percentile(1000) == 1000) && bOk;
+    bOk = check("percentiles in order", ordered(histogram)) && bOk;
+
+    // past the last bin - counted there, and the percentile is the maximum
+    sfeTkLatencyHistogram<32> small;
+    small.add(3);
+    small.add(1000000);
+    bOk = check("overflow bin", small.binCount(31) == 1 && small.percentile(1000) == 1000000) && bOk;
+
+    histogram.reset();
+    bOk = check("reset", histogram.count() == 0 && histogram.percentile(500) == 0) && bOk;
+    return bOk;
+}
+
+static bool testProbe(void)
+{
+    bool bOk = true;
+    sfeTkLatencyProbe<ManualClock, 64, 2> probe;
+
+    // done without an interrupt is ignored
+    probe.busStart();
+    probe.busDone();
+    bOk = check("no interrupt, no event", probe.total().count() == 0) && bOk;
+
+    ManualClock::tick = 100;
+    probe.interrupt();
+    ManualClock::tick = 150;
+    probe.busStart();
+    ManualClock::tick = 170;
+    probe.busStart(); // the read already started
+    ManualClock::tick = 400;
+    probe.busDone();
+    bOk = check("the stages of an event", probe.toStart().max() == 50 && probe.bus().max() == 250 &&
+                                               probe.total().max() == 300) &&
+          bOk;
+
+    // an interrupt before the last is served keeps the first stamp
+    ManualClock::tick = 1000;
+    probe.interrupt();
+    ManualClock::tick = 1100;
+    probe.interrupt();
+    probe.busStart();
+    ManualClock::tick = 1200;
+    probe.busDone();
+    bOk = check("overrun keeps the first interrupt",
+                probe.overruns() == 1 && probe.interrupts() == 3 && probe.total().max() == 300 &&
+                    probe.toStart().max() == 100) &&
+          bOk;
+
+    // a failed read is counted, not timed
+    ManualClock::tick = 2000;
+    probe.interrupt();
+    probe.busStart();
+    ManualClock::tick = 9000;
+    probe.busDone(kSTkErrFail);
+    bOk = check("failed read", probe.failures() == 1 && probe.total().count() == 2) && bOk;
+
+    // the worst cases, longest first - only two are kept. Events are numbered from the interrupts taken, with the
+    // failed read
+    ManualClock::tick = 10000;
+    probe.interrupt();
+    probe.busStart();
+    ManualClock::tick = 10500;
+    probe.busDone();
+    bOk = check("worst cases", probe.worstCount() == 2 && probe.worst(0).total == 500 &&
+                                   probe.worst(1).total == 300 && probe.worst(0).sequence == 4) &&
+          bOk;
+
+    probe.reset();
+    bOk = check("reset", probe.total().count() == 0 && probe.interrupts() == 0 && probe.worstCount() == 0) && bOk;
+    return bOk;
+}
+
+typedef sfeTkLatencyProbe<SimClock, 176, 4> SimProbe;
+
+static bool testHooks(void)
+{
+    bool bOk = true;
+    Wire.setClock(400000);
+    sfeTkArdI2CHooked<sfeTkLatencyHooks<SimProbe>> i2c;
+    i2c.init(Wire, kAddress);
+    SimProbe probe;
+    i2c.hooks().attach(probe);
+
+    uint8_t data[12];
+    size_t nRead;
+
+    // bus operations without an interrupt are not stamped
+    i2c.writeRegisterByte(kRegStatus, 0);
+    i2c.readRegisterRegion(kRegData, data, sizeof(data), nRead);
+    bOk = check("no stamps without an interrupt", probe.total().count() == 0) && bOk;
+
+    // the interrupt, 20 us to start the read, then a status read and the data
+    probe.interrupt();
+    SimClock::idleNanos += 20000;
+    uint64_t start = Wire.busyNanos();
+    uint8_t status;
+    i2c.readRegisterByte(kRegStatus, status);
+    bOk = check("a status read does not end the event", probe.total().count() == 0) && bOk;
+    i2c.readRegisterRegion(kRegData, data, sizeof(data), nRead);
+    uint32_t wire = (uint32_t)(Wire.busyNanos() - start);
+    bOk = check("interrupt to the first operation", probe.toStart().max() == 20000) && bOk;
+    bOk = check("bus time is the wire time", probe.bus().max() == wire && probe.total().max() == 20000 + wire) && bOk;
+
+    sfeTkBusWire model = sfeTkBusWire::i2c(400000);
+    uint32_t modelled = model.time(model.bits(true, 1, 1) + model.bits(true, 1, sizeof(data)), 1000000000);
+    bOk = check("and the wire model", wire + 20 >= modelled && wire <= modelled + 20) && bOk;
+
+    // a failed read on a bus attached to the same probe
+    sfeTkArdI2CHooked<sfeTkLatencyHooks<SimProbe>> absent;
+    absent.init(Wire, kAbsent);
+    absent.hooks().attach(probe);
+    probe.interrupt();
+    absent.readRegisterRegion(kRegData, data, sizeof(data), nRead);
+    bOk = check("failed read counted", probe.failures() == 1 && probe.total().count() == 1) && bOk;
+
+    // another operation type ends the event
+    i2c.hooks().attach(probe, kSTkBusHookReadRegisterByte);
+    probe.interrupt();
+    i2c.readRegisterByte(kRegStatus, status);
+    bOk = check("attached to a byte read", probe.total().count() == 2) && bOk;
+
+    i2c.hooks().detach();
+    probe.interrupt();
+    i2c.readRegisterByte(kRegStatus, status);
+    bOk = check("detached", probe.total().count() == 2) && bOk;
+    return bOk;
+}
+
+// The synthetic interrupt source and the main loop
+static sfeTkArdLatencyProbe probe;
+static std::atomic<bool> bDataReady{false};
+
+static void onDataReady(void *)
+{
+    probe.interrupt();
+    bDataReady = true;
+}
+
+// The ticks a second of the cycle counter - measured against the steady clock where the core does not know it
+static uint32_t cyclesHz(void)
+{
+    if (sfeTkArdCyclesHz() > 0)
+        return sfeTkArdCyclesHz();
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t cycles = sfeTkArdCycles();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100))
+        ;
+    uint32_t elapsed = sfeTkArdCycles() - cycles;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (uint32_t)(elapsed / seconds);
+}
+
+static bool testSynthetic(void)
+{
+    bool bOk = true;
+    uint32_t rate = cyclesHz();
+
+    Wire.setClock(400000);
+    Wire.setRealTime(true);
+    sfeTkArdI2CHooked<sfeTkArdLatencyHooks> i2c;
+    i2c.init(Wire, kAddress);
+    i2c.hooks().attach(probe);
+    probe.reset();
+
+    // data ready every 2 ms, up to 300 us late; the main loop works up to 400 us between polls
+    sfeTkSimInterrupt dataReady;
+    std::minstd_rand random(7);
+    dataReady.start(onDataReady, nullptr, 2000, 300);
+
+    uint8_t data[12];
+    size_t nRead;
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        sfeTkSim::spinNanos((random() % 400) * 1000);
+        if (bDataReady.exchange(false))
+            i2c.readRegisterRegion(kRegData, data, sizeof(data), nRead);
+    }
+    dataReady.stop();
+    Wire.setRealTime(false);
+
+    printf("\nSynthetic data ready, 2 ms +0..300 us, 12 byte read at 400 kHz - cycle counter at %lu MHz:\n\n",
+           (unsigned long)(rate / 1000000));
+    Print out;
+    probe.report(out, rate);
+    printf("\n");
+
+    const sfeTkArdLatencyProbe::Histogram &total = probe.total();
+    uint32_t events = total.count();
+    bOk = check("interrupts raised and stamped", probe.interrupts() == dataReady.count() && events > 400) && bOk;
+    bOk = check("every interrupt served or an overrun",
+                events + probe.overruns() + 1 >= probe.interrupts() && probe.failures() == 0) &&
+          bOk;
+    bOk = check("percentiles in order", ordered(probe.toStart()) && ordered(probe.bus()) && ordered(total)) && bOk;
+    bOk = check("worst case is the maximum",
+                probe.worst(0).total == total.max() && probe.worst(0).total >= total.percentile(990)) &&
+          bOk;
+
+    // the read takes at least its wire time
+    sfeTkBusWire model = sfeTkBusWire::i2c(400000);
+    uint64_t wire = (uint64_t)model.time(model.bits(true, 1, sizeof(data)), 1000000) * rate / 1000000;
+    bOk = check("bus stage is at least the wire time", probe.bus().min() + probe.bus().min() / 50 >= wire) && bOk;
+    return bOk;
+}
+
+int main()
+{
+    sfeTkSimDevice sim;
+    Wire.attach(kAddress, sim);
+
+    bool bOk = testHistogram();
+    bOk = testProbe() && bOk;
+    bOk = testHooks() && bOk;
+    bOk = testSynthetic() && bOk;
+
+    Wire.detach(kAddress);
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,291 @@
+// test_log.cpp - host test and benchmark of the binary log (sfeTkLog.h, sfeTkArdLog.h)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -DSFE_TK_LOG_LEVEL=4 -Itests/host/sim -Isrc -o test_log tests/host/test_log.cpp
+//       src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp src/sfeTkArdI2CPort.cpp src/sfeTkArdSPIPort.cpp
+//       src/sfeTkArdLog.cpp
+//
+// Checks the record layout and argument encoding, that a full log drops its oldest records, that the bus code
+// logs a failed I2C read, and that the format strings of log sites are not in the program. Then compares the
+// cost of a log site to formatting the same message with snprintf.
+//
+// Run with a file name to save a capture of the log, then decode it:
+//   ./test_log capture.txt
+//   python3 tools/sfeTkLog.py decode capture.txt --src src tests/host/test_log.cpp
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <sfeTkArdI2C.h>
+#include <sfeTkArdLog.h>
+
+#if SFE_TK_LOG_LEVEL < 4
+#error "build with -DSFE_TK_LOG_LEVEL=4"
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define kUnits "cycles"
+static inline uint64_t now(void)
+{
+    return __rdtsc();
+}
+#else
+#define kUnits "ns"
+static inline uint64_t now(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+#endif
+
+static const uint8_t kAddress = 0x42;
+static const uint8_t kAbsent = 0x43;
+static const uint8_t kRegData = 0x28;
+
+// The IDs are the FNV-1a hashes of the formats, at compile time
+static_assert(sfeTkLogHash("") == 0x811C9DC5UL, "FNV-1a of the empty string");
+static_assert(sfeTkLogHash("a") == 0xE40C292CUL, "FNV-1a of \"a\"");
+static_assert(sfeTkLogHash("foobar") == 0xBF9CF968UL, "FNV-1a of \"foobar\"");
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-52s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+static uint32_t get32(const uint8_t *data)
+{
+    return data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+// Collects the lines of sfeTkArdLogDump()
+struct CaptureOut
+{
+    std::string pending;
+    std::vector<std::string> lines;
+
+    void print(const char *text)
+    {
+        pending += text;
+    }
+    void println(const char *text)
+    {
+        lines.push_back(pending + text);
+        pending.clear();
+    }
+    void println(unsigned long value)
+    {
+        println(std::to_string(value).c_str());
+    }
+};
+
+static bool testRecords(void)
+{
+    sfeTkLog<64> log;
+    const uint32_t args[] = {sfeTkLogArg(-1), sfeTkLogArg((short)-2), sfeTkLogArg(1.5f), sfeTkLogArg((uint8_t)200)};
+
+    bool bOk = check("arguments are sign extended, floats are bits",
+                     args[0] == 0xFFFFFFFF && args[1] == 0xFFFFFFFE && args[2] == 0x3FC00000 && args[3] == 200);
+
+    log.write(0x11223344, kSTkLogWarn, 1000, args, 4);
+    uint8_t data[64];
+    size_t length = log.read(data, sizeof(data));
+    bOk = check("a record is the ID, time, level and arguments",
+                length == kSTkLogHeaderSize + 16 && get32(data) == 0x11223344 && get32(data + 4) == 1000 &&
+                    data[8] == (kSTkLogWarn << 4 | 4) && get32(data + 9) == 0xFFFFFFFF &&
+                    get32(data + 17) == 0x3FC00000 && log.empty()) &&
+          bOk;
+
+    // 64 bytes hold 4 records of 13 bytes - the fifth drops the oldest
+    for (uint32_t i = 0; i < 4; i++)
+        log.write(i, kSTkLogInfo, i, args, 1);
+    bOk = check("records fit without drops", log.size() == 52 && log.takeDropped() == 0) && bOk;
+    bool bDropped = log.write(4, kSTkLogInfo, 4, args, 1);
+    bOk = check("a full log drops its oldest record", bDropped && log.takeDropped() == 1 && log.takeDropped() == 0 &&
+                                                         log.size() == 52) &&
+          bOk;
+
+    length = log.read(data, 20);
+    bOk = check("read() returns whole records", length == 13 && get32(data) == 1) && bOk;
+    length = log.read(data, sizeof(data));
+    bOk = check("and the rest in order", length == 39 && get32(data) == 2 && get32(data + 26) == 4) && bOk;
+
+    // a big record drops as many as it needs
+    for (uint32_t i = 0; i < 4; i++)
+        log.write(i, kSTkLogInfo, i, args, 1);
+    uint32_t eight[kSTkLogMaxArgs] = {};
+    log.write(9, kSTkLogError, 9, eight, kSTkLogMaxArgs);
+    length = log.read(data, sizeof(data));
+    bOk = check("a large record drops enough records", log.takeDropped() == 3 && length == 13 + 41 &&
+                                                          get32(data) == 3 && get32(data + 13) == 9) &&
+          bOk;
+    return bOk;
+}
+
+static bool testSites(const char *capturePath)
+{
+    sfeTkArdLog_t &log = sfeTkArdLogInstance();
+    log.clear();
+
+    SFE_TK_LOG_INFO("test_log: started, %d devices, %f V", 2, 3.3f);
+    SFE_TK_LOG_DEBUG("test_log: no arguments");
+
+    // A read from an absent device - the bus code logs the failed address write
+    sfeTkSimDevice sim;
+    for (uint8_t i = 0; i < 8; i++)
+        sim.setReg(kRegData + i, i);
+    Wire.attach(kAddress, sim);
+
+    sfeTkArdI2C absent;
+    absent.init(Wire, kAbsent);
+    uint8_t data[4];
+    size_t nRead;
+    bool bOk = absent.readRegisterRegion(kRegData, data, sizeof(data), nRead) != kSTkErrOk;
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kAddress);
+    bOk = i2c.readRegisterRegion(kRegData, data, sizeof(data), nRead) == kSTkErrOk && bOk; // logs nothing
+
+    uint8_t records[128];
+    size_t length = log.read(records, sizeof(records));
+    constexpr uint32_t kWriteFailed = sfeTkLogHash("I2C 0x%02x: write of %u bytes failed, status %u");
+    bOk = check("log sites record their IDs and arguments",
+                bOk && length == (9 + 8) + 9 + (9 + 12) && get32(records) == sfeTkLogHash("test_log: started, %d "
+                                                                                         "devices, %f V") &&
+                    get32(records + 9) == 2 && get32(records + 13) == sfeTkLogArg(3.3f) &&
+                    records[17 + 8] == (kSTkLogDebug << 4) && get32(records + 26) == kWriteFailed &&
+                    records[26 + 8] == (kSTkLogWarn << 4 | 3) && get32(records + 35) == kAbsent &&
+                    get32(records + 39) == 1 && get32(records + 43) == 2) &&
+          bOk;
+
+    // The dump - a line a record, and a line for the dropped records
+    for (int i = 0; i < 40; i++)
+        SFE_TK_LOG_DEBUG("test_log: record %d of %d", i, 40);
+    CaptureOut out;
+    size_t nRecords = sfeTkArdLogDump(out);
+    uint32_t nFit = SFE_TK_LOG_BUFFER_SIZE / (kSTkLogHeaderSize + 8);
+    bOk = check("the dump sends the dropped count and each record",
+                nRecords == nFit && out.lines.size() == nFit + 1 &&
+                    out.lines[0] == "#LD " + std::to_string(40 - nFit) && out.lines[1].compare(0, 2, "#L") == 0 &&
+                    out.lines[1].size() == 2 + 2 * 17 && log.empty()) &&
+          bOk;
+
+    if (capturePath)
+    {
+        // a capture as a serial monitor would show it - the log lines mixed with other output
+        absent.readRegisterRegion(kRegData, data, sizeof(data), nRead);
+        SFE_TK_LOG_INFO("test_log: read %u bytes, first 0x%02x", (unsigned)nRead, data[0]);
+        SFE_TK_LOG_ERROR("test_log: temperature %.2f C out of range, code %d", -41.25f, -7);
+
+        FILE *file = fopen(capturePath, "w");
+        if (file)
+        {
+            fprintf(file, "sketch output before the dump\n");
+            for (const std::string &line : out.lines)
+                fprintf(file, "%s\n", line.c_str());
+            CaptureOut more;
+            sfeTkArdLogDump(more);
+            for (const std::string &line : more.lines)
+                fprintf(file, "%s\n", line.c_str());
+            fclose(file);
+            printf("capture saved to %s\n", capturePath);
+        }
+    }
+    Wire.detach(kAddress);
+    return bOk;
+}
+
+// The format strings are hashed at compile time - they are not in the program
+static bool testNoStrings(void)
+{
+    std::vector<char> image;
+    FILE *file = fopen("/proc/self/exe", "rb");
+    if (!file)
+        return check("format strings are not in the program (skipped)", true);
+
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        image.insert(image.end(), buffer, buffer + n);
+    fclose(file);
+
+    // the formats are joined at run time, so the search keys themselves are not in the program
+    const char *formats[][2] = {{"test_log: no ", "arguments"},
+                                {"I2C 0x%02x: write of ", "%u bytes failed, status %u"},
+                                {"test_log: record ", "%d of %d"}};
+    bool bFound = false;
+    for (const auto &parts : formats)
+    {
+        std::string format = std::string(parts[0]) + parts[1];
+        bFound = bFound || std::search(image.begin(), image.end(), format.begin(), format.end()) != image.end();
+    }
+
+    // and the search finds a string that is there
+    std::string control = std::string("format strings are not ") + "in the program";
+    bool bControl = std::search(image.begin(), image.end(), control.begin(), control.end()) != image.end();
+    return check("format strings are not in the program", !bFound && bControl);
+}
+
+static void benchmark(void)
+{
+    const int kCalls = 200000;
+    sfeTkArdLog_t &log = sfeTkArdLogInstance();
+    char message[80];
+    int length = 0;
+
+    uint64_t start = now();
+    for (int i = 0; i < kCalls; i++)
+        SFE_TK_LOG_DEBUG("test_log: bench %u of %u, status %d", (unsigned)i, (unsigned)kCalls, -1);
+    double logCost = (double)(now() - start) / kCalls;
+    log.clear();
+
+    start = now();
+    for (int i = 0; i < kCalls; i++)
+        length += snprintf(message, sizeof(message), "test_log: bench %u of %u, status %d", (unsigned)i,
+                           (unsigned)kCalls, -1);
+    double printfCost = (double)(now() - start) / kCalls;
+
+    printf("\nCost of a three argument message, %s (%d formatted characters):\n", kUnits, length / kCalls);
+    printf("  log site (record to the ring) %8.1f\n", logCost);
+    printf("  snprintf (format only)        %8.1f\n", printfCost);
+    printf("  record %u bytes, message %d characters\n", (unsigned)(kSTkLogHeaderSize + 12), length / kCalls);
+}
+
+int main(int argc, char **argv)
+{
+    bool bOk = testRecords();
+    bOk = testSites(argc > 1 ? argv[1] : nullptr) && bOk;
+    bOk = testNoStrings() && bOk;
+    benchmark();
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+// test_pool.cpp - host test of the static pool and arena allocators
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o test_pool tests/host/test_pool.cpp src/sfeTkArdI2C.cpp
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#include <sfeTk/sfeTkArena.h>
+#include <sfeTk/sfeTkBusService.h>
+#include <sfeTk/sfeTkPool.h>
+#include <sfeTkArdI2C.h>
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-36s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+// On the host, the "interrupt" is a thread - the guard policy is a mutex in place of the interrupt guard
+static std::mutex guardMutex;
+class TestGuard
+{
+  public:
+    TestGuard()
+    {
+        guardMutex.lock();
+    }
+    ~TestGuard()
+    {
+        guardMutex.unlock();
+    }
+};
+
+static bool testPool(void)
+{
+    sfeTkPool<10, 4> pool;
+    void *blocks[4];
+    bool bOk = pool.nFree() == 4;
+
+    for (int i = 0; i < 4; i++)
+    {
+        blocks[i] = pool.alloc();
+        bOk = blocks[i] != nullptr && ((uintptr_t)blocks[i] % __BIGGEST_ALIGNMENT__) == 0 && bOk;
+    }
+    bOk = pool.alloc() == nullptr && pool.nFailed() == 1 && pool.highWater() == 4 && bOk;
+
+    alignas(__BIGGEST_ALIGNMENT__) uint8_t outside[64];
+    bOk = !pool.free(outside) && !pool.free((uint8_t *)blocks[1] + 1) && pool.free(nullptr) && bOk;
+
+    bOk = pool.free(blocks[2]) && pool.alloc() == blocks[2] && bOk; // LIFO reuse - the block is still in cache
+    for (int i = 0; i < 4; i++)
+        bOk = pool.free(blocks[i]) && bOk;
+
+    bOk = pool.nInUse() == 0 && pool.highWater() == 4 && bOk;
+    pool.resetStats();
+    bOk = pool.highWater() == 0 && pool.nFailed() == 0 && bOk;
+
+    return check("pool", bOk);
+}
+
+static bool testPoolShared(void)
+{
+    static sfeTkPool<32, 16, TestGuard> pool;
+    const int kCycles = 100000;
+    int nIsrFailed = 0;
+
+    // the "interrupt" takes and returns blocks while the main task does the same
+    std::thread isr([&] {
+        for (int i = 0; i < kCycles; i++)
+        {
+            void *block = pool.alloc();
+            if (!block)
+                nIsrFailed++;
+            pool.free(block);
+        }
+    });
+
+    void *held[8];
+    for (int i = 0; i < kCycles / 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+            held[j] = pool.alloc();
+        for (int j = 0; j < 8; j++)
+            pool.free(held[j]);
+    }
+    isr.join();
+
+    bool bOk = pool.nInUse() == 0 && pool.highWater() <= 9 && nIsrFailed == 0 && pool.nFailed() == 0;
+    return check("pool shared with an interrupt", bOk);
+}
+
+static bool testArena(void)
+{
+    sfeTkArena<100> arena;
+
+    uint8_t *bytes = arena.allocArray<uint8_t>(3);
+    uint32_t *words = arena.allocArray<uint32_t>(4);
+    bool bOk = bytes && words && ((uintptr_t)words % alignof(uint32_t)) == 0 && (uint8_t *)words >= bytes + 3;
+    bOk = arena.used() >= 19 && arena.alloc(200) == nullptr && arena.nFailed() == 1 && bOk;
+
+    size_t firstCycle = arena.used();
+    arena.reset();
+    bOk = arena.used() == 0 && arena.highWater() == firstCycle && arena.allocArray<uint8_t>(100) && bOk;
+    bOk = arena.highWater() == 100 && arena.allocArray<uint8_t>(1) == nullptr && bOk;
+
+    return check("arena", bOk);
+}
+
+//---------------------------------------------------------------------------
+// A batch of bus reads per acquisition cycle - request descriptors from a pool, scratch buffers from an arena
+static const uint8_t kDevAddress = 0x48;
+static const int kBatch = 6;
+static const int kCycles = 50;
+
+struct BatchState
+{
+    sfeTkPool<sizeof(sfeTkBusRequest), kBatch> *pool;
+    int nDone;
+};
+
+static void onBatchDone(sfeTkBusRequest &request, void *context)
+{
+    BatchState *state = static_cast<BatchState *>(context);
+    state->nDone++;
+    state->pool->free(&request);
+}
+
+static bool testBatch(void)
+{
+    sfeTkSimDevice device;
+    for (int i = 0; i < 256; i++)
+        device.setReg((uint16_t)i, (uint8_t)(255 - i));
+    Wire.attach(kDevAddress, device);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kDevAddress);
+    sfeTkBusService<8, 1> service(i2c);
+
+    sfeTkPool<sizeof(sfeTkBusRequest), kBatch> pool;
+    sfeTkArena<256> scratch;
+    BatchState state = {&pool, 0};
+
+    bool bOk = true;
+    for (int cycle = 0; cycle < kCycles; cycle++)
+    {
+        uint8_t *buffers[kBatch];
+        size_t lengths[kBatch];
+
+        for (int i = 0; i < kBatch; i++)
+        {
+            lengths[i] = (size_t)(4 + (cycle + i) % 24);
+            buffers[i] = scratch.allocArray<uint8_t>(lengths[i]);
+
+            sfeTkBusRequest *request = new (pool.alloc()) sfeTkBusRequest;
+            request->set(kSTkBusOpReadRegisterRegion, (uint16_t)(i * 16), buffers[i], lengths[i]);
+            request->onComplete = onBatchDone;
+            request->context = &state;
+            bOk = service.submit(*request) == kSTkErrOk && bOk;
+        }
+        service.serviceAll();
+
+        for (int i = 0; i < kBatch; i++)
+        {
+            for (size_t j = 0; j < lengths[i]; j++)
+                bOk = buffers[i][j] == device.reg((uint16_t)(i * 16 + j)) && bOk;
+        }
+        scratch.reset();
+    }
+    Wire.detach(kDevAddress);
+
+    printf("  %d cycles: request pool high water %zu of %zu, scratch arena high water %zu of %zu bytes\n", kCycles,
+           pool.highWater(), pool.capacity(), scratch.highWater(), scratch.capacity());
+
+    bOk = state.nDone == kBatch * kCycles && pool.nInUse() == 0 && pool.nFailed() == 0 && scratch.nFailed() == 0 && bOk;
+    return check("batched requests from pool and arena", bOk);
+}
+
+//---------------------------------------------------------------------------
+static volatile uintptr_t sink;
+
+static void benchAlloc(void)
+{
+    const int kRounds = 1000000;
+    static sfeTkPool<48, 8> pool;
+    static sfeTkArena<8 * 48> arena;
+    void *held[8];
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; i++)
+    {
+        for (int j = 0; j < 8; j++)
+            held[j] = pool.alloc();
+        sink = (uintptr_t)held[i & 7];
+        for (int j = 0; j < 8; j++)
+            pool.free(held[j]);
+    }
+    double poolNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; i++)
+    {
+        for (int j = 0; j < 8; j++)
+            held[j] = arena.alloc(48);
+        sink = (uintptr_t)held[i & 7];
+        arena.reset();
+    }
+    double arenaNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRounds; i++)
+    {
+        for (int j = 0; j < 8; j++)
+            held[j] = malloc(48);
+        sink = (uintptr_t)held[i & 7];
+        for (int j = 0; j < 8; j++)
+            free(held[j]);
+    }
+    double mallocNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("  8 x 48 byte alloc/free: pool %.1f ns, arena %.1f ns, malloc %.1f ns per allocation\n",
+           poolNs / (kRounds * 8), arenaNs / (kRounds * 8), mallocNs / (kRounds * 8));
+}
+
+int main(void)
+{
+    bool bOk = testPool();
+    bOk = testPoolShared() && bOk;
+    bOk = testArena() && bOk;
+    bOk = testBatch() && bOk;
+    benchAlloc();
+
+    printf("%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+// test_profiler.cpp - host test of the bus phase profiler (sfeTkProfiler.h)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -DSFE_TK_ENABLE_TRANSACTIONS=1 -DSFE_TK_PROFILE_PHASES -Itests/host/sim -Isrc
+//       -o test_profiler tests/host/test_profiler.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+//       src/sfeTkArdI2CPort.cpp src/sfeTkArdSPIPort.cpp src/sfeTkArdProfiler.cpp
+//
+// Checks the profiler splits I2C and SPI operations into their phases - a 64 byte I2C read is an address phase
+// and two 32 byte chunks, a transaction and an operation called inside another are one operation - then prints
+// the phase breakdown of register reads with the simulated buses spending wire time in real time. The host clock
+// is the time stamp counter, so its rate is measured against the steady clock to show microseconds.
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include <sfeTkArdI2C.h>
+#include <sfeTkArdSPI.h>
+#include <sfeTk/sfeTkProfiler.h>
+
+#if !defined(SFE_TK_PROFILE_PHASES)
+#error "build with -DSFE_TK_PROFILE_PHASES"
+#endif
+#if !SFE_TK_ENABLE_TRANSACTIONS
+#error "build with -DSFE_TK_ENABLE_TRANSACTIONS=1"
+#endif
+
+static const uint8_t kAddress = 0x42;
+static const uint8_t kCS = 10;
+static const uint8_t kRegData = 0x28;
+
+static const char *kPhaseNames[kSTkProfilePhases] = {"setup", "address", "transfer", "copy", "teardown"};
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-52s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+static void setupDevice(sfeTkSimDevice &sim)
+{
+    for (uint16_t i = 0; i < 128; i++)
+        sim.setReg(kRegData + i, (uint8_t)i);
+}
+
+// The phases of the last operation add up to its time, and it has the expected type and number of chunks
+static bool lastOk(sfeTkBusHookOp_t op, uint32_t chunks)
+{
+    sfeTkProfiler &profiler = sfeTkProfilerInstance();
+    const sfeTkProfileRecord &last = profiler.last();
+    return profiler.lastOp() == op && last.count == 1 && last.chunks == chunks && last.maxTotal == last.total() &&
+           last.phase[kSTkProfileTransfer] > 0;
+}
+
+static bool testI2C(void)
+{
+    sfeTkSimDevice sim;
+    setupDevice(sim);
+    Wire.attach(kAddress, sim);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kAddress);
+
+    sfeTkProfiler &profiler = sfeTkProfilerInstance();
+    profiler.reset();
+
+    uint8_t block[64];
+    size_t nRead = 0;
+    bool bOk = check("I2C 64 byte read", i2c.readRegisterRegion(kRegData, block, sizeof(block), nRead) == kSTkErrOk &&
+                                             nRead == sizeof(block) && block[63] == 63);
+    const sfeTkProfileRecord &last = profiler.last();
+    bOk = check("I2C 64 byte read is two chunks", lastOk(kSTkBusHookReadRegisterRegion, 2)) && bOk;
+    bOk = check("I2C read has address and copy phases",
+                last.phase[kSTkProfileAddress] > 0 && last.phase[kSTkProfileCopy] > 0) &&
+          bOk;
+
+    uint8_t data = 0;
+    bOk = check("I2C byte read is one chunk",
+                i2c.readRegisterByte(kRegData + 1, data) == kSTkErrOk && lastOk(kSTkBusHookReadRegisterByte, 1)) &&
+          bOk;
+    bOk = check("I2C register write is all transfer",
+                i2c.writeRegisterByte(kRegData, 0x55) == kSTkErrOk && lastOk(kSTkBusHookWriteRegisterByte, 1) &&
+                    last.phase[kSTkProfileAddress] == 0 && last.phase[kSTkProfileCopy] == 0) &&
+          bOk;
+
+    // A transaction is one operation, with a chunk for each step
+    bOk = check("I2C transaction is one operation",
+                i2c.transaction(sfeTkTxn() << sfeTkWrite(kRegData, 0x01) >> sfeTkRead(kRegData, block, 4)) ==
+                        kSTkErrOk &&
+                    lastOk(kSTkBusHookTransaction, 2) && profiler.stats(kSTkBusHookTransaction).count == 1) &&
+          bOk;
+
+    // An operation inside another is part of the outer one
+    {
+        sfeTkProfileScope outer(kSTkBusHookTransaction);
+        i2c.readRegisterByte(kRegData, data);
+        i2c.readRegisterByte(kRegData, data);
+    }
+    bOk = check("nested operations are part of the outer one",
+                lastOk(kSTkBusHookTransaction, 2) && profiler.stats(kSTkBusHookTransaction).count == 2 &&
+                    profiler.stats(kSTkBusHookReadRegisterByte).count == 1) &&
+          bOk;
+
+    // The totals add up, and stop when disabled
+    const sfeTkProfileRecord &stats = profiler.stats(kSTkBusHookReadRegisterRegion);
+    bOk = check("stats sum the operations", stats.count == 1 && stats.chunks == 2 && stats.maxTotal == stats.total()) &&
+          bOk;
+    profiler.setEnabled(false);
+    i2c.readRegisterRegion(kRegData, block, sizeof(block), nRead);
+    profiler.setEnabled(true);
+    bOk = check("nothing is collected when disabled", stats.count == 1) && bOk;
+    profiler.reset();
+    bOk = check("reset clears the stats", stats.count == 0 && stats.total() == 0) && bOk;
+
+    Wire.detach(kAddress);
+    return bOk;
+}
+
+static bool testSPI(void)
+{
+    sfeTkSimDevice sim;
+    setupDevice(sim);
+    SPI.attach(kCS, sim);
+
+    sfeTkArdSPI spi;
+    spi.init(kCS, true);
+
+    sfeTkProfiler &profiler = sfeTkProfilerInstance();
+    profiler.reset();
+
+    uint8_t block[64];
+    size_t nRead = 0;
+    bool bOk = check("SPI 64 byte read", spi.readRegisterRegion(kRegData, block, sizeof(block), nRead) == kSTkErrOk &&
+                                             nRead == sizeof(block) && block[63] == 63);
+    const sfeTkProfileRecord &last = profiler.last();
+    bOk = check("SPI read is one chunk", lastOk(kSTkBusHookReadRegisterRegion, 1) &&
+                                             last.phase[kSTkProfileAddress] > 0) &&
+          bOk;
+    bOk = check("SPI register write", spi.writeRegisterRegion(kRegData, block, 4) == kSTkErrOk &&
+                                          lastOk(kSTkBusHookWriteRegisterRegion, 1) &&
+                                          last.phase[kSTkProfileAddress] > 0) &&
+          bOk;
+    bOk = check("SPI transaction is one operation",
+                spi.transaction(sfeTkTxn() << sfeTkWrite(kRegData, 0x01) >> sfeTkRead(kRegData, block, 4)) ==
+                        kSTkErrOk &&
+                    lastOk(kSTkBusHookTransaction, 2)) &&
+          bOk;
+
+    SPI.detach(kCS);
+    return bOk;
+}
+
+// The rate of the profiler clock, measured against the steady clock when the platform doesn't give it
+static double clockHz(void)
+{
+    if (sfeTkProfileClockHz() != 0)
+        return sfeTkProfileClockHz();
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t ticks = sfeTkProfileClock();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20))
+        ;
+    uint32_t elapsed = sfeTkProfileClock() - ticks;
+    return elapsed / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Prints the average phase times of a type of operation
+static void printBreakdown(const char *title, sfeTkBusHookOp_t op, double hz)
+{
+    const sfeTkProfileRecord &stats = sfeTkProfilerInstance().stats(op);
+    if (stats.count == 0)
+        return;
+
+    double total = stats.total();
+    printf("  %-22s", title);
+    for (uint8_t i = 0; i < kSTkProfilePhases; i++)
+        printf(" %7.1f %3.0f%%", stats.phase[i] / hz / stats.count * 1e6, stats.phase[i] * 100.0 / total);
+    printf(" %9.1f %6.1f\n", total / hz / stats.count * 1e6, (double)stats.chunks / stats.count);
+}
+
+static void breakdown(void)
+{
+    const int kCalls = 40;
+    double hz = clockHz();
+
+    sfeTkSimDevice i2cSim, spiSim;
+    setupDevice(i2cSim);
+    setupDevice(spiSim);
+    Wire.attach(kAddress, i2cSim);
+    SPI.attach(kCS, spiSim);
+    Wire.setRealTime(true);
+    SPI.setRealTime(true);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kAddress);
+    sfeTkArdSPI spi;
+    spi.init(kCS, true);
+
+    printf("\nPhase breakdown, us and share of each operation (wire time in real time, clock %.0f MHz):\n",
+           hz / 1e6);
+    printf("  %-22s", "");
+    for (uint8_t i = 0; i < kSTkProfilePhases; i++)
+        printf(" %12s", kPhaseNames[i]);
+    printf(" %9s %6s\n", "total", "chunks");
+
+    sfeTkProfiler &profiler = sfeTkProfilerInstance();
+    uint8_t block[64];
+    size_t nRead;
+    uint8_t data;
+    const uint32_t clocks[] = {100000, 400000};
+    for (uint32_t clock : clocks)
+    {
+        Wire.setClock(clock);
+        char title[32];
+
+        profiler.reset();
+        for (int i = 0; i < kCalls; i++)
+            i2c.readRegisterRegion(kRegData, block, sizeof(block), nRead);
+        snprintf(title, sizeof(title), "I2C %u kHz 64 bytes", (unsigned)(clock / 1000));
+        printBreakdown(title, kSTkBusHookReadRegisterRegion, hz);
+
+        profiler.reset();
+        for (int i = 0; i < kCalls; i++)
+            i2c.readRegisterByte(kRegData, data);
+        snprintf(title, sizeof(title), "I2C %u kHz byte", (unsigned)(clock / 1000));
+        printBreakdown(title, kSTkBusHookReadRegisterByte, hz);
+    }
+
+    profiler.reset();
+    for (int i = 0; i < kCalls; i++)
+        spi.readRegisterRegion(kRegData, block, sizeof(block), nRead);
+    printBreakdown("SPI 4 MHz 64 bytes", kSTkBusHookReadRegisterRegion, hz);
+
+    profiler.reset();
+    for (int i = 0; i < kCalls; i++)
+        spi.readRegisterByte(kRegData, data);
+    printBreakdown("SPI 4 MHz byte", kSTkBusHookReadRegisterByte, hz);
+
+    Wire.setRealTime(false);
+    SPI.setRealTime(false);
+    Wire.setClock(100000);
+    Wire.detach(kAddress);
+    SPI.detach(kCS);
+}
+
+int main()
+{
+    bool bOk = testI2C();
+    bOk = testSPI() && bOk;
+    breakdown();
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
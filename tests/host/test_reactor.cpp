@@ -0,0 +1,309 @@
+// test_reactor.cpp - host test of the event reactor
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o test_reactor tests/host/test_reactor.cpp
+//       src/sfeTkArdI2C.cpp
+
+#include <stdio.h>
+
+#include <sfeTk/sfeTkReactor.h>
+#include <sfeTk/sfeTkReactorEpoll.h>
+#include <sfeTkArdI2C.h>
+
+#include "sim/sfeTkSimDMA.h"
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-36s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+//---------------------------------------------------------------------------
+// The first tests use a manual clock, so results are exact
+static uint32_t fakeTime = 0;
+static uint32_t fakeNow(void)
+{
+    return fakeTime;
+}
+
+struct Trace
+{
+    int order[16];
+    int count = 0;
+    uint32_t runTime = 0; // each handler advances the fake clock by this
+};
+
+struct Entry
+{
+    Trace *trace;
+    int tag;
+};
+
+static void record(void *context)
+{
+    Entry *entry = static_cast<Entry *>(context);
+    Trace &trace = *entry->trace;
+    if (trace.count < 16)
+        trace.order[trace.count] = entry->tag;
+    trace.count++;
+    fakeTime += trace.runTime;
+}
+
+static bool sameOrder(const Trace &trace, std::initializer_list<int> expected)
+{
+    if ((size_t)trace.count != expected.size())
+        return false;
+    int i = 0;
+    for (int tag : expected)
+    {
+        if (trace.order[i++] != tag)
+            return false;
+    }
+    return true;
+}
+
+// Everything ready in the same pass - dispatched in the order the handlers were added
+static bool testOrder(void)
+{
+    sfeTkReactor<4> reactor(fakeNow);
+    Trace trace;
+    Entry entries[3] = {{&trace, 0}, {&trace, 1}, {&trace, 2}};
+
+    sfeTkBusRequest request;
+    request.status = kSTkErrBusPending;
+
+    int16_t event = reactor.addEvent(record, &entries[0]);
+    reactor.addTimer(100, record, &entries[1]);
+    reactor.addCompletion(request, record, &entries[2]);
+
+    bool bOk = reactor.runOnce() == 0;
+
+    fakeTime += 100;
+    request.complete(kSTkErrOk);
+    reactor.signal(event);
+    reactor.signal(event); // two signals before a pass collapse into one dispatch
+
+    bOk = reactor.runOnce() == 3 && sameOrder(trace, {0, 1, 2}) && bOk;
+
+    // the completion handler is one shot, the event needs a new signal, the timer is not due
+    bOk = reactor.runOnce() == 0 && bOk;
+
+    return check("deterministic order", bOk);
+}
+
+// With a dispatch limit, handlers left over run first on the next pass - none starve
+static bool testBounded(void)
+{
+    sfeTkReactor<4> reactor(fakeNow);
+    Trace trace;
+    Entry entries[4] = {{&trace, 0}, {&trace, 1}, {&trace, 2}, {&trace, 3}};
+    int16_t ids[4];
+
+    for (int i = 0; i < 4; i++)
+        ids[i] = reactor.addEvent(record, &entries[i]);
+    reactor.setMaxDispatch(2);
+
+    for (int i = 0; i < 4; i++)
+        reactor.signal(ids[i]);
+
+    bool bOk = reactor.runOnce() == 2;
+
+    // handler 0 is ready again, but 2 and 3 have waited longer
+    reactor.signal(ids[0]);
+    bOk = reactor.runOnce() == 2 && bOk;
+    bOk = reactor.runOnce() == 1 && bOk;
+
+    bOk = sameOrder(trace, {0, 1, 2, 3, 0}) && bOk;
+    return check("bounded dispatch", bOk);
+}
+
+// Timer period, one shot timers, handler run time and dispatch latency
+static bool testTimers(void)
+{
+    sfeTkReactor<4> reactor(fakeNow);
+    Trace trace;
+    trace.runTime = 7;
+    Entry periodic = {&trace, 0};
+    Entry oneShot = {&trace, 1};
+
+    fakeTime = 1000;
+    int16_t idPeriodic = reactor.addTimer(100, record, &periodic);
+    int16_t idOneShot = reactor.addTimer(250, record, &oneShot, false);
+
+    bool bOk = reactor.timeToNextTimer(5000) == 100;
+
+    // the loop was busy - the timer runs 30 late, but stays on its period grid
+    fakeTime = 1130;
+    bOk = reactor.runOnce() == 1 && bOk;
+    bOk = reactor.timeToNextTimer(5000) == 200 - 137 && bOk;
+
+    fakeTime = 1260;
+    bOk = reactor.runOnce() == 2 && bOk;
+
+    fakeTime = 1600;
+    // more than a period behind - the timer restarts from now rather than firing to catch up
+    bOk = reactor.runOnce() == 1 && reactor.timeToNextTimer(5000) == 100 - 7 && bOk;
+
+    const sfeTkReactorStats &stats = reactor.stats(idPeriodic);
+    bOk = stats.count == 3 && stats.totalTime == 21 && stats.maxTime == 7 && stats.maxLatency == 300 && bOk;
+    bOk = reactor.stats(idOneShot).count == 1 && reactor.stats(idOneShot).maxLatency == 17 && bOk;
+
+    return check("timers and run time statistics", bOk);
+}
+
+//---------------------------------------------------------------------------
+// A data ready interrupt starts an async read, the completion processes the block - on the epoll backed loop,
+// with a real clock, the "interrupt" and DMA engine on their own threads.
+
+static const uint8_t kDevAddress = 0x2A;
+static const uint8_t kRegData = 0x10;
+static const int kSamples = 20;
+
+static uint32_t hostMicros(void)
+{
+    return (uint32_t)micros();
+}
+
+struct Sensor
+{
+    sfeTkReactor<4> *reactor;
+    sfeTkReactorEpoll<4> *loop;
+    sfeTkArdI2C *bus;
+    sfeTkSimDevice *device;
+
+    int16_t idReady;
+    int16_t idDone;
+    sfeTkBusRequest request;
+    uint8_t data[16];
+
+    int nRead = 0;
+    int nBad = 0;
+    int nTicks = 0;
+};
+
+static void onDmaComplete(sfeTkBusRequest &request, void *context)
+{
+    (void)request;
+    // the DMA thread - wake the loop, which polls the request
+    static_cast<Sensor *>(context)->loop->wake();
+}
+
+static void onDataReady(void *context)
+{
+    Sensor *sensor = static_cast<Sensor *>(context);
+    sensor->request.onComplete = onDmaComplete;
+    sensor->request.context = sensor;
+    if (sensor->bus->readRegisterRegionAsync(kRegData, sensor->data, sizeof(sensor->data), sensor->request) ==
+        kSTkErrOk)
+        sensor->reactor->watch(sensor->idDone, sensor->request);
+}
+
+static void onReadDone(void *context)
+{
+    Sensor *sensor = static_cast<Sensor *>(context);
+    for (size_t i = 0; i < sizeof(sensor->data); i++)
+    {
+        if (sensor->data[i] != sensor->device->reg((uint16_t)(kRegData + i)))
+            sensor->nBad++;
+    }
+    sensor->nRead++;
+}
+
+static void onTick(void *context)
+{
+    static_cast<Sensor *>(context)->nTicks++;
+}
+
+static bool testEpoll(void)
+{
+    sfeTkSimDevice device;
+    for (int i = 0; i < 256; i++)
+        device.setReg((uint16_t)i, (uint8_t)(i * 7));
+    Wire.attach(kDevAddress, device);
+    Wire.setClock(400000);
+    Wire.setRealTime(true);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kDevAddress);
+    sfeTkSimDMA dma;
+    i2c.setAsyncTransfer(&dma);
+
+    sfeTkReactor<4> reactor(hostMicros);
+    sfeTkReactorEpoll<4> loop(reactor);
+    if (loop.begin() != kSTkErrOk)
+        return check("epoll loop", false);
+
+    Sensor sensor;
+    sensor.reactor = &reactor;
+    sensor.loop = &loop;
+    sensor.bus = &i2c;
+    sensor.device = &device;
+    sensor.idReady = reactor.addEvent(onDataReady, &sensor);
+    sensor.idDone = reactor.addCompletion(sensor.request, onReadDone, &sensor);
+    reactor.disarm(sensor.idDone);
+    reactor.addTimer(1000, onTick, &sensor);
+
+    // the data ready "interrupt" - every 2 ms
+    std::thread interrupt([&] {
+        for (int i = 0; i < kSamples; i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            reactor.signal(sensor.idReady);
+            loop.wake();
+        }
+    });
+
+    uint32_t start = micros();
+    uint32_t nPasses = 0;
+    while (sensor.nRead < kSamples && micros() - start < 2000000)
+    {
+        loop.runOnce(100);
+        nPasses++;
+    }
+    uint32_t elapsed = micros() - start;
+    interrupt.join();
+
+    i2c.setAsyncTransfer(nullptr);
+    Wire.setRealTime(false);
+    Wire.detach(kDevAddress);
+
+    const sfeTkReactorStats &stats = reactor.stats(sensor.idDone);
+    printf("%-36s: %d reads, %d ticks, %u loop passes in %u us, read handler max %u us\n", "epoll loop",
+           sensor.nRead, sensor.nTicks, nPasses, elapsed, stats.maxTime);
+
+    // the ticks are timing dependent, only check there were some
+    bool bOk = sensor.nRead == kSamples && sensor.nBad == 0 && sensor.nTicks > 0;
+    return check("epoll loop", bOk);
+}
+
+int main(void)
+{
+    bool bOk = testOrder();
+    bOk = testBounded() && bOk;
+    bOk = testTimers() && bOk;
+    bOk = testEpoll() && bOk;
+
+    printf("%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
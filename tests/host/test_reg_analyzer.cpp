@@ -0,0 +1,287 @@
+// test_reg_analyzer.cpp - host test of the register access analyzer (sfeTkRegAnalyzer.h)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -DSFE_TK_ENABLE_TRANSACTIONS=1 -Itests/host/sim -Isrc -o test_reg_analyzer
+//       tests/host/test_reg_analyzer.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+//
+// Runs a naive driver for the example device of regmap/ - it checks the device ID each cycle, updates a control
+// register with a read-modify-write, rewrites its interrupt configuration and reads the volatile status and
+// sample registers - through the analyzer hooks, and checks the counts of each register, the avoidable reads and
+// writes found, that volatile registers are not flagged and the ranking of the report. The clock is the simulated
+// wire time, so the time saved the analyzer estimates is checked against the wire time of the same driver with
+// the avoidable operations removed.
+
+#include <stdio.h>
+
+#include <string>
+
+#include <sfeTkArdBusHooks.h>
+
+#include "regmap/sfeExampleImuRegs.h"
+
+#if !SFE_TK_ENABLE_TRANSACTIONS
+#error "build with -DSFE_TK_ENABLE_TRANSACTIONS=1"
+#endif
+
+static const uint8_t kCS = 10;
+static const int kCycles = 10;
+
+// The wire time of both simulated buses, in microseconds
+struct WireClock
+{
+    static uint32_t now(void)
+    {
+        return (uint32_t)((Wire.busyNanos() + SPI.busyNanos()) / 1000);
+    }
+};
+
+typedef sfeTkRegAnalyzer<WireClock> Analyzer;
+typedef sfeTkRegAnalyzerHooks<Analyzer> AnalyzerHooks;
+
+// The example device - the status register always reads data ready, the samples change on each read
+class ImuDevice : public sfeTkSimDevice
+{
+  public:
+    ImuDevice() : _sample{0}
+    {
+        setReg(kExampleImuRegWhoAmI.address, 0x6B);
+        setReg(kExampleImuRegCtrl2.address, 0x04);
+    }
+
+  protected:
+    uint8_t onRead(uint16_t theReg)
+    {
+        if (theReg == kExampleImuRegStatus.address)
+            return 0x01;
+        if (theReg >= kExampleImuRegTemp.address && theReg < kExampleImuRegOutZ.address + 2)
+            return _sample++;
+        return sfeTkSimDevice::onRead(theReg);
+    }
+
+  private:
+    uint8_t _sample;
+};
+
+// Report output - kept to check, and printed
+struct Capture
+{
+    std::string text;
+
+    void println(const char *line)
+    {
+        text += line;
+        text += '\n';
+        printf("%s\n", line);
+    }
+};
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-52s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+// One cycle of the naive driver
+static void naiveCycle(sfeTkIBus &bus)
+{
+    uint8_t value = 0;
+    uint8_t sample[kExampleImuBurstSampleLength];
+
+    // is the device still there?
+    bus.readRegisterByte(kExampleImuRegWhoAmI.address, value);
+
+    // set the data rate - read, modify, write
+    bus.readRegisterByte(kExampleImuRegCtrl1.address, value);
+    bus.writeRegisterByte(kExampleImuRegCtrl1.address, (uint8_t)kExampleImuCtrl1Odr.set(value, 0x6));
+
+    // make sure the interrupt is set up
+    bus.writeRegisterByte(kExampleImuRegIntCfg.address, 0x01);
+
+    // new data?
+    bus.readRegisterByte(kExampleImuRegStatus.address, value);
+    bus.readRegisterRegion(kExampleImuBurstSample.address, sample, sizeof(sample));
+}
+
+// The same driver, without the operations the analyzer finds avoidable
+static void cachedCycle(sfeTkIBus &bus, bool bFirst)
+{
+    uint8_t value = 0;
+    uint8_t sample[kExampleImuBurstSampleLength];
+
+    if (bFirst)
+    {
+        bus.readRegisterByte(kExampleImuRegWhoAmI.address, value);
+        bus.writeRegisterByte(kExampleImuRegCtrl1.address, (uint8_t)kExampleImuCtrl1Odr.set(0x00, 0x6));
+        bus.writeRegisterByte(kExampleImuRegIntCfg.address, 0x01);
+    }
+    bus.readRegisterByte(kExampleImuRegStatus.address, value);
+    bus.readRegisterRegion(kExampleImuBurstSample.address, sample, sizeof(sample));
+}
+
+static bool testCounts(void)
+{
+    bool bOk = true;
+    ImuDevice imu;
+    Wire.attach(kExampleImuAddress, imu);
+
+    Analyzer analyzer;
+    sfeTkArdI2CHooked<AnalyzerHooks> bus;
+    bus.init(Wire, kExampleImuAddress);
+    bOk = check("attach", bus.hooks().attach(analyzer, "imu", kExampleImuRegisters, kExampleImuRegisterCount)) &&
+          bOk;
+
+    uint32_t start = WireClock::now();
+    for (int i = 0; i < kCycles; i++)
+        naiveCycle(bus);
+    uint32_t naiveTime = WireClock::now() - start;
+
+    const Analyzer::Stats *whoAmI = analyzer.stats(0, kExampleImuRegWhoAmI.address);
+    const Analyzer::Stats *ctrl1 = analyzer.stats(0, kExampleImuRegCtrl1.address);
+    const Analyzer::Stats *intCfg = analyzer.stats(0, kExampleImuRegIntCfg.address);
+    const Analyzer::Stats *status = analyzer.stats(0, kExampleImuRegStatus.address);
+    const Analyzer::Stats *sample = analyzer.stats(0, kExampleImuBurstSample.address);
+    bOk = check("each register is counted", analyzer.size() == 5 && whoAmI && ctrl1 && intCfg && status && sample) &&
+          bOk;
+    if (!bOk)
+        return false;
+
+    bOk = check("read and write counts", whoAmI->reads == kCycles && ctrl1->reads == kCycles &&
+                                             ctrl1->writes == kCycles && intCfg->writes == kCycles &&
+                                             sample->reads == kCycles &&
+                                             sample->bytesRead == kCycles * kExampleImuBurstSampleLength) &&
+          bOk;
+    bOk = check("repeated ID reads are redundant", whoAmI->redundantReads == kCycles - 1) && bOk;
+    bOk = check("first control read is read-modify-write", ctrl1->rmwReads == 1) && bOk;
+    bOk = check("later control reads are redundant", ctrl1->redundantReads == kCycles - 1) && bOk;
+    bOk = check("same value writes are redundant",
+                ctrl1->redundantWrites == kCycles - 1 && intCfg->redundantWrites == kCycles - 1) &&
+          bOk;
+    bOk = check("volatile registers are never avoidable", status->avoidable() == 0 && sample->avoidable() == 0) &&
+          bOk;
+
+    Capture out;
+    analyzer.report(out, 10, "us");
+    size_t avoidable = out.text.find("Avoidable operations:");
+    size_t heat = out.text.find("Most accessed registers:");
+    size_t ctrl1Row = out.text.find("0x0010", avoidable);
+    size_t intCfgRow = out.text.find("0x0012", avoidable);
+    size_t whoAmIRow = out.text.find("0x000f", avoidable);
+    bOk = check("report ranks the control register first", avoidable != std::string::npos &&
+                                                               heat != std::string::npos && ctrl1Row < intCfgRow &&
+                                                               ctrl1Row < whoAmIRow && intCfgRow < heat &&
+                                                               whoAmIRow < heat) &&
+          bOk;
+    bOk = check("report leaves volatile registers out of the ranking",
+                out.text.find("0x001e", avoidable) > heat && out.text.find("0x001ev", heat) != std::string::npos) &&
+          bOk;
+
+    // the estimate is the avoidable operations at their average wire time - compare with the driver without them
+    uint32_t estimate = analyzer.saved();
+    ImuDevice imu2;
+    Wire.detach(kExampleImuAddress);
+    Wire.attach(kExampleImuAddress, imu2);
+    start = WireClock::now();
+    for (int i = 0; i < kCycles; i++)
+        cachedCycle(bus, i == 0);
+    uint32_t cachedTime = WireClock::now() - start;
+
+    uint32_t saved = naiveTime - cachedTime;
+    printf("  wire time %lu us naive, %lu us cached - saved %lu us, estimated %lu us\n", (unsigned long)naiveTime,
+           (unsigned long)cachedTime, (unsigned long)saved, (unsigned long)estimate);
+    bOk = check("estimated time saved is within 10%",
+                estimate * 10 >= saved * 9 && estimate * 10 <= saved * 11) &&
+          bOk;
+
+    analyzer.reset();
+    bOk = check("reset clears the statistics", analyzer.size() == 0 && analyzer.totals().reads == 0) && bOk;
+
+    Wire.detach(kExampleImuAddress);
+    return bOk;
+}
+
+static bool testTransactionsAndFailures(void)
+{
+    bool bOk = true;
+    ImuDevice imu;
+    Wire.attach(kExampleImuAddress, imu);
+    sfeTkSimDevice spiDevice;
+    spiDevice.setReg(0x0F, 0x33);
+    SPI.attach(kCS, spiDevice);
+
+    Analyzer analyzer;
+    sfeTkArdI2CHooked<AnalyzerHooks> bus;
+    bus.init(Wire, kExampleImuAddress);
+    bus.hooks().attach(analyzer, "imu", kExampleImuRegisters, kExampleImuRegisterCount);
+    sfeTkArdSPIHooked<AnalyzerHooks> spi;
+    spi.init(kCS, true);
+    spi.hooks().attach(analyzer, "spi dev");
+
+    // each step of a transaction is a register operation
+    for (int i = 0; i < 3; i++)
+        bus.transaction(sfeTkTxn() << sfeTkWrite(kExampleImuRegCtrl2.address, 0x44)
+                                   << sfeTkWrite(kExampleImuRegIntCfg.address, 0x01));
+    const Analyzer::Stats *ctrl2 = analyzer.stats(0, kExampleImuRegCtrl2.address);
+    bOk = check("transaction steps are counted",
+                ctrl2 && ctrl2->writes == 3 && ctrl2->redundantWrites == 2 && ctrl2->writeTime > 0) &&
+          bOk;
+
+    // a register without a descriptor is judged by its value, and marked
+    uint8_t value = 0;
+    for (int i = 0; i < 4; i++)
+        spi.readRegisterByte(0x0F, value);
+    const Analyzer::Stats *spiId = analyzer.stats(1, 0x0F);
+    bOk = check("undescribed register redundant reads", spiId && spiId->redundantReads == 3) && bOk;
+
+    Capture out;
+    analyzer.report(out);
+    bOk = check("report marks undescribed registers", out.text.find("spi dev      0x000f?") != std::string::npos) &&
+          bOk;
+
+    // a failed operation is not counted
+    Wire.detach(kExampleImuAddress);
+    bus.readRegisterByte(kExampleImuRegCtrl2.address, value);
+    bOk = check("failed operations are not counted", ctrl2->reads == 0) && bOk;
+
+    // a full analyzer counts the rest as untracked
+    sfeTkRegAnalyzer<WireClock, 2, 1> small;
+    sfeTkHookedBus<sfeTkArdSPI, sfeTkRegAnalyzerHooks<sfeTkRegAnalyzer<WireClock, 2, 1>>>::type smallBus;
+    smallBus.init(kCS, true);
+    bOk = check("device limit", smallBus.hooks().attach(small, "a") && small.addDevice("b") == -1) && bOk;
+    for (uint8_t reg = 0; reg < 4; reg++)
+        smallBus.readRegisterByte(reg, value);
+    bOk = check("registers past the limit are untracked", small.size() == 2 && small.untracked() == 2) && bOk;
+
+    SPI.detach(kCS);
+    return bOk;
+}
+
+int main(void)
+{
+    bool bOk = testCounts();
+    printf("\n");
+    bOk = testTransactionsAndFailures() && bOk;
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,253 @@
+// test_regmap.cpp - host test of a generated register map (tools/sfeTkRegGen.py) and sfeTkRegister.h
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   python3 tools/sfeTkRegGen.py tests/host/regmap/sfeExampleImu.json --check tests/host/regmap/sfeExampleImuRegs.h
+//   g++ -std=c++17 -O2 -pthread -DSFE_TK_ENABLE_TRANSACTIONS=1 -Itests/host/sim -Isrc -o test_regmap
+//       tests/host/test_regmap.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp
+//
+// The register map of an example device is generated from regmap/sfeExampleImu.json, and checked in - the first
+// command checks it is up to date. The map is checked at compile time (fields, burst groups, shadow slots), then
+// used on I2C and SPI against a simulated device: register reads and writes of each width and byte order, burst
+// group reads - on their own and as a transaction step - and the shadow cache, counting the bus frames each
+// access takes.
+
+#include <stdio.h>
+
+#include <sfeTkArdI2C.h>
+#include <sfeTkArdSPI.h>
+
+#include "regmap/sfeExampleImuRegs.h"
+
+#if !SFE_TK_ENABLE_TRANSACTIONS
+#error "build with -DSFE_TK_ENABLE_TRANSACTIONS=1"
+#endif
+
+static const uint8_t kCS = 10;
+
+// The generated map is constant data - check it at compile time
+static_assert(kExampleImuCtrl1Odr.mask() == 0xF0 && kExampleImuCtrl1Fs.mask() == 0x0C, "field masks");
+static_assert(kExampleImuCtrl1Odr.set(0x0F, 0x6) == 0x6F && kExampleImuCtrl1Odr.get(0x6F) == 0x6,
+              "fields are set and read without touching other bits");
+static_assert(kExampleImuThresholdLevel.mask() == 0x0FFF, "a field of a 16 bit register");
+static_assert(kExampleImuBurstSample.offset(kExampleImuRegOutZ) == 6 && kExampleImuBurstSampleLength == 8,
+              "burst group layout");
+static_assert(!kExampleImuBurstSample.contains(kExampleImuRegStatus), "a burst group has only its registers");
+static_assert(kExampleImuRegWhoAmI.cacheable() && !kExampleImuRegStatus.cacheable() &&
+                  !kExampleImuRegOutX.cacheable(),
+              "volatile registers have no shadow slot");
+static_assert(kExampleImuRegThreshold.shadow == 4 && kExampleImuShadowSize == 6,
+              "the shadow cache is packed - 1 byte for each 8 bit register, 2 for the 16 bit one");
+static_assert(kExampleImuRegisterCount == sizeof(kExampleImuRegisters) / sizeof(kExampleImuRegisters[0]),
+              "register table");
+static_assert(sizeof(sfeExampleImuShadow_t) <= 2 * sizeof(sfeTkBitset<kExampleImuShadowSize>),
+              "the cache is the bytes of the cached registers and a bitset");
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-52s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+static void setupDevice(sfeTkSimDevice &sim)
+{
+    for (uint16_t i = 0; i < sim.size(); i++)
+        sim.setReg(i, 0);
+    sim.setReg(0x0F, 0x6B); // who am i
+    sim.setReg(0x11, 0x04); // ctrl2 reset value
+    sim.setReg(0x13, 0x34); // threshold, little endian
+    sim.setReg(0x14, 0x12);
+    sim.setReg(0x1E, 0x01); // status
+    for (uint8_t i = 0; i < 8; i++)
+        sim.setReg(0x20 + i, 0x10 + i); // temp, x, y, z
+    sim.setReg(0x40, 0x01); // timestamp, big endian
+    sim.setReg(0x41, 0x02);
+    sim.setReg(0x42, 0x03);
+}
+
+static bool testRegisters(const char *title, sfeTkIBus &theBus, sfeTkSimDevice &sim)
+{
+    char name[64];
+    bool bOk = true;
+    uint32_t value = 0;
+
+    snprintf(name, sizeof(name), "%s 8 bit register read", title);
+    bOk = check(name, sfeTkRegRead(theBus, kExampleImuRegWhoAmI, value) == kSTkErrOk && value == 0x6B) && bOk;
+
+    snprintf(name, sizeof(name), "%s 16 bit little endian read", title);
+    bOk = check(name, sfeTkRegRead(theBus, kExampleImuRegThreshold, value) == kSTkErrOk && value == 0x1234) && bOk;
+
+    snprintf(name, sizeof(name), "%s 24 bit big endian read", title);
+    bOk = check(name, sfeTkRegRead(theBus, kExampleImuRegTimestamp, value) == kSTkErrOk && value == 0x010203) && bOk;
+
+    snprintf(name, sizeof(name), "%s 16 bit little endian write", title);
+    bOk = check(name, sfeTkRegWrite(theBus, kExampleImuRegThreshold, 0x0ABC) == kSTkErrOk &&
+                          sim.reg(0x13) == 0xBC && sim.reg(0x14) == 0x0A) &&
+          bOk;
+
+    snprintf(name, sizeof(name), "%s access is checked", title);
+    bOk = check(name, sfeTkRegRead(theBus, kExampleImuRegIntCfg, value) == kSTkErrRegNoAccess &&
+                          sfeTkRegWrite(theBus, kExampleImuRegStatus, 0) == kSTkErrRegNoAccess) &&
+          bOk;
+    return bOk;
+}
+
+static bool testBursts(const char *title, sfeTkIBus &theBus, sfeTkSimDevice &sim)
+{
+    char name[64];
+    bool bOk = true;
+
+    // one register at a time, then the group
+    uint32_t values[4] = {0};
+    const sfeTkRegister *regs[4] = {&kExampleImuRegTemp, &kExampleImuRegOutX, &kExampleImuRegOutY,
+                                    &kExampleImuRegOutZ};
+    uint32_t frames = sim.nFrames();
+    for (int i = 0; i < 4; i++)
+        bOk = sfeTkRegRead(theBus, *regs[i], values[i]) == kSTkErrOk && bOk;
+    uint32_t framesSingle = sim.nFrames() - frames;
+
+    uint8_t buffer[kExampleImuBurstSampleLength];
+    frames = sim.nFrames();
+    sfeTkError_t retval = sfeTkRegReadBurst(theBus, kExampleImuBurstSample, buffer);
+    uint32_t framesBurst = sim.nFrames() - frames;
+
+    bool bSame = retval == kSTkErrOk;
+    for (int i = 0; i < 4; i++)
+        bSame = bSame && sfeTkRegBurstValue(kExampleImuBurstSample, *regs[i], buffer) == values[i];
+    snprintf(name, sizeof(name), "%s burst group matches register reads", title);
+    bOk = check(name, bSame && values[1] == 0x1312) && bOk;
+
+    snprintf(name, sizeof(name), "%s burst group is one read (%u vs %u frames)", title, (unsigned)framesBurst,
+             (unsigned)framesSingle);
+    bOk = check(name, framesBurst * 4 == framesSingle) && bOk;
+
+    // a group with a gap - the gap byte is read and skipped
+    uint8_t statusSample[kExampleImuBurstStatusSampleLength];
+    retval = sfeTkRegReadBurst(theBus, kExampleImuBurstStatusSample, statusSample);
+    snprintf(name, sizeof(name), "%s burst group with a gap", title);
+    bOk = check(name, retval == kSTkErrOk &&
+                          kExampleImuStatusDrdy.get(
+                              sfeTkRegBurstValue(kExampleImuBurstStatusSample, kExampleImuRegStatus, statusSample)) &&
+                          sfeTkRegBurstValue(kExampleImuBurstStatusSample, kExampleImuRegOutZ, statusSample) ==
+                              values[3]) &&
+          bOk;
+
+    // a group as a transaction step, after a register write
+    uint8_t txnBuffer[kExampleImuBurstSampleLength] = {0};
+    retval = theBus.transaction(sfeTkTxn() << sfeTkWrite(kExampleImuRegCtrl1.address, 0x40)
+                                           >> sfeTkRegBurstStep(kExampleImuBurstSample, txnBuffer));
+    snprintf(name, sizeof(name), "%s burst group as a transaction step", title);
+    bOk = check(name, retval == kSTkErrOk && sim.reg(0x10) == 0x40 &&
+                          sfeTkRegBurstValue(kExampleImuBurstSample, kExampleImuRegOutZ, txnBuffer) == values[3]) &&
+          bOk;
+    return bOk;
+}
+
+static bool testShadow(const char *title, sfeTkIBus &theBus, sfeTkSimDevice &sim)
+{
+    char name[64];
+    bool bOk = true;
+    sfeExampleImuShadow_t shadow;
+    uint32_t value = 0;
+    sim.setReg(0x10, 0x00);
+
+    // a register the device does not change is read once
+    uint32_t frames = sim.nFrames();
+    bool bRead = shadow.read(theBus, kExampleImuRegWhoAmI, value) == kSTkErrOk && value == 0x6B;
+    uint32_t framesFirst = sim.nFrames() - frames;
+    frames = sim.nFrames();
+    bRead = bRead && shadow.read(theBus, kExampleImuRegWhoAmI, value) == kSTkErrOk && value == 0x6B;
+    snprintf(name, sizeof(name), "%s cached read is not a bus read", title);
+    bOk = check(name, bRead && framesFirst > 0 && sim.nFrames() == frames) && bOk;
+
+    // the first field write reads the register, the next only write it, and an unchanged value is not written
+    frames = sim.nFrames();
+    sfeTkError_t retval = shadow.writeField(theBus, kExampleImuCtrl1Odr, 0x6);
+    uint32_t framesFirstField = sim.nFrames() - frames;
+    frames = sim.nFrames();
+    retval = retval == kSTkErrOk ? shadow.writeField(theBus, kExampleImuCtrl1Fs, 0x2) : retval;
+    uint32_t framesCachedField = sim.nFrames() - frames;
+    frames = sim.nFrames();
+    retval = retval == kSTkErrOk ? shadow.writeField(theBus, kExampleImuCtrl1Fs, 0x2) : retval;
+    uint32_t framesUnchanged = sim.nFrames() - frames;
+    snprintf(name, sizeof(name), "%s field writes (frames: %u, %u, %u)", title, (unsigned)framesFirstField,
+             (unsigned)framesCachedField, (unsigned)framesUnchanged);
+    bOk = check(name, retval == kSTkErrOk && sim.reg(0x10) == 0x68 && framesCachedField < framesFirstField &&
+                          framesUnchanged == 0) &&
+          bOk;
+
+    // a write only register can have fields written once the cache has a value
+    snprintf(name, sizeof(name), "%s write only field needs a cached value", title);
+    bOk = check(name, shadow.writeField(theBus, kExampleImuIntCfgDrdyEn, 1) == kSTkErrRegNotCached) && bOk;
+
+    shadow.loadReset(kExampleImuRegisters, kExampleImuRegisterCount);
+    retval = shadow.writeField(theBus, kExampleImuIntCfgDrdyEn, 1);
+    retval = retval == kSTkErrOk ? shadow.writeField(theBus, kExampleImuIntCfgPolarity, 1) : retval;
+    snprintf(name, sizeof(name), "%s write only fields after loadReset()", title);
+    bOk = check(name, retval == kSTkErrOk && sim.reg(0x12) == 0x03) && bOk;
+
+    // volatile registers always go to the bus
+    frames = sim.nFrames();
+    sim.setReg(0x1E, 0x00);
+    retval = shadow.readField(theBus, kExampleImuStatusDrdy, value);
+    bool bVolatile = retval == kSTkErrOk && value == 0;
+    sim.setReg(0x1E, 0x01);
+    retval = shadow.readField(theBus, kExampleImuStatusDrdy, value);
+    snprintf(name, sizeof(name), "%s volatile register is not cached", title);
+    bOk = check(name, bVolatile && retval == kSTkErrOk && value == 1 && sim.nFrames() > frames) && bOk;
+
+    // after invalidate() the value comes from the device again
+    sim.setReg(0x10, 0x11);
+    shadow.invalidate(kExampleImuRegCtrl1);
+    snprintf(name, sizeof(name), "%s invalidate()", title);
+    bOk = check(name, shadow.read(theBus, kExampleImuRegCtrl1, value) == kSTkErrOk && value == 0x11) && bOk;
+    return bOk;
+}
+
+int main()
+{
+    sfeTkSimDevice i2cSim, spiSim;
+    setupDevice(i2cSim);
+    setupDevice(spiSim);
+    Wire.attach(kExampleImuAddress, i2cSim);
+    SPI.attach(kCS, spiSim);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kExampleImuAddress);
+    sfeTkArdSPI spi;
+    spi.init(kCS, true);
+
+    bool bOk = true;
+    bOk = testRegisters("I2C", i2c, i2cSim) && bOk;
+    bOk = testRegisters("SPI", spi, spiSim) && bOk;
+    bOk = testBursts("I2C", i2c, i2cSim) && bOk;
+    bOk = testBursts("SPI", spi, spiSim) && bOk;
+    bOk = testShadow("I2C", i2c, i2cSim) && bOk;
+    bOk = testShadow("SPI", spi, spiSim) && bOk;
+
+    Wire.detach(kExampleImuAddress);
+    SPI.detach(kCS);
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
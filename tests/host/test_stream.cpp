@@ -0,0 +1,222 @@
+// test_stream.cpp - host demonstration of ping-pong streaming reads with overlapped processing
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -Itests/host/sim -Isrc -o test_stream
+//       tests/host/test_stream.cpp src/sfeTkArdSPI.cpp src/sfeTkArdI2C.cpp
+//
+// With ThreadSanitizer - the DMA engine completes transfers on its own thread - add: -g -O1 -fsanitize=thread
+
+#include <stdio.h>
+
+#include <sfeTk/sfeTkStreamReader.h>
+#include <sfeTkArdI2C.h>
+#include <sfeTkArdSPI.h>
+
+#include "sim/sfeTkSimDMA.h"
+
+static const uint8_t kDevCS = 5;
+static const uint8_t kAbsentAddress = 0x5A;
+static const uint8_t kRegFifo = 0x40;
+static const size_t kBlock = 64;
+static const uint32_t kNumBlocks = 400;
+
+// A FIFO - every byte read from the FIFO register is the next sample, a running 8 bit count
+class simFifo : public sfeTkSimDevice
+{
+  public:
+    simFifo() : _sample{0}
+    {
+    }
+
+  protected:
+    uint8_t onRead(uint16_t theReg) override
+    {
+        return theReg >= kRegFifo ? _sample++ : sfeTkSimDevice::onRead(theReg);
+    }
+
+  private:
+    uint8_t _sample;
+};
+
+static uint32_t nowUS(void)
+{
+    return micros();
+}
+
+// "processing" - the time the consumer spends on a block. Yields, as the DMA engine is a thread on this host.
+static void process(uint32_t usecs)
+{
+    sfeTkSim::spinNanos((uint64_t)usecs * 1000);
+}
+
+// the blocks must be in order with no gaps - each starts where the last ended
+struct continuity
+{
+    bool bFirst = true;
+    uint8_t next = 0;
+    uint32_t nGaps = 0;
+
+    void check(const uint8_t *block)
+    {
+        if (!bFirst && block[0] != next)
+            nGaps++;
+        for (size_t i = 1; i < kBlock; i++)
+        {
+            if (block[i] != (uint8_t)(block[i - 1] + 1))
+                nGaps++;
+        }
+        next = (uint8_t)(block[kBlock - 1] + 1);
+        bFirst = false;
+    }
+};
+
+// read a block, process it, repeat
+static uint32_t runSequential(sfeTkArdSPI &bus, uint32_t processUS)
+{
+    uint8_t block[kBlock];
+    size_t nRead;
+    continuity order;
+
+    unsigned long start = micros();
+    for (uint32_t i = 0; i < kNumBlocks; i++)
+    {
+        bus.readRegisterRegion(kRegFifo, block, sizeof(block), nRead);
+        order.check(block);
+        process(processUS);
+    }
+    unsigned long elapsed = micros() - start;
+    uint32_t throughput = (uint32_t)((uint64_t)kNumBlocks * kBlock * 1000000 / elapsed);
+
+    printf("sequential          process %3u us: %7u B/s\n", processUS, throughput);
+    return throughput;
+}
+
+// what a run expects of the overrun count
+enum overruns
+{
+    kOverrunsAny,
+    kOverrunsSome,
+    kOverrunsNone
+};
+
+template <uint8_t kBuffers>
+static bool runStream(const char *name, sfeTkArdSPI &bus, sfeTkIAsyncTransfer &transfer, uint32_t processUS,
+                      overruns expect)
+{
+    sfeTkStreamReader<kBlock, kBuffers> reader(nowUS);
+    continuity order;
+    uint32_t nConsumed = 0;
+
+    sfeTkError_t rc = reader.begin(bus, transfer, kRegFifo);
+    while (rc == kSTkErrOk && nConsumed < kNumBlocks)
+    {
+        uint8_t *block = reader.acquire();
+        if (!block)
+        {
+            reader.poll();
+            std::this_thread::yield();
+            continue;
+        }
+        order.check(block);
+        process(processUS);
+        reader.release();
+        nConsumed++;
+    }
+    reader.end();
+
+    // let a transfer in flight finish before the reader goes out of scope
+    while (transfer.busy())
+        std::this_thread::yield();
+
+    bool bOk = rc == kSTkErrOk && order.nGaps == 0 && reader.nErrors() == 0 &&
+               (expect != kOverrunsSome || reader.nOverruns() > 0) &&
+               (expect != kOverrunsNone || reader.nOverruns() == 0);
+
+    printf("%-20sprocess %3u us: %7u B/s  blocks %4u  overruns %3u  gaps %u  %s\n", name, processUS,
+           reader.throughput(), reader.nBlocks(), reader.nOverruns(), order.nGaps, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+// stream from a device that is not there - every transfer fails. The stream must not recurse on the retries, and
+// must stop after kMaxRetries failures in a row, with the error reported
+static bool runAbsent(const char *name, sfeTkIBus &bus, sfeTkIAsyncTransfer &transfer)
+{
+    sfeTkStreamReader<kBlock, 2> reader(nowUS);
+    const uint32_t kMaxErrors = sfeTkStreamReader<kBlock, 2>::kMaxRetries + 1;
+
+    reader.begin(bus, transfer, kRegFifo);
+
+    // the synchronous backend stops inside begin() - give an asynchronous one time to fail
+    unsigned long start = micros();
+    while (reader.running() && micros() - start < 1000000)
+    {
+        reader.poll();
+        std::this_thread::yield();
+    }
+    while (transfer.busy())
+        std::this_thread::yield();
+
+    bool bOk = !reader.running() && reader.nBlocks() == 0 && reader.nErrors() == kMaxErrors &&
+               reader.lastError() != kSTkErrOk && reader.acquire() == nullptr;
+
+    printf("%-20sabsent device:   errors %u  last error %d  running %d  %s\n", name, reader.nErrors(),
+           reader.lastError(), reader.running(), bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+int main(void)
+{
+    simFifo device;
+    SPI.attach(kDevCS, device);
+
+    sfeTkArdSPI bus;
+    SPISettings settings(8000000, MSBFIRST, SPI_MODE0);
+    bus.init(SPI, settings, kDevCS);
+    SPI.setRealTime(true);
+
+    // 65 bytes at 8MHz is ~65 us of wire time per block
+    sfeTkSimDMA dma;
+    sfeTkCpuTransfer cpu;
+    bool bOk = true;
+
+    runSequential(bus, 50);
+    // overruns are timing dependent here (a loaded host can starve the consumer) - reported, not checked
+    bOk = runStream<2>("ping-pong", bus, dma, 50, kOverrunsAny) && bOk;
+    bOk = runStream<3>("triple buffered", bus, dma, 50, kOverrunsAny) && bOk;
+
+    // a consumer slower than the wire - the stream stalls and the overruns are counted
+    runSequential(bus, 200);
+    bOk = runStream<2>("ping-pong (slow)", bus, dma, 200, kOverrunsSome) && bOk;
+
+    // no backend overlap - the CPU fallback reads when the consumer releases a buffer, so never overruns
+    bOk = runStream<2>("CPU fallback", bus, cpu, 50, kOverrunsNone) && bOk;
+
+    sfeTkArdI2C absent;
+    absent.init(Wire, kAbsentAddress);
+    bOk = runAbsent("CPU fallback", absent, cpu) && bOk;
+    bOk = runAbsent("DMA", absent, dma) && bOk;
+
+    printf("%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
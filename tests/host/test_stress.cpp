@@ -0,0 +1,417 @@
+// test_stress.cpp - host stress test of concurrent use of shared ports and the bus service
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -DSFE_TK_ENABLE_TRANSACTIONS=1 -Itests/host/sim -Isrc -o test_stress
+//       tests/host/test_stress.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp src/sfeTkArdI2CPort.cpp
+//       src/sfeTkArdSPIPort.cpp
+//
+// With the sanitizers - build each the same way, with the flags added:
+//   ThreadSanitizer   -g -O1 -fsanitize=thread
+//   AddressSanitizer  -g -O1 -fsanitize=address -fno-omit-frame-pointer
+//
+// 1, 2, 4, 8 and 16 threads share an I2C port (sfeTkArdI2CPort) and an SPI port (sfeTkArdSPIPort) with a lock,
+// each thread with its own device handles on 8 simulated devices. Each thread mixes
+//
+//   - an id read - each device answers its own id, so a read routed to the wrong device is caught
+//   - a transaction that writes a block every thread writes, and reads it back - under one hold of the lock, so
+//     the block read back is the one the thread wrote, unless another thread got in between
+//   - a write of a block only the thread writes, then a separate read of it - the data must survive the other
+//     threads' traffic
+//
+// and the port statistics, updated under the lock, must count every transaction. Then the same number of threads
+// submit requests to one bus service thread (sfeTkBusServiceThread), so its queues are used from many threads.
+// The lock counts how often it was taken while held, and the time waited - reported with the throughput for
+// each thread count. The simulated buses do not spend wire time, so the lock is held for CPU time only.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sfeTk/sfeTkBusServiceThread.h>
+#include <sfeTkArdI2CPort.h>
+#include <sfeTkArdSPIPort.h>
+
+#if !SFE_TK_ENABLE_TRANSACTIONS
+#error "build with -DSFE_TK_ENABLE_TRANSACTIONS=1"
+#endif
+
+static const int kDevices = 8;
+static const uint8_t kFirstAddress = 0x20;
+static const uint8_t kFirstCS = 10;
+static const uint8_t kRegId = 0x0F;
+static const uint8_t kRegShared = 0x10;
+static const uint8_t kRegPrivate = 0x20; // a block for each thread - below 0x80, the SPI read bit
+static const size_t kBlock = 6;
+static const int kMaxThreads = 16;
+static const int kOpsPerThread = 3000;
+
+static uint64_t nanos(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-52s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+// A lock that counts contention - taken while another thread held it - and the time waited for it
+class ContentionLock : public sfeTkILock
+{
+  public:
+    void lock(void)
+    {
+        if (!_mutex.try_lock())
+        {
+            uint64_t start = nanos();
+            _mutex.lock();
+            _waitNanos += nanos() - start;
+            _nContended++;
+        }
+        _nLocks++;
+    }
+
+    void unlock(void)
+    {
+        _mutex.unlock();
+    }
+
+    void reset(void)
+    {
+        _nLocks = 0;
+        _nContended = 0;
+        _waitNanos = 0;
+    }
+
+    uint64_t nLocks(void) const
+    {
+        return _nLocks;
+    }
+
+    uint64_t nContended(void) const
+    {
+        return _nContended;
+    }
+
+    uint64_t waitNanos(void) const
+    {
+        return _waitNanos;
+    }
+
+  private:
+    std::mutex _mutex;
+    std::atomic<uint64_t> _nLocks{0};
+    std::atomic<uint64_t> _nContended{0};
+    std::atomic<uint64_t> _waitNanos{0};
+};
+
+// A block only one thread and operation writes - the thread, a sequence number and a check byte
+static void makeBlock(uint8_t *block, int thread, int op)
+{
+    block[0] = (uint8_t)thread;
+    block[1] = (uint8_t)op;
+    block[2] = (uint8_t)(op >> 8);
+    for (size_t i = 3; i < kBlock - 1; i++)
+        block[i] = (uint8_t)(thread * 31 + op * 7 + i);
+    uint8_t sum = 0;
+    for (size_t i = 0; i < kBlock - 1; i++)
+        sum += block[i];
+    block[kBlock - 1] = (uint8_t)~sum;
+}
+
+struct Counts
+{
+    std::atomic<uint32_t> wrongId{0};
+    std::atomic<uint32_t> torn{0};
+    std::atomic<uint32_t> corrupt{0};
+    std::atomic<uint32_t> failed{0};
+    std::atomic<uint32_t> transactions{0};
+};
+
+// One thread's work on a port - Device is the handle type, and ids are the expected id of each device
+template <typename Device>
+static void hammer(Device *devices, const uint8_t *ids, int thread, Counts &counts)
+{
+    uint32_t nTransactions = 0;
+    for (int op = 0; op < kOpsPerThread; op++)
+    {
+        int d = (thread + op) % kDevices;
+        Device &device = devices[d];
+        uint8_t block[kBlock], back[kBlock];
+        size_t nRead = 0;
+
+        switch (op % 3)
+        {
+        case 0: {
+            uint8_t id = 0;
+            if (device.readRegisterByte(kRegId, id) != kSTkErrOk)
+                counts.failed++;
+            else if (id != ids[d])
+                counts.wrongId++;
+            nTransactions++;
+            break;
+        }
+
+        case 1:
+            makeBlock(block, thread, op);
+            memset(back, 0, sizeof(back));
+            if (device.transaction(sfeTkTxn() << sfeTkWrite(kRegShared, block, kBlock) >>
+                                   sfeTkRead(kRegShared, back, kBlock)) != kSTkErrOk)
+                counts.failed++;
+            else if (memcmp(block, back, kBlock) != 0)
+                counts.torn++;
+            nTransactions++;
+            break;
+
+        case 2:
+            makeBlock(block, thread, op);
+            memset(back, 0, sizeof(back));
+            if (device.writeRegisterRegion((uint8_t)(kRegPrivate + thread * kBlock), block, kBlock) != kSTkErrOk ||
+                device.readRegisterRegion((uint8_t)(kRegPrivate + thread * kBlock), back, kBlock, nRead) !=
+                    kSTkErrOk)
+                counts.failed++;
+            else if (nRead != kBlock || memcmp(block, back, kBlock) != 0)
+                counts.corrupt++;
+            nTransactions += 2;
+            break;
+        }
+    }
+    counts.transactions += nTransactions;
+}
+
+// Runs the threads on a port, and checks and reports the result
+template <typename Port, typename Device>
+static bool runPort(const char *name, Port &port, ContentionLock &lock, Device *prototypes, const uint8_t *ids,
+                    int nThreads)
+{
+    Counts counts;
+    port.resetStats();
+    lock.reset();
+
+    // each thread has its own handles - copies of the prototypes
+    std::vector<std::vector<Device>> handles(nThreads, std::vector<Device>(prototypes, prototypes + kDevices));
+    std::vector<std::thread> threads;
+    uint64_t start = nanos();
+    for (int t = 0; t < nThreads; t++)
+        threads.emplace_back([&, t] { hammer(handles[t].data(), ids, t, counts); });
+    for (auto &thread : threads)
+        thread.join();
+    double seconds = (double)(nanos() - start) / 1e9;
+
+    uint32_t nTransactions = counts.transactions;
+    printf("  %-4s %2d threads %9.0f transactions/s  contended %5.1f%%  wait %7.2f us/transaction\n", name,
+           nThreads, nTransactions / seconds, 100.0 * lock.nContended() / (lock.nLocks() ? lock.nLocks() : 1),
+           lock.waitNanos() / 1000.0 / (nTransactions ? nTransactions : 1));
+
+    bool bOk = counts.wrongId == 0 && counts.torn == 0 && counts.corrupt == 0 && counts.failed == 0;
+    bOk = bOk && port.nTransactions() == nTransactions && port.nErrors() == 0 && lock.nLocks() == nTransactions;
+    if (!bOk)
+        printf("    wrong ids %u, torn transactions %u, corrupt blocks %u, failed %u, port counted %u of %u, "
+               "lock taken %llu\n",
+               (unsigned)counts.wrongId, (unsigned)counts.torn, (unsigned)counts.corrupt, (unsigned)counts.failed,
+               (unsigned)port.nTransactions(), (unsigned)nTransactions, (unsigned long long)lock.nLocks());
+    return bOk;
+}
+
+// Many threads submit to one service thread - each waits for its request, then checks it
+static bool runService(sfeTkIBus &bus, int nThreads)
+{
+    sfeTkBusServiceThread<4, 2> service(bus); // fewer slots than threads - submits find it full
+    service.start();
+
+    std::atomic<uint32_t> nWrong{0};
+    std::atomic<uint32_t> nFull{0};
+    std::vector<std::thread> threads;
+    uint64_t start = nanos();
+    for (int t = 0; t < nThreads; t++)
+    {
+        threads.emplace_back([&, t] {
+            uint8_t block[kBlock], back[kBlock];
+            sfeTkBusRequest request;
+            for (int op = 0; op < kOpsPerThread / 2; op++)
+            {
+                makeBlock(block, t, op);
+                memset(back, 0, sizeof(back));
+
+                // the write, then the read of the thread's own block - retried while the queue is full
+                sfeTkError_t result;
+                request.set(kSTkBusOpWriteRegisterRegion, kRegPrivate + t * kBlock, block, kBlock, (uint8_t)(t & 1));
+                while ((result = service.transact(request, 1000)) == kSTkErrBusQueueFull)
+                {
+                    nFull++;
+                    std::this_thread::yield();
+                }
+                if (result != kSTkErrOk)
+                {
+                    nWrong++;
+                    continue;
+                }
+
+                request.set(kSTkBusOpReadRegisterRegion, kRegPrivate + t * kBlock, back, kBlock, (uint8_t)(t & 1));
+                while ((result = service.transact(request, 1000)) == kSTkErrBusQueueFull)
+                {
+                    nFull++;
+                    std::this_thread::yield();
+                }
+                if (result != kSTkErrOk || request.transferred != kBlock || memcmp(block, back, kBlock) != 0)
+                    nWrong++;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    double seconds = (double)(nanos() - start) / 1e9;
+    service.stop();
+
+    uint32_t nRequests = (uint32_t)nThreads * (kOpsPerThread / 2) * 2;
+    printf("  svc  %2d threads %9.0f requests/s      queue full %5.1f%% of submits\n", nThreads, nRequests / seconds,
+           100.0 * nFull / (nRequests + nFull));
+
+    bool bOk = nWrong == 0 && service.nCompleted() == nRequests;
+    if (!bOk)
+        printf("    wrong %u, completed %u of %u\n", (unsigned)nWrong, (unsigned)service.nCompleted(),
+               (unsigned)nRequests);
+    return bOk;
+}
+
+// the approximate size() of a queue must stay in 0..capacity while other threads push and pop
+static bool runQueueSize(void)
+{
+    static const size_t kCapacity = 8;
+    static const int kItems = 20000;
+    sfeTkBusQueue<int, kCapacity> queue;
+    std::atomic<bool> bDone{false};
+    std::atomic<int> nPopped{0};
+    size_t maxSize = 0;
+    uint32_t nOutOfRange = 0, nSamples = 0;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; t++)
+    {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kItems; i++)
+            {
+                while (!queue.push(i))
+                    std::this_thread::yield();
+            }
+        });
+        threads.emplace_back([&] {
+            int item;
+            while (nPopped.load() < 2 * kItems)
+            {
+                if (queue.pop(item))
+                    nPopped++;
+                std::this_thread::yield();
+            }
+        });
+    }
+    std::thread watcher([&] {
+        while (!bDone.load())
+        {
+            size_t n = queue.size();
+            nOutOfRange += n > kCapacity;
+            maxSize = n > maxSize ? n : maxSize;
+            if (++nSamples % 256 == 0)
+                std::this_thread::yield();
+        }
+    });
+    for (auto &thread : threads)
+        thread.join();
+    bDone = true;
+    watcher.join();
+
+    printf("  queue size() %u samples under 2 pushing and 2 popping threads: max %u of %u\n", (unsigned)nSamples,
+           (unsigned)maxSize, (unsigned)kCapacity);
+    return nOutOfRange == 0 && queue.size() == 0 && nPopped.load() == 2 * kItems;
+}
+
+int main()
+{
+    sfeTkSimDevice i2cSims[kDevices], spiSims[kDevices];
+    uint8_t i2cIds[kDevices], spiIds[kDevices];
+
+    sfeTkArdI2CPort i2cPort;
+    ContentionLock i2cLock;
+    i2cPort.init(Wire);
+    i2cPort.setLock(&i2cLock);
+    i2cPort.setClock(1000000);
+
+    sfeTkArdSPIPort spiPort;
+    ContentionLock spiLock;
+    spiPort.init();
+    spiPort.setLock(&spiLock);
+
+    sfeTkArdI2CDevice i2cDevices[kDevices];
+    sfeTkArdSPIDevice spiDevices[kDevices];
+    for (int i = 0; i < kDevices; i++)
+    {
+        i2cIds[i] = (uint8_t)(0xA0 + i);
+        i2cSims[i].setReg(kRegId, i2cIds[i]);
+        Wire.attach((uint8_t)(kFirstAddress + i), i2cSims[i]);
+        i2cDevices[i].init(i2cPort, (uint8_t)(kFirstAddress + i));
+
+        spiIds[i] = (uint8_t)(0xC0 + i);
+        spiSims[i].setReg(kRegId, spiIds[i]);
+        SPI.attach((uint8_t)(kFirstCS + i), spiSims[i]);
+        spiDevices[i].init(spiPort, (uint8_t)(kFirstCS + i));
+    }
+
+    // the bus service owns its own bus object on the first I2C device
+    sfeTkArdI2C serviceBus;
+    serviceBus.init(Wire, kFirstAddress);
+
+    bool bOk = true;
+    const int threadCounts[] = {1, 2, 4, 8, kMaxThreads};
+    for (int nThreads : threadCounts)
+    {
+        char name[64];
+        bool bI2C = runPort("I2C", i2cPort, i2cLock, i2cDevices, i2cIds, nThreads);
+        bool bSPI = runPort("SPI", spiPort, spiLock, spiDevices, spiIds, nThreads);
+
+        // the service and the I2C port are not used at the same time - both would drive Wire
+        bool bService = runService(serviceBus, nThreads);
+
+        snprintf(name, sizeof(name), "%d threads - ids, atomicity, data, counts", nThreads);
+        bOk = check(name, bI2C && bSPI && bService) && bOk;
+    }
+
+    for (int i = 0; i < kDevices; i++)
+    {
+        Wire.detach((uint8_t)(kFirstAddress + i));
+        SPI.detach((uint8_t)(kFirstCS + i));
+    }
+
+    bOk = check("queue size() in range under concurrent pops", runQueueSize()) && bOk;
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,366 @@
+// test_transaction.cpp - host test and benchmark of bus transactions (sfeTkTransaction)
+/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Build (from the repository root):
+//   g++ -std=c++17 -O2 -pthread -DSFE_TK_ENABLE_TRANSACTIONS=1 -Itests/host/sim -Isrc -o test_transaction
+//       tests/host/test_transaction.cpp src/sfeTkArdI2C.cpp src/sfeTkArdSPI.cpp src/sfeTkArdI2CPort.cpp
+//       src/sfeTkArdSPIPort.cpp
+//
+// Runs a typical sequence - write two control registers, read a sample block - as separate bus calls and as
+// one transaction, on I2C, SPI, a device handle and a bus that uses the sfeTkIBus one-operation-a-step version.
+// Checks the results match, and compares the stops, SPI transactions, lock holds, wire time and CPU time.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <mutex>
+
+#include <sfeTkArdI2CPort.h>
+#include <sfeTkArdSPIPort.h>
+
+#if !SFE_TK_ENABLE_TRANSACTIONS
+#error "build with -DSFE_TK_ENABLE_TRANSACTIONS=1"
+#endif
+
+static const uint8_t kAddress = 0x42;
+static const uint8_t kCS = 10;
+static const uint8_t kRegCtrl1 = 0x20;
+static const uint8_t kRegCtrl2 = 0x21;
+static const uint8_t kRegThreshold = 0x30;
+static const uint8_t kRegOut = 0x28;
+
+// The transaction is built by the compiler - a fixed array of steps, with the values in the steps
+static uint8_t sample[6];
+static constexpr auto kReadSample =
+    sfeTkTxn() << sfeTkWrite(kRegCtrl1, 0x47) << sfeTkWriteWord(kRegThreshold, 0x0123) >> sfeTkRead(kRegOut, sample);
+
+static_assert(kReadSample.size() == 3, "the length is part of the type");
+static_assert(sizeof(kReadSample) == 3 * sizeof(sfeTkTxnStep), "a transaction is only its steps");
+static_assert(kReadSample[0].op == kSTkBusOpWriteRegisterRegion && kReadSample[0].nValue == 1 &&
+                  kReadSample[0].value == 0x47,
+              "a byte write carries its value");
+static_assert(kReadSample[1].nValue == 2 && kReadSample[1].value == 0x0123, "a word write carries its value");
+static_assert(kReadSample[2].op == kSTkBusOpReadRegisterRegion && kReadSample[2].data == sample &&
+                  kReadSample[2].length == sizeof(sample),
+              "a read takes the length of its buffer");
+
+static bool check(const char *name, bool bOk)
+{
+    printf("%-44s: %s\n", name, bOk ? "ok" : "FAILED");
+    return bOk;
+}
+
+class CountingLock : public sfeTkILock
+{
+  public:
+    void lock(void)
+    {
+        _mutex.lock();
+        nLocks++;
+    }
+    void unlock(void)
+    {
+        _mutex.unlock();
+    }
+    int nLocks = 0;
+
+  private:
+    std::mutex _mutex;
+};
+
+// A register file bus, with no transaction of its own - runs the sfeTkIBus version, one operation a step
+class RegisterBus final : public sfeTkIBus
+{
+  public:
+    sfeTkError_t writeByte(uint8_t)
+    {
+        return kSTkErrOk;
+    }
+    sfeTkError_t writeWord(uint16_t)
+    {
+        return kSTkErrOk;
+    }
+    sfeTkError_t writeRegion(const uint8_t *, size_t)
+    {
+        nOps++;
+        return kSTkErrOk;
+    }
+    sfeTkError_t writeRegisterByte(uint8_t devReg, uint8_t data)
+    {
+        return writeRegisterRegion(devReg, &data, 1);
+    }
+    sfeTkError_t writeRegisterWord(uint8_t devReg, uint16_t data)
+    {
+        return writeRegisterRegion(devReg, (const uint8_t *)&data, sizeof(data));
+    }
+    sfeTkError_t writeRegisterRegion(uint8_t devReg, const uint8_t *data, size_t length)
+    {
+        nOps++;
+        for (size_t i = 0; i < length; i++)
+            regs[(uint8_t)(devReg + i)] = data[i];
+        return kSTkErrOk;
+    }
+    sfeTkError_t writeRegister16Region(uint16_t devReg, const uint8_t *data, size_t length)
+    {
+        return writeRegisterRegion((uint8_t)devReg, data, length);
+    }
+    sfeTkError_t readRegisterByte(uint8_t devReg, uint8_t &data)
+    {
+        size_t nRead;
+        return readRegisterRegion(devReg, &data, 1, nRead);
+    }
+    sfeTkError_t readRegisterWord(uint8_t devReg, uint16_t &data)
+    {
+        size_t nRead;
+        return readRegisterRegion(devReg, (uint8_t *)&data, sizeof(data), nRead);
+    }
+    sfeTkError_t readRegisterRegion(uint8_t reg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        nOps++;
+        for (size_t i = 0; i < numBytes; i++)
+            data[i] = regs[(uint8_t)(reg + i)];
+        readBytes = numBytes;
+        return kSTkErrOk;
+    }
+    sfeTkError_t readRegister16Region(uint16_t reg, uint8_t *data, size_t numBytes, size_t &readBytes)
+    {
+        return readRegisterRegion((uint8_t)reg, data, numBytes, readBytes);
+    }
+
+    uint8_t regs[256] = {0};
+    int nOps = 0;
+};
+
+static void setupDevice(sfeTkSimDevice &sim)
+{
+    for (uint8_t i = 0; i < sizeof(sample); i++)
+        sim.setReg(kRegOut + i, (uint8_t)(0x10 + i));
+    sim.setReg(kRegCtrl1, 0);
+    sim.setReg(kRegThreshold, 0);
+    sim.setReg(kRegThreshold + 1, 0);
+}
+
+static bool sampleOk(const sfeTkSimDevice &sim)
+{
+    bool bOk = sim.reg(kRegCtrl1) == 0x47 && sim.reg(kRegThreshold) == 0x23 && sim.reg(kRegThreshold + 1) == 0x01;
+    for (uint8_t i = 0; i < sizeof(sample); i++)
+        bOk = bOk && sample[i] == 0x10 + i;
+    return bOk;
+}
+
+// The same sequence as kReadSample, as separate calls
+template <typename Bus> static sfeTkError_t readSampleSeparate(Bus &bus)
+{
+    size_t nRead;
+    sfeTkError_t retval = bus.writeRegisterByte(kRegCtrl1, 0x47);
+    if (retval == kSTkErrOk)
+        retval = bus.writeRegisterWord(kRegThreshold, 0x0123);
+    if (retval == kSTkErrOk)
+        retval = bus.readRegisterRegion(kRegOut, sample, sizeof(sample), nRead);
+    return retval;
+}
+
+static bool testI2C(void)
+{
+    sfeTkSimDevice sim;
+    setupDevice(sim);
+    Wire.attach(kAddress, sim);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kAddress);
+
+    uint32_t stops = Wire.nStops();
+    uint32_t frames = sim.nFrames();
+    bool bOk = check("I2C separate calls", readSampleSeparate(i2c) == kSTkErrOk && sampleOk(sim));
+    uint32_t separateStops = Wire.nStops() - stops;
+    uint32_t separateFrames = sim.nFrames() - frames;
+
+    setupDevice(sim);
+    memset(sample, 0, sizeof(sample));
+    stops = Wire.nStops();
+    frames = sim.nFrames();
+    bOk = check("I2C transaction", i2c.transaction(kReadSample) == kSTkErrOk && sampleOk(sim)) && bOk;
+    printf("    stops: separate %u, transaction %u\n", separateStops, Wire.nStops() - stops);
+    // separately, each write ends with a stop, and the read sends one after the register too (stop() is set)
+    bOk = check("I2C transaction is one start ... stop", Wire.nStops() - stops == 1 && separateStops == 4 &&
+                                                            sim.nFrames() - frames == separateFrames) &&
+          bOk;
+
+    // a transaction built at run time, through the interface
+    uint8_t ctrl = 0x11;
+    uint8_t out[2];
+    sfeTkIBus &bus = i2c;
+    bOk = check("I2C run time transaction", bus.transaction(sfeTkTxn() << sfeTkWrite(kRegCtrl2, &ctrl, 1) >>
+                                                           sfeTkRead(kRegCtrl2, out)) == kSTkErrOk &&
+                                              sim.reg(kRegCtrl2) == 0x11 && out[0] == 0x11 && out[1] == 0) &&
+          bOk;
+
+    // a failing step stops the transaction - the read is not run
+    Wire.detach(kAddress);
+    memset(sample, 0, sizeof(sample));
+    bOk = check("I2C transaction stops at a failed step",
+                i2c.transaction(kReadSample) == kSTkErrFail && sample[0] == 0) &&
+          bOk;
+
+    sfeTkArdI2C notInit;
+    bOk = check("I2C transaction on a bus not initialized", notInit.transaction(kReadSample) == kSTkErrBusNotInit) &&
+          bOk;
+    return bOk;
+}
+
+static bool testSPI(void)
+{
+    sfeTkSimDevice sim;
+    setupDevice(sim);
+    SPI.attach(kCS, sim);
+
+    sfeTkArdSPI spi;
+    spi.init(kCS, true);
+
+    uint32_t transactions = SPI.nTransactions();
+    uint32_t frames = sim.nFrames();
+    bool bOk = check("SPI separate calls", readSampleSeparate(spi) == kSTkErrOk && sampleOk(sim));
+    uint32_t separateTransactions = SPI.nTransactions() - transactions;
+    uint32_t separateFrames = sim.nFrames() - frames;
+
+    setupDevice(sim);
+    memset(sample, 0, sizeof(sample));
+    transactions = SPI.nTransactions();
+    frames = sim.nFrames();
+    bOk = check("SPI transaction", spi.transaction(kReadSample) == kSTkErrOk && sampleOk(sim)) && bOk;
+    printf("    SPI transactions: separate %u, transaction %u\n", separateTransactions,
+           SPI.nTransactions() - transactions);
+    bOk = check("SPI settings applied once, a CS frame a step", SPI.nTransactions() - transactions == 1 &&
+                                                                    separateTransactions == 3 &&
+                                                                    sim.nFrames() - frames == separateFrames) &&
+          bOk;
+
+    uint8_t *noBuffer = nullptr;
+    transactions = SPI.nTransactions();
+    bOk = check("SPI transaction with a null buffer",
+                spi.transaction(sfeTkTxn() << sfeTkWrite(kRegCtrl1, 1) >> sfeTkRead(kRegOut, noBuffer, 2)) ==
+                        kSTkErrBusNullBuffer &&
+                    SPI.nTransactions() == transactions) &&
+          bOk;
+
+    SPI.detach(kCS);
+    return bOk;
+}
+
+static bool testDeviceHandle(void)
+{
+    sfeTkSimDevice sim;
+    setupDevice(sim);
+    Wire.attach(kAddress, sim);
+
+    CountingLock lock;
+    sfeTkArdI2CPort port;
+    port.init(Wire);
+    port.setLock(&lock);
+    sfeTkArdI2CDevice device(port, kAddress);
+
+    int nLocks = lock.nLocks;
+    bool bOk = check("device handle transaction", device.transaction(kReadSample) == kSTkErrOk && sampleOk(sim));
+    bOk = check("device handle transaction holds the lock once", lock.nLocks - nLocks == 1) && bOk;
+
+    Wire.detach(kAddress);
+    return bOk;
+}
+
+static bool testDefault(void)
+{
+    RegisterBus regBus;
+    for (uint8_t i = 0; i < sizeof(sample); i++)
+        regBus.regs[kRegOut + i] = (uint8_t)(0x10 + i);
+    memset(sample, 0, sizeof(sample));
+
+    sfeTkIBus &bus = regBus;
+    bool bOk = bus.transaction(kReadSample) == kSTkErrOk && regBus.nOps == 3 && regBus.regs[kRegCtrl1] == 0x47 &&
+               regBus.regs[kRegThreshold] == 0x23 && regBus.regs[kRegThreshold + 1] == 0x01;
+    for (uint8_t i = 0; i < sizeof(sample); i++)
+        bOk = bOk && sample[i] == 0x10 + i;
+    return check("sfeTkIBus transaction, an operation a step", bOk);
+}
+
+template <typename Fn> static double nsPerCall(Fn fn, int nCalls)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nCalls; i++)
+        fn();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / nCalls;
+}
+
+static bool benchmark(void)
+{
+    const int kCalls = 200000;
+    sfeTkSimDevice i2cSim, spiSim;
+    setupDevice(i2cSim);
+    setupDevice(spiSim);
+    Wire.attach(kAddress, i2cSim);
+    SPI.attach(kCS, spiSim);
+
+    sfeTkArdI2C i2c;
+    i2c.init(Wire, kAddress);
+    Wire.setClock(400000);
+    sfeTkArdSPI spi;
+    spi.init(kCS, true);
+
+    bool bOk = true;
+    printf("\nWrite 2 registers and read 6 bytes - CPU time (simulated core), and I2C wire time at 400 kHz:\n");
+    printf("  %-8s %14s %14s %16s %16s\n", "", "separate ns", "txn ns", "separate wire", "txn wire");
+
+    int nFailed = 0;
+    uint64_t busy = Wire.busyNanos();
+    readSampleSeparate(i2c);
+    uint64_t separateWire = Wire.busyNanos() - busy;
+    busy = Wire.busyNanos();
+    i2c.transaction(kReadSample);
+    uint64_t txnWire = Wire.busyNanos() - busy;
+
+    double separateNs = nsPerCall([&] { nFailed += readSampleSeparate(i2c) != kSTkErrOk; }, kCalls);
+    double txnNs = nsPerCall([&] { nFailed += i2c.transaction(kReadSample) != kSTkErrOk; }, kCalls);
+    printf("  %-8s %14.1f %14.1f %13.2f us %13.2f us\n", "I2C", separateNs, txnNs, separateWire / 1000.0,
+           txnWire / 1000.0);
+    bOk = check("I2C transaction wire time is not longer", txnWire <= separateWire) && bOk;
+
+    separateNs = nsPerCall([&] { nFailed += readSampleSeparate(spi) != kSTkErrOk; }, kCalls);
+    txnNs = nsPerCall([&] { nFailed += spi.transaction(kReadSample) != kSTkErrOk; }, kCalls);
+    printf("  %-8s %14.1f %14.1f\n", "SPI", separateNs, txnNs);
+
+    Wire.setClock(100000);
+    Wire.detach(kAddress);
+    SPI.detach(kCS);
+    return check("benchmark calls all succeeded", nFailed == 0) && bOk;
+}
+
+int main()
+{
+    bool bOk = testI2C();
+    bOk = testSPI() && bOk;
+    bOk = testDeviceHandle() && bOk;
+    bOk = testDefault() && bOk;
+    bOk = benchmark() && bOk;
+
+    printf("\n%s\n", bOk ? "PASSED" : "FAILED");
+    return bOk ? 0 : 1;
+}
@@ -7,6 +7,11 @@
 sfeTkArdI2C myI2C;
 sfeTkArdSPI mySPI;
 
+sfeTkArdI2CPort myI2CPort;
+sfeTkArdI2CDevice myI2CDevice(myI2CPort, 0x20);
+sfeTkArdSPIPort mySPIPort;
+sfeTkArdSPIDevice mySPIDevice(mySPIPort, 10);
+
 void setup()
 {
 }
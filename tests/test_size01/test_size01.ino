@@ -0,0 +1,40 @@
+
+
+// Size test - one I2C device. Used by tests/host/footprint.py and tests/host/size_configs.py
+//
+// A typical 8-bit register driver: one I2C device, byte and block register access through the bus
+// interface. It only uses operations that are always enabled, so it builds in every configuration.
+
+#include "SparkFun_Toolkit.h"
+
+sfeTkArdI2C myI2C;
+sfeTkIBus *myBus = &myI2C;
+
+uint8_t myData[6];
+
+#if defined(SFE_TK_HOT_PATH_CHECK)
+// Instrumented builds - track the hot path nesting depth
+volatile uint8_t hotDepth = 0;
+
+void sfeTkHotPathEnter(const char *)
+{
+    hotDepth++;
+}
+
+void sfeTkHotPathLeave(void)
+{
+    hotDepth--;
+}
+#endif
+
+void setup()
+{
+    myI2C.init(0x42);
+    myBus->writeRegisterByte(0x20, 0x57);
+}
+
+void loop()
+{
+    size_t nRead;
+    myBus->readRegisterRegion(0x28, myData, sizeof(myData), nRead);
+}
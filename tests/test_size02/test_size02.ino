@@ -0,0 +1,39 @@
+
+
+// Size test - one SPI device. Used by tests/host/footprint.py
+//
+// A typical 8-bit register driver on SPI: byte and block register access through the bus interface.
+
+#include "SparkFun_Toolkit.h"
+
+sfeTkArdSPI mySPI;
+sfeTkIBus *myBus = &mySPI;
+
+uint8_t myData[6];
+
+#if defined(SFE_TK_HOT_PATH_CHECK)
+// Instrumented builds - track the hot path nesting depth
+volatile uint8_t hotDepth = 0;
+
+void sfeTkHotPathEnter(const char *)
+{
+    hotDepth++;
+}
+
+void sfeTkHotPathLeave(void)
+{
+    hotDepth--;
+}
+#endif
+
+void setup()
+{
+    mySPI.init(10, true);
+    myBus->writeRegisterByte(0x20, 0x57);
+}
+
+void loop()
+{
+    size_t nRead;
+    myBus->readRegisterRegion(0x28, myData, sizeof(myData), nRead);
+}
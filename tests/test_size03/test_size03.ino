@@ -0,0 +1,56 @@
+
+
+// Size test - batched usage. Used by tests/host/footprint.py
+//
+// Four I2C devices share one port context through device handles, and each loop reads a table of
+// register blocks from them in one batch.
+
+#include "SparkFun_Toolkit.h"
+
+sfeTkArdI2CPort myI2CPort;
+sfeTkArdI2CDevice myDevice0(myI2CPort, 0x40);
+sfeTkArdI2CDevice myDevice1(myI2CPort, 0x41);
+sfeTkArdI2CDevice myDevice2(myI2CPort, 0x42);
+sfeTkArdI2CDevice myDevice3(myI2CPort, 0x43);
+
+struct batchRead
+{
+    sfeTkArdI2CDevice *device;
+    uint8_t reg;
+    uint8_t length;
+    uint8_t offset;
+};
+
+const batchRead myBatch[] = {
+    {&myDevice0, 0x28, 6, 0}, {&myDevice1, 0x28, 6, 6}, {&myDevice2, 0x3B, 14, 12}, {&myDevice3, 0x00, 4, 26}};
+
+uint8_t myData[30];
+
+#if defined(SFE_TK_HOT_PATH_CHECK)
+// Instrumented builds - track the hot path nesting depth
+volatile uint8_t hotDepth = 0;
+
+void sfeTkHotPathEnter(const char *)
+{
+    hotDepth++;
+}
+
+void sfeTkHotPathLeave(void)
+{
+    hotDepth--;
+}
+#endif
+
+void setup()
+{
+    myI2CPort.init(Wire, true);
+    for (const batchRead &item : myBatch)
+        item.device->writeRegisterByte(0x20, 0x57);
+}
+
+void loop()
+{
+    size_t nRead;
+    for (const batchRead &item : myBatch)
+        item.device->readRegisterRegion(item.reg, myData + item.offset, item.length, nRead);
+}
@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+# sfeTkLog.py - builds the string table of the toolkit log sites, and decodes binary log records into messages
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2023 SparkFun Electronics
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions: The
+# above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+# "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+# NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+# ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+# A log site (src/sfeTk/sfeTkLog.h) records the FNV-1a hash of its format string, a time stamp and its raw
+# arguments. The table maps each hash back to the format and the places it is used - it is built from the
+# sources by finding the SFE_TK_LOG_ERROR/WARN/INFO/DEBUG sites. Two different formats with the same hash are
+# an error - change the wording of one.
+#
+# The records are read from a capture of the serial port - the "#L" lines written by sfeTkArdLogDump(), mixed
+# with any other output - or, with --binary, from a file of the raw records (sfeTkLog::read()).
+#
+# Run from the repository root:
+#   python3 tools/sfeTkLog.py table src path/to/sketch -o log_table.json
+#   python3 tools/sfeTkLog.py decode --table log_table.json capture.txt
+#   python3 tools/sfeTkLog.py decode capture.txt --src src path/to/sketch    (build the table on the fly)
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+LEVELS = {"ERROR": 1, "WARN": 2, "INFO": 3, "DEBUG": 4}
+LEVEL_NAMES = {value: name for name, value in LEVELS.items()}
+
+SOURCE_EXTENSIONS = (".h", ".hpp", ".c", ".cpp", ".ino")
+
+HEADER_SIZE = 9
+
+# a log site - the macro, then one or more adjacent string literals
+SITE = re.compile(r'\bSFE_TK_LOG_(ERROR|WARN|INFO|DEBUG)\s*\(\s*((?:"(?:[^"\\\n]|\\.)*"\s*)+)')
+LITERAL = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+
+# the tokens that can hold a comment marker - strings and character literals are kept, comments are blanked
+TOKENS = re.compile(r'"(?:[^"\\\n]|\\.)*"|\'(?:[^\'\\\n]|\\.)*\'|//[^\n]*|/\*.*?\*/', re.S)
+
+# a printf conversion - flags, width, precision, length, conversion
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t|L)?([diouxXcfFeEgGaAps%])")
+
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "\\": "\\", '"': '"', "'": "'", "a": "\a", "b": "\b",
+           "f": "\f", "v": "\v", "?": "?"}
+
+
+class TableError(Exception):
+    pass
+
+
+def fnv1a(data):
+    value = 2166136261
+    for byte in data:
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def unescape(literal):
+    out = []
+    i = 0
+    while i < len(literal):
+        ch = literal[i]
+        if ch != "\\":
+            out.append(ch)
+            i += 1
+            continue
+        nxt = literal[i + 1]
+        if nxt == "x":
+            digits = re.match(r"[0-9a-fA-F]+", literal[i + 2:]).group(0)
+            out.append(chr(int(digits, 16)))
+            i += 2 + len(digits)
+        elif nxt in "01234567":
+            digits = re.match(r"[0-7]{1,3}", literal[i + 1:]).group(0)
+            out.append(chr(int(digits, 8)))
+            i += 1 + len(digits)
+        else:
+            out.append(ESCAPES.get(nxt, nxt))
+            i += 2
+    return "".join(out)
+
+
+def strip_comments(text):
+    """The text with comments blanked out - line numbers are kept"""
+    def blank(match):
+        token = match.group(0)
+        if token.startswith("/"):
+            return re.sub(r"[^\n]", " ", token)
+        return token
+    return TOKENS.sub(blank, text)
+
+
+def source_files(paths):
+    for path in paths:
+        if os.path.isfile(path):
+            yield path
+            continue
+        for root, dirs, files in os.walk(path):
+            dirs.sort()
+            for name in sorted(files):
+                if name.endswith(SOURCE_EXTENSIONS):
+                    yield os.path.join(root, name)
+
+
+def build_table(paths):
+    """The log sites in the sources - {id: {"format", "level", "sites"}}"""
+    table = {}
+    for path in source_files(paths):
+        with open(path, encoding="utf-8", errors="replace") as f:
+            text = strip_comments(f.read())
+        for match in SITE.finditer(text):
+            # the macro definitions take a format parameter, not a literal - they don't match
+            fmt = "".join(unescape(lit) for lit in LITERAL.findall(match.group(2)))
+            site_id = fnv1a(fmt.encode("utf-8"))
+            line = text.count("\n", 0, match.start()) + 1
+            where = "%s:%d" % (path.replace(os.sep, "/"), line)
+
+            entry = table.setdefault(site_id, {"format": fmt, "level": match.group(1), "sites": []})
+            if entry["format"] != fmt:
+                raise TableError("%s: format \"%s\" has the same ID 0x%08x as \"%s\" (%s) - reword one"
+                                 % (where, fmt, site_id, entry["format"], entry["sites"][0]))
+            entry["sites"].append(where)
+    return table
+
+
+def save_table(table, out):
+    data = {"0x%08x" % key: table[key] for key in sorted(table)}
+    json.dump(data, out, indent=2)
+    out.write("\n")
+
+
+def load_table(path):
+    with open(path) as f:
+        data = json.load(f)
+    return {int(key, 16): value for key, value in data.items()}
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def format_message(fmt, args):
+    """printf formatting of raw 32 bit arguments - the conversion gives the type"""
+    out = []
+    pos = 0
+    index = 0
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:match.start()])
+        pos = match.end()
+        flags, width, precision, _, conv = match.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if index >= len(args):
+            out.append("<missing>")
+            continue
+        raw = args[index]
+        index += 1
+
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+        if conv in "di":
+            out.append((spec + "d") % signed(raw))
+        elif conv in "ouxXc":
+            out.append((spec + conv) % (raw if conv != "c" else chr(raw & 0xFF)))
+        elif conv in "fFeEgGaA":
+            value = struct.unpack("<f", struct.pack("<I", raw))[0]
+            out.append((spec + (conv if conv not in "aA" else "g")) % value)
+        elif conv == "p":
+            out.append("0x%x" % raw)
+        else:  # a string is recorded as its address
+            out.append("<string at 0x%x>" % raw)
+    out.append(fmt[pos:])
+    if index < len(args):
+        out.append(" <+%d arguments>" % (len(args) - index))
+    return "".join(out)
+
+
+def parse_records(data):
+    """Split raw records - yields (id, time, level, args) or None for a truncated record"""
+    pos = 0
+    while pos + HEADER_SIZE <= len(data):
+        site_id, time, info = struct.unpack_from("<IIB", data, pos)
+        n_args = info & 0x0F
+        end = pos + HEADER_SIZE + 4 * n_args
+        if end > len(data):
+            break
+        args = list(struct.unpack_from("<%dI" % n_args, data, pos + HEADER_SIZE))
+        yield site_id, time, info >> 4, args
+        pos = end
+    if pos < len(data):
+        yield None
+
+
+def capture_records(lines):
+    """The records and drop counts in a capture - yields bytes, or an int for a "#LD" line"""
+    for line in lines:
+        start = line.find("#L")
+        if start < 0:
+            continue
+        body = line[start + 2:].strip()
+        if body.startswith("D"):
+            yield int(body[1:].strip() or "0")
+        elif re.fullmatch(r"(?:[0-9a-fA-F]{2})+", body):
+            yield bytes.fromhex(body)
+
+
+def decode(table, chunks, out):
+    """Print the messages of the records - returns the number of records that were not in the table"""
+    unknown = 0
+    for chunk in chunks:
+        if isinstance(chunk, int):
+            out.write("... %d records dropped - the log was full\n" % chunk)
+            continue
+        for record in parse_records(chunk):
+            if record is None:
+                out.write("... truncated record\n")
+                continue
+            site_id, time, level, args = record
+            level_name = LEVEL_NAMES.get(level, "L%d" % level)
+            entry = table.get(site_id)
+            if entry is None:
+                unknown += 1
+                message = "<unknown site 0x%08x> %s" % (site_id, " ".join("0x%x" % a for a in args))
+            else:
+                message = format_message(entry["format"], args)
+            out.write("%12.6f %-5s %s\n" % (time / 1e6, level_name, message))
+    return unknown
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the toolkit log string table, and decode log records")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    table_cmd = commands.add_parser("table", help="build the string table of the log sites in the sources")
+    table_cmd.add_argument("paths", nargs="+", help="source files and directories to search")
+    table_cmd.add_argument("-o", "--output", help="the table to write - default stdout")
+
+    decode_cmd = commands.add_parser("decode", help="turn log records into messages")
+    decode_cmd.add_argument("input", nargs="?", default="-", help="the capture or record file - default stdin")
+    decode_cmd.add_argument("--table", help="the string table from the table command")
+    decode_cmd.add_argument("--src", nargs="+", metavar="PATH", help="build the table from these sources")
+    decode_cmd.add_argument("--binary", action="store_true", help="the input is raw records, not a capture")
+    args = parser.parse_args()
+
+    try:
+        if args.command == "table":
+            table = build_table(args.paths)
+            if args.output:
+                with open(args.output, "w") as f:
+                    save_table(table, f)
+            else:
+                save_table(table, sys.stdout)
+            print("%d log formats" % len(table), file=sys.stderr)
+            return 0
+
+        if not args.table and not args.src:
+            parser.error("decode needs --table or --src")
+        table = load_table(args.table) if args.table else {}
+        if args.src:
+            table.update(build_table(args.src))
+
+        if args.binary:
+            data = sys.stdin.buffer.read() if args.input == "-" else open(args.input, "rb").read()
+            chunks = [data]
+        else:
+            text = sys.stdin if args.input == "-" else open(args.input, encoding="utf-8", errors="replace")
+            chunks = capture_records(text)
+
+        unknown = decode(table, chunks, sys.stdout)
+        if unknown:
+            print("%d records from sites not in the table - rebuild it from the firmware's sources" % unknown,
+                  file=sys.stderr)
+        return 0
+    except (TableError, OSError, ValueError) as err:
+        print("sfeTkLog: %s" % err, file=sys.stderr)
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,339 @@
+#!/usr/bin/env python3
+# sfeTkRegGen.py - generates a constexpr register map header for a device from its register description
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2023 SparkFun Electronics
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions: The
+# above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+# "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+# NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+# ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+# The description is JSON, or YAML when PyYAML is installed. Numbers may be integers or strings ("0x6B").
+#
+#   {
+#     "device": "ExampleImu",            // the name - constants are kExampleImu..., the cache is sfeExampleImuShadow_t
+#     "address": "0x6A",                 // optional - the default I2C address
+#     "addressBits": 8,                  // 8 (default) or 16 bit register addresses
+#     "byteOrder": "little",             // the default order of multi-byte registers - "little" or "big"
+#     "registers": [
+#       { "name": "CTRL1", "address": "0x10", "width": 1, "access": "rw", "volatile": false, "reset": "0x00",
+#         "description": "Control 1",
+#         "fields": [ { "name": "ODR", "bits": "7:4" }, { "name": "EN", "bits": 0 } ] }
+#     ],
+#     "bursts": [ { "name": "SAMPLE", "first": "OUT_X", "last": "OUT_Z" } ]
+#   }
+#
+# A register is "ro", "wo" or "rw" (default), 1 to 4 bytes wide (default 1), and may set "byteOrder" and
+# "cache": false. Registers that are not volatile get a slot in the shadow cache (sfeTkRegShadow). A burst group
+# is the registers from first to last - they must all be readable, and the range must have no gaps unless the
+# group sets "gaps": true.
+#
+# Run from the repository root:
+#   python3 tools/sfeTkRegGen.py device.json -o sfeDevRegs.h
+#   python3 tools/sfeTkRegGen.py device.json --check sfeDevRegs.h    (exit status 1 if the header is out of date)
+
+import argparse
+import json
+import os
+import re
+import sys
+
+LICENSE = """/*
+
+The MIT License (MIT)
+
+Copyright (c) 2023 SparkFun Electronics
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation
+the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the
+Software is furnished to do so, subject to the following conditions: The
+above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+"AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+*/
+"""
+
+ACCESS = {"ro": "kSTkRegReadOnly", "wo": "kSTkRegWriteOnly", "rw": "kSTkRegReadWrite"}
+
+
+class DescriptionError(Exception):
+    pass
+
+
+def load(path):
+    with open(path) as f:
+        if os.path.splitext(path)[1] in (".yaml", ".yml"):
+            try:
+                import yaml
+            except ImportError:
+                raise DescriptionError("%s: YAML descriptions need PyYAML (pip install pyyaml)" % path)
+            return yaml.safe_load(f)
+        return json.load(f)
+
+
+def number(value, what):
+    if isinstance(value, bool):
+        raise DescriptionError("%s: expected a number, got %r" % (what, value))
+    if isinstance(value, int):
+        return value
+    try:
+        return int(str(value), 0)
+    except ValueError:
+        raise DescriptionError("%s: expected a number, got %r" % (what, value))
+
+
+def camel(name):
+    """CTRL1_XL, ctrl1-xl and Ctrl1Xl all give Ctrl1Xl"""
+    parts = [p for p in re.split(r"[^0-9A-Za-z]+", name) if p]
+    if not parts or not re.match(r"[A-Za-z]", parts[0]):
+        raise DescriptionError("%r is not a usable name" % name)
+    return "".join(p[0].upper() + (p[1:].lower() if p.isupper() else p[1:]) for p in parts)
+
+
+def field_bits(field, what):
+    bits = field.get("bits")
+    if bits is None:
+        raise DescriptionError("%s: no bits" % what)
+    text = str(bits)
+    if ":" in text:
+        high, low = (number(b.strip(), what) for b in text.split(":", 1))
+    else:
+        high = low = number(bits, what)
+    if high < low:
+        raise DescriptionError("%s: bits %s - the high bit comes first" % (what, text))
+    return low, high - low + 1
+
+
+def parse(desc):
+    """Validates the description, and returns the device with the shadow slots and burst groups worked out"""
+    if not isinstance(desc, dict) or "device" not in desc:
+        raise DescriptionError("the description has no device name")
+
+    device = {"name": camel(desc["device"]), "registers": [], "bursts": []}
+    device["address"] = number(desc["address"], "address") if "address" in desc else None
+    addr_bits = number(desc.get("addressBits", 8), "addressBits")
+    if addr_bits not in (8, 16):
+        raise DescriptionError("addressBits must be 8 or 16")
+    device["addressBits"] = addr_bits
+    default_order = desc.get("byteOrder", "little")
+
+    names = set()
+    shadow = 0
+    for raw in desc.get("registers", []):
+        what = "register %s" % raw.get("name", "?")
+        reg = {"name": camel(raw.get("name", "")), "description": raw.get("description", "")}
+        if reg["name"] in names:
+            raise DescriptionError("%s: defined twice" % what)
+        names.add(reg["name"])
+
+        reg["address"] = number(raw.get("address"), what + " address")
+        reg["width"] = number(raw.get("width", 1), what + " width")
+        if not 1 <= reg["width"] <= 4:
+            raise DescriptionError("%s: width must be 1 to 4 bytes" % what)
+        if reg["address"] < 0 or reg["address"] + reg["width"] > (1 << addr_bits):
+            raise DescriptionError("%s: address out of range for %d bit addresses" % (what, addr_bits))
+        reg["access"] = raw.get("access", "rw")
+        if reg["access"] not in ACCESS:
+            raise DescriptionError("%s: access must be one of %s" % (what, ", ".join(sorted(ACCESS))))
+        reg["volatile"] = bool(raw.get("volatile", False))
+        order = raw.get("byteOrder", default_order)
+        if order not in ("little", "big"):
+            raise DescriptionError("%s: byteOrder must be little or big" % what)
+        reg["bigEndian"] = order == "big" and reg["width"] > 1
+        reg["reset"] = number(raw.get("reset", 0), what + " reset")
+        if not 0 <= reg["reset"] < (1 << (8 * reg["width"])):
+            raise DescriptionError("%s: reset value does not fit the register" % what)
+
+        # every register the device does not change can be cached - the bytes are packed in address order below
+        reg["cached"] = not reg["volatile"] and raw.get("cache", True)
+
+        reg["fields"] = []
+        used = 0
+        for rawField in raw.get("fields", []):
+            fwhat = "%s field %s" % (what, rawField.get("name", "?"))
+            shift, width = field_bits(rawField, fwhat)
+            if shift + width > 8 * reg["width"]:
+                raise DescriptionError("%s: does not fit the register" % fwhat)
+            mask = ((1 << width) - 1) << shift
+            if used & mask:
+                raise DescriptionError("%s: overlaps another field" % fwhat)
+            used |= mask
+            reg["fields"].append({"name": camel(rawField.get("name", "")), "shift": shift, "width": width,
+                                  "description": rawField.get("description", "")})
+        device["registers"].append(reg)
+
+    regs = sorted(device["registers"], key=lambda r: r["address"])
+    for prev, reg in zip(regs, regs[1:]):
+        if prev["address"] + prev["width"] > reg["address"]:
+            raise DescriptionError("registers %s and %s overlap" % (prev["name"], reg["name"]))
+    for reg in regs:
+        if reg["cached"]:
+            reg["shadow"] = shadow
+            shadow += reg["width"]
+        else:
+            reg["shadow"] = None
+    device["registers"] = regs
+    device["shadowSize"] = shadow
+
+    byName = {r["name"]: r for r in regs}
+    for raw in desc.get("bursts", []):
+        what = "burst %s" % raw.get("name", "?")
+        try:
+            first, last = byName[camel(raw["first"])], byName[camel(raw["last"])]
+        except KeyError as e:
+            raise DescriptionError("%s: unknown or missing register %s" % (what, e))
+        if last["address"] < first["address"]:
+            raise DescriptionError("%s: the last register comes before the first" % what)
+        members = [r for r in regs if first["address"] <= r["address"] <= last["address"]]
+        for reg in members:
+            if reg["access"] == "wo":
+                raise DescriptionError("%s: register %s is write only" % (what, reg["name"]))
+        end = last["address"] + last["width"]
+        covered = sum(r["width"] for r in members)
+        if covered != end - first["address"] and not raw.get("gaps", False):
+            raise DescriptionError("%s: the registers have gaps - set \"gaps\": true to read them anyway" % what)
+        device["bursts"].append({"name": camel(raw.get("name", "")), "address": first["address"],
+                                 "length": end - first["address"], "members": members})
+    return device
+
+
+def hexval(value, width):
+    return "0x%0*X" % (2 * width, value)
+
+
+def declare(lhs, rhs):
+    """A declaration, with the initializer on its own line if it would pass 120 columns"""
+    line = "%s = %s;" % (lhs, rhs)
+    return line if len(line) <= 120 else "%s =\n    %s;" % (lhs, rhs)
+
+
+def generate(device, source):
+    name = device["name"]
+    k = "k" + name
+    burstFlags = "kSTkRegAddress16" if device["addressBits"] == 16 else "0"
+    addrWidth = device["addressBits"] // 8
+    out = []
+    w = out.append
+
+    w("// %sRegs.h" % name)
+    w("//")
+    w("// The register map of the %s - generated by tools/sfeTkRegGen.py from %s. Do not edit." % (name, source))
+    w(LICENSE)
+    w("#pragma once")
+    w("")
+    w("#include <sfeTk/sfeTkRegister.h>")
+    w("")
+    if device["addressBits"] == 16:
+        w("static_assert(SFE_TK_ENABLE_16BIT_REGISTERS, \"%s has 16 bit register addresses - "
+          "set SFE_TK_ENABLE_16BIT_REGISTERS\");" % name)
+        w("")
+    if device["address"] is not None:
+        w("/** The default I2C address */")
+        w("const uint8_t %sAddress = %s;" % (k, hexval(device["address"], 1)))
+        w("")
+
+    w("// Registers")
+    for reg in device["registers"]:
+        flags = []
+        if reg["volatile"]:
+            flags.append("kSTkRegVolatile")
+        if reg["bigEndian"]:
+            flags.append("kSTkRegBigEndian")
+        if device["addressBits"] == 16:
+            flags.append("kSTkRegAddress16")
+        shadow = "kSTkRegNoShadow" if reg["shadow"] is None else str(reg["shadow"])
+        if reg["description"]:
+            w("/** %s */" % reg["description"])
+        w(declare("constexpr sfeTkRegister %sReg%s" % (k, reg["name"]),
+                  "{%s, %d, %s, %s, %s, %s}" % (hexval(reg["address"], addrWidth), reg["width"], ACCESS[reg["access"]],
+                                                " | ".join(flags) or "0", shadow, hexval(reg["reset"], reg["width"]))))
+    w("")
+
+    fields = [(reg, f) for reg in device["registers"] for f in reg["fields"]]
+    if fields:
+        w("// Fields")
+        for reg, field in fields:
+            if field["description"]:
+                w("/** %s */" % field["description"])
+            w("constexpr sfeTkRegField %s%s%s = {%sReg%s, %d, %d};" %
+              (k, reg["name"], field["name"], k, reg["name"], field["shift"], field["width"]))
+        w("")
+
+    if device["bursts"]:
+        w("// Burst groups - read with sfeTkRegReadBurst(), or as a transaction step with sfeTkRegBurstStep()")
+        for burst in device["bursts"]:
+            w("constexpr sfeTkRegBurst %sBurst%s = {%s, %d, %s};" %
+              (k, burst["name"], hexval(burst["address"], addrWidth), burst["length"], burstFlags))
+            w("const size_t %sBurst%sLength = %d;" % (k, burst["name"], burst["length"]))
+            for reg in burst["members"]:
+                w("static_assert(%sBurst%s.contains(%sReg%s), \"%s is in burst %s\");" %
+                  (k, burst["name"], k, reg["name"], reg["name"], burst["name"]))
+        w("")
+
+    w("// All registers, in address order - for sfeTkRegShadow::loadReset()")
+    w("constexpr sfeTkRegister %sRegisters[] = {" % k)
+    for reg in device["registers"]:
+        w("    %sReg%s," % (k, reg["name"]))
+    w("};")
+    w("const size_t %sRegisterCount = %d;" % (k, len(device["registers"])))
+    w("")
+    w("// The shadow cache - %d bytes for %d registers the device does not change" %
+      (device["shadowSize"], sum(1 for r in device["registers"] if r["shadow"] is not None)))
+    w("const size_t %sShadowSize = %d;" % (k, device["shadowSize"]))
+    if device["shadowSize"]:
+        w("typedef sfeTkRegShadow<%sShadowSize> sfe%sShadow_t;" % (k, name))
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate a constexpr register map header from a description")
+    parser.add_argument("description", help="the register description - JSON, or YAML with PyYAML")
+    parser.add_argument("-o", "--output", help="the header to write - default stdout")
+    parser.add_argument("--check", metavar="HEADER", help="check the header is up to date, rather than write it")
+    args = parser.parse_args()
+
+    try:
+        header = generate(parse(load(args.description)), os.path.basename(args.description))
+    except DescriptionError as e:
+        print("%s: %s" % (args.description, e), file=sys.stderr)
+        return 2
+
+    if args.check:
+        with open(args.check) as f:
+            if f.read() != header:
+                print("%s is out of date - regenerate it from %s" % (args.check, args.description), file=sys.stderr)
+                return 1
+        print("%s is up to date" % args.check)
+        return 0
+
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(header)
+    else:
+        sys.stdout.write(header)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())